@@ -0,0 +1,41 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+// Board revisions: every pin and which sensor or actuator sits on it.
+// Select one with -DBOARD_REV=<n>; the rest of the firmware only uses
+// Board.
+
+#include "hal.h"
+
+#define BOARD_REV_1 1
+#define BOARD_REV_2 2
+
+#ifndef BOARD_REV
+#define BOARD_REV BOARD_REV_1
+#endif
+
+// Rev 1: ESP32 DevKit, one soil probe and one pump relay
+struct BoardRev1 {
+    static const int i2cSda = 19;
+    static const int i2cScl = 21;
+    typedef hal::DigitalOut<23> StatusLed;
+    typedef hal::DigitalOut<2> OnboardLed;
+    typedef hal::DeviceSet<hal::AnalogIn<34> > SoilSensors;
+    typedef hal::DeviceSet<hal::DigitalOut<5> > Pumps;
+};
+
+// Rev 2: rev 1 plus a second zone, probe on GPIO 35 and relay on GPIO 18
+struct BoardRev2 : BoardRev1 {
+    typedef hal::DeviceSet<hal::AnalogIn<34>, hal::AnalogIn<35> > SoilSensors;
+    typedef hal::DeviceSet<hal::DigitalOut<5>, hal::DigitalOut<18> > Pumps;
+};
+
+#if BOARD_REV == BOARD_REV_1
+typedef BoardRev1 Board;
+#elif BOARD_REV == BOARD_REV_2
+typedef BoardRev2 Board;
+#else
+#error "Unknown BOARD_REV"
+#endif
+
+#endif
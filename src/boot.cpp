@@ -0,0 +1,82 @@
+#include "boot.h"
+#include "connectToWifi.h"
+#include "logger.h"
+#include "outbox.h"
+#include <esp_timer.h>
+
+struct BootJob {
+    void (*work)();
+    BootPhase phase;
+};
+
+static const char* const phaseNames[BOOT_PHASE_COUNT] = {
+    "core", "wifi_start", "sensors", "setup", "first_sample",
+    "first_control", "display", "wifi", "mqtt"
+};
+
+// Written once per phase, from whichever task reaches it
+static volatile uint32_t phaseUs[BOOT_PHASE_COUNT];
+static BootJob jobs[BOOT_PHASE_COUNT];
+static bool reported = false;
+
+void bootMark(BootPhase phase) {
+    if (phaseUs[phase] != 0) {
+        return;
+    }
+    // esp_timer starts at 0 shortly after reset; never store 0, it means
+    // "not reached"
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    phaseUs[phase] = now != 0 ? now : 1;
+    LOG_INFO("Boot: %s at %lu ms", phaseNames[phase], (unsigned long)(now / 1000));
+}
+
+bool bootPhaseDone(BootPhase phase) {
+    return phaseUs[phase] != 0;
+}
+
+uint32_t bootPhaseUs(BootPhase phase) {
+    return phaseUs[phase];
+}
+
+static void bootTask(void* arg) {
+    BootJob* job = (BootJob*)arg;
+    job->work();
+    bootMark(job->phase);
+    vTaskDelete(NULL);
+}
+
+void bootRunAsync(const char* name, void (*work)(), BootPhase phase) {
+    BootJob* job = &jobs[phase];
+    job->work = work;
+    job->phase = phase;
+    if (xTaskCreate(bootTask, name, BOOT_TASK_STACK, job, 1, NULL) != pdPASS) {
+        // No memory for a task: do it inline, only slower
+        LOG_WARN("Boot: no task for %s, running inline", name);
+        work();
+        bootMark(phase);
+    }
+}
+
+void bootPublishReport() {
+    if (reported) {
+        return;
+    }
+    reported = true;
+
+    char event[320];
+    int len = snprintf(event, sizeof(event), "{\"event\":\"boot\",\"phases_ms\":{");
+    for (uint8_t phase = 0; phase < BOOT_PHASE_COUNT && len < (int)sizeof(event); phase++) {
+        uint32_t us = phaseUs[phase];
+        const char* comma = phase > 0 ? "," : "";
+        if (us != 0) {
+            len += snprintf(event + len, sizeof(event) - len, "%s\"%s\":%lu.%lu", comma, phaseNames[phase],
+                            (unsigned long)(us / 1000), (unsigned long)(us % 1000 / 100));
+        } else {
+            len += snprintf(event + len, sizeof(event) - len, "%s\"%s\":null", comma, phaseNames[phase]);
+        }
+    }
+    if (len < (int)sizeof(event)) {
+        snprintf(event + len, sizeof(event) - len, "}}");
+    }
+    publishEvent(event);
+}
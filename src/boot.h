@@ -0,0 +1,44 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <Arduino.h>
+
+// Boot sequencing: WiFi association starts first and runs in the
+// background, slow peripheral init runs in its own task, and sensing and
+// watering start as soon as the local hardware is up. Each phase is
+// timestamped from reset and reported once MQTT is connected.
+
+// Stack of a parallel init task
+#define BOOT_TASK_STACK 3072
+
+enum BootPhase {
+    BOOT_PHASE_CORE = 0,        // logger, timers, health, safety
+    BOOT_PHASE_WIFI_START,      // association started
+    BOOT_PHASE_SENSORS,         // I2C bus, soil, pump, SHT31 probe
+    BOOT_PHASE_SETUP,           // setup() returned
+    BOOT_PHASE_FIRST_SAMPLE,
+    BOOT_PHASE_FIRST_CONTROL,   // first pump decision
+    BOOT_PHASE_DISPLAY,         // panel initialised
+    BOOT_PHASE_WIFI,
+    BOOT_PHASE_MQTT,
+    BOOT_PHASE_COUNT
+};
+
+// Record a phase as done now; later marks of the same phase are ignored.
+// Safe from any task.
+void bootMark(BootPhase phase);
+
+bool bootPhaseDone(BootPhase phase);
+
+// Microseconds from reset to the phase, 0 if not reached
+uint32_t bootPhaseUs(BootPhase phase);
+
+// Run work in its own task and mark phase when it returns; setup() goes
+// on in the meantime
+void bootRunAsync(const char* name, void (*work)(), BootPhase phase);
+
+// Publish {"event":"boot","phases_ms":{...}} once, on the first MQTT
+// connection; phases not reached yet are null
+void bootPublishReport();
+
+#endif
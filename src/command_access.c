@@ -0,0 +1,18 @@
+#include "command_access.h"
+#include <stddef.h>
+#include <string.h>
+
+static const char *const lan_commands[] = {
+    "PUMP_ON", "PUMP_ENABLE", "PUMP_DISABLE", "STATUS", "PUMP_CAL_STATUS", "CAL_STATUS", "OTA_STATUS"
+};
+
+bool command_lan_allowed(const char *line) {
+    // The command word ends at the arguments, deadline or request id
+    size_t len = strcspn(line, " @:");
+    for (size_t i = 0; i < sizeof(lan_commands) / sizeof(lan_commands[0]); i++) {
+        if (strlen(lan_commands[i]) == len && strncmp(line, lan_commands[i], len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
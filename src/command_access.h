@@ -0,0 +1,24 @@
+#ifndef COMMAND_ACCESS_H
+#define COMMAND_ACCESS_H
+
+// Which control commands each source may run. The local web server has no
+// authentication, so LAN clients get the dashboard's commands and status
+// queries only; flashing firmware, clearing a safety fault and calibrating
+// are taken from the broker alone. Plain C, so it also builds on a host.
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// True if a command line, "<COMMAND>[ <args>][@<deadline>][:<request id>]"
+// as runCommand() takes it, may come from the LAN. The command word must
+// match an allowed one exactly.
+bool command_lan_allowed(const char *line);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
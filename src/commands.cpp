@@ -0,0 +1,135 @@
+#include "commands.h"
+#include "connectToWifi.h"
+#include "logger.h"
+#include "display_scheduler.h"
+#include "soil_calibration.h"
+#include "safety.h"
+#include "pump.h"
+#include "controller.h"
+#include "ota.h"
+#include "outbox.h"
+#include "rules.h"
+#include <time.h>
+
+// Deadline check for "...@<unix seconds>"; reports a command it drops
+static bool commandExpired(const String& command, const String& deadline, const String& requestId) {
+    time_t now = time(NULL);
+    const char* reason = NULL;
+    if ((unsigned long)now < COMMAND_CLOCK_MIN) {
+        reason = "no_clock";
+    } else if ((unsigned long)now > strtoul(deadline.c_str(), NULL, 10)) {
+        reason = "expired";
+    }
+    if (reason == NULL) {
+        return false;
+    }
+
+    char event[128];
+    int len = snprintf(event, sizeof(event), "{\"event\":\"command_expired\",\"command\":\"%.24s\",\"reason\":\"%s\"",
+                       command.c_str(), reason);
+    if (requestId.length() > 0) {
+        len += snprintf(event + len, sizeof(event) - len, ",\"req\":\"%s\"", requestId.c_str());
+    }
+    snprintf(event + len, sizeof(event) - len, "}");
+    publishEvent(event);
+    LOG_WARN("Dropped %s: %s", command.c_str(), reason);
+    return true;
+}
+
+void runCommand(const String& line) {
+    displayWake();
+    
+    String message = line;
+    LOG_DEBUG("Message: '%s' pumpServiceEnabled BEFORE: %d", message.c_str(), pumpServiceEnabled);
+    
+    // Commands may carry a request id to echo back: "STATUS:<id>"
+    String requestId = "";
+    int separator = message.indexOf(':');
+    if (separator >= 0) {
+        requestId = message.substring(separator + 1);
+        message = message.substring(0, separator);
+        if (requestId.length() > COMMAND_REQUEST_ID_MAX) {
+            requestId = requestId.substring(0, COMMAND_REQUEST_ID_MAX);
+        }
+        // The id is echoed into JSON, so only accept [A-Za-z0-9_-]
+        for (unsigned int i = 0; i < requestId.length(); i++) {
+            if (!isalnum(requestId[i]) && requestId[i] != '_' && requestId[i] != '-') {
+                requestId = "";
+                break;
+            }
+        }
+    }
+    
+    // Then an optional deadline: "PUMP_ON 50@1760000000:<id>"
+    String deadline = "";
+    int at = message.indexOf('@');
+    if (at >= 0) {
+        deadline = message.substring(at + 1);
+        message = message.substring(0, at);
+    }
+    
+    // Arguments follow the command after a space: "CAL_POINT 40:<id>"
+    String args = "";
+    int space = message.indexOf(' ');
+    if (space >= 0) {
+        args = message.substring(space + 1);
+        message = message.substring(0, space);
+    }
+    
+    if (deadline.length() > 0 && commandExpired(message, deadline, requestId)) {
+        return;
+    }
+    
+    if (message == "PUMP_ON") {
+        // Dose, then the pump: "PUMP_ON 50 1"
+        LOG_INFO("EXECUTING: PUMP_ON %s", args.c_str());
+        int pumpSpace = args.indexOf(' ');
+        long pump = pumpSpace >= 0 ? args.substring(pumpSpace + 1).toInt() : 0;
+        if (pump < 0 || pump >= PUMP_COUNT) {
+            LOG_WARN("Manual watering refused, no pump %ld", pump);
+            publishEvent("{\"event\":\"pump_blocked\",\"reason\":\"bad_pump\"}");
+        } else {
+            manualPump(args.toInt() > 0 ? args.toInt() : 0, pump);
+        }
+    } 
+    else if (message == "PUMP_ENABLE") {
+        LOG_INFO("EXECUTING: PUMP_ENABLE");
+        pumpServiceEnabled = true;
+        rulesCancelPumpHold();
+        publishEvent("{\"event\":\"pump_enabled\"}");
+        LOG_INFO("Pump service ENABLED");
+    } 
+    else if (message == "PUMP_DISABLE") {
+        LOG_INFO("EXECUTING: PUMP_DISABLE");
+        pumpServiceEnabled = false;
+        rulesCancelPumpHold();
+        stopPump();
+        publishEvent("{\"event\":\"pump_disabled\"}");
+        LOG_INFO("Pump service DISABLED - pump stopped");
+    } 
+    else if (message == "STATUS") {
+        LOG_INFO("EXECUTING: STATUS %s", requestId.c_str());
+        sendCachedStatus(requestId.length() > 0 ? requestId.c_str() : NULL);
+    } 
+    else if (message == "FAULT_CLEAR") {
+        LOG_INFO("EXECUTING: FAULT_CLEAR");
+        safetyClearFault();
+    } 
+    else if (message.startsWith("PUMP_CAL")) {
+        LOG_INFO("EXECUTING: %s %s", message.c_str(), args.c_str());
+        handlePumpCommand(message, args, requestId.length() > 0 ? requestId.c_str() : NULL);
+    } 
+    else if (message.startsWith("CAL_")) {
+        LOG_INFO("EXECUTING: %s %s", message.c_str(), args.c_str());
+        handleCalibrationCommand(message, args, requestId.length() > 0 ? requestId.c_str() : NULL);
+    } 
+    else if (message.startsWith("OTA_")) {
+        LOG_INFO("EXECUTING: %s %s", message.c_str(), args.c_str());
+        handleOtaCommand(message, args, requestId.length() > 0 ? requestId.c_str() : NULL);
+    } 
+    else {
+        LOG_WARN("Unknown command: '%s'", message.c_str());
+    }
+    
+    LOG_DEBUG("pumpServiceEnabled AFTER: %d", pumpServiceEnabled);
+}
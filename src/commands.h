@@ -0,0 +1,20 @@
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include <Arduino.h>
+
+// Longest request id echoed back in a command reply
+#define COMMAND_REQUEST_ID_MAX 16
+
+// Unix time before which the clock is taken as not yet set by SNTP
+#define COMMAND_CLOCK_MIN 1577836800UL
+
+// Run one control command, "<COMMAND>[ <args>][@<deadline>][:<request id>]",
+// from the MQTT control topic or the local web server. Loop task only.
+// A command with a deadline (Unix seconds) is dropped with a
+// command_expired event once it has passed, or while the clock is unset,
+// so one queued in the MQTT session while the box was offline does not
+// run hours later.
+void runCommand(const String& line);
+
+#endif
@@ -1,131 +1,194 @@
 #include "connectToWifi.h"
 #include <secrets.h>
+#include "logger.h"
+#include "commands.h"
+#include "health.h"
+#include "timer_wheel.h"
+#include "boot.h"
+#include "ota.h"
+#include "web_server.h"
+#include "outbox.h"
+#include "rules.h"
 
+#ifdef MQTT_TLS
+MqttTlsClient espClient;
+#else
 WiFiClient espClient;
+#endif
 PubSubClient mqttClient(espClient);
 bool pumpServiceEnabled = false;
 
-// Add this at the top of the file
-extern const int pumpPin;
+char deviceId[DEVICE_ID_LENGTH + 1];
+char mqttTopicControl[MQTT_TOPIC_MAX];
+char mqttTopicStatus[MQTT_TOPIC_MAX];
+char mqttTopicMetrics[MQTT_TOPIC_MAX];
+char mqttTopicAvailability[MQTT_TOPIC_MAX];
+char mqttTopicOta[MQTT_TOPIC_MAX];
+char mqttTopicOtaAck[MQTT_TOPIC_MAX];
+char mqttTopicAck[MQTT_TOPIC_MAX];
+char mqttTopicRules[MQTT_TOPIC_MAX];
 
-void connectToWifi() {
-    Serial.print("Connecting to WiFi...");
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(WIFI_NETWORK, WIFI_PASSWORD);
+void initDeviceIdentity() {
+    // Efuse MAC is stored little-endian, byte 0 is the first MAC octet
+    uint64_t mac = ESP.getEfuseMac();
+    for (int i = 0; i < 6; i++) {
+        snprintf(&deviceId[i * 2], 3, "%02x", (uint8_t)(mac >> (8 * i)));
+    }
     
-    unsigned long startAttemptTime = millis();
+    snprintf(mqttTopicControl, MQTT_TOPIC_MAX, MQTT_TOPIC_ROOT "/%s/control", deviceId);
+    snprintf(mqttTopicStatus, MQTT_TOPIC_MAX, MQTT_TOPIC_ROOT "/%s/status", deviceId);
+    snprintf(mqttTopicMetrics, MQTT_TOPIC_MAX, MQTT_TOPIC_ROOT "/%s/metrics", deviceId);
+    snprintf(mqttTopicAvailability, MQTT_TOPIC_MAX, MQTT_TOPIC_ROOT "/%s/availability", deviceId);
+    snprintf(mqttTopicOta, MQTT_TOPIC_MAX, MQTT_TOPIC_ROOT "/%s/ota", deviceId);
+    snprintf(mqttTopicOtaAck, MQTT_TOPIC_MAX, MQTT_TOPIC_ROOT "/%s/ota_ack", deviceId);
+    snprintf(mqttTopicAck, MQTT_TOPIC_MAX, MQTT_TOPIC_ROOT "/%s/ack", deviceId);
+    snprintf(mqttTopicRules, MQTT_TOPIC_MAX, MQTT_TOPIC_ROOT "/%s/rules", deviceId);
     
-    while (WiFi.status() != WL_CONNECTED && millis() - startAttemptTime < WIFI_TIMEOUT_MS) {
-        delay(500);
-        Serial.print(".");
+    LOG_INFO("Device ID: %s", deviceId);
+}
+
+static TimerId wifiTimer = TIMER_NONE;
+static TimerId mqttPollTimer = TIMER_NONE;
+static TimerId mqttConnectTimer = TIMER_NONE;
+static uint32_t wifiWaitedMs = 0;
+
+// WiFi event task; only timestamps the connection
+static void onWifiGotIp(arduino_event_id_t event, arduino_event_info_t info) {
+    bootMark(BOOT_PHASE_WIFI);
+}
+
+// Runs every WIFI_POLL_MS until the first connection or the timeout; the
+// station reconnects on its own after that. MQTT starts here, so its first
+// attempt is not spent on a network that is not up yet.
+static void checkWifi() {
+    wifiWaitedMs += WIFI_POLL_MS;
+    if (WiFi.status() == WL_CONNECTED) {
+        LOG_INFO("WiFi connected! IP address: %s", WiFi.localIP().toString().c_str());
+        timerStop(wifiTimer);
+        timerStart(mqttConnectTimer, 0, MQTT_RETRY_INTERVAL);
+    } else if (wifiWaitedMs >= WIFI_TIMEOUT_MS) {
+        LOG_ERROR("Failed to connect to WiFi! Timeout reached.");
+        timerStop(wifiTimer);
+        timerStart(mqttConnectTimer, 0, MQTT_RETRY_INTERVAL);
     }
+}
+
+// Returns at once; association runs in the background while the rest of
+// setup() goes on, and the connection is reported from the wifi timer
+void connectToWifi() {
+    LOG_INFO("Connecting to WiFi...");
+    WiFi.onEvent(onWifiGotIp, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    WiFi.mode(WIFI_STA);
+    WiFi.begin(WIFI_NETWORK, WIFI_PASSWORD);
     
-    if (WiFi.status() != WL_CONNECTED) {
-        Serial.println();
-        Serial.println("Failed to connect to WiFi!");
-        Serial.println("Timeout reached.");
-    } else {
-        Serial.println();
-        Serial.println("WiFi connected!");
-        Serial.print("IP address: ");
-        Serial.println(WiFi.localIP());
-    }
+    wifiWaitedMs = 0;
+    wifiTimer = timerCreate("wifi", checkWifi);
+    timerStart(wifiTimer, WIFI_POLL_MS, WIFI_POLL_MS);
 }
 
 void setupMQTT() {
+    initDeviceIdentity();
+#ifdef MQTT_TLS
+    espClient.setCACert(MQTT_CA_CERT);
+    espClient.setCertificate(MQTT_CLIENT_CERT, MQTT_CLIENT_KEY);
+#endif
     mqttClient.setServer(MQTT_BROKER, MQTT_PORT);
     mqttClient.setCallback(mqttCallback);
+    mqttClient.setBufferSize(MQTT_BUFFER_SIZE);
+    mqttClient.setKeepAlive(MQTT_KEEPALIVE_S);
+    
+    mqttPollTimer = timerCreate("mqtt_poll", pollMQTT);
+    timerStart(mqttPollTimer, MQTT_POLL_MS, MQTT_POLL_MS);
+    // Started by the wifi timer
+    mqttConnectTimer = timerCreate("mqtt_connect", reconnectMQTT);
+}
+
+// Status messages go to the broker and to the LAN clients of the web server
+void publishStatus(const char* json, bool retain) {
+    mqttClient.publish(mqttTopicStatus, json, retain);
+    webBroadcast(json);
+}
+
+// Keepalive and incoming commands
+void pollMQTT() {
+    static bool wasConnected = false;
+    healthMark(HEALTH_STAGE_MQTT);
+    if (mqttClient.connected()) {
+        mqttClient.loop();
+        wasConnected = true;
+    } else if (wasConnected) {
+        // Reconnect now rather than at the next retry slot; with TLS the
+        // cached session makes this one round trip
+        LOG_WARN("MQTT connection lost, rc=%d", mqttClient.state());
+        wasConnected = false;
+        timerStart(mqttConnectTimer, 0, MQTT_RETRY_INTERVAL);
+    }
 }
 
+// One attempt every MQTT_RETRY_INTERVAL (mqtt_connect timer), so the loop
+// keeps running (and feeding the watchdog) while the broker is unreachable
 void reconnectMQTT() {
-    while (!mqttClient.connected()) {
-        Serial.print("Attempting MQTT connection...");
-        String clientId = "ESP32-PlantMonitor-" + String(random(0xffff), HEX);
+    if (mqttClient.connected() || WiFi.status() != WL_CONNECTED) {
+        return;
+    }
+    healthMark(HEALTH_STAGE_MQTT);
+
+    LOG_INFO("Attempting MQTT connection...");
+    String clientId = String("growbox-") + deviceId;
+    
+    // Broker publishes a retained "offline" for us if the connection drops.
+    // The session outlives the connection (clean session off, stable client
+    // id), so QoS 1 commands sent while we are away arrive on reconnect.
+    if (mqttClient.connect(clientId.c_str(), NULL, NULL, mqttTopicAvailability, 1, true, "offline", false)) {
+        LOG_INFO("MQTT connected!");
         
-        if (mqttClient.connect(clientId.c_str())) {
-            Serial.println("connected!");
-            
-            // Subscribe to control topic
-            bool subscribed = mqttClient.subscribe(MQTT_TOPIC_CONTROL);
-            if (subscribed) {
-                Serial.print("✓ Successfully subscribed to: ");
-                Serial.println(MQTT_TOPIC_CONTROL);
-            } else {
-                Serial.println("✗ FAILED to subscribe to control topic!");
-            }
-            
-            // Send online notification
-            mqttClient.publish(MQTT_TOPIC_STATUS, "online");
-            Serial.println("Published online status");
-            
+        // Subscribe to control topic
+        bool subscribed = mqttClient.subscribe(mqttTopicControl, 1);
+        if (subscribed) {
+            LOG_INFO("Subscribed to: %s", mqttTopicControl);
         } else {
-            Serial.print("failed, rc=");
-            Serial.print(mqttClient.state());
-            Serial.println(" try again in 5 seconds");
-            delay(5000);
+            LOG_ERROR("FAILED to subscribe to control topic!");
         }
+        mqttClient.subscribe(mqttTopicAck);
+        otaOnConnected();
+        rulesOnConnected();
+        
+        // Send online notification
+        mqttClient.publish(mqttTopicAvailability, "online", true);
+        LOG_DEBUG("Published online status");
+        
+        bootMark(BOOT_PHASE_MQTT);
+        bootPublishReport();
+        outboxOnConnected();
+        
+    } else {
+        LOG_WARN("MQTT connect failed, rc=%d try again in %d seconds", mqttClient.state(), MQTT_RETRY_INTERVAL / 1000);
     }
 }
 
 void mqttCallback(char* topic, byte* payload, unsigned int length) {
-    Serial.println("\n========================================");
-    Serial.println("=== MQTT MESSAGE RECEIVED ===");
-    Serial.print("Topic: ");
-    Serial.println(topic);
-    Serial.print("Payload length: ");
-    Serial.println(length);
+    LOG_DEBUG("MQTT message on %s (%u bytes)", topic, length);
+    
+    // Firmware chunks are binary, not commands
+    if (strcmp(topic, mqttTopicOta) == 0) {
+        otaHandleChunk(payload, length);
+        return;
+    }
+    if (strcmp(topic, mqttTopicAck) == 0) {
+        outboxHandleAck(payload, length);
+        return;
+    }
+    if (strcmp(topic, mqttTopicRules) == 0) {
+        rulesHandleMessage(payload, length);
+        return;
+    }
+    if (strcmp(topic, mqttTopicControl) != 0) {
+        return;
+    }
     
     String message = "";
     for (int i = 0; i < length; i++) {
         message += (char)payload[i];
     }
-    
-    Serial.print("Message: '");
-    Serial.print(message);
-    Serial.println("'");
-    Serial.print("pumpServiceEnabled BEFORE: ");
-    Serial.println(pumpServiceEnabled);
-    
-    // Declare external functions
-    extern float readSHT31Temperature();
-    extern float readSHT31Humidity();
-    extern int getSoilPercent();
-    extern void sendMQTTStatus(float temp, float humidity, int soilPercent);
-    extern void manualPump();
-    
-    // Handle commands from Discord
-    if (message == "PUMP_ON") {
-        Serial.println(">>> EXECUTING: PUMP_ON");
-        manualPump();
-    } 
-    else if (message == "PUMP_ENABLE") {
-        Serial.println(">>> EXECUTING: PUMP_ENABLE");
-        pumpServiceEnabled = true;
-        digitalWrite(pumpPin, LOW);
-        mqttClient.publish(MQTT_TOPIC_STATUS, "{\"event\":\"pump_enabled\"}");
-        Serial.println("Pump service ENABLED");
-    } 
-    else if (message == "PUMP_DISABLE") {
-        Serial.println(">>> EXECUTING: PUMP_DISABLE");
-        pumpServiceEnabled = false;
-        digitalWrite(pumpPin, LOW);
-        mqttClient.publish(MQTT_TOPIC_STATUS, "{\"event\":\"pump_disabled\"}");
-        Serial.println("Pump service DISABLED - pump stopped");
-    } 
-    else if (message == "STATUS") {
-        Serial.println(">>> EXECUTING: STATUS");
-        float temp = readSHT31Temperature();
-        float humidity = readSHT31Humidity();
-        int soilPercent = getSoilPercent();
-        sendMQTTStatus(temp, humidity, soilPercent);
-    } 
-    else {
-        Serial.print(">>> WARNING: Unknown command: '");
-        Serial.print(message);
-        Serial.println("'");
-    }
-    
-    Serial.print("pumpServiceEnabled AFTER: ");
-    Serial.println(pumpServiceEnabled);
-    Serial.println("========================================\n");
-}
\ No newline at end of file
+    runCommand(message);
+}
@@ -5,27 +5,69 @@
 #include <PubSubClient.h>
 
 #define WIFI_TIMEOUT_MS 20000
+#define WIFI_POLL_MS 100
 
-// MQTT settings
+// MQTT settings. With -DMQTT_TLS the broker is reached over TLS
+// (mqtt_tls.h) with the CA and client certificate from secrets.h; set
+// -DMQTT_BROKER for a broker of your own.
+#ifndef MQTT_BROKER
 #define MQTT_BROKER "broker.hivemq.com"
+#endif
+#ifdef MQTT_TLS
+#define MQTT_PORT 8883
+#else
 #define MQTT_PORT 1883
-#define MQTT_TOPIC_CONTROL "esp32/control"
-#define MQTT_TOPIC_STATUS "esp32/status"
+#endif
+#define MQTT_RETRY_INTERVAL 5000
 
-// LED pin
-#define LED_PIN 2
+// Ping when idle this long. Well inside common NAT and broker idle
+// timeouts, so the connection, and with TLS its session, stays up.
+#define MQTT_KEEPALIVE_S 30
+
+// PubSubClient has no event to wait on; its socket is read this often
+#define MQTT_POLL_MS 20
+
+// Largest publish (the health metrics), header included
+#define MQTT_BUFFER_SIZE 2048
+
+// Topics are growbox/<device id>/<leaf>, built at boot from the efuse MAC
+#define MQTT_TOPIC_ROOT "growbox"
+#define MQTT_TOPIC_MAX 40
+#define DEVICE_ID_LENGTH 12
 
 // Function declarations
+void initDeviceIdentity();
 void connectToWifi();
 void setupMQTT();
 void reconnectMQTT();
+void pollMQTT();
 void mqttCallback(char* topic, byte* payload, unsigned int length);
 String getWifiNetwork();
 String getWifiPassword();
 
+// Publish on growbox/<id>/status and to the web server's LAN clients, once
+// and at once (replies); events go through publishEvent() in outbox.h
+void publishStatus(const char* json, bool retain = false);
+
 // External objects
+#ifdef MQTT_TLS
+#include "mqtt_tls.h"
+extern MqttTlsClient espClient;
+#else
 extern WiFiClient espClient;
+#endif
 extern PubSubClient mqttClient;
 extern bool pumpServiceEnabled;
 
+// Device identity and per-device topics
+extern char deviceId[DEVICE_ID_LENGTH + 1];
+extern char mqttTopicControl[MQTT_TOPIC_MAX];
+extern char mqttTopicStatus[MQTT_TOPIC_MAX];
+extern char mqttTopicMetrics[MQTT_TOPIC_MAX];
+extern char mqttTopicAvailability[MQTT_TOPIC_MAX];
+extern char mqttTopicOta[MQTT_TOPIC_MAX];
+extern char mqttTopicOtaAck[MQTT_TOPIC_MAX];
+extern char mqttTopicAck[MQTT_TOPIC_MAX];
+extern char mqttTopicRules[MQTT_TOPIC_MAX];
+
 #endif
\ No newline at end of file
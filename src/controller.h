@@ -0,0 +1,27 @@
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#include <Arduino.h>
+
+// Sensing and watering state in main.cpp used by the command handler and
+// the OLED pages
+
+extern bool sht31Available;
+extern unsigned long lastPumpTime;
+
+// Publish the latest sample without new sensor conversions
+void sendCachedStatus(const char* requestId);
+
+// Manual dose on one pump; 0 uses the default dose
+void manualPump(uint32_t volumeMl, uint8_t pump = 0);
+
+// Stops every pump
+void stopPump();
+
+// Dose on pump 0 for an automation rule, refused (false) where an
+// automatic run would be
+bool rulePump(uint32_t volumeMl);
+
+unsigned long pumpCooldownRemaining(uint8_t pump);
+
+#endif
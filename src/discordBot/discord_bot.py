@@ -1,109 +1,109 @@
 import discord
 from discord.ext import commands, tasks
 import paho.mqtt.client as mqtt
-import json
+import asyncio
+import time
+import uuid
 from datetime import datetime
 from dotenv import load_dotenv
 import os
 
+from ingest import DeviceStore, EventBatcher, IngestService, MQTT_TOPIC_ROOT
+
 load_dotenv()
 
 # Discord Bot Token
 DISCORD_TOKEN = os.getenv("DISCORD_TOKEN")
 
-# MQTT Settings
-MQTT_BROKER = "broker.hivemq.com"
-MQTT_PORT = 1883
-MQTT_TOPIC_CONTROL = "esp32/control"
-MQTT_TOPIC_STATUS = "esp32/status"
+# How long !status waits for the device to answer
+STATUS_TIMEOUT = 3.0
+
+# Commands that run the pump carry a deadline this many seconds ahead; a
+# box that gets one later (it was offline) drops it
+COMMAND_TTL = 120
+
+# MQTT Settings. Set MQTT_CA_CERT (a PEM file) to connect over TLS, as
+# firmware built with -DMQTT_TLS does; MQTT_CLIENT_CERT/KEY if the broker
+# asks for a client certificate.
+MQTT_BROKER = os.getenv("MQTT_BROKER", "broker.hivemq.com")
+MQTT_CA_CERT = os.getenv("MQTT_CA_CERT")
+MQTT_CLIENT_CERT = os.getenv("MQTT_CLIENT_CERT")
+MQTT_CLIENT_KEY = os.getenv("MQTT_CLIENT_KEY")
+MQTT_PORT = int(os.getenv("MQTT_PORT", 8883 if MQTT_CA_CERT else 1883))
+MQTT_TOPIC_STATUS = f"{MQTT_TOPIC_ROOT}/+/status"
+MQTT_TOPIC_METRICS = f"{MQTT_TOPIC_ROOT}/+/metrics"
+MQTT_TOPIC_AVAILABILITY = f"{MQTT_TOPIC_ROOT}/+/availability"
 
 # Bot setup
 intents = discord.Intents.default()
 intents.message_content = True
 bot = commands.Bot(command_prefix='!', intents=intents)
 
-# Store latest plant status
-plant_status = {
-    "temperature": None,
-    "humidity": None,
-    "soil_moisture": None,
-    "status": None,
-    "pump_enabled": None,
-    "last_update": None
-}
+# Per-device state, batched channel notifications and the MQTT ingest path
+store = DeviceStore()
+batcher = EventBatcher()
+ingest = IngestService(store, batcher)
+
+# Outstanding STATUS requests: request id -> future resolved with the reply
+pending_requests = {}
 
 # MQTT Client
 mqtt_client = mqtt.Client(mqtt.CallbackAPIVersion.VERSION2)
 status_channel_id = None
 
+def control_topic(device_id):
+    return f"{MQTT_TOPIC_ROOT}/{device_id}/control"
+
+def send_command(device_id, command, ttl=None):
+    # QoS 1 into the device's persistent session: a box that is offline
+    # gets the command when it reconnects, unless its deadline has passed
+    if ttl is not None:
+        head, separator, request_id = command.partition(":")
+        command = f"{head}@{int(time.time()) + ttl}{separator}{request_id}"
+    return mqtt_client.publish(control_topic(device_id), command, qos=1)
+
+def on_event_ack(device_id, seq):
+    # The device resends an event until it sees this
+    mqtt_client.publish(f"{MQTT_TOPIC_ROOT}/{device_id}/ack", str(seq))
+
+def resolve_device(device_id):
+    """Pick the target device: the one named, or the only one we know of."""
+    known = store.devices()
+    if device_id:
+        return device_id if device_id in known else None
+    if len(known) == 1:
+        return next(iter(known))
+    return None
+
 def on_mqtt_connect(client, userdata, flags, rc, properties=None):
     print(f"Connected to MQTT broker with code {rc}")
-    client.subscribe(MQTT_TOPIC_STATUS)
-    print(f"Subscribed to topic: {MQTT_TOPIC_STATUS}")
+    for topic in (MQTT_TOPIC_STATUS, MQTT_TOPIC_METRICS, MQTT_TOPIC_AVAILABILITY):
+        client.subscribe(topic)
+        print(f"Subscribed to topic: {topic}")
 
 def on_mqtt_message(client, userdata, msg):
-    global plant_status
-    try:
-        payload = msg.payload.decode()
-        print(f"Raw MQTT payload: {payload}")
-        
-        if payload == "online":
-            print("ESP32 is online!")
-            if status_channel_id:
-                channel = bot.get_channel(status_channel_id)
-                if channel:
-                    bot.loop.create_task(
-                        channel.send("✅ **ESP32 Connected!** Plant monitor is online.")
-                    )
-            return
-        
-        data = json.loads(payload)
-        print(f"Parsed MQTT message: {data}")
-        
-        if "event" in data:
-            # Handle events
-            if data["event"] == "pump_activated":
-                pump_type = data.get("type", "auto")
-                message = f"💧 **Pump Activated!** Your plant has been watered ({'manual' if pump_type == 'manual' else 'automatic'})."
-                if status_channel_id:
-                    channel = bot.get_channel(status_channel_id)
-                    if channel:
-                        bot.loop.create_task(channel.send(message))
-            
-            elif data["event"] == "pump_cooldown":
-                seconds = data.get("seconds", 0)
-                if status_channel_id:
-                    channel = bot.get_channel(status_channel_id)
-                    if channel:
-                        bot.loop.create_task(
-                            channel.send(f"⏳ **Pump on cooldown:** {seconds} seconds remaining. Please wait before watering again.")
-                        )
-            
-            elif data["event"] == "pump_enabled":
-                if status_channel_id:
-                    channel = bot.get_channel(status_channel_id)
-                    if channel:
-                        bot.loop.create_task(channel.send("✅ Pump service enabled"))
-            
-            elif data["event"] == "pump_disabled":
-                if status_channel_id:
-                    channel = bot.get_channel(status_channel_id)
-                    if channel:
-                        bot.loop.create_task(channel.send("🛑 Pump service disabled"))
-        else:
-            # Regular status update
-            plant_status["temperature"] = data.get("temperature")
-            plant_status["humidity"] = data.get("humidity")
-            plant_status["soil_moisture"] = data.get("soil_moisture")
-            plant_status["status"] = data.get("status")
-            plant_status["pump_enabled"] = data.get("pump_enabled", True)
-            plant_status["last_update"] = datetime.now()
-            print(f"Updated plant_status: {plant_status}")
-            
-    except json.JSONDecodeError as e:
-        print(f"JSON decode error: {e}")
-        print(f"Payload was: {msg.payload}")
+    ingest.handle(msg.topic, msg.payload, msg.retain)
 
+def resolve_request(request_id, data):
+    future = pending_requests.pop(request_id, None)
+    if future is not None and not future.done():
+        future.set_result(data)
+
+def on_status_reply(device_id, request_id, data):
+    # Runs on the MQTT network thread; hand over to the bot's event loop
+    bot.loop.call_soon_threadsafe(resolve_request, request_id, data)
+
+ingest.reply_handler = on_status_reply
+ingest.ack_handler = on_event_ack
+
+async def send_batch(text):
+    if status_channel_id:
+        channel = bot.get_channel(status_channel_id)
+        if channel:
+            await channel.send(text)
+
+if MQTT_CA_CERT:
+    mqtt_client.tls_set(ca_certs=MQTT_CA_CERT, certfile=MQTT_CLIENT_CERT, keyfile=MQTT_CLIENT_KEY)
 mqtt_client.on_connect = on_mqtt_connect
 mqtt_client.on_message = on_mqtt_message
 
@@ -113,51 +113,78 @@ async def on_ready():
     mqtt_client.connect(MQTT_BROKER, MQTT_PORT, 60)
     mqtt_client.loop_start()
     print("MQTT client started")
+    bot.loop.create_task(batcher.run(send_batch))
+
+async def send_unknown_device(ctx, device_id):
+    if device_id:
+        await ctx.send(f"❓ Unknown device `{device_id}`. Use `!devices` to list grow boxes.")
+    else:
+        await ctx.send("❓ Several grow boxes are connected, name one: `!<command> <device>`. Use `!devices` to list them.")
+
+@bot.command(name='devices', help='List known grow boxes')
+async def devices(ctx):
+    known = store.devices()
+    if not known:
+        await ctx.send("⏳ No grow boxes seen yet.")
+        return
+    lines = [f"{'🟢' if online else '🔴'} `{device_id}`" for device_id, online in sorted(known.items())]
+    await ctx.send("\n".join(lines))
 
 @bot.command(name='status', help='Get current plant status')
-async def status(ctx):
+async def status(ctx, device_id: str = None):
     global status_channel_id
     status_channel_id = ctx.channel.id
     
-    # Request fresh status
-    mqtt_client.publish(MQTT_TOPIC_CONTROL, "STATUS")
+    target = resolve_device(device_id)
+    if target is None:
+        await send_unknown_device(ctx, device_id)
+        return
+    device_id = target
+    
+    # Request the device's latest sample and wait for the reply carrying our id
+    request_id = uuid.uuid4().hex[:12]
+    future = asyncio.get_running_loop().create_future()
+    pending_requests[request_id] = future
+    send_command(device_id, f"STATUS:{request_id}")
     
-    # Wait up to 3 seconds for response
-    import asyncio
-    for i in range(6):  # 6 attempts, 500ms each = 3 seconds
-        if plant_status["temperature"] is not None:
-            break
-        await asyncio.sleep(0.5)
+    fresh = True
+    try:
+        await asyncio.wait_for(future, STATUS_TIMEOUT)
+    except asyncio.TimeoutError:
+        fresh = False
+    finally:
+        pending_requests.pop(request_id, None)
     
-    if plant_status["temperature"] is None:
+    # The reply has already been stored; on timeout fall back to the last known state
+    device_status = store.latest(device_id)
+    if device_status is None:
         await ctx.send("⏳ Waiting for data from ESP32... Please try again in a moment.")
         return
-    
-    # Rest of your status command code...
-    pump_enabled = plant_status.get("pump_enabled", True)
+
+    pump_enabled = device_status.get("pump_enabled", True)
     pump_status = "🟢 Enabled" if pump_enabled else "🔴 Disabled"
     
     embed = discord.Embed(
-        title="🌱 Plant Monitor Status",
-        color=discord.Color.green() if plant_status["status"] == "OK" else discord.Color.orange(),
-        timestamp=plant_status["last_update"]
+        title=f"🌱 Plant Monitor Status ({device_id})",
+        color=discord.Color.green() if device_status["status"] == "OK" else discord.Color.orange(),
+        timestamp=datetime.fromtimestamp(device_status["last_update"])
     )
     
     embed.add_field(
         name="🌡️ Temperature",
-        value=f"{plant_status['temperature']}°C",
+        value=f"{device_status['temperature']}°C",
         inline=True
     )
     
     embed.add_field(
         name="💨 Humidity",
-        value=f"{plant_status['humidity']}%",
+        value=f"{device_status['humidity']}%",
         inline=True
     )
     
     embed.add_field(
         name="💧 Soil Moisture",
-        value=f"{plant_status['soil_moisture']}%",
+        value=f"{device_status['soil_moisture']}%",
         inline=True
     )
     
@@ -169,7 +196,7 @@ async def status(ctx):
     
     embed.add_field(
         name="📊 Soil Status",
-        value=f"{status_emoji.get(plant_status['status'], '⚪')} {plant_status['status']}",
+        value=f"{status_emoji.get(device_status['status'], '⚪')} {device_status['status']}",
         inline=True
     )
     
@@ -179,25 +206,137 @@ async def status(ctx):
         inline=True
     )
     
-    embed.set_footer(text="Last updated")
+    fault = device_status.get("fault", "none")
+    if fault != "none":
+        embed.add_field(
+            name="🚨 Fault",
+            value=f"{fault}, automatic watering blocked (`!clear_fault`)",
+            inline=False
+        )
+    
+    embed.set_footer(text="Last updated" if fresh else "Device did not answer, last known state from")
     
     await ctx.send(embed=embed)
 
 @bot.command(name='pump_on', help='Enable automatic pump service')
-async def pump_on(ctx):
-    mqtt_client.publish(MQTT_TOPIC_CONTROL, "PUMP_ENABLE")
+async def pump_on(ctx, device_id: str = None):
+    target = resolve_device(device_id)
+    if target is None:
+        await send_unknown_device(ctx, device_id)
+        return
+    send_command(target, "PUMP_ENABLE")
     await ctx.send("✅ **Pump service ENABLED**\nAutomatic watering is now active.")
 
 @bot.command(name='pump_off', help='Disable automatic pump service')
-async def pump_off(ctx):
-    result = mqtt_client.publish(MQTT_TOPIC_CONTROL, "PUMP_DISABLE")
+async def pump_off(ctx, device_id: str = None):
+    target = resolve_device(device_id)
+    if target is None:
+        await send_unknown_device(ctx, device_id)
+        return
+    result = send_command(target, "PUMP_DISABLE")
     print(f"Published PUMP_DISABLE to MQTT, result: {result}")
     await ctx.send("🛑 **Pump service DISABLED**\nAutomatic watering is now turned off.")
 
-@bot.command(name='water', help='Manually trigger the water pump')
-async def water(ctx):
-    mqtt_client.publish(MQTT_TOPIC_CONTROL, "PUMP_ON")
-    await ctx.send("💧 **Manual watering command sent!**\nThe pump will activate if cooldown period has passed.")
+@bot.command(name='water', help='Manually trigger the water pump, optionally with a dose in mL')
+async def water(ctx, volume: str = None, device_id: str = None):
+    if volume is not None and not volume.isdigit():
+        # "!water <device>": dose left out
+        volume, device_id = None, volume
+    target = resolve_device(device_id)
+    if target is None:
+        await send_unknown_device(ctx, device_id)
+        return
+    send_command(target, f"PUMP_ON {volume}" if volume else "PUMP_ON", ttl=COMMAND_TTL)
+    dose = f" ({volume} mL)" if volume else ""
+    await ctx.send(f"💧 **Manual watering command sent{dose}!**\nThe pump will activate if cooldown period has passed.")
+
+@bot.command(name='pump_cal', help='Pump flow calibration: run, <measured mL>, status')
+async def pump_cal(ctx, action: str = "status", device_id: str = None):
+    if action.isdigit():
+        command = f"PUMP_CAL {action}"
+    elif action.lower() in ("run", "status"):
+        command = "PUMP_CAL_RUN" if action.lower() == "run" else "PUMP_CAL_STATUS"
+    else:
+        await ctx.send("❓ Use `!pump_cal run`, then `!pump_cal <mL>` with the measured volume, or `!pump_cal status`.")
+        return
+    target = resolve_device(device_id)
+    if target is None:
+        await send_unknown_device(ctx, device_id)
+        return
+    send_command(target, command, ttl=COMMAND_TTL if command == "PUMP_CAL_RUN" else None)
+    await ctx.send(f"🧪 `{command}` sent to `{target}`, progress follows in the status channel.")
+
+@bot.command(name='ota', help='Firmware update: status, abort (send with tools/ota_patch.py)')
+async def ota(ctx, action: str = "status", device_id: str = None):
+    if action.lower() not in ("status", "abort"):
+        await ctx.send("❓ Use `!ota status` or `!ota abort`; updates are sent with `tools/ota_patch.py send`.")
+        return
+    target = resolve_device(device_id)
+    if target is None:
+        await send_unknown_device(ctx, device_id)
+        return
+    command = f"OTA_{action.upper()}"
+    send_command(target, command)
+    await ctx.send(f"📦 `{command}` sent to `{target}`, the answer follows in the status channel.")
+
+@bot.command(name='clear_fault', help='Clear a latched sensor or pump fault')
+async def clear_fault(ctx, device_id: str = None):
+    target = resolve_device(device_id)
+    if target is None:
+        await send_unknown_device(ctx, device_id)
+        return
+    send_command(target, "FAULT_CLEAR")
+    await ctx.send("🔧 **Fault clear sent.**\nCheck the probe and the water tank first; the fault latches again if the cause remains.")
+
+CALIBRATION_ACTIONS = {"start": "CAL_START", "point": "CAL_POINT", "save": "CAL_SAVE",
+                       "cancel": "CAL_CANCEL", "clear": "CAL_CLEAR", "status": "CAL_STATUS"}
+
+@bot.command(name='calibrate', help='Soil sensor calibration: start [zone], point <percent>, save, cancel, clear [zone], status [zone]')
+async def calibrate(ctx, action: str = "status", value: str = None, device_id: str = None):
+    command = CALIBRATION_ACTIONS.get(action.lower())
+    if command is None:
+        await ctx.send("❓ Use `!calibrate start|point|save|cancel|clear|status`.")
+        return
+    if command in ("CAL_SAVE", "CAL_CANCEL") and device_id is None:
+        # No argument to take, so the second word is the device
+        value, device_id = None, value
+    if command == "CAL_POINT" and (value is None or not value.isdigit()):
+        await ctx.send("❓ Give the sample's moisture: `!calibrate point <percent> [device]`.")
+        return
+    if command != "CAL_POINT" and value is not None and not value.isdigit():
+        # "!calibrate status <device>": zone left out
+        value, device_id = None, value
+    target = resolve_device(device_id)
+    if target is None:
+        await send_unknown_device(ctx, device_id)
+        return
+    send_command(target, f"{command} {value}" if value is not None else command)
+    await ctx.send(f"🧪 `{command}` sent to `{target}`, progress follows in the status channel.")
+
+@bot.command(name='history', help='Min/avg/max over the last N minutes')
+async def history(ctx, device_id: str = None, minutes: int = 60):
+    target = resolve_device(device_id)
+    if target is None:
+        await send_unknown_device(ctx, device_id)
+        return
+    
+    window = store.window(target, minutes * 60)
+    if not window or window["count"] == 0:
+        await ctx.send(f"⏳ No samples from `{target}` in the last {minutes} minutes.")
+        return
+    
+    embed = discord.Embed(
+        title=f"📈 Last {minutes} min ({target}, {window['count']} samples)",
+        color=discord.Color.blue()
+    )
+    labels = {"temperature": "🌡️ Temperature", "humidity": "💨 Humidity", "soil_moisture": "💧 Soil Moisture"}
+    for field, label in labels.items():
+        if field in window:
+            stats = window[field]
+            embed.add_field(name=label, value=f"{stats['min']} / {stats['avg']} / {stats['max']}", inline=True)
+    embed.set_footer(text="min / avg / max")
+    
+    await ctx.send(embed=embed)
 
 @bot.command(name='plant', help='Show all available plant commands')
 async def plant_help(ctx):
@@ -208,29 +347,65 @@ async def plant_help(ctx):
     )
     
     embed.add_field(
-        name="!status",
+        name="!devices",
+        value="List grow boxes and whether they are online",
+        inline=False
+    )
+    
+    embed.add_field(
+        name="!status [device]",
         value="Get current temperature, humidity, and soil moisture",
         inline=False
     )
     
     embed.add_field(
-        name="!water",
-        value="Manually trigger the water pump (one time)",
+        name="!history [device] [minutes]",
+        value="Min, average and max readings over a time window",
+        inline=False
+    )
+    
+    embed.add_field(
+        name="!clear_fault [device]",
+        value="Clear a latched sensor or pump fault",
+        inline=False
+    )
+    
+    embed.add_field(
+        name="!calibrate <action> [value] [device]",
+        value="Guided soil sensor calibration: start [zone], point <percent>, save, cancel, clear [zone], status [zone]",
+        inline=False
+    )
+    
+    embed.add_field(
+        name="!water [mL] [device]",
+        value="Manually trigger the water pump (one time, default dose unless a volume is given)",
+        inline=False
+    )
+    
+    embed.add_field(
+        name="!pump_cal <run|mL|status> [device]",
+        value="Pump flow calibration: `run` pumps for 10 s, then give the measured volume in mL",
         inline=False
     )
     
     embed.add_field(
-        name="!pump_on",
+        name="!pump_on [device]",
         value="Enable automatic pump service",
         inline=False
     )
     
     embed.add_field(
-        name="!pump_off",
+        name="!pump_off [device]",
         value="Disable automatic pump service",
         inline=False
     )
     
+    embed.add_field(
+        name="!ota <status|abort> [device]",
+        value="Firmware version and update state; updates are sent with `tools/ota_patch.py send`",
+        inline=False
+    )
+    
     await ctx.send(embed=embed)
 
 bot.run(DISCORD_TOKEN)
\ No newline at end of file
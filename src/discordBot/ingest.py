@@ -0,0 +1,453 @@
+import asyncio
+import json
+import threading
+import time
+from collections import deque
+
+MQTT_TOPIC_ROOT = "growbox"
+
+# Samples kept per device for window queries (12 h at the 5 s sample interval)
+HISTORY_LENGTH = 8640
+
+# Event seqs remembered per device to drop repeats; well over the
+# device's queue of unacked events
+EVENT_DEDUP_WINDOW = 64
+
+# Discord rejects messages longer than this
+DISCORD_MESSAGE_LIMIT = 2000
+
+SAMPLE_FIELDS = ("temperature", "humidity", "soil_moisture")
+
+
+class DeviceState:
+    __slots__ = ("device_id", "online", "latest", "metrics", "last_update", "history")
+
+    def __init__(self, device_id):
+        self.device_id = device_id
+        self.online = None
+        self.latest = None
+        self.metrics = None
+        self.last_update = None
+        self.history = deque(maxlen=HISTORY_LENGTH)
+
+
+class DeviceStore:
+    """In-memory per-device state, indexed by device id and soil status."""
+
+    def __init__(self):
+        self._lock = threading.Lock()
+        self._devices = {}
+        self._by_status = {}
+
+    def _get(self, device_id):
+        state = self._devices.get(device_id)
+        if state is None:
+            state = DeviceState(device_id)
+            self._devices[device_id] = state
+        return state
+
+    def update_status(self, device_id, data, now=None):
+        now = time.time() if now is None else now
+        with self._lock:
+            state = self._get(device_id)
+            old_status = state.latest.get("status") if state.latest else None
+            new_status = data.get("status")
+            if old_status != new_status:
+                if old_status is not None:
+                    self._by_status.get(old_status, set()).discard(device_id)
+                if new_status is not None:
+                    self._by_status.setdefault(new_status, set()).add(device_id)
+            state.latest = data
+            state.last_update = now
+            if state.online is None:
+                state.online = True
+            state.history.append((now, data.get("temperature"), data.get("humidity"), data.get("soil_moisture")))
+
+    def update_metrics(self, device_id, data):
+        with self._lock:
+            self._get(device_id).metrics = data
+
+    def set_online(self, device_id, online):
+        """Returns the previous online state (None if never seen)."""
+        with self._lock:
+            state = self._get(device_id)
+            previous = state.online
+            state.online = online
+            return previous
+
+    def latest(self, device_id):
+        with self._lock:
+            state = self._devices.get(device_id)
+            if state is None or state.latest is None:
+                return None
+            return dict(state.latest, last_update=state.last_update)
+
+    def metrics(self, device_id):
+        with self._lock:
+            state = self._devices.get(device_id)
+            return state.metrics if state else None
+
+    def devices(self):
+        with self._lock:
+            return {device_id: state.online for device_id, state in self._devices.items()}
+
+    def devices_by_status(self, status):
+        with self._lock:
+            return sorted(self._by_status.get(status, ()))
+
+    def window(self, device_id, seconds, now=None):
+        """Min/max/avg of each sample field over the last `seconds`."""
+        now = time.time() if now is None else now
+        cutoff = now - seconds
+        with self._lock:
+            state = self._devices.get(device_id)
+            if state is None:
+                return None
+            samples = []
+            for sample in reversed(state.history):
+                if sample[0] < cutoff:
+                    break
+                samples.append(sample)
+
+        result = {"count": len(samples)}
+        for index, field in enumerate(SAMPLE_FIELDS, start=1):
+            values = [sample[index] for sample in samples if sample[index] is not None]
+            if values:
+                result[field] = {
+                    "min": min(values),
+                    "max": max(values),
+                    "avg": round(sum(values) / len(values), 2),
+                }
+        return result
+
+
+class EventBatcher:
+    """Coalesces event lines into batched channel messages with rate limiting.
+
+    add() is safe to call from the MQTT network thread; run() drains on the
+    bot's event loop.
+    """
+
+    def __init__(self, interval=2.0, max_messages=5, per_seconds=5.0):
+        self.interval = interval
+        self.max_messages = max_messages
+        self.per_seconds = per_seconds
+        self._lock = threading.Lock()
+        self._pending = deque()
+        self._sent_times = deque()
+        self.lines_batched = 0
+        self.messages_sent = 0
+
+    def add(self, line):
+        with self._lock:
+            self._pending.append(line)
+
+    def _take_batch(self):
+        with self._lock:
+            lines = []
+            length = 0
+            while self._pending:
+                line = self._pending[0]
+                if lines and length + len(line) + 1 > DISCORD_MESSAGE_LIMIT:
+                    break
+                lines.append(self._pending.popleft()[:DISCORD_MESSAGE_LIMIT])
+                length += len(line) + 1
+            return lines
+
+    def _can_send(self, now):
+        while self._sent_times and now - self._sent_times[0] >= self.per_seconds:
+            self._sent_times.popleft()
+        return len(self._sent_times) < self.max_messages
+
+    async def flush(self, send):
+        now = time.monotonic()
+        while self._pending and self._can_send(now):
+            lines = self._take_batch()
+            if not lines:
+                break
+            self._sent_times.append(now)
+            self.lines_batched += len(lines)
+            self.messages_sent += 1
+            await send("\n".join(lines))
+
+    async def run(self, send):
+        while True:
+            await asyncio.sleep(self.interval)
+            await self.flush(send)
+
+
+# Next step of the guided capture, shown after each calibration event
+CALIBRATION_ERRORS = {
+    "no_session": "no calibration in progress, start one with `!calibrate start [zone]`",
+    "bad_zone": "no such zone",
+    "bad_percent": "percent must be 0-100",
+    "too_close": "reading is within noise of an existing point, use a wetter or drier sample",
+    "full": "no room for more points, save or re-capture an existing percent",
+    "too_few_points": "capture at least two points before saving",
+    "not_monotonic": "moisture must rise steadily as the reading falls, re-capture the odd point",
+    "nvs_write": "could not store the table, it is active until the next reboot",
+    "bad_temp": "expected `CAL_TEMP <zone> <slope> <ref>` from tools/soil_tempfit.py",
+}
+
+
+def calibration_message(device_id, data):
+    zone = data.get("zone", 0)
+    state = data.get("state")
+    points = data.get("points", 0)
+    where = f"{device_id} zone {zone}"
+    if state == "started":
+        return (f"🧪 **Calibrating {where}.** Put the sensor in a sample of known moisture and send "
+                f"`!calibrate point <percent>` (dry air is 0, water is 100). "
+                f"Capture two or more points, then `!calibrate save`.")
+    if state == "point":
+        return (f"📍 {where}: raw {data.get('raw')} recorded as {data.get('percent')} % "
+                f"({points} points). Next sample, or `!calibrate save`.")
+    if state == "saved":
+        return f"✅ **{where} calibrated** with {points} points."
+    if state == "cancelled":
+        return f"↩️ Calibration of {where} cancelled, previous table kept."
+    if state == "cleared":
+        return f"🧹 Calibration of {where} cleared, back to air/water defaults."
+    if state == "temp":
+        if not data.get("temp_slope"):
+            return f"🌡️ Temperature compensation off for {where}."
+        return (f"🌡️ Temperature compensation for {where}: {data['temp_slope'] / 256:+.2f} counts/°C "
+                f"around {data.get('temp_ref', 0) / 100:.1f} °C.")
+    if state == "status":
+        table = f"{points}-point table" if data.get("calibrated") else "air/water defaults"
+        comp = f" ({data.get('raw_comp')} compensated)" if data.get("temp_slope") else ""
+        return f"📏 {where}: {table}, now raw {data.get('raw')}{comp} = {data.get('percent')} %"
+    reason = data.get("reason", "unknown")
+    return f"⚠️ Calibration of {where}: {CALIBRATION_ERRORS.get(reason, reason)}"
+
+
+PUMP_CALIBRATION_ERRORS = {
+    "bad_pump": "no such pump",
+    "busy": "the pump is running, try again when it stops",
+    "runtime_cap": "pump runtime cap reached, try again later",
+    "no_run": "run `!pump_cal run` first and measure what it pumps",
+    "bad_volume": "give the measured volume in mL",
+    "flow_out_of_range": "measured flow is implausible, check the volume and repeat the run",
+}
+
+
+def pump_calibration_message(device_id, data):
+    pump = data.get("pump", 0)
+    state = data.get("state")
+    flow = data.get("flow_ml_min")
+    where = f"{device_id} pump {pump}"
+    if state == "running":
+        return (f"🧪 **{where} running for {data.get('run_ms', 0) / 1000:.0f} s.** Catch the water in a "
+                f"measuring jug, then send `!pump_cal <mL>`.")
+    if state == "measure":
+        return f"📏 {where} ran {data.get('run_ms', 0)} ms. Send the measured volume: `!pump_cal <mL>`."
+    if state == "cancelled":
+        return f"↩️ Calibration run of {where} was stopped early, start it again with `!pump_cal run`."
+    if state == "saved":
+        return f"✅ **{where} calibrated:** {flow} mL/min."
+    if state == "status":
+        source = "calibrated" if data.get("calibrated") else "default, not calibrated"
+        return f"💧 {where}: {flow} mL/min ({source})"
+    reason = data.get("reason", "unknown")
+    return f"⚠️ Pump calibration of {where}: {PUMP_CALIBRATION_ERRORS.get(reason, reason)}"
+
+
+OTA_ERRORS = {
+    "unconfirmed": "the running image has not passed its health check yet",
+    "base_mismatch": "the patch was made for a different firmware, build it against the running image",
+    "too_large": "the image does not fit the OTA partition",
+    "hash_mismatch": "the written image does not match the patch",
+    "image_invalid": "the image failed the bootloader checks",
+}
+
+
+def ota_message(device_id, data):
+    state = data.get("state")
+    reason = data.get("reason", "unknown")
+    if state == "ready":
+        return f"📦 {device_id} receiving a {data.get('size', 0) / 1024:.0f} KiB firmware patch into {data.get('partition')}"
+    if state == "rebooting":
+        return f"🔄 **{device_id} firmware verified**, rebooting into {data.get('partition')}"
+    if state == "confirmed":
+        return f"✅ **{device_id} new firmware passed its health check** and is kept"
+    if state == "rolled_back":
+        return f"↩️ **{device_id} firmware update rolled back** ({reason}), running {data.get('partition')} again"
+    if state == "aborted":
+        return f"🛑 Firmware transfer to {device_id} aborted ({reason})"
+    if state == "status":
+        trial = ", on trial" if data.get("trial") else ""
+        return (f"📦 {device_id} runs {data.get('version')} ({data.get('built')}) from {data.get('running')}{trial}; "
+                f"transfer {data.get('transfer')}")
+    return f"⚠️ Firmware update of {device_id} failed: {OTA_ERRORS.get(reason, reason)}"
+
+
+RULE_ACTIONS = {
+    "alert": "alert",
+    "water": "water {arg} mL",
+    "pump_disable": "disable the pump for {arg} min",
+    "pump_enable": "enable the pump",
+}
+
+
+def rule_message(device_id, data):
+    action = data.get("action", "unknown")
+    arg = data.get("arg", 0)
+    text = "disable the pump" if action == "pump_disable" and not arg else RULE_ACTIONS.get(action, action)
+    refused = "" if data.get("done", True) else " (refused: pump disabled, cooling down or blocked)"
+    return f"🤖 {device_id} rule {data.get('id')}: {text.format(arg=arg)}{refused}"
+
+
+def rules_message(device_id, data):
+    state = data.get("state")
+    if state == "loaded":
+        return f"🤖 {device_id} loaded {data.get('count', 0)} automation rules"
+    if state == "cleared":
+        return f"🤖 {device_id} automation rules cleared"
+    if state == "not_stored":
+        return f"⚠️ {device_id} runs {data.get('count', 0)} new rules but could not store them; lost on reboot"
+    return f"⚠️ {device_id} rejected the rule set ({data.get('reason', 'unknown')})"
+
+
+def boot_message(device_id, data):
+    phases = data.get("phases_ms", {})
+
+    def at(name):
+        ms = phases.get(name)
+        return "-" if ms is None else f"{ms:.0f} ms"
+
+    return (f"🔌 {device_id} started: first sample {at('first_sample')}, display {at('display')}, "
+            f"WiFi {at('wifi')}, MQTT {at('mqtt')}")
+
+
+class IngestService:
+    """Parses growbox/<id>/<leaf> messages into the store and event batcher."""
+
+    def __init__(self, store, batcher, reply_handler=None, ack_handler=None):
+        self.store = store
+        self.batcher = batcher
+        # Called as reply_handler(device_id, request_id, data) for status
+        # messages that answer a correlated request
+        self.reply_handler = reply_handler
+        # Called as ack_handler(device_id, seq) for every event carrying a
+        # seq, repeats included; the device resends until it gets one
+        self.ack_handler = ack_handler
+        self.messages = 0
+        self.errors = 0
+        self.duplicates = 0
+        # device id -> (deque, set) of recent event seqs; network thread only
+        self._seen_events = {}
+
+    def handle(self, topic, payload, retained=False):
+        self.messages += 1
+        parts = topic.split("/")
+        if len(parts) != 3 or parts[0] != MQTT_TOPIC_ROOT:
+            return
+        device_id, leaf = parts[1], parts[2]
+        if isinstance(payload, bytes):
+            payload = payload.decode()
+
+        if leaf == "availability":
+            online = payload == "online"
+            previous = self.store.set_online(device_id, online)
+            # Retained messages replay on connect; only announce changes
+            if not retained and previous != online:
+                self.batcher.add(f"✅ **{device_id} Connected!** Plant monitor is online." if online
+                                 else f"⚠️ **{device_id} went offline.**")
+            return
+
+        try:
+            data = json.loads(payload)
+        except json.JSONDecodeError:
+            self.errors += 1
+            return
+
+        if leaf == "metrics":
+            self.store.update_metrics(device_id, data)
+        elif leaf == "status":
+            if "event" in data:
+                if self._is_repeat(device_id, data):
+                    return
+                self._handle_event(device_id, data)
+            elif "samples" in data:
+                # Retained batches replay on every (re)subscribe and were
+                # stored when they first arrived; the next batch is at most
+                # a batch window away
+                if retained:
+                    return
+                # Batch, oldest first, each with its age at publish time
+                now = time.time()
+                for sample in data["samples"]:
+                    age_ms = sample.pop("age_ms", 0)
+                    self.store.update_status(device_id, sample, now - age_ms / 1000)
+            else:
+                request_id = data.pop("req", None)
+                self.store.update_status(device_id, data)
+                if request_id is not None and self.reply_handler:
+                    self.reply_handler(device_id, request_id, data)
+
+    def _is_repeat(self, device_id, data):
+        """Ack an event with a seq; True if it was handled before."""
+        seq = data.pop("seq", None)
+        data.pop("dup", None)
+        if seq is None:
+            return False
+        if self.ack_handler:
+            self.ack_handler(device_id, seq)
+        seen = self._seen_events.get(device_id)
+        if seen is None:
+            seen = (deque(), set())
+            self._seen_events[device_id] = seen
+        order, seqs = seen
+        if seq in seqs:
+            self.duplicates += 1
+            return True
+        order.append(seq)
+        seqs.add(seq)
+        if len(order) > EVENT_DEDUP_WINDOW:
+            seqs.discard(order.popleft())
+        return False
+
+    def _handle_event(self, device_id, data):
+        event = data["event"]
+        if event == "pump_activated":
+            pump_type = "manual" if data.get("type") == "manual" else "automatic"
+            volume = f"{data['ml']} mL, " if "ml" in data else ""
+            pump = f" pump {data['pump']}" if data.get("pump") else ""
+            self.batcher.add(f"💧 **Pump Activated on {device_id}{pump}!** Your plant has been watered ({volume}{pump_type}).")
+        elif event == "pump_cooldown":
+            seconds = data.get("seconds", 0)
+            self.batcher.add(f"⏳ **{device_id} pump on cooldown:** {seconds} seconds remaining. Please wait before watering again.")
+        elif event == "pump_enabled":
+            source = " (rule hold over)" if data.get("source") == "rule" else ""
+            self.batcher.add(f"✅ Pump service enabled on {device_id}{source}")
+        elif event == "pump_disabled":
+            self.batcher.add(f"🛑 Pump service disabled on {device_id}")
+        elif event == "alarm":
+            zone = f", zone {data['zone']}" if "zone" in data else ""
+            if data.get("latched"):
+                self.batcher.add(f"🚨 **{device_id} fault: {data.get('alarm')}** (value {data.get('value')}{zone}). "
+                                 f"Automatic watering is blocked until `!clear_fault`.")
+            else:
+                self.batcher.add(f"⚠️ {device_id} alarm: {data.get('alarm')} (value {data.get('value')}{zone})")
+        elif event == "alarm_cleared":
+            self.batcher.add(f"✅ Fault cleared on {device_id}, automatic watering allowed again")
+        elif event == "command_expired":
+            why = "its clock was not set yet" if data.get("reason") == "no_clock" else "it arrived too late"
+            self.batcher.add(f"⌛ {device_id} dropped `{data.get('command')}`: {why}. Send it again if still needed.")
+        elif event == "pump_blocked":
+            if data.get("reason") == "bad_pump":
+                self.batcher.add(f"🛑 **{device_id} pump blocked:** no such pump on this board.")
+            else:
+                self.batcher.add(f"🛑 **{device_id} pump blocked:** {data.get('reason')} reached.")
+        elif event == "calibration":
+            self.batcher.add(calibration_message(device_id, data))
+        elif event == "pump_calibration":
+            self.batcher.add(pump_calibration_message(device_id, data))
+        elif event == "boot":
+            self.batcher.add(boot_message(device_id, data))
+        elif event == "ota":
+            self.batcher.add(ota_message(device_id, data))
+        elif event == "rule":
+            self.batcher.add(rule_message(device_id, data))
+        elif event == "rules":
+            self.batcher.add(rules_message(device_id, data))
@@ -0,0 +1,138 @@
+"""Simulates a fleet of grow boxes publishing status and measures ingest throughput.
+
+Each simulated device publishes what the firmware's outbox sends: retained
+{"samples":[...]} batches of BATCH_SIZE formatStatus() samples, each with
+its age in ms. By default everything runs in-process against MockBroker,
+so the numbers reported are the cost of the bot-side ingest path (topic
+parsing, JSON decode, store update, event batching), per message and per
+sample.
+
+    python load_generator.py --devices 5000 --rounds 20
+"""
+import argparse
+import asyncio
+import json
+import random
+import time
+
+from ingest import DeviceStore, EventBatcher, IngestService, MQTT_TOPIC_ROOT
+from mock_broker import MockBroker, MockClient
+
+
+# Keep in sync with OUTBOX_BATCH_MAX (outbox.h) and the sample interval
+# in main.cpp
+BATCH_SIZE = 6
+SAMPLE_INTERVAL_MS = 5000
+
+
+def device_id_for(index):
+    return f"{0x240ac4000000 + index:012x}"
+
+
+def status_payload(rng):
+    soil = rng.randint(0, 100)
+    raw = 4095 - soil * 19
+    if soil < 30:
+        status = "DRY"
+    elif soil < 60:
+        status = "OK"
+    else:
+        status = "WET"
+    # Same field order and formatting as formatStatus()
+    return (
+        "{"
+        f"\"temperature\":{rng.uniform(15, 30):.1f},"
+        f"\"humidity\":{rng.uniform(30, 80):.1f},"
+        f"\"soil_moisture\":{soil},"
+        f"\"pump_enabled\":{'true' if rng.random() < 0.5 else 'false'},"
+        f"\"sensor_ok\":true,"
+        f"\"status\":\"{status}\","
+        f"\"soil_moisture_uncomp\":{soil},"
+        f"\"soil_raw\":{raw},"
+        f"\"soil_raw_comp\":{raw},"
+        "\"fault\":\"none\""
+        "}"
+    )
+
+
+def batch_payload(rng, size):
+    # As the outbox builds it: oldest first, ,"age_ms":N before each "}"
+    samples = [f"{status_payload(rng)[:-1]},\"age_ms\":{(size - 1 - i) * SAMPLE_INTERVAL_MS}}}"
+               for i in range(size)]
+    return "{\"samples\":[" + ",".join(samples) + "]}"
+
+
+def run(devices, rounds, batch_size, event_ratio, seed):
+    rng = random.Random(seed)
+    broker = MockBroker()
+    store = DeviceStore()
+    batcher = EventBatcher()
+    ingest = IngestService(store, batcher)
+
+    client = MockClient(broker)
+    client.on_message = lambda c, userdata, msg: ingest.handle(msg.topic, msg.payload, msg.retain)
+    client.connect()
+    for leaf in ("status", "metrics", "availability"):
+        client.subscribe(f"{MQTT_TOPIC_ROOT}/+/{leaf}")
+
+    ids = [device_id_for(i) for i in range(devices)]
+    for device_id in ids:
+        broker.publish(f"{MQTT_TOPIC_ROOT}/{device_id}/availability", "online", retain=True)
+
+    # Pre-generate payloads so the timed section measures ingest only
+    messages = []
+    samples = 0
+    for _ in range(rounds):
+        for device_id in ids:
+            topic = f"{MQTT_TOPIC_ROOT}/{device_id}/status"
+            if rng.random() < event_ratio:
+                messages.append((topic, json.dumps({"event": "pump_activated", "ml": 75, "ms": 3000, "width_err_us": 40}).encode(), False))
+            else:
+                messages.append((topic, batch_payload(rng, batch_size).encode(), True))
+                samples += batch_size
+
+    start = time.perf_counter()
+    for topic, payload, retain in messages:
+        broker.publish(topic, payload, retain=retain)
+    elapsed = time.perf_counter() - start
+
+    sent = []
+
+    async def drain():
+        async def send(text):
+            sent.append(text)
+        while batcher._pending:
+            batcher._sent_times.clear()
+            await batcher.flush(send)
+
+    asyncio.run(drain())
+
+    query_start = time.perf_counter()
+    for device_id in ids:
+        store.window(device_id, 3600)
+    query_elapsed = time.perf_counter() - query_start
+
+    print(f"devices:            {devices}")
+    print(f"messages ingested:  {len(messages)} ({samples} samples)")
+    print(f"ingest time:        {elapsed:.3f} s")
+    print(f"ingest throughput:  {len(messages) / elapsed:,.0f} msg/s, {samples / elapsed:,.0f} samples/s")
+    print(f"per message:        {elapsed / len(messages) * 1e6:.1f} us")
+    print(f"parse errors:       {ingest.errors}")
+    print(f"event lines:        {batcher.lines_batched} in {batcher.messages_sent} channel messages")
+    print(f"DRY devices:        {len(store.devices_by_status('DRY'))}")
+    print(f"window query:       {query_elapsed / devices * 1e6:.1f} us/device")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--devices", type=int, default=1000)
+    parser.add_argument("--rounds", type=int, default=10, help="status messages per device")
+    parser.add_argument("--batch", type=int, default=BATCH_SIZE, help="samples per status message")
+    parser.add_argument("--event-ratio", type=float, default=0.01, help="fraction of messages that are pump events")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+    run(args.devices, args.rounds, args.batch, args.event_ratio, args.seed)
+
+
+if __name__ == "__main__":
+    main()
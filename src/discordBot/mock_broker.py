@@ -0,0 +1,113 @@
+"""In-process MQTT stand-in for running the ingest path without a real broker.
+
+MockClient implements the subset of paho.mqtt.client.Client the bot uses,
+so it can be swapped in for tests and load generation.
+"""
+import threading
+
+
+def topic_matches(pattern, topic):
+    pattern_parts = pattern.split("/")
+    topic_parts = topic.split("/")
+    for index, part in enumerate(pattern_parts):
+        if part == "#":
+            return True
+        if index >= len(topic_parts):
+            return False
+        if part != "+" and part != topic_parts[index]:
+            return False
+    return len(pattern_parts) == len(topic_parts)
+
+
+class MockMessage:
+    __slots__ = ("topic", "payload", "retain", "qos")
+
+    def __init__(self, topic, payload, retain=False, qos=0):
+        self.topic = topic
+        self.payload = payload
+        self.retain = retain
+        self.qos = qos
+
+
+class MockBroker:
+    def __init__(self):
+        self._lock = threading.Lock()
+        self._subscriptions = []
+        self._retained = {}
+        self.published = 0
+
+    def subscribe(self, client, pattern):
+        with self._lock:
+            self._subscriptions.append((pattern, client))
+            retained = [(topic, payload) for topic, payload in self._retained.items()
+                        if topic_matches(pattern, topic)]
+        for topic, payload in retained:
+            client._deliver(MockMessage(topic, payload, retain=True))
+
+    def unsubscribe_all(self, client):
+        with self._lock:
+            self._subscriptions = [(p, c) for p, c in self._subscriptions if c is not client]
+
+    def publish(self, topic, payload, retain=False, qos=0):
+        if isinstance(payload, str):
+            payload = payload.encode()
+        with self._lock:
+            self.published += 1
+            if retain:
+                if payload:
+                    self._retained[topic] = payload
+                else:
+                    self._retained.pop(topic, None)
+            targets = [client for pattern, client in self._subscriptions if topic_matches(pattern, topic)]
+        for client in targets:
+            client._deliver(MockMessage(topic, payload, qos=qos))
+
+
+class MockPublishResult:
+    rc = 0
+
+    def wait_for_publish(self, timeout=None):
+        return True
+
+
+class MockClient:
+    def __init__(self, broker, *args, **kwargs):
+        self.broker = broker
+        self.on_connect = None
+        self.on_message = None
+        self._will = None
+        self._connected = False
+
+    def will_set(self, topic, payload=None, qos=0, retain=False):
+        self._will = (topic, payload, qos, retain)
+
+    def connect(self, host=None, port=None, keepalive=60):
+        self._connected = True
+        if self.on_connect:
+            self.on_connect(self, None, {}, 0, None)
+        return 0
+
+    def disconnect(self, unexpected=False):
+        self.broker.unsubscribe_all(self)
+        self._connected = False
+        if unexpected and self._will:
+            topic, payload, qos, retain = self._will
+            self.broker.publish(topic, payload, retain=retain, qos=qos)
+
+    def loop_start(self):
+        pass
+
+    def loop_stop(self):
+        pass
+
+    def subscribe(self, topic, qos=0):
+        self.broker.subscribe(self, topic)
+        return (0, 1)
+
+    def publish(self, topic, payload=None, qos=0, retain=False):
+        self.broker.publish(topic, payload or b"", retain=retain, qos=qos)
+        return MockPublishResult()
+
+    def _deliver(self, message):
+        if self._connected and self.on_message:
+            self.on_message(self, None, message)
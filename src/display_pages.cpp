@@ -0,0 +1,217 @@
+#include "display_pages.h"
+#include "display_scheduler.h"
+#include "connectToWifi.h"
+#include <oled_ssd1306.h>
+#include <oled_widgets.h>
+#include <oled_trend.h>
+#include <oled_font.h>
+#include "fonts/TomThumbAtlas.h"
+#include "fixed_point.h"
+#include "safety.h"
+#include "controller.h"
+
+enum {
+    PAGE_LIVE = 0,
+    PAGE_TREND,
+    PAGE_PUMP,
+    PAGE_NETWORK
+};
+
+static int32_t sampleTempCenti = 0;
+static int32_t sampleHumidityCenti = 0;
+static int sampleSoil = 0;
+
+// Live values: labels are drawn once, updates repaint only the changed
+// character cells and gauge columns
+static const oled_label_t liveLabels[] = {
+    {0, 0, "Temp:"}, {72, 0, "C"},
+    {0, 12, "Hum:"}, {66, 12, "%"},
+    {0, 24, "Soil:"}, {60, 24, "%"},
+    {0, 50, "Status:"},
+};
+static oled_field_t tempField = {36, 0, 6};
+static oled_field_t humidityField = {30, 12, 6};
+static oled_field_t soilField = {36, 24, 4};
+static oled_field_t statusField = {48, 50, 3};
+static oled_gauge_t soilGauge = {0, 36, 100, 8};
+
+static void showLivePage() {
+    for (const oled_label_t& label : liveLabels) {
+        oled_label_draw(&label);
+    }
+    oled_field_init(&tempField);
+    oled_field_init(&humidityField);
+    oled_field_init(&soilField);
+    oled_field_init(&statusField);
+    oled_gauge_init(&soilGauge);
+}
+
+static void updateLivePage() {
+    oled_field_set_fixed(&tempField, sampleTempCenti, FIXED_CENTI, 1);
+    oled_field_set_fixed(&humidityField, sampleHumidityCenti, FIXED_CENTI, 1);
+    oled_field_set_int(&soilField, sampleSoil);
+    oled_gauge_set(&soilGauge, sampleSoil);
+
+    if (sampleSoil < 30) {
+        oled_field_set_text(&statusField, "DRY");
+    } else if (sampleSoil < 60) {
+        oled_field_set_text(&statusField, "OK");
+    } else {
+        oled_field_set_text(&statusField, "WET");
+    }
+}
+
+// Trends: three sparklines, 30 s per column (about 54 minutes)
+const uint16_t TREND_SAMPLES_PER_COLUMN = 6;
+
+static oled_sparkline_t soilTrend = {20, 0, 108, 16, 0, 100, TREND_SAMPLES_PER_COLUMN};
+static oled_sparkline_t tempTrend = {20, 16, 108, 16, 0, 400, TREND_SAMPLES_PER_COLUMN};      // 0.1 C
+static oled_sparkline_t humidityTrend = {20, 32, 108, 16, 0, 100, TREND_SAMPLES_PER_COLUMN};
+
+static void showTrendPage() {
+    oled_print(0, 4, "SOI");
+    oled_print(0, 20, "TMP");
+    oled_print(0, 36, "HUM");
+    oled_font_print(&TomThumbAtlas, 0, 57, "30 s/column  temp 0-40 °C");
+    oled_sparkline_redraw(&soilTrend);
+    oled_sparkline_redraw(&tempTrend);
+    oled_sparkline_redraw(&humidityTrend);
+}
+
+static void updateTrendPage() {
+    // Columns are drawn as samples arrive in displayPagesOnSample()
+}
+
+// Pump status
+static const oled_label_t pumpLabels[] = {
+    {0, 0, "PUMP"},
+    {0, 12, "AUTO:"},
+    {0, 24, "LAST:"},
+    {0, 36, "COOL:"},
+    {0, 48, "SHT31:"},
+};
+static oled_field_t pumpAutoField = {36, 12, 3};
+static oled_field_t pumpLastField = {36, 24, 10};
+static oled_field_t pumpCooldownField = {36, 36, 6};
+static oled_field_t sensorField = {42, 48, 5};
+
+static void showPumpPage() {
+    for (const oled_label_t& label : pumpLabels) {
+        oled_label_draw(&label);
+    }
+    oled_field_init(&pumpAutoField);
+    oled_field_init(&pumpLastField);
+    oled_field_init(&pumpCooldownField);
+    oled_field_init(&sensorField);
+}
+
+static void updatePumpPage() {
+    char buffer[16];
+    unsigned long now = millis();
+
+    if (safetyFaultLatched()) {
+        oled_field_set_text(&pumpAutoField, "FLT");
+    } else {
+        oled_field_set_text(&pumpAutoField, pumpServiceEnabled ? "ON" : "OFF");
+    }
+
+    if (lastPumpTime == 0) {
+        oled_field_set_text(&pumpLastField, "NEVER");
+    } else {
+        snprintf(buffer, sizeof(buffer), "%luS AGO", (now - lastPumpTime) / 1000);
+        oled_field_set_text(&pumpLastField, buffer);
+    }
+
+    unsigned long cooldown = pumpCooldownRemaining(0);
+    if (cooldown != 0) {
+        snprintf(buffer, sizeof(buffer), "%luS", (cooldown + 999) / 1000);
+        oled_field_set_text(&pumpCooldownField, buffer);
+    } else {
+        oled_field_set_text(&pumpCooldownField, "READY");
+    }
+
+    oled_field_set_text(&sensorField, sht31Available ? "OK" : "FAULT");
+}
+
+// Network and health
+static const oled_label_t networkLabels[] = {
+    {0, 0, "ID:"},
+    {0, 10, "WIFI:"},
+    {0, 20, "IP:"},
+    {0, 30, "MQTT:"},
+    {0, 40, "UP:"},
+    {0, 50, "HEAP:"},
+};
+static oled_field_t idField = {24, 0, 12};
+static oled_field_t wifiField = {36, 10, 6};
+static oled_field_t ipField = {24, 20, 15};
+static oled_field_t mqttField = {36, 30, 4};
+static oled_field_t uptimeField = {24, 40, 10};
+static oled_field_t heapField = {36, 50, 8};
+
+static void showNetworkPage() {
+    for (const oled_label_t& label : networkLabels) {
+        oled_label_draw(&label);
+    }
+    oled_field_init(&idField);
+    oled_field_init(&wifiField);
+    oled_field_init(&ipField);
+    oled_field_init(&mqttField);
+    oled_field_init(&uptimeField);
+    oled_field_init(&heapField);
+}
+
+static void updateNetworkPage() {
+    char buffer[16];
+
+    // The 5x7 font has no lowercase
+    for (uint8_t i = 0; i <= DEVICE_ID_LENGTH; i++) {
+        buffer[i] = toupper(deviceId[i]);
+    }
+    oled_field_set_text(&idField, buffer);
+
+    if (WiFi.status() == WL_CONNECTED) {
+        snprintf(buffer, sizeof(buffer), "%dDB", WiFi.RSSI());
+        oled_field_set_text(&wifiField, buffer);
+        oled_field_set_text(&ipField, WiFi.localIP().toString().c_str());
+    } else {
+        oled_field_set_text(&wifiField, "DOWN");
+        oled_field_set_text(&ipField, "-");
+    }
+
+    oled_field_set_text(&mqttField, mqttClient.connected() ? "UP" : "DOWN");
+
+    snprintf(buffer, sizeof(buffer), "%luS", millis() / 1000);
+    oled_field_set_text(&uptimeField, buffer);
+
+    snprintf(buffer, sizeof(buffer), "%lu", (unsigned long)ESP.getFreeHeap());
+    oled_field_set_text(&heapField, buffer);
+}
+
+// Same order as the PAGE_ enum
+static const DisplayPage displayPages[] = {
+    {showLivePage, updateLivePage, 10000, 0},
+    {showTrendPage, updateTrendPage, 10000, 0},
+    {showPumpPage, updatePumpPage, 5000, 1000},
+    {showNetworkPage, updateNetworkPage, 5000, 1000},
+};
+
+void initDisplayPages() {
+    oled_sparkline_init(&soilTrend);
+    oled_sparkline_init(&tempTrend);
+    oled_sparkline_init(&humidityTrend);
+    initDisplayScheduler(displayPages, sizeof(displayPages) / sizeof(displayPages[0]));
+}
+
+void displayPagesOnSample(int32_t tempCenti, int32_t humidityCenti, int soilPercent) {
+    sampleTempCenti = tempCenti;
+    sampleHumidityCenti = humidityCenti;
+    sampleSoil = soilPercent;
+
+    bool trendVisible = displayCurrentPage() == PAGE_TREND && displayPowerState() != DISPLAY_OFF;
+    oled_sparkline_add(&soilTrend, soilPercent, trendVisible);
+    oled_sparkline_add(&tempTrend, tempCenti / 10, trendVisible);
+    oled_sparkline_add(&humidityTrend, humidityCenti / 100, trendVisible);
+
+    displayRequestUpdate();
+}
@@ -0,0 +1,13 @@
+#ifndef DISPLAY_PAGES_H
+#define DISPLAY_PAGES_H
+
+#include <stdint.h>
+
+// Register the OLED pages (live values, trends, pump, network/health)
+// with the display scheduler
+void initDisplayPages();
+
+// Feed a new sensor sample to the pages (centi-degrees, centi-%RH)
+void displayPagesOnSample(int32_t tempCenti, int32_t humidityCenti, int soilPercent);
+
+#endif
@@ -0,0 +1,115 @@
+#include "display_scheduler.h"
+#include "logger.h"
+#include <oled_ssd1306.h>
+
+static const DisplayPage* displayPages = NULL;
+static uint8_t displayPageCount = 0;
+static uint8_t currentPage = 0;
+
+static unsigned long pageStart = 0;
+static unsigned long lastRefresh = 0;
+static unsigned long lastActivity = 0;
+
+static bool pageNeedsShow = true;
+static bool updatePending = false;
+static DisplayPower powerState = DISPLAY_ACTIVE;
+
+void initDisplayScheduler(const DisplayPage* pages, uint8_t count) {
+    displayPages = pages;
+    displayPageCount = count;
+    currentPage = 0;
+    pageNeedsShow = true;
+
+    unsigned long now = millis();
+    pageStart = now;
+    lastActivity = now;
+}
+
+static void setPowerState(DisplayPower state) {
+    if (state == powerState) {
+        return;
+    }
+
+    if (state == DISPLAY_OFF) {
+        oled_set_power(false);
+    } else {
+        if (powerState == DISPLAY_OFF) {
+            oled_set_power(true);
+        }
+        oled_set_contrast(state == DISPLAY_DIMMED ? DISPLAY_CONTRAST_DIM : DISPLAY_CONTRAST_ACTIVE);
+    }
+
+    LOG_DEBUG("Display power %d -> %d", powerState, state);
+    powerState = state;
+}
+
+void displaySchedulerTick() {
+    if (displayPageCount == 0) {
+        return;
+    }
+
+    unsigned long now = millis();
+
+    unsigned long idle = now - lastActivity;
+    if (idle >= DISPLAY_OFF_AFTER_MS) {
+        setPowerState(DISPLAY_OFF);
+    } else if (idle >= DISPLAY_DIM_AFTER_MS) {
+        setPowerState(DISPLAY_DIMMED);
+    }
+
+    // Nothing to show while the panel is off; catch up on wake
+    if (powerState == DISPLAY_OFF) {
+        return;
+    }
+
+    if (displayPageCount > 1 && now - pageStart >= displayPages[currentPage].durationMs) {
+        currentPage = (currentPage + 1) % displayPageCount;
+        pageStart = now;
+        pageNeedsShow = true;
+    }
+
+    const DisplayPage& page = displayPages[currentPage];
+
+    if (pageNeedsShow) {
+        oled_clear();
+        page.show();
+        page.update();
+        oled_display();
+        pageNeedsShow = false;
+        updatePending = false;
+        lastRefresh = now;
+        return;
+    }
+
+    if (updatePending || (page.refreshMs != 0 && now - lastRefresh >= page.refreshMs)) {
+        page.update();
+        updatePending = false;
+        lastRefresh = now;
+    }
+
+    // Unchanged frame: no dirty rects, no bus traffic
+    const oled_rect_t* rects;
+    if (oled_get_dirty_rects(&rects) != 0) {
+        oled_display_dirty();
+    }
+}
+
+void displayRequestUpdate() {
+    updatePending = true;
+}
+
+void displayWake() {
+    lastActivity = millis();
+    if (powerState == DISPLAY_OFF) {
+        pageNeedsShow = true;
+    }
+    setPowerState(DISPLAY_ACTIVE);
+}
+
+uint8_t displayCurrentPage() {
+    return currentPage;
+}
+
+DisplayPower displayPowerState() {
+    return powerState;
+}
@@ -0,0 +1,46 @@
+#ifndef DISPLAY_SCHEDULER_H
+#define DISPLAY_SCHEDULER_H
+
+#include <Arduino.h>
+
+// Frame period; at most one flush to the panel per tick
+#define DISPLAY_MIN_FRAME_MS 200
+
+// Display power management
+#define DISPLAY_CONTRAST_ACTIVE 0xCF
+#define DISPLAY_CONTRAST_DIM 0x08
+#define DISPLAY_DIM_AFTER_MS 120000
+#define DISPLAY_OFF_AFTER_MS 600000
+
+struct DisplayPage {
+    void (*show)();         // draw the whole page into the cleared framebuffer
+    void (*update)();       // redraw changed parts, marking dirty rects
+    uint32_t durationMs;    // time on screen before rotating
+    uint32_t refreshMs;     // periodic update while shown, 0 = only on new data
+};
+
+enum DisplayPower {
+    DISPLAY_ACTIVE = 0,
+    DISPLAY_DIMMED,
+    DISPLAY_OFF
+};
+
+// Start rotating through the pages
+void initDisplayScheduler(const DisplayPage* pages, uint8_t count);
+
+// Rotate, refresh and flush changes. Run every DISPLAY_MIN_FRAME_MS from
+// the display timer, which caps the frame rate.
+void displaySchedulerTick();
+
+// New data for the current page; it is redrawn on the next frame
+void displayRequestUpdate();
+
+// Restore full brightness after an event (watering, alarm, command)
+void displayWake();
+
+// Index of the page on screen
+uint8_t displayCurrentPage();
+
+DisplayPower displayPowerState();
+
+#endif
@@ -0,0 +1,50 @@
+#include "fixed_point.h"
+
+static const uint32_t pow10_table[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000};
+
+uint8_t fixed_format(char *out, int32_t value, uint8_t frac_digits, uint8_t decimals) {
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    char digits[FIXED_FORMAT_MAX];
+    uint8_t count = 0;
+    uint8_t emitted = 0;
+    uint8_t len = 0;
+
+    if (frac_digits > 7) frac_digits = 7;
+    if (decimals > frac_digits) decimals = frac_digits;
+
+    uint32_t divisor = pow10_table[frac_digits - decimals];
+    if (divisor > 1) {
+        magnitude = (magnitude + divisor / 2) / divisor;
+    }
+
+    // Least significant digit first; at least one integer digit
+    do {
+        if (decimals != 0 && emitted == decimals) {
+            digits[count++] = '.';
+        }
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+        emitted++;
+    } while (magnitude != 0 || emitted <= decimals);
+
+    // No "-0.0" for values that round to zero
+    if (value < 0) {
+        for (uint8_t i = 0; i < count; i++) {
+            if (digits[i] > '0') {
+                out[len++] = '-';
+                break;
+            }
+        }
+    }
+
+    while (count > 0) {
+        out[len++] = digits[--count];
+    }
+    out[len] = '\0';
+    return len;
+}
+
+int32_t fixed_from_float(float value, uint8_t frac_digits) {
+    float scaled = value * (float)pow10_table[frac_digits > 7 ? 7 : frac_digits];
+    return (int32_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+}
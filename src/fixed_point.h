@@ -0,0 +1,32 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+// Scaled-integer sensor values and a decimal formatter shared by the OLED
+// driver and the telemetry encoder, so the sensor -> control -> display ->
+// MQTT path needs no float math or printf-family float formatting
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Centi-units: 2345 = 23.45 (degrees C, %RH, % soil)
+#define FIXED_CENTI 2
+
+// Longest output of fixed_format(), including the terminator
+#define FIXED_FORMAT_MAX 13
+
+// Write `value` (with `frac_digits` implied decimals) as text with
+// `decimals` decimals, rounding half away from zero. Returns the length.
+uint8_t fixed_format(char *out, int32_t value, uint8_t frac_digits, uint8_t decimals);
+
+// Float to scaled integer, for the API edges (sensor libraries, callers
+// that still pass float)
+int32_t fixed_from_float(float value, uint8_t frac_digits);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
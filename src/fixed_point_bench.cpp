@@ -0,0 +1,55 @@
+#ifdef FIXED_POINT_BENCH
+
+#include <Arduino.h>
+#include "fixed_point.h"
+#include "logger.h"
+
+// Formatting cost of one sensor cycle in CPU cycles, float path vs the
+// fixed-point path. Build with -DFIXED_POINT_BENCH (env:esp32dev_bench).
+
+static const int BENCH_ITERATIONS = 1000;
+
+static volatile uint32_t benchSink = 0;
+
+// What a cycle used to do: String(float, 1) twice for the MQTT payload and
+// a runtime format string plus sprintf twice for the OLED
+static void floatCycle(float temp, float humidity) {
+    String tempText = String(temp, 1);
+    String humidityText = String(humidity, 1);
+    char format[10];
+    char buffer[20];
+    sprintf(format, "%%.%df", 1);
+    sprintf(buffer, format, temp);
+    benchSink += buffer[0];
+    sprintf(format, "%%.%df", 1);
+    sprintf(buffer, format, humidity);
+    benchSink += buffer[0] + tempText.length() + humidityText.length();
+}
+
+// The same work now: one conversion at the sensor edge, shared formatter
+static void fixedCycle(float temp, float humidity) {
+    int32_t tempCenti = fixed_from_float(temp, FIXED_CENTI);
+    int32_t humidityCenti = fixed_from_float(humidity, FIXED_CENTI);
+    char buffer[FIXED_FORMAT_MAX];
+    benchSink += fixed_format(buffer, tempCenti, FIXED_CENTI, 1);
+    benchSink += fixed_format(buffer, humidityCenti, FIXED_CENTI, 1);
+    benchSink += fixed_format(buffer, tempCenti, FIXED_CENTI, 1);
+    benchSink += fixed_format(buffer, humidityCenti, FIXED_CENTI, 1);
+}
+
+static uint32_t cyclesPerIteration(void (*cycle)(float, float)) {
+    uint32_t start = ESP.getCycleCount();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        cycle(15.0f + (i % 200) * 0.07f, 40.0f + (i % 300) * 0.13f);
+    }
+    return (ESP.getCycleCount() - start) / BENCH_ITERATIONS;
+}
+
+void runFixedPointBench() {
+    uint32_t floatCycles = cyclesPerIteration(floatCycle);
+    uint32_t fixedCycles = cyclesPerIteration(fixedCycle);
+    LOG_INFO("Format bench per sensor cycle: float %lu cycles, fixed-point %lu cycles @ %lu MHz",
+             (unsigned long)floatCycles, (unsigned long)fixedCycles, (unsigned long)getCpuFrequencyMhz());
+}
+
+#endif
@@ -0,0 +1,262 @@
+// Generated by tools/fontconv.py from TomThumb.h (extended); do not edit
+
+#include "TomThumbAtlas.h"
+
+static const uint8_t TomThumbAtlasBitmap[] = {
+    0xEE, 0x7F, 0x57, 0xD5, 0xFA, 0x48, 0x89, 0xF7, 0x4F, 0xBA, 0x31, 0x75,
+    0x55, 0x74, 0xDE, 0x32, 0x61, 0xF1, 0xF2, 0x3F, 0x3A, 0xA6, 0x35, 0x57,
+    0x09, 0xFE, 0xD6, 0x4F, 0xAD, 0xE7, 0x4C, 0x7E, 0xBF, 0xED, 0x7D, 0x46,
+    0x88, 0xA8, 0xDB, 0x62, 0xA2, 0x42, 0xB8, 0x75, 0x5A, 0xFA, 0x3F, 0xF5,
+    0x53, 0xA3, 0x1F, 0xC5, 0xDF, 0xAD, 0x7F, 0x4A, 0x3A, 0xB7, 0xF9, 0x3F,
+    0x1F, 0xC4, 0x41, 0xF7, 0xC9, 0xBF, 0x84, 0x3F, 0x67, 0xFE, 0xEF, 0xBA,
+    0x2E, 0xFD, 0x10, 0xE9, 0xBF, 0xF6, 0x6A, 0x6B, 0x28, 0x7E, 0x1E, 0x0F,
+    0xF8, 0x3E, 0x7C, 0xDF, 0xD9, 0x37, 0x83, 0xE2, 0x75, 0xCF, 0xE3, 0x18,
+    0x8C, 0x63, 0xF6, 0x66, 0xF5, 0xFE, 0x93, 0x34, 0xC9, 0x93, 0xF6, 0xBD,
+    0x23, 0xE8, 0xCA, 0xFB, 0xE8, 0x3D, 0xC2, 0x06, 0xEF, 0x99, 0x31, 0xF8,
+    0x7F, 0xBF, 0xE1, 0xDA, 0x5B, 0xF2, 0x63, 0x25, 0xF7, 0x88, 0x5F, 0xA4,
+    0x7D, 0x3C, 0x3F, 0xC7, 0xDE, 0xFF, 0x2D, 0x38, 0x2F, 0xAF, 0xF4, 0x9B,
+    0x8E, 0xE3, 0xB2, 0x3C, 0xED, 0xA8, 0xBF, 0xAD, 0x5D, 0x5D, 0x1F, 0x45,
+    0xDD, 0x2A, 0xB5, 0xB5, 0xEA, 0xB5, 0xFF, 0x15, 0x52, 0x7A, 0x99, 0xCD,
+    0xFF, 0xE2, 0xE2, 0x2F, 0xFF, 0xF9, 0xAB, 0xA6, 0xA9, 0xAB, 0x02, 0x1E,
+    0x86, 0x1C, 0x68, 0x63, 0xA8, 0x47, 0x65, 0xAE, 0xC3, 0x9D, 0xA6, 0xBF,
+    0x4E, 0xEA, 0xBF, 0xF4, 0x77, 0xFE, 0xAC, 0x4B, 0x31, 0xEE, 0xD7, 0xDC,
+    0xB7, 0xBD, 0x6E, 0x7A, 0x96, 0xED, 0x6D, 0xCB, 0x5B, 0xD6, 0xA7, 0xAF,
+    0xEA, 0xEB, 0xE9, 0xE7, 0xAB, 0xDF, 0x53, 0xDE, 0xB7, 0xBF, 0x5F, 0x72,
+    0xDD, 0xF5, 0xF5, 0xD2, 0x73, 0xA6, 0xF7, 0x8D, 0xEE, 0x1B, 0x99, 0x76,
+    0xFA, 0x9C, 0xFD, 0x5A, 0x0E, 0xAF, 0x5D, 0x4F, 0x3A, 0xDD, 0x7D, 0xBC,
+    0xCB, 0x71, 0xF7, 0xEF, 0xFC, 0x8A, 0xD8, 0x57, 0x7A, 0xAE, 0x79, 0x5E,
+    0xF2, 0x3D, 0xEE, 0x84, 0x5E, 0x17, 0x84, 0x0F, 0x05, 0x76, 0xF7, 0xE2,
+    0xC5, 0x55, 0x2A, 0xA2, 0x95, 0x65, 0x2E, 0xAA, 0x45, 0x91, 0x2A, 0x47,
+    0xDE, 0xB2, 0x4E, 0x64, 0xDE, 0xD1, 0xBD, 0x83, 0x72, 0x15, 0xBB, 0xEA,
+    0x25, 0x02, 0xDC, 0xEF, 0xD5, 0xFF, 0x6A, 0xFD, 0x50, 0x74, 0xDB, 0xFA,
+    0xEF, 0xF7, 0xF1, 0xF8,
+};
+
+/* {bit offset, width << 4 | height, advance, x offset, y offset} */
+static const oled_glyph_t TomThumbAtlasGlyphs[] = {
+    {0, 0x00, 2, 0, -5},         /* 0x0020 space */
+    {0, 0x15, 2, 0, -5},         /* 0x0021 exclam */
+    {5, 0x32, 4, 0, -5},         /* 0x0022 quotedbl */
+    {11, 0x35, 4, 0, -5},        /* 0x0023 numbersign */
+    {26, 0x35, 4, 0, -5},        /* 0x0024 dollar */
+    {41, 0x35, 4, 0, -5},        /* 0x0025 percent */
+    {56, 0x35, 4, 0, -5},        /* 0x0026 ampersand */
+    {71, 0x12, 2, 0, -5},        /* 0x0027 quotesingle */
+    {73, 0x25, 3, 0, -5},        /* 0x0028 parenleft */
+    {83, 0x25, 3, 0, -5},        /* 0x0029 parenright */
+    {93, 0x33, 4, 0, -5},        /* 0x002A asterisk */
+    {102, 0x33, 4, 0, -4},       /* 0x002B plus */
+    {111, 0x22, 3, 0, -2},       /* 0x002C comma */
+    {115, 0x31, 4, 0, -3},       /* 0x002D hyphen */
+    {118, 0x11, 2, 0, -1},       /* 0x002E period */
+    {119, 0x35, 4, 0, -5},       /* 0x002F slash */
+    {134, 0x35, 4, 0, -5},       /* 0x0030 zero */
+    {149, 0x25, 3, 0, -5},       /* 0x0031 one */
+    {159, 0x35, 4, 0, -5},       /* 0x0032 two */
+    {174, 0x35, 4, 0, -5},       /* 0x0033 three */
+    {189, 0x35, 4, 0, -5},       /* 0x0034 four */
+    {204, 0x35, 4, 0, -5},       /* 0x0035 five */
+    {219, 0x35, 4, 0, -5},       /* 0x0036 six */
+    {234, 0x35, 4, 0, -5},       /* 0x0037 seven */
+    {249, 0x35, 4, 0, -5},       /* 0x0038 eight */
+    {264, 0x35, 4, 0, -5},       /* 0x0039 nine */
+    {279, 0x13, 2, 0, -4},       /* 0x003A colon */
+    {282, 0x24, 3, 0, -4},       /* 0x003B semicolon */
+    {290, 0x35, 4, 0, -5},       /* 0x003C less */
+    {305, 0x33, 4, 0, -4},       /* 0x003D equal */
+    {314, 0x35, 4, 0, -5},       /* 0x003E greater */
+    {329, 0x35, 4, 0, -5},       /* 0x003F question */
+    {344, 0x35, 4, 0, -5},       /* 0x0040 at */
+    {359, 0x35, 4, 0, -5},       /* 0x0041 A */
+    {374, 0x35, 4, 0, -5},       /* 0x0042 B */
+    {389, 0x35, 4, 0, -5},       /* 0x0043 C */
+    {404, 0x35, 4, 0, -5},       /* 0x0044 D */
+    {419, 0x35, 4, 0, -5},       /* 0x0045 E */
+    {434, 0x35, 4, 0, -5},       /* 0x0046 F */
+    {449, 0x35, 4, 0, -5},       /* 0x0047 G */
+    {464, 0x35, 4, 0, -5},       /* 0x0048 H */
+    {479, 0x35, 4, 0, -5},       /* 0x0049 I */
+    {494, 0x35, 4, 0, -5},       /* 0x004A J */
+    {509, 0x35, 4, 0, -5},       /* 0x004B K */
+    {524, 0x35, 4, 0, -5},       /* 0x004C L */
+    {539, 0x35, 4, 0, -5},       /* 0x004D M */
+    {554, 0x35, 4, 0, -5},       /* 0x004E N */
+    {569, 0x35, 4, 0, -5},       /* 0x004F O */
+    {584, 0x35, 4, 0, -5},       /* 0x0050 P */
+    {599, 0x35, 4, 0, -5},       /* 0x0051 Q */
+    {614, 0x35, 4, 0, -5},       /* 0x0052 R */
+    {629, 0x35, 4, 0, -5},       /* 0x0053 S */
+    {644, 0x35, 4, 0, -5},       /* 0x0054 T */
+    {659, 0x35, 4, 0, -5},       /* 0x0055 U */
+    {674, 0x35, 4, 0, -5},       /* 0x0056 V */
+    {689, 0x35, 4, 0, -5},       /* 0x0057 W */
+    {704, 0x35, 4, 0, -5},       /* 0x0058 X */
+    {719, 0x35, 4, 0, -5},       /* 0x0059 Y */
+    {734, 0x35, 4, 0, -5},       /* 0x005A Z */
+    {749, 0x35, 4, 0, -5},       /* 0x005B bracketleft */
+    {764, 0x33, 4, 0, -4},       /* 0x005C backslash */
+    {773, 0x35, 4, 0, -5},       /* 0x005D bracketright */
+    {788, 0x32, 4, 0, -5},       /* 0x005E asciicircum */
+    {115, 0x31, 4, 0, -1},       /* 0x005F underscore */
+    {794, 0x22, 3, 0, -5},       /* 0x0060 grave */
+    {798, 0x34, 4, 0, -4},       /* 0x0061 a */
+    {810, 0x35, 4, 0, -5},       /* 0x0062 b */
+    {825, 0x34, 4, 0, -4},       /* 0x0063 c */
+    {837, 0x35, 4, 0, -5},       /* 0x0064 d */
+    {852, 0x34, 4, 0, -4},       /* 0x0065 e */
+    {864, 0x35, 4, 0, -5},       /* 0x0066 f */
+    {879, 0x35, 4, 0, -4},       /* 0x0067 g */
+    {894, 0x35, 4, 0, -5},       /* 0x0068 h */
+    {909, 0x15, 2, 0, -5},       /* 0x0069 i */
+    {914, 0x36, 4, 0, -5},       /* 0x006A j */
+    {932, 0x35, 4, 0, -5},       /* 0x006B k */
+    {947, 0x35, 4, 0, -5},       /* 0x006C l */
+    {962, 0x34, 4, 0, -4},       /* 0x006D m */
+    {974, 0x34, 4, 0, -4},       /* 0x006E n */
+    {986, 0x34, 4, 0, -4},       /* 0x006F o */
+    {998, 0x35, 4, 0, -4},       /* 0x0070 p */
+    {1013, 0x35, 4, 0, -4},      /* 0x0071 q */
+    {1028, 0x34, 4, 0, -4},      /* 0x0072 r */
+    {1040, 0x34, 4, 0, -4},      /* 0x0073 s */
+    {1052, 0x35, 4, 0, -5},      /* 0x0074 t */
+    {1067, 0x34, 4, 0, -4},      /* 0x0075 u */
+    {1079, 0x34, 4, 0, -4},      /* 0x0076 v */
+    {1091, 0x34, 4, 0, -4},      /* 0x0077 w */
+    {1103, 0x34, 4, 0, -4},      /* 0x0078 x */
+    {1115, 0x35, 4, 0, -4},      /* 0x0079 y */
+    {1130, 0x34, 4, 0, -4},      /* 0x007A z */
+    {1142, 0x35, 4, 0, -5},      /* 0x007B braceleft */
+    {1157, 0x15, 2, 0, -5},      /* 0x007C bar */
+    {1162, 0x35, 4, 0, -5},      /* 0x007D braceright */
+    {1177, 0x32, 4, 0, -5},      /* 0x007E asciitilde */
+    {909, 0x15, 2, 0, -5},       /* 0x00A1 exclamdown */
+    {1183, 0x35, 4, 0, -5},      /* 0x00A2 cent */
+    {1198, 0x35, 4, 0, -5},      /* 0x00A3 sterling */
+    {1213, 0x35, 4, 0, -5},      /* 0x00A4 currency */
+    {1228, 0x35, 4, 0, -5},      /* 0x00A5 yen */
+    {1157, 0x15, 2, 0, -5},      /* 0x00A6 brokenbar */
+    {1243, 0x35, 4, 0, -5},      /* 0x00A7 section */
+    {1258, 0x31, 4, 0, -5},      /* 0x00A8 dieresis */
+    {1261, 0x33, 4, 0, -5},      /* 0x00A9 copyright */
+    {1270, 0x35, 4, 0, -5},      /* 0x00AA ordfeminine */
+    {1285, 0x23, 3, 0, -5},      /* 0x00AB guillemotleft */
+    {1291, 0x32, 4, 0, -4},      /* 0x00AC logicalnot */
+    {1297, 0x21, 3, 0, -3},      /* 0x00AD softhyphen */
+    {1299, 0x33, 4, 0, -5},      /* 0x00AE registered */
+    {115, 0x31, 4, 0, -5},       /* 0x00AF macron */
+    {1308, 0x33, 4, 0, -5},      /* 0x00B0 degree */
+    {1317, 0x35, 4, 0, -5},      /* 0x00B1 plusminus */
+    {1332, 0x33, 4, 0, -5},      /* 0x00B2 twosuperior */
+    {1341, 0x33, 4, 0, -5},      /* 0x00B3 threesuperior */
+    {111, 0x22, 3, 0, -5},       /* 0x00B4 acute */
+    {1350, 0x35, 4, 0, -5},      /* 0x00B5 mu */
+    {1365, 0x35, 4, 0, -5},      /* 0x00B6 paragraph */
+    {1380, 0x33, 4, 0, -4},      /* 0x00B7 periodcentered */
+    {1389, 0x33, 4, 0, -3},      /* 0x00B8 cedilla */
+    {1398, 0x13, 2, 0, -5},      /* 0x00B9 onesuperior */
+    {1401, 0x35, 4, 0, -5},      /* 0x00BA ordmasculine */
+    {1416, 0x23, 3, 0, -5},      /* 0x00BB guillemotright */
+    {1422, 0x35, 4, 0, -5},      /* 0x00BC onequarter */
+    {1437, 0x35, 4, 0, -5},      /* 0x00BD onehalf */
+    {1452, 0x35, 4, 0, -5},      /* 0x00BE threequarters */
+    {1467, 0x35, 4, 0, -5},      /* 0x00BF questiondown */
+    {1482, 0x35, 4, 0, -5},      /* 0x00C0 Agrave */
+    {1497, 0x35, 4, 0, -5},      /* 0x00C1 Aacute */
+    {1512, 0x35, 4, 0, -5},      /* 0x00C2 Acircumflex */
+    {1527, 0x35, 4, 0, -5},      /* 0x00C3 Atilde */
+    {1542, 0x35, 4, 0, -5},      /* 0x00C4 Adieresis */
+    {1557, 0x35, 4, 0, -5},      /* 0x00C5 Aring */
+    {1572, 0x35, 4, 0, -5},      /* 0x00C6 AE */
+    {1587, 0x36, 4, 0, -5},      /* 0x00C7 Ccedilla */
+    {1605, 0x35, 4, 0, -5},      /* 0x00C8 Egrave */
+    {1620, 0x35, 4, 0, -5},      /* 0x00C9 Eacute */
+    {1635, 0x35, 4, 0, -5},      /* 0x00CA Ecircumflex */
+    {1650, 0x35, 4, 0, -5},      /* 0x00CB Edieresis */
+    {1665, 0x35, 4, 0, -5},      /* 0x00CC Igrave */
+    {1680, 0x35, 4, 0, -5},      /* 0x00CD Iacute */
+    {1695, 0x35, 4, 0, -5},      /* 0x00CE Icircumflex */
+    {1710, 0x35, 4, 0, -5},      /* 0x00CF Idieresis */
+    {1725, 0x35, 4, 0, -5},      /* 0x00D0 Eth */
+    {1740, 0x35, 4, 0, -5},      /* 0x00D1 Ntilde */
+    {1755, 0x35, 4, 0, -5},      /* 0x00D2 Ograve */
+    {1770, 0x35, 4, 0, -5},      /* 0x00D3 Oacute */
+    {1785, 0x35, 4, 0, -5},      /* 0x00D4 Ocircumflex */
+    {1800, 0x35, 4, 0, -5},      /* 0x00D5 Otilde */
+    {1815, 0x35, 4, 0, -5},      /* 0x00D6 Odieresis */
+    {93, 0x33, 4, 0, -4},        /* 0x00D7 multiply */
+    {1830, 0x35, 4, 0, -5},      /* 0x00D8 Oslash */
+    {1845, 0x35, 4, 0, -5},      /* 0x00D9 Ugrave */
+    {1860, 0x35, 4, 0, -5},      /* 0x00DA Uacute */
+    {1875, 0x35, 4, 0, -5},      /* 0x00DB Ucircumflex */
+    {1890, 0x35, 4, 0, -5},      /* 0x00DC Udieresis */
+    {1905, 0x35, 4, 0, -5},      /* 0x00DD Yacute */
+    {1920, 0x35, 4, 0, -5},      /* 0x00DE Thorn */
+    {1935, 0x36, 4, 0, -5},      /* 0x00DF germandbls */
+    {1953, 0x35, 4, 0, -5},      /* 0x00E0 agrave */
+    {1968, 0x35, 4, 0, -5},      /* 0x00E1 aacute */
+    {1983, 0x35, 4, 0, -5},      /* 0x00E2 acircumflex */
+    {1998, 0x35, 4, 0, -5},      /* 0x00E3 atilde */
+    {2013, 0x35, 4, 0, -5},      /* 0x00E4 adieresis */
+    {2028, 0x35, 4, 0, -5},      /* 0x00E5 aring */
+    {2043, 0x34, 4, 0, -4},      /* 0x00E6 ae */
+    {2055, 0x35, 4, 0, -4},      /* 0x00E7 ccedilla */
+    {2070, 0x35, 4, 0, -5},      /* 0x00E8 egrave */
+    {2085, 0x35, 4, 0, -5},      /* 0x00E9 eacute */
+    {2100, 0x35, 4, 0, -5},      /* 0x00EA ecircumflex */
+    {2115, 0x35, 4, 0, -5},      /* 0x00EB edieresis */
+    {2130, 0x25, 3, 0, -5},      /* 0x00EC igrave */
+    {2140, 0x25, 3, 0, -5},      /* 0x00ED iacute */
+    {2150, 0x35, 4, 0, -5},      /* 0x00EE icircumflex */
+    {2165, 0x35, 4, 0, -5},      /* 0x00EF idieresis */
+    {2180, 0x35, 4, 0, -5},      /* 0x00F0 eth */
+    {2195, 0x35, 4, 0, -5},      /* 0x00F1 ntilde */
+    {2210, 0x35, 4, 0, -5},      /* 0x00F2 ograve */
+    {2225, 0x35, 4, 0, -5},      /* 0x00F3 oacute */
+    {2240, 0x35, 4, 0, -5},      /* 0x00F4 ocircumflex */
+    {2255, 0x35, 4, 0, -5},      /* 0x00F5 otilde */
+    {2270, 0x35, 4, 0, -5},      /* 0x00F6 odieresis */
+    {2285, 0x35, 4, 0, -5},      /* 0x00F7 divide */
+    {2300, 0x34, 4, 0, -4},      /* 0x00F8 oslash */
+    {2312, 0x35, 4, 0, -5},      /* 0x00F9 ugrave */
+    {2327, 0x35, 4, 0, -5},      /* 0x00FA uacute */
+    {2342, 0x35, 4, 0, -5},      /* 0x00FB ucircumflex */
+    {2357, 0x35, 4, 0, -5},      /* 0x00FC udieresis */
+    {2372, 0x36, 4, 0, -5},      /* 0x00FD yacute */
+    {2390, 0x35, 4, 0, -4},      /* 0x00FE thorn */
+    {2405, 0x36, 4, 0, -5},      /* 0x00FF ydieresis */
+    {0, 0x00, 2, 0, -1},         /* 0x011D gcircumflex */
+    {2423, 0x35, 4, 0, -5},      /* 0x0152 OE */
+    {2438, 0x34, 4, 0, -4},      /* 0x0153 oe */
+    {2450, 0x35, 4, 0, -5},      /* 0x0160 Scaron */
+    {2450, 0x35, 4, 0, -5},      /* 0x0161 scaron */
+    {2465, 0x35, 4, 0, -5},      /* 0x0178 Ydieresis */
+    {2480, 0x35, 4, 0, -5},      /* 0x017D Zcaron */
+    {2480, 0x35, 4, 0, -5},      /* 0x017E zcaron */
+    {0, 0x00, 2, 0, -1},         /* 0x0EA4 uni0EA4 */
+    {0, 0x00, 2, 0, -1},         /* 0x13A0 uni13A0 */
+    {118, 0x11, 2, 0, -3},       /* 0x2022 bullet */
+    {1258, 0x31, 4, 0, -1},      /* 0x2026 ellipsis */
+    {2495, 0x35, 4, 0, -5},      /* 0x20AC Euro */
+    {2510, 0x35, 5, 0, -5},      /* 0xFFFD uniFFFD */
+};
+
+/* {first codepoint, count, first glyph} */
+static const oled_glyph_range_t TomThumbAtlasRanges[] = {
+    {0x0020, 95, 0},
+    {0x00A1, 95, 95},
+    {0x011D, 1, 190},
+    {0x0152, 2, 191},
+    {0x0160, 2, 193},
+    {0x0178, 1, 195},
+    {0x017D, 2, 196},
+    {0x0EA4, 1, 198},
+    {0x13A0, 1, 199},
+    {0x2022, 1, 200},
+    {0x2026, 1, 201},
+    {0x20AC, 1, 202},
+    {0xFFFD, 1, 203},
+};
+
+const oled_font_t TomThumbAtlas = {
+    TomThumbAtlasBitmap, TomThumbAtlasGlyphs, TomThumbAtlasRanges, 13, 203, 5, 6
+};
@@ -0,0 +1,18 @@
+#ifndef TOM_THUMB_ATLAS_H
+#define TOM_THUMB_ATLAS_H
+
+// Generated by tools/fontconv.py from TomThumb.h (extended); do not edit
+
+#include "../oled_font.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const oled_font_t TomThumbAtlas;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
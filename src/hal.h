@@ -0,0 +1,147 @@
+#ifndef HAL_H
+#define HAL_H
+
+// Sensors and actuators as types parameterised by pin and channel. All
+// members are static and inline: a call compiles down to the register
+// access, with no object, virtual call or pin lookup. Built with
+// BOARD_NATIVE, the same types drive mock pins and ADC channels instead,
+// so board-dependent code runs on a host.
+
+#include <stdint.h>
+
+#ifdef BOARD_NATIVE
+#include <string.h>
+#else
+#include <Arduino.h>
+#include "soc/gpio_struct.h"
+#include "driver/adc.h"
+#endif
+
+namespace hal {
+
+// ADC1 channel of a pin, -1 if it has none (ADC2 is taken by WiFi)
+constexpr int adc1Channel(int pin) {
+    return pin == 36 ? 0 : pin == 37 ? 1 : pin == 38 ? 2 : pin == 39 ? 3 :
+           pin == 32 ? 4 : pin == 33 ? 5 : pin == 34 ? 6 : pin == 35 ? 7 : -1;
+}
+
+#ifdef BOARD_NATIVE
+// Pin levels and ADC readings of the host build, set and checked by tests
+struct Mock {
+    static uint8_t* levels() {
+        static uint8_t pins[40];
+        return pins;
+    }
+    static uint16_t* adc() {
+        static uint16_t channels[8];
+        return channels;
+    }
+    static void reset() {
+        memset(levels(), 0, 40);
+        memset(adc(), 0, 8 * sizeof(uint16_t));
+    }
+};
+#endif
+
+template <int PIN, bool ACTIVE_HIGH = true>
+struct DigitalOut {
+    static_assert(PIN >= 0 && PIN < 34, "GPIO 34-39 are input only");
+    static constexpr int pin() { return PIN; }
+
+    static void init() {
+#ifndef BOARD_NATIVE
+        pinMode(PIN, OUTPUT);
+#endif
+        set(false);
+    }
+
+    // One store to the set/clear register: no read-modify-write, so it is
+    // safe from any task or timer callback
+    static inline void set(bool on) {
+        bool high = on == ACTIVE_HIGH;
+#ifdef BOARD_NATIVE
+        Mock::levels()[PIN] = high;
+#else
+        if (PIN < 32) {
+            if (high) {
+                GPIO.out_w1ts = 1UL << (PIN & 31);
+            } else {
+                GPIO.out_w1tc = 1UL << (PIN & 31);
+            }
+        } else {
+            if (high) {
+                GPIO.out1_w1ts.val = 1UL << (PIN & 31);
+            } else {
+                GPIO.out1_w1tc.val = 1UL << (PIN & 31);
+            }
+        }
+#endif
+    }
+};
+
+// 12-bit reading, 11 dB attenuation (full 0-3.3 V range)
+template <int PIN, int CHANNEL = adc1Channel(PIN)>
+struct AnalogIn {
+    static_assert(CHANNEL >= 0 && CHANNEL == adc1Channel(PIN), "pin is not on ADC1");
+    static constexpr int pin() { return PIN; }
+
+    static void init() {
+#ifndef BOARD_NATIVE
+        adc1_config_width(ADC_WIDTH_BIT_12);
+        adc1_config_channel_atten((adc1_channel_t)CHANNEL, ADC_ATTEN_DB_11);
+#endif
+    }
+
+    static inline int read() {
+#ifdef BOARD_NATIVE
+        return Mock::adc()[CHANNEL];
+#else
+        return adc1_get_raw((adc1_channel_t)CHANNEL);
+#endif
+    }
+};
+
+// Numbered group of sensors or actuators (soil zones, pumps). Indexing is
+// unrolled at compile time into a compare chain; with one member it
+// inlines to that member.
+template <typename... Members>
+struct DeviceSet;
+
+template <>
+struct DeviceSet<> {
+    static const uint8_t count = 0;
+    static void init() {}
+    static inline int pin(uint8_t) { return -1; }
+    static inline int read(uint8_t) { return 0; }
+    static inline void set(uint8_t, bool) {}
+};
+
+template <typename First, typename... Rest>
+struct DeviceSet<First, Rest...> {
+    static const uint8_t count = 1 + sizeof...(Rest);
+
+    static void init() {
+        First::init();
+        DeviceSet<Rest...>::init();
+    }
+
+    static inline int pin(uint8_t index) {
+        return index == 0 ? First::pin() : DeviceSet<Rest...>::pin(index - 1);
+    }
+
+    static inline int read(uint8_t index) {
+        return index == 0 ? First::read() : DeviceSet<Rest...>::read(index - 1);
+    }
+
+    static inline void set(uint8_t index, bool on) {
+        if (index == 0) {
+            First::set(on);
+        } else {
+            DeviceSet<Rest...>::set(index - 1, on);
+        }
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,271 @@
+#include "health.h"
+#include "connectToWifi.h"
+#include "logger.h"
+#include <Preferences.h>
+#include <esp_task_wdt.h>
+#include <esp_system.h>
+#include <limits.h>
+#include "i2c_bus.h"
+#include "fixed_point.h"
+#include "timer_wheel.h"
+#include "outbox.h"
+#include "rules.h"
+
+#define HEALTH_RTC_MAGIC 0x48454C54
+
+// Survives a panic or watchdog reset, cleared on power-on
+typedef struct {
+    uint32_t magic;
+    uint8_t stage;
+} HealthRtcState;
+
+static RTC_NOINIT_ATTR HealthRtcState rtcState;
+
+static esp_reset_reason_t resetReason = ESP_RST_UNKNOWN;
+static int crashStage = -1;
+static uint32_t bootCount = 0;
+
+static uint32_t sensorErrors = 0;
+static uint32_t busRecoveries = 0;
+
+// Loop timing over the current telemetry window
+static unsigned long lastTickMicros = 0;
+static unsigned long loopMinUs = ULONG_MAX;
+static unsigned long loopMaxUs = 0;
+static unsigned long long loopSumUs = 0;
+static uint32_t loopCount = 0;
+
+// Start of the current bus utilisation window
+static unsigned long i2cWindowStartUs = 0;
+
+static const char* resetReasonName(esp_reset_reason_t reason) {
+    switch (reason) {
+        case ESP_RST_POWERON:   return "poweron";
+        case ESP_RST_EXT:       return "external";
+        case ESP_RST_SW:        return "software";
+        case ESP_RST_PANIC:     return "panic";
+        case ESP_RST_INT_WDT:   return "int_wdt";
+        case ESP_RST_TASK_WDT:  return "task_wdt";
+        case ESP_RST_WDT:       return "wdt";
+        case ESP_RST_DEEPSLEEP: return "deepsleep";
+        case ESP_RST_BROWNOUT:  return "brownout";
+        case ESP_RST_SDIO:      return "sdio";
+        default:                return "unknown";
+    }
+}
+
+void initHealth() {
+    resetReason = esp_reset_reason();
+
+    bool crashed = resetReason == ESP_RST_PANIC || resetReason == ESP_RST_INT_WDT ||
+                   resetReason == ESP_RST_TASK_WDT || resetReason == ESP_RST_WDT;
+
+    Preferences prefs;
+    prefs.begin("health", false);
+    bootCount = prefs.getUInt("boots", 0) + 1;
+    prefs.putUInt("boots", bootCount);
+    prefs.putUChar("reset", (uint8_t)resetReason);
+    if (crashed && rtcState.magic == HEALTH_RTC_MAGIC) {
+        crashStage = rtcState.stage;
+        prefs.putUChar("crash_stage", rtcState.stage);
+        prefs.putUInt("crashes", prefs.getUInt("crashes", 0) + 1);
+    }
+    prefs.end();
+
+    rtcState.magic = HEALTH_RTC_MAGIC;
+    rtcState.stage = HEALTH_STAGE_BOOT;
+
+    if (crashed) {
+        LOG_ERROR("Reset after crash: %s (stage %d), boot #%lu", resetReasonName(resetReason), crashStage, (unsigned long)bootCount);
+    } else {
+        LOG_INFO("Reset reason: %s, boot #%lu", resetReasonName(resetReason), (unsigned long)bootCount);
+    }
+
+    esp_task_wdt_init(HEALTH_WDT_TIMEOUT_S, true);
+    i2cWindowStartUs = micros();
+}
+
+void healthWatchTask() {
+    esp_task_wdt_add(NULL);
+}
+
+void healthLoopTick() {
+    esp_task_wdt_reset();
+
+    unsigned long now = micros();
+    if (lastTickMicros != 0) {
+        unsigned long period = now - lastTickMicros;
+        if (period < loopMinUs) loopMinUs = period;
+        if (period > loopMaxUs) loopMaxUs = period;
+        loopSumUs += period;
+        loopCount++;
+    }
+    lastTickMicros = now;
+}
+
+void healthMark(HealthStage stage) {
+    rtcState.stage = stage;
+}
+
+void healthRecordSensorError() {
+    sensorErrors++;
+}
+
+bool i2cBusRecover() {
+    bool released = i2c_bus_recover();
+    busRecoveries++;
+
+    if (released) {
+        LOG_WARN("I2C bus recovered");
+    } else {
+        LOG_ERROR("I2C bus recovery failed, SDA still held low");
+    }
+    return released;
+}
+
+// Per-device bus counters since the last publish: ,"i2c_bus":{"<name>":{...},...}
+static int formatBusStats(char* out, size_t size) {
+    unsigned long now = micros();
+    unsigned long windowUs = now - i2cWindowStartUs;
+    i2cWindowStartUs = now;
+
+    int len = snprintf(out, size, ",\"i2c_bus\":{");
+    for (uint8_t device = 0; device < i2c_bus_device_count() && (size_t)len < size; device++) {
+        i2c_bus_stats_t stats;
+        i2c_bus_take_stats(device, &stats);
+
+        // Share of the window the device held the bus, in 0.1 %
+        char utilisation[FIXED_FORMAT_MAX];
+        uint32_t permille = windowUs ? (uint32_t)((uint64_t)stats.busy_us * 1000 / windowUs) : 0;
+        fixed_format(utilisation, permille, 1, 1);
+
+        len += snprintf(out + len, size - len,
+                        "%s\"%s\":{\"txn\":%lu,\"bytes\":%lu,\"errors\":%lu,\"util_pct\":%s,"
+                        "\"wait_max_us\":%lu,\"clock_khz\":%lu}",
+                        device ? "," : "", i2c_bus_device_name(device),
+                        (unsigned long)stats.transactions, (unsigned long)stats.bytes,
+                        (unsigned long)stats.errors, utilisation,
+                        (unsigned long)stats.wait_max_us, (unsigned long)(stats.clock_hz / 1000));
+    }
+    if ((size_t)len < size) {
+        len += snprintf(out + len, size - len, "}");
+    }
+    return len;
+}
+
+// Per-timer lateness since the last publish, as
+// ,"timers":{"<name>":[runs,late_avg_ms,late_max_ms,missed],...}
+static int formatTimerStats(char* out, size_t size) {
+    int len = snprintf(out, size, ",\"timers\":{");
+    for (TimerId id = 0; id < timerCount() && (size_t)len < size; id++) {
+        TimerStats stats;
+        timerTakeStats(id, &stats);
+
+        // Milliseconds with one decimal
+        char lateAvg[FIXED_FORMAT_MAX];
+        char lateMax[FIXED_FORMAT_MAX];
+        fixed_format(lateAvg, stats.runs ? stats.lateSumUs / stats.runs / 100 : 0, 1, 1);
+        fixed_format(lateMax, stats.lateMaxUs / 100, 1, 1);
+
+        len += snprintf(out + len, size - len,
+                        "%s\"%s\":[%lu,%s,%s,%lu]",
+                        id ? "," : "", timerName(id), (unsigned long)stats.runs, lateAvg, lateMax,
+                        (unsigned long)stats.missed);
+    }
+    if ((size_t)len < size) {
+        len += snprintf(out + len, size - len, "}");
+    }
+    return len;
+}
+
+// Outbound queue since the last publish: event depth and delivery, and
+// samples per batch message
+static int formatOutboxStats(char* out, size_t size) {
+    OutboxStats stats;
+    outboxTakeStats(&stats);
+
+    char perBatch[FIXED_FORMAT_MAX];
+    fixed_format(perBatch, stats.batches ? stats.batchSamples * 10 / stats.batches : 0, 1, 1);
+
+    return snprintf(out, size,
+                    ",\"outbox\":{\"pending\":%u,\"pending_max\":%u,\"sent\":%lu,\"resent\":%lu,"
+                    "\"acked\":%lu,\"dropped\":%lu,\"batches\":%lu,\"per_batch_avg\":%s,"
+                    "\"per_batch_max\":%u,\"samples_dropped\":%lu}",
+                    stats.eventsPending, stats.eventsPendingMax, (unsigned long)stats.eventsSent,
+                    (unsigned long)stats.eventsResent, (unsigned long)stats.eventsAcked,
+                    (unsigned long)stats.eventsDropped, (unsigned long)stats.batches, perBatch,
+                    stats.batchMax, (unsigned long)stats.samplesDropped);
+}
+
+static int formatRulesStats(char* out, size_t size) {
+    RulesStats stats;
+    rulesTakeStats(&stats);
+    return snprintf(out, size,
+                    ",\"rules\":{\"count\":%u,\"samples\":%lu,\"runs\":%lu,\"skipped\":%lu,\"fired\":%lu,"
+                    "\"eval_max_us\":%lu}",
+                    stats.count, (unsigned long)stats.samples, (unsigned long)stats.runs,
+                    (unsigned long)stats.skipped, (unsigned long)stats.fired, (unsigned long)stats.evalMaxUs);
+}
+
+#ifdef MQTT_TLS
+static int formatTlsStats(char* out, size_t size) {
+    MqttTlsStats stats;
+    espClient.takeStats(&stats);
+    return snprintf(out, size,
+                    ",\"tls\":{\"handshakes\":%lu,\"resumed\":%lu,\"failures\":%lu,\"full_ms_max\":%lu,"
+                    "\"resumed_ms_max\":%lu,\"last_ms\":%lu,\"heap_used\":%lu,\"heap_peak\":%lu,"
+                    "\"last_error\":%d}",
+                    (unsigned long)stats.handshakes, (unsigned long)stats.resumed,
+                    (unsigned long)stats.failures, (unsigned long)stats.fullMsMax,
+                    (unsigned long)stats.resumedMsMax, (unsigned long)stats.lastMs,
+                    (unsigned long)stats.heapUsed, (unsigned long)stats.heapPeak, stats.lastError);
+}
+#endif
+
+// Append a section whole or not at all: snprintf returns the length it
+// wanted, and a section cut short would leave the JSON unparseable
+static int appendSection(char* out, size_t size, int len, int (*format)(char*, size_t)) {
+    int added = format(out + len, size - len);
+    return (size_t)(len + added) < size ? len + added : len;
+}
+
+void publishHealth(bool sensorOk) {
+    unsigned long avgUs = loopCount ? (unsigned long)(loopSumUs / loopCount) : 0;
+    unsigned long jitterUs = loopCount ? loopMaxUs - loopMinUs : 0;
+
+    // Static: too large for the loop task's stack
+    static char payload[MQTT_BUFFER_SIZE - 64];
+    const size_t room = sizeof(payload) - 1;    // leaves space for the closing brace
+    int len = snprintf(payload, room,
+             "{\"uptime_s\":%lu,\"free_heap\":%lu,\"min_free_heap\":%lu,"
+             "\"reset_reason\":\"%s\",\"crash_stage\":%d,\"boot_count\":%lu,"
+             "\"sht31_ok\":%s,\"i2c_errors\":{\"sht31\":%lu},\"i2c_recoveries\":%lu,"
+             "\"loop_avg_us\":%lu,\"loop_max_us\":%lu,\"loop_jitter_us\":%lu,\"log_dropped\":%lu",
+             millis() / 1000,
+             (unsigned long)esp_get_free_heap_size(),
+             (unsigned long)esp_get_minimum_free_heap_size(),
+             resetReasonName(resetReason), crashStage, (unsigned long)bootCount,
+             sensorOk ? "true" : "false",
+             (unsigned long)sensorErrors, (unsigned long)busRecoveries,
+             avgUs, loopMaxUs, jitterUs, (unsigned long)getLogDroppedLines());
+    if ((size_t)len >= room) {
+        len = room - 1;
+    }
+    len = appendSection(payload, room, len, formatBusStats);
+    len = appendSection(payload, room, len, formatTimerStats);
+    len = appendSection(payload, room, len, formatOutboxStats);
+    len = appendSection(payload, room, len, formatRulesStats);
+#ifdef MQTT_TLS
+    len = appendSection(payload, room, len, formatTlsStats);
+#endif
+    snprintf(payload + len, sizeof(payload) - len, "}");
+
+    mqttClient.publish(mqttTopicMetrics, payload);
+    LOG_DEBUG("Health sent: %s", payload);
+
+    // Start a fresh jitter window
+    loopMinUs = ULONG_MAX;
+    loopMaxUs = 0;
+    loopSumUs = 0;
+    loopCount = 0;
+}
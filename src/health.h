@@ -0,0 +1,52 @@
+#ifndef HEALTH_H
+#define HEALTH_H
+
+#include <Arduino.h>
+
+// Task watchdog timeout. Must exceed the longest blocking timer callback
+// (MQTT connect timeout).
+#define HEALTH_WDT_TIMEOUT_S 30
+
+// Health telemetry interval
+#define HEALTH_PUBLISH_INTERVAL 60000
+
+// How often to re-probe a missing sensor in degraded mode
+#define HEALTH_SENSOR_RETRY_MS 30000
+
+// Consecutive read failures before a sensor is marked missing
+#define HEALTH_SENSOR_MAX_FAILURES 3
+
+// Code location breadcrumbs, kept in RTC memory across a crash
+enum HealthStage {
+    HEALTH_STAGE_BOOT = 0,
+    HEALTH_STAGE_SETUP,
+    HEALTH_STAGE_MQTT,
+    HEALTH_STAGE_SENSORS,
+    HEALTH_STAGE_DISPLAY,
+    HEALTH_STAGE_PUMP,
+    HEALTH_STAGE_IDLE
+};
+
+// Capture reset reason and crash breadcrumb, persist them to NVS
+void initHealth();
+
+// Subscribe the calling task to the task watchdog
+void healthWatchTask();
+
+// Feed the watchdog and record loop timing. Call once per loop() pass.
+void healthLoopTick();
+
+// Record where the firmware is, so a crash can be attributed after reset
+void healthMark(HealthStage stage);
+
+// Count a failed SHT31 read (bus errors are also counted per device by i2c_bus)
+void healthRecordSensorError();
+
+// Unstick a bus held low by a slave (i2c_bus_recover()) and count it
+bool i2cBusRecover();
+
+// Publish uptime, heap, per-device I2C, loop and timer lateness statistics
+// over MQTT
+void publishHealth(bool sensorOk);
+
+#endif
@@ -0,0 +1,313 @@
+#include "i2c_bus.h"
+#include <string.h>
+#include "driver/i2c.h"
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "I2C";
+
+// Above loop() so queued transactions go out while it keeps drawing
+#define I2C_BUS_TASK_PRIORITY 3
+#define I2C_BUS_TASK_STACK 3072
+
+typedef enum {
+    I2C_BUS_OP_WRITE,
+    I2C_BUS_OP_READ,
+    I2C_BUS_OP_PROBE,
+    I2C_BUS_OP_RECOVER
+} i2c_bus_op_t;
+
+typedef struct {
+    uint8_t device;
+    uint8_t op;
+    bool sync;
+    uint8_t inline_len;
+    uint8_t inline_bytes[I2C_BUS_ASYNC_MAX + 1];  // async writes: control + payload
+    const uint8_t *write_bytes;     // sync transfers use the caller's buffer
+    uint8_t *read_bytes;
+    size_t len;
+    int64_t queued_us;
+} i2c_bus_txn_t;
+
+typedef struct {
+    i2c_bus_device_config_t config;
+    uint32_t clock_hz;
+    i2c_bus_stats_t stats;
+} i2c_bus_slot_t;
+
+static i2c_bus_slot_t devices[I2C_BUS_MAX_DEVICES];
+static uint8_t device_count = 0;
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static i2c_config_t bus_config;
+static uint32_t bus_clock = 0;
+static bool bus_ready = false;
+
+// One FIFO per priority; `pending` counts the transactions across them
+static const UBaseType_t queue_length[I2C_BUS_PRIO_COUNT] = {8, I2C_BUS_QUEUE_LENGTH};
+static QueueHandle_t queues[I2C_BUS_PRIO_COUNT];
+static SemaphoreHandle_t pending;
+
+// Blocking callers go one at a time and are woken with the result
+static SemaphoreHandle_t sync_lock;
+static SemaphoreHandle_t sync_done;
+static esp_err_t sync_result;
+
+static void set_clock(uint32_t hz) {
+    if (hz == bus_clock) {
+        return;
+    }
+    bus_config.master.clk_speed = hz;
+    i2c_param_config(I2C_BUS_PORT, &bus_config);
+    bus_clock = hz;
+}
+
+static esp_err_t install_driver() {
+    bus_clock = bus_config.master.clk_speed;
+    esp_err_t ret = i2c_param_config(I2C_BUS_PORT, &bus_config);
+    if (ret == ESP_OK) {
+        ret = i2c_driver_install(I2C_BUS_PORT, I2C_MODE_MASTER, 0, 0, 0);
+    }
+    return ret;
+}
+
+// A slave stuck mid-byte releases SDA after at most nine clocks; then STOP
+static esp_err_t recover_bus() {
+    int sda = bus_config.sda_io_num;
+    int scl = bus_config.scl_io_num;
+
+    i2c_driver_delete(I2C_BUS_PORT);
+    gpio_set_direction(sda, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_direction(scl, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_pull_mode(sda, GPIO_PULLUP_ONLY);
+    gpio_set_pull_mode(scl, GPIO_PULLUP_ONLY);
+    gpio_set_level(sda, 1);
+    gpio_set_level(scl, 1);
+    esp_rom_delay_us(5);
+
+    for (uint8_t i = 0; i < 9 && gpio_get_level(sda) == 0; i++) {
+        gpio_set_level(scl, 0);
+        esp_rom_delay_us(5);
+        gpio_set_level(scl, 1);
+        esp_rom_delay_us(5);
+    }
+
+    gpio_set_level(sda, 0);
+    esp_rom_delay_us(5);
+    gpio_set_level(scl, 1);
+    esp_rom_delay_us(5);
+    gpio_set_level(sda, 1);
+    esp_rom_delay_us(5);
+    bool released = gpio_get_level(sda) == 1;
+
+    install_driver();
+    return released ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t run_transaction(const i2c_bus_txn_t *txn) {
+    if (txn->op == I2C_BUS_OP_RECOVER) {
+        return recover_bus();
+    }
+
+    i2c_bus_slot_t *slot = &devices[txn->device];
+    uint8_t rw = txn->op == I2C_BUS_OP_READ ? I2C_MASTER_READ : I2C_MASTER_WRITE;
+    size_t bytes = 0;
+
+    set_clock(slot->clock_hz);
+
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (slot->config.address << 1) | rw, true);
+    if (txn->op == I2C_BUS_OP_WRITE && txn->write_bytes != NULL) {
+        i2c_master_write(cmd, txn->write_bytes, txn->len, true);
+        bytes = txn->len;
+    } else if (txn->op == I2C_BUS_OP_WRITE) {
+        i2c_master_write(cmd, txn->inline_bytes, txn->inline_len, true);
+        bytes = txn->inline_len;
+    } else if (txn->op == I2C_BUS_OP_READ) {
+        i2c_master_read(cmd, txn->read_bytes, txn->len, I2C_MASTER_LAST_NACK);
+        bytes = txn->len;
+    }
+    i2c_master_stop(cmd);
+
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = i2c_master_cmd_begin(I2C_BUS_PORT, cmd, pdMS_TO_TICKS(I2C_BUS_TIMEOUT_MS));
+    int64_t end = esp_timer_get_time();
+    i2c_cmd_link_delete(cmd);
+
+    taskENTER_CRITICAL(&stats_lock);
+    i2c_bus_stats_t *stats = &slot->stats;
+    stats->transactions++;
+    stats->bytes += bytes;
+    stats->busy_us += (uint32_t)(end - start);
+    if (start - txn->queued_us > stats->wait_max_us) {
+        stats->wait_max_us = (uint32_t)(start - txn->queued_us);
+    }
+    if (ret != ESP_OK) {
+        stats->errors++;
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+
+    if (ret != ESP_OK) {
+        if (!txn->sync) {
+            ESP_LOGE(TAG, "%s write failed: %s", slot->config.name, esp_err_to_name(ret));
+        }
+        // Fast-mode plus needs stronger pull-ups than many boards have
+        if (slot->clock_hz > I2C_BUS_CLOCK_FAST) {
+            ESP_LOGW(TAG, "%s: dropping to %d Hz", slot->config.name, I2C_BUS_CLOCK_FAST);
+            slot->clock_hz = I2C_BUS_CLOCK_FAST;
+        }
+    }
+    return ret;
+}
+
+static void i2c_bus_task(void *arg) {
+    i2c_bus_txn_t txn;
+
+    for (;;) {
+        xSemaphoreTake(pending, portMAX_DELAY);
+        for (uint8_t prio = 0; prio < I2C_BUS_PRIO_COUNT; prio++) {
+            if (xQueueReceive(queues[prio], &txn, 0) == pdTRUE) {
+                break;
+            }
+        }
+
+        esp_err_t ret = run_transaction(&txn);
+        if (txn.sync) {
+            sync_result = ret;
+            xSemaphoreGive(sync_done);
+        }
+    }
+}
+
+static esp_err_t submit(i2c_bus_txn_t *txn, i2c_bus_prio_t prio) {
+    txn->queued_us = esp_timer_get_time();
+    if (xQueueSend(queues[prio], txn, pdMS_TO_TICKS(I2C_BUS_TIMEOUT_MS)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    xSemaphoreGive(pending);
+    return ESP_OK;
+}
+
+static esp_err_t submit_sync(i2c_bus_txn_t *txn, i2c_bus_prio_t prio) {
+    if (!bus_ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    txn->sync = true;
+
+    xSemaphoreTake(sync_lock, portMAX_DELAY);
+    esp_err_t ret = submit(txn, prio);
+    if (ret == ESP_OK) {
+        xSemaphoreTake(sync_done, portMAX_DELAY);
+        ret = sync_result;
+    }
+    xSemaphoreGive(sync_lock);
+    return ret;
+}
+
+esp_err_t i2c_bus_init(int sda, int scl) {
+    if (bus_ready) {
+        return ESP_OK;
+    }
+
+    memset(&bus_config, 0, sizeof(bus_config));
+    bus_config.mode = I2C_MODE_MASTER;
+    bus_config.sda_io_num = sda;
+    bus_config.scl_io_num = scl;
+    bus_config.sda_pullup_en = GPIO_PULLUP_ENABLE;
+    bus_config.scl_pullup_en = GPIO_PULLUP_ENABLE;
+    bus_config.master.clk_speed = I2C_BUS_CLOCK_FAST;
+
+    esp_err_t ret = install_driver();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Driver install failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    UBaseType_t total = 0;
+    for (uint8_t prio = 0; prio < I2C_BUS_PRIO_COUNT; prio++) {
+        queues[prio] = xQueueCreate(queue_length[prio], sizeof(i2c_bus_txn_t));
+        total += queue_length[prio];
+    }
+    pending = xSemaphoreCreateCounting(total, 0);
+    sync_lock = xSemaphoreCreateMutex();
+    sync_done = xSemaphoreCreateBinary();
+
+    xTaskCreate(i2c_bus_task, "i2c_bus", I2C_BUS_TASK_STACK, NULL, I2C_BUS_TASK_PRIORITY, NULL);
+    bus_ready = true;
+    return ESP_OK;
+}
+
+// Drivers may register from different tasks during boot
+esp_err_t i2c_bus_add_device(const i2c_bus_device_config_t *config, i2c_bus_device_t *device) {
+    portENTER_CRITICAL(&stats_lock);
+    if (device_count >= I2C_BUS_MAX_DEVICES) {
+        portEXIT_CRITICAL(&stats_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    i2c_bus_slot_t *slot = &devices[device_count];
+    slot->config = *config;
+    slot->clock_hz = config->clock_hz;
+    memset(&slot->stats, 0, sizeof(slot->stats));
+    *device = device_count++;
+    portEXIT_CRITICAL(&stats_lock);
+    return ESP_OK;
+}
+
+esp_err_t i2c_bus_probe(i2c_bus_device_t device) {
+    i2c_bus_txn_t txn = {.device = device, .op = I2C_BUS_OP_PROBE};
+    return submit_sync(&txn, devices[device].config.priority);
+}
+
+esp_err_t i2c_bus_write(i2c_bus_device_t device, const uint8_t *bytes, size_t len) {
+    i2c_bus_txn_t txn = {.device = device, .op = I2C_BUS_OP_WRITE, .write_bytes = bytes, .len = len};
+    return submit_sync(&txn, devices[device].config.priority);
+}
+
+esp_err_t i2c_bus_read(i2c_bus_device_t device, uint8_t *bytes, size_t len) {
+    i2c_bus_txn_t txn = {.device = device, .op = I2C_BUS_OP_READ, .read_bytes = bytes, .len = len};
+    return submit_sync(&txn, devices[device].config.priority);
+}
+
+esp_err_t i2c_bus_write_async(i2c_bus_device_t device, uint8_t control, const uint8_t *bytes, size_t len) {
+    if (!bus_ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (len > I2C_BUS_ASYNC_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    i2c_bus_txn_t txn = {.device = device, .op = I2C_BUS_OP_WRITE, .inline_len = len + 1};
+    txn.inline_bytes[0] = control;
+    memcpy(&txn.inline_bytes[1], bytes, len);
+    return submit(&txn, devices[device].config.priority);
+}
+
+bool i2c_bus_recover() {
+    i2c_bus_txn_t txn = {.op = I2C_BUS_OP_RECOVER};
+    return submit_sync(&txn, I2C_BUS_PRIO_HIGH) == ESP_OK;
+}
+
+void i2c_bus_take_stats(i2c_bus_device_t device, i2c_bus_stats_t *stats) {
+    i2c_bus_slot_t *slot = &devices[device];
+
+    taskENTER_CRITICAL(&stats_lock);
+    *stats = slot->stats;
+    memset(&slot->stats, 0, sizeof(slot->stats));
+    taskEXIT_CRITICAL(&stats_lock);
+    stats->clock_hz = slot->clock_hz;
+}
+
+const char *i2c_bus_device_name(i2c_bus_device_t device) {
+    return devices[device].config.name;
+}
+
+uint8_t i2c_bus_device_count() {
+    return device_count;
+}
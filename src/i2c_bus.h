@@ -0,0 +1,86 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+// Owner of the I2C controller shared by the SHT31 and the OLED. A bus task
+// runs every transaction; requests wait in one FIFO per priority, so a
+// sensor read goes ahead of queued display chunks and only waits for the
+// transaction already on the wire. Each device gets its own bus clock.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define I2C_BUS_PORT 0
+#define I2C_BUS_MAX_DEVICES 4
+#define I2C_BUS_TIMEOUT_MS 50
+
+// Queued transactions per priority; a full 128x64 I2C frame is 65
+#define I2C_BUS_QUEUE_LENGTH 80
+
+// Largest payload of a queued (asynchronous) write, after its control byte
+#define I2C_BUS_ASYNC_MAX 32
+
+#define I2C_BUS_CLOCK_FAST 400000
+#define I2C_BUS_CLOCK_FAST_PLUS 1000000
+
+typedef enum {
+    I2C_BUS_PRIO_HIGH = 0,      // sensor reads
+    I2C_BUS_PRIO_LOW,           // display traffic
+    I2C_BUS_PRIO_COUNT
+} i2c_bus_prio_t;
+
+typedef uint8_t i2c_bus_device_t;
+
+typedef struct {
+    const char *name;
+    uint8_t address;
+    uint32_t clock_hz;          // a device erroring above fast mode drops to it
+    i2c_bus_prio_t priority;
+} i2c_bus_device_config_t;
+
+// Per-device counters since the last i2c_bus_take_stats()
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t errors;
+    uint32_t busy_us;           // time on the wire
+    uint32_t wait_max_us;       // longest time queued
+    uint32_t clock_hz;          // current clock
+} i2c_bus_stats_t;
+
+// Install the controller driver and start the bus task
+esp_err_t i2c_bus_init(int sda, int scl);
+
+esp_err_t i2c_bus_add_device(const i2c_bus_device_config_t *config, i2c_bus_device_t *device);
+
+// Address the device and check it acknowledges
+esp_err_t i2c_bus_probe(i2c_bus_device_t device);
+
+// Blocking transfers
+esp_err_t i2c_bus_write(i2c_bus_device_t device, const uint8_t *bytes, size_t len);
+esp_err_t i2c_bus_read(i2c_bus_device_t device, uint8_t *bytes, size_t len);
+
+// Copy control byte and payload into the queue and return; failures are
+// counted in the device's stats. Blocks only while the queue is full.
+esp_err_t i2c_bus_write_async(i2c_bus_device_t device, uint8_t control, const uint8_t *bytes, size_t len);
+
+// Clock out a slave holding SDA low, then reinstall the driver. Runs
+// between transactions; true if SDA was released.
+bool i2c_bus_recover();
+
+// Copy a device's counters and start a new window
+void i2c_bus_take_stats(i2c_bus_device_t device, i2c_bus_stats_t *stats);
+
+const char *i2c_bus_device_name(i2c_bus_device_t device);
+uint8_t i2c_bus_device_count();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,91 @@
+#include "logger.h"
+#include <Arduino.h>
+#include <stdarg.h>
+#include <esp_task_wdt.h>
+
+// Ring buffer of formatted lines. Writers fill the head slot, the drain
+// task empties the tail slot.
+static char logLines[LOG_RING_LINES][LOG_LINE_MAX];
+static uint8_t logLineLength[LOG_RING_LINES];
+static volatile uint16_t logHead = 0;
+static volatile uint16_t logTail = 0;
+static volatile uint32_t logDropped = 0;
+static uint32_t logDroppedReported = 0;
+static portMUX_TYPE logMux = portMUX_INITIALIZER_UNLOCKED;
+
+static const char logLevelTag[] = {'-', 'E', 'W', 'I', 'D'};
+
+static void logDrainTask(void* param);
+
+void initLogger() {
+    xTaskCreate(logDrainTask, "logDrain", 3072, NULL, tskIDLE_PRIORITY + 1, NULL);
+}
+
+void logWrite(uint8_t level, const char* fmt, ...) {
+    char line[LOG_LINE_MAX];
+    int len = snprintf(line, sizeof(line), "%c (%lu) ", logLevelTag[level <= LOG_LEVEL_DEBUG ? level : 0], millis());
+
+    va_list args;
+    va_start(args, fmt);
+    int body = vsnprintf(line + len, sizeof(line) - len, fmt, args);
+    va_end(args);
+
+    if (body > 0) {
+        len += body;
+    }
+    if (len > LOG_LINE_MAX - 1) {
+        len = LOG_LINE_MAX - 1;
+    }
+
+    portENTER_CRITICAL(&logMux);
+    uint16_t next = (logHead + 1) % LOG_RING_LINES;
+    if (next == logTail) {
+        logDropped++;
+    } else {
+        memcpy(logLines[logHead], line, len);
+        logLineLength[logHead] = len;
+        logHead = next;
+    }
+    portEXIT_CRITICAL(&logMux);
+}
+
+uint32_t getLogDroppedLines() {
+    return logDropped;
+}
+
+static void logDrainTask(void* param) {
+    esp_task_wdt_add(NULL);
+
+    while (1) {
+        esp_task_wdt_reset();
+        uint8_t written = 0;
+
+        // Report drops before draining so the gap shows up in order
+        uint32_t dropped = logDropped;
+        if (dropped != logDroppedReported && Serial.availableForWrite() >= 40) {
+            char note[40];
+            int len = snprintf(note, sizeof(note), "W log: %lu lines dropped\r\n", (unsigned long)(dropped - logDroppedReported));
+            Serial.write((const uint8_t*)note, len);
+            logDroppedReported = dropped;
+            written++;
+        }
+
+        while (written < LOG_DRAIN_LINES_PER_TICK && logTail != logHead) {
+            uint8_t len = logLineLength[logTail];
+
+            // Only write what fits in the TX FIFO so this task never blocks either
+            if (Serial.availableForWrite() < len + 2) {
+                break;
+            }
+            Serial.write((const uint8_t*)logLines[logTail], len);
+            Serial.write((const uint8_t*)"\r\n", 2);
+
+            portENTER_CRITICAL(&logMux);
+            logTail = (logTail + 1) % LOG_RING_LINES;
+            portEXIT_CRITICAL(&logMux);
+            written++;
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL_MS));
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Log levels
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// Compile-time level, set from platformio.ini build_flags
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Ring buffer geometry (static, no heap)
+#define LOG_LINE_MAX 96
+#define LOG_RING_LINES 32
+
+// Drain task rate limit: at most this many lines per interval
+#define LOG_DRAIN_LINES_PER_TICK 4
+#define LOG_DRAIN_INTERVAL_MS 20
+
+// Start the low-priority task that drains the ring buffer to Serial
+void initLogger();
+
+// Format a line into the ring buffer. Never waits on the UART; drops the
+// line and counts it if the buffer is full.
+void logWrite(uint8_t level, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+// Number of lines dropped since boot
+uint32_t getLogDroppedLines();
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) logWrite(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) logWrite(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) logWrite(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) logWrite(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do {} while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,267 +1,517 @@
 #include <Arduino.h>
-#include <Wire.h>
-#include <Adafruit_SHT31.h>
 #include <oled_ssd1306.h>
+#include "i2c_bus.h"
+#include "sht31.h"
 #include "connectToWifi.h"
+#include "logger.h"
+#include "health.h"
+#include "display_scheduler.h"
+#include "display_pages.h"
+#include "fixed_point.h"
+#include "soil_calibration.h"
+#include "safety.h"
+#include "timer_wheel.h"
+#include "pump.h"
+#include "board.h"
+#include "controller.h"
+#include "boot.h"
+#include "ota.h"
+#include "web_server.h"
+#include "outbox.h"
+#include "rules.h"
 
-Adafruit_SHT31 sht31 = Adafruit_SHT31();
+bool sht31Available = false;
 
-extern bool pumpServiceEnabled;
+// Pins and the sensors on them come from board.h; zone n drives pump n
+static_assert(PUMP_COUNT == SOIL_ZONE_COUNT, "every soil zone needs its own pump");
 
-// Pin definitions
-const int LED = 23;
-const int I2C_SDA = 19;
-const int I2C_SCL = 21;
-const int soilHumiditySensor = 34;
-extern const int pumpPin = 5;
-
-// Calibration values
-const int AIR_VALUE = 4095;
-const int WATER_VALUE = 2200;
+// Moisture thresholds
 const int DRY_THRESHOLD = 20;
 const int WET_THRESHOLD = 60;
 
-// Pump settings
-const int PUMP_DURATION = 3000;
+// Pump settings; the dose is delivered at the pump's calibrated flow rate
+const uint32_t PUMP_DOSE_ML = 75;
 const unsigned long PUMP_COOLDOWN = 10000;
+const unsigned long PUMP_CHECK_INTERVAL = 1000;
 unsigned long lastPumpTime = 0;
+static int pumpRawBefore[PUMP_COUNT];
+
+// Sample interval; samples reach the broker in batches (outbox.h)
+const unsigned long SENSOR_INTERVAL = 5000;
+
+// Everything periodic runs from a timer; loop() sleeps in between
+static TimerId sensorTimer;
+static TimerId healthTimer;
+static TimerId probeTimer;
+static TimerId displayTimer;
+static TimerId pumpCheckTimer;
+static TimerId pumpCooldownTimers[PUMP_COUNT];
+
+// One zone's soil reading, kept with and without temperature
+// compensation so the model can be checked
+struct SoilReading {
+    int raw;
+    int rawComp;
+    int percent;                // compensated, drives the zone's pump
+    int percentUncomp;
+};
 
-// MQTT update interval
-unsigned long lastMQTTUpdate = 0;
-const unsigned long MQTT_UPDATE_INTERVAL = 10000;
+// Latest sample from the sensor block, used to answer STATUS requests
+// without new sensor conversions. Centi-units (2345 = 23.45) end to end,
+// straight from the SHT31 ticks.
+struct SensorSample {
+    int32_t tempCenti;
+    int32_t humidityCenti;
+    SoilReading soil[SOIL_ZONE_COUNT];
+    bool tempValid;             // read and plausible
+    bool valid;
+};
+SensorSample latestSample = {};
 
 // Function prototypes
-float readSHT31Temperature();
-float readSHT31Humidity();
-int getSoilRaw();
-int getSoilPercent();
-void initPumpService();
-void runPump();
-void manualPump(); 
-void updateDisplay(float temp, float humidity, int soilPercent);
-void sendMQTTStatus(float temp, float humidity, int soilPercent);
+bool readSHT31(int32_t* tempCenti, int32_t* humidityCenti);
+void readSensorSample(SensorSample* sample);
+int getSoilRaw(uint8_t zone);
+int getSoilPercent(uint8_t zone);
+bool probeSHT31();
+void runPump(uint8_t zone);
+void onPumpDone(const PumpPulse& pulse);
+void sensorTick();
+static void evaluateRules(const SensorSample& sample);
+void healthTick();
+void probeTick();
+void displayTick();
+void pumpCheckTick();
+void initTimerTasks();
+static void initOled();
+void formatStatus(char* status, size_t size, const SensorSample& sample, const char* requestId);
+void sendMQTTStatus(const SensorSample& sample, const char* requestId = NULL);
+#ifdef FIXED_POINT_BENCH
+void runFixedPointBench();
+#endif
 
 void setup() {
     Serial.begin(115200);
+    initLogger();
+    initTimers();
+    initHealth();
+    initSafety();
+    initOta();
+    healthMark(HEALTH_STAGE_SETUP);
+#ifdef FIXED_POINT_BENCH
+    runFixedPointBench();
+#endif
+    bootMark(BOOT_PHASE_CORE);
+
+    // Association takes seconds; start it first and let it run while the
+    // local hardware comes up
+    connectToWifi();
+    bootMark(BOOT_PHASE_WIFI_START);
+
+    // The SHT31 is ready 1.5 ms after power-up, long before we get here
+    i2c_bus_init(Board::i2cSda, Board::i2cScl);
 
-    Wire.begin(I2C_SDA, I2C_SCL);
-    delay(100);
+    // The panel needs 100 ms after power-up before it takes commands;
+    // that wait and the init sequence run beside the sensor setup
+    bootRunAsync("oled_init", initOled, BOOT_PHASE_DISPLAY);
     
-    pinMode(soilHumiditySensor, INPUT);
-    initPumpService();
+    initSoilCalibration();
+    initPump(onPumpDone);
+    initRules();
   
-    if (!sht31.begin(0x44)) {
-        Serial.println("Check circuit. SHT31 not found!");
-        while (1) delay(1000);
+    // Without the SHT31 we keep running in degraded mode: soil sensing and
+    // watering still work and the sensor is re-probed periodically
+    sht31Available = probeSHT31();
+    if (!sht31Available) {
+        LOG_ERROR("Check circuit. SHT31 not found! Running in degraded mode");
     }
     
-    pinMode(LED, OUTPUT);
-    pinMode(LED_PIN, OUTPUT);
-    digitalWrite(LED, LOW);
-    digitalWrite(LED_PIN, LOW);
+    Board::StatusLed::init();
+    Board::OnboardLed::init();
+    bootMark(BOOT_PHASE_SENSORS);
     
-    oled_init(I2C_SDA, I2C_SCL);
-    oled_clear();
-    connectToWifi();
+    initDisplayPages();
     setupMQTT();
+    initOutbox();
+    initWebServer();
+    initTimerTasks();
+    
+    healthWatchTask();
+    bootMark(BOOT_PHASE_SETUP);
+}
+
+static void initOled() {
+    oled_init(Board::i2cSda, Board::i2cScl);
+}
+
+void initTimerTasks() {
+    sensorTimer = timerCreate("sensor", sensorTick);
+    healthTimer = timerCreate("health", healthTick);
+    probeTimer = timerCreate("sht31_probe", probeTick);
+    displayTimer = timerCreate("display", displayTick);
+    pumpCheckTimer = timerCreate("pump_check", pumpCheckTick);
+    for (uint8_t pump = 0; pump < PUMP_COUNT; pump++) {
+        pumpCooldownTimers[pump] = timerCreate("pump_cooldown", NULL);
+    }
+    
+    timerStart(sensorTimer, 0, SENSOR_INTERVAL);
+    timerStart(healthTimer, HEALTH_PUBLISH_INTERVAL, HEALTH_PUBLISH_INTERVAL);
+    timerStart(probeTimer, HEALTH_SENSOR_RETRY_MS, HEALTH_SENSOR_RETRY_MS);
+    timerStart(displayTimer, 0, DISPLAY_MIN_FRAME_MS);
+    // First decision one tick after the first sample
+    timerStart(pumpCheckTimer, TIMER_TICK_MS, PUMP_CHECK_INTERVAL);
 }
 
 void loop() {
-    static unsigned long lastSensorRead = 0;
-    const unsigned long SENSOR_INTERVAL = 5000;
+    healthLoopTick();
     
+    uint32_t sleepMs = timerRun();
     
-    if (!mqttClient.connected()) {
-        Serial.println("MQTT disconnected - reconnecting...");
-        reconnectMQTT();
-    }
-    mqttClient.loop();
+    healthMark(HEALTH_STAGE_IDLE);
+    delay(sleepMs);
+}
+
+void sensorTick() {
+    healthMark(HEALTH_STAGE_SENSORS);
     
-    unsigned long currentTime = millis();
-    if (currentTime - lastSensorRead >= SENSOR_INTERVAL) {
-        lastSensorRead = currentTime;
-        
-        float temp = readSHT31Temperature();
-        float humidity = readSHT31Humidity();
-        int soilPercent = getSoilPercent();
-        int soilRaw = getSoilRaw();
-        
-        updateDisplay(temp, humidity, soilPercent);
-        
-        Serial.print("Temp: "); Serial.print(temp); Serial.print("C  ");
-        Serial.print("Humidity: "); Serial.print(humidity); Serial.print("%  ");
-        Serial.print("Soil Moisture: ");
-        Serial.print(soilPercent);
-        Serial.print(" % (Raw: ");
-        Serial.print(soilRaw);
-        Serial.println(")");
-        
-        if (soilPercent < 30) {
-            Serial.println("   Status: DRY - Needs water");
-        } else if (soilPercent < 60) {
-            Serial.println("   Status: MOIST - Good");
-        } else {
-            Serial.println("   Status: WET");
-        }
-        
-        if (currentTime - lastMQTTUpdate >= MQTT_UPDATE_INTERVAL) {
-            sendMQTTStatus(temp, humidity, soilPercent);
-            lastMQTTUpdate = currentTime;
-        }
+    readSensorSample(&latestSample);
+    int soilPercent = latestSample.soil[0].percent;
+    bootMark(BOOT_PHASE_FIRST_SAMPLE);
+    
+    displayPagesOnSample(latestSample.tempCenti, latestSample.humidityCenti, soilPercent);
+    
+    // LAN clients get every sample at once, the broker in batches
+    char status[WEB_STATUS_MAX];
+    formatStatus(status, sizeof(status), latestSample, NULL);
+    webUpdateStatus(status);
+    outboxAddSample(status);
+    
+    evaluateRules(latestSample);
+    
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+    char tempText[FIXED_FORMAT_MAX];
+    char humidityText[FIXED_FORMAT_MAX];
+    fixed_format(tempText, latestSample.tempCenti, FIXED_CENTI, 2);
+    fixed_format(humidityText, latestSample.humidityCenti, FIXED_CENTI, 2);
+    LOG_INFO("Temp: %sC  Humidity: %s%%", tempText, humidityText);
+    for (uint8_t zone = 0; zone < SOIL_ZONE_COUNT; zone++) {
+        const SoilReading& soil = latestSample.soil[zone];
+        LOG_INFO("   Zone %u soil moisture: %d %% (Raw: %d, compensated %d, %d %% uncompensated)",
+                 zone, soil.percent, soil.raw, soil.rawComp, soil.percentUncomp);
     }
+#endif
     
+    if (soilPercent < 30) {
+        LOG_INFO("   Status: DRY - Needs water");
+    } else if (soilPercent < 60) {
+        LOG_INFO("   Status: MOIST - Good");
+    } else {
+        LOG_INFO("   Status: WET");
+    }
+}
+
+// A reading that failed or did not pass the safety checks is not valid,
+// and rules that read it stay false. Rules see zone 0 and water pump 0.
+static void evaluateRules(const SensorSample& sample) {
+    int32_t channels[RULE_CHANNELS] = {0};
+    uint16_t valid = (1u << RULE_CH_PUMP_ENABLED) | (1u << RULE_CH_FAULT);
+    channels[RULE_CH_TEMP] = sample.tempCenti;
+    channels[RULE_CH_HUMIDITY] = sample.humidityCenti;
+    if (sample.tempValid) {
+        valid |= (1u << RULE_CH_TEMP) | (1u << RULE_CH_HUMIDITY);
+    }
+    channels[RULE_CH_SOIL] = sample.soil[0].percent;
+    channels[RULE_CH_SOIL_RAW] = sample.soil[0].raw;
+    if (safetySoilInRange(sample.soil[0].raw)) {
+        valid |= (1u << RULE_CH_SOIL) | (1u << RULE_CH_SOIL_RAW);
+    }
+    channels[RULE_CH_PUMP_ENABLED] = pumpServiceEnabled;
+    channels[RULE_CH_FAULT] = safetyFaultLatched();
+    rulesEvaluate(channels, valid);
+}
+
+void healthTick() {
+    publishHealth(sht31Available);
+}
+
+// Degraded mode: unstick the bus and look for the sensor again
+void probeTick() {
+    if (sht31Available) {
+        return;
+    }
+    healthMark(HEALTH_STAGE_SENSORS);
+    i2cBusRecover();
+    sht31Available = probeSHT31();
+    if (sht31Available) {
+        LOG_INFO("SHT31 found, leaving degraded mode");
+        displayWake();
+    }
+}
+
+// Nothing is drawn until the oled_init task has finished
+void displayTick() {
+    if (!bootPhaseDone(BOOT_PHASE_DISPLAY)) {
+        return;
+    }
+    healthMark(HEALTH_STAGE_DISPLAY);
+    displaySchedulerTick();
+}
+
+void pumpCheckTick() {
+    bootMark(BOOT_PHASE_FIRST_CONTROL);
     if (pumpServiceEnabled) {
-        runPump();
+        healthMark(HEALTH_STAGE_PUMP);
+        for (uint8_t zone = 0; zone < SOIL_ZONE_COUNT; zone++) {
+            runPump(zone);
+        }
     }
-    
-    delay(10);
 }
 
-void sendMQTTStatus(float temp, float humidity, int soilPercent) {
-    String status = "{";
-    status += "\"temperature\":" + String(temp, 1) + ",";
-    status += "\"humidity\":" + String(humidity, 1) + ",";
-    status += "\"soil_moisture\":" + String(soilPercent) + ",";
-    status += "\"pump_enabled\":" + String(pumpServiceEnabled ? "true" : "false") + ",";
+// Zone 0 keeps the unsuffixed keys; further zones add soil_moisture_<n>
+// and soil_raw_<n>
+void formatStatus(char* status, size_t size, const SensorSample& sample, const char* requestId) {
+    char tempText[FIXED_FORMAT_MAX];
+    char humidityText[FIXED_FORMAT_MAX];
+    fixed_format(tempText, sample.tempCenti, FIXED_CENTI, 1);
+    fixed_format(humidityText, sample.humidityCenti, FIXED_CENTI, 1);
     
-    String soilStatus;
-    if (soilPercent < 30) {
+    const SoilReading& soil = sample.soil[0];
+    const char* soilStatus;
+    if (soil.percent < 30) {
         soilStatus = "DRY";
-    } else if (soilPercent < 60) {
+    } else if (soil.percent < 60) {
         soilStatus = "OK";
     } else {
         soilStatus = "WET";
     }
-    status += "\"status\":\"" + soilStatus + "\"";
-    status += "}";
     
-    mqttClient.publish(MQTT_TOPIC_STATUS, status.c_str());
-    Serial.println("MQTT Status sent: " + status);
+    int len = snprintf(status, size,
+                       "{\"temperature\":%s,\"humidity\":%s,\"soil_moisture\":%d,"
+                       "\"pump_enabled\":%s,\"sensor_ok\":%s,\"status\":\"%s\","
+                       "\"soil_moisture_uncomp\":%d,\"soil_raw\":%d,\"soil_raw_comp\":%d,\"fault\":\"%s\"",
+                       tempText, humidityText, soil.percent,
+                       pumpServiceEnabled ? "true" : "false",
+                       sht31Available ? "true" : "false",
+                       soilStatus,
+                       soil.percentUncomp, soil.raw, soil.rawComp,
+                       safetyFaultName(safetyFault()));
+    for (uint8_t zone = 1; zone < SOIL_ZONE_COUNT; zone++) {
+        len += snprintf(status + len, size - len, ",\"soil_moisture_%u\":%d,\"soil_raw_%u\":%d",
+                        zone, sample.soil[zone].percent, zone, sample.soil[zone].raw);
+    }
+    if (requestId != NULL) {
+        len += snprintf(status + len, size - len, ",\"req\":\"%s\"", requestId);
+    }
+    snprintf(status + len, size - len, "}");
+}
+
+void sendMQTTStatus(const SensorSample& sample, const char* requestId) {
+    char status[WEB_STATUS_MAX];
+    formatStatus(status, sizeof(status), sample, requestId);
+    
+    // A reply goes out at once, outside the batches
+    publishStatus(status);
+    LOG_DEBUG("MQTT Status sent: %s", status);
+}
+
+void sendCachedStatus(const char* requestId) {
+    if (!latestSample.valid) {
+        readSensorSample(&latestSample);
+    }
+    sendMQTTStatus(latestSample, requestId);
 }
 
-float readSHT31Temperature() {
-    float temp = sht31.readTemperature();
-    if (isnan(temp)) {
-        Serial.println("Failed to read temperature!");
-        return 0;
+// The temperature of this sample also compensates the soil readings, here
+// and in runPump() until the next sample. All readings go through the
+// anomaly checks.
+void readSensorSample(SensorSample* sample) {
+    bool tempOk = readSHT31(&sample->tempCenti, &sample->humidityCenti);
+    sample->tempValid = safetyCheckTemperature(sample->tempCenti, tempOk);
+    soilUpdateTemperature(sample->tempCenti, sample->tempValid);
+    
+    for (uint8_t zone = 0; zone < SOIL_ZONE_COUNT; zone++) {
+        SoilReading& soil = sample->soil[zone];
+        soil.raw = getSoilRaw(zone);
+        safetyCheckSoil(zone, soil.raw);
+        soil.rawComp = soilCompensateRaw(zone, soil.raw);
+        soil.percent = soilPercentFromRaw(zone, soil.rawComp);
+        soil.percentUncomp = soilPercentFromRaw(zone, soil.raw);
     }
-    return temp;
+    sample->valid = true;
+}
+
+bool probeSHT31() {
+    return sht31_init() == ESP_OK;
+}
+
+// Track consecutive failures; enough of them drops the sensor into
+// degraded mode and lets loop() recover the bus and re-probe
+static void recordSHT31Result(bool ok) {
+    static uint8_t consecutiveFailures = 0;
+    
+    if (ok) {
+        consecutiveFailures = 0;
+        return;
+    }
+    healthRecordSensorError();
+    if (++consecutiveFailures >= HEALTH_SENSOR_MAX_FAILURES) {
+        LOG_ERROR("SHT31 not responding, entering degraded mode");
+        sht31Available = false;
+        displayWake();
+        consecutiveFailures = 0;
+    }
+}
+
+// One measurement for both values; 0 on failure
+bool readSHT31(int32_t* tempCenti, int32_t* humidityCenti) {
+    *tempCenti = 0;
+    *humidityCenti = 0;
+    if (!sht31Available) {
+        return false;
+    }
+    
+    esp_err_t ret = sht31_read(tempCenti, humidityCenti);
+    recordSHT31Result(ret == ESP_OK);
+    if (ret != ESP_OK) {
+        LOG_WARN("Failed to read SHT31: %s", esp_err_to_name(ret));
+        *tempCenti = 0;
+        *humidityCenti = 0;
+        return false;
+    }
+    return true;
+}
+
+int getSoilRaw(uint8_t zone) {
+    return soilReadRaw(zone);
+}
+
+// Compensated with the temperature of the latest sample
+int getSoilPercent(uint8_t zone) {
+    return soilPercentFromRaw(zone, soilCompensateRaw(zone, getSoilRaw(zone)));
 }
 
-float readSHT31Humidity() {
-    float humidity = sht31.readHumidity();
-    if (isnan(humidity)) {
-        Serial.println("Failed to read humidity!");
-        return 0;
+static bool startPump(uint8_t pump, uint32_t volumeMl, PumpRunKind kind, int rawBefore) {
+    if (!pumpStart(pump, volumeMl, kind)) {
+        return false;
     }
-    return humidity;
+    pumpRawBefore[pump] = rawBefore;
+    lastPumpTime = millis();
+    return true;
 }
 
-int getSoilRaw() {
-    return analogRead(soilHumiditySensor);
+// Early stop of every pump when the service is disabled; the pulses are
+// still reported
+void stopPump() {
+    for (uint8_t pump = 0; pump < PUMP_COUNT; pump++) {
+        pumpStop(pump);
+    }
 }
 
-int getSoilPercent() {
-    int soilPercent = map(analogRead(soilHumiditySensor), AIR_VALUE, WATER_VALUE, 0, 100);
-    return constrain(soilPercent, 0, 100);
+// Bookkeeping once the pulse has ended; the cooldown starts here
+void onPumpDone(const PumpPulse& pulse) {
+    uint32_t actualMs = pulse.actualUs / 1000;
+    safetyRecordPump(pulse.pump, actualMs, pumpRawBefore[pulse.pump], pulse.kind == PUMP_RUN_AUTO);
+    if (pulse.kind == PUMP_RUN_CALIBRATION) {
+        return;
+    }
+    timerStart(pumpCooldownTimers[pulse.pump], PUMP_COOLDOWN);
+    
+    // Delivered volume, scaled down if the run was cut short
+    uint32_t deliveredMl = pulse.requestedUs ? (uint32_t)((uint64_t)pulse.volumeMl * pulse.actualUs / pulse.requestedUs) : 0;
+    bool manual = pulse.kind == PUMP_RUN_MANUAL;
+    LOG_INFO("%s complete on pump %u: %lu mL in %lu ms", manual ? "Manual watering" : "Watering",
+             pulse.pump, (unsigned long)deliveredMl, (unsigned long)actualMs);
+    
+    char event[144];
+    snprintf(event, sizeof(event), "{\"event\":\"pump_activated\",\"pump\":%u,\"ml\":%lu,\"ms\":%lu,\"width_err_us\":%ld%s}",
+             pulse.pump, (unsigned long)deliveredMl, (unsigned long)actualMs, (long)pulse.widthErrorUs,
+             manual ? ",\"type\":\"manual\"" : "");
+    publishEvent(event);
 }
 
-void initPumpService() {
-    pinMode(pumpPin, OUTPUT);
-    digitalWrite(pumpPin, LOW);
+// Time until the pump may run again, including a run in progress
+unsigned long pumpCooldownRemaining(uint8_t pump) {
+    if (pumpRunning(pump)) {
+        return pumpRemainingMs(pump) + PUMP_COOLDOWN;
+    }
+    return timerRemainingMs(pumpCooldownTimers[pump]);
 }
 
-void runPump() {
-    // Check if pump service is enabled
-    if (!pumpServiceEnabled) {
+// Each zone waters from its own probe and pump, with its own cooldown
+void runPump(uint8_t zone) {
+    // Check if pump service is enabled and no fault is latched
+    if (!pumpServiceEnabled || safetyFaultLatched() || pumpRunning(zone)) {
         return;
     }
     
-    int soilPercent = getSoilPercent();
-    unsigned long currentTime = millis();
+    // An unplugged probe reads as bone dry; never water on such a reading
+    // while the sample checks confirm it
+    int soilRaw = getSoilRaw(zone);
+    if (!safetySoilInRange(soilRaw)) {
+        return;
+    }
+    int soilPercent = soilPercentFromRaw(zone, soilCompensateRaw(zone, soilRaw));
     
     if (soilPercent <= DRY_THRESHOLD) {
-        if (currentTime - lastPumpTime >= PUMP_COOLDOWN) {
-            Serial.println("PUMP ON - Watering plant...");
-            digitalWrite(pumpPin, HIGH);
-            delay(PUMP_DURATION);
-            digitalWrite(pumpPin, LOW);
-            
-            lastPumpTime = currentTime;
-            
-            Serial.print("Watering complete (");
-            Serial.print(PUMP_DURATION / 1000);
-            Serial.println(" seconds)");
-            
-            mqttClient.publish(MQTT_TOPIC_STATUS, "{\"event\":\"pump_activated\"}");
-            
-            delay(10000);
+        if (!timerActive(pumpCooldownTimers[zone])) {
+            if (!safetyPumpAllowed(pumpDoseUs(zone, PUMP_DOSE_ML) / 1000)) {
+                return;
+            }
+            LOG_INFO("PUMP %u ON - Watering zone (%lu mL)...", zone, (unsigned long)PUMP_DOSE_ML);
+            displayWake();
+            startPump(zone, PUMP_DOSE_ML, PUMP_RUN_AUTO, soilRaw);
         } else {
-            unsigned long timeLeft = (PUMP_COOLDOWN - (currentTime - lastPumpTime)) / 1000;
-            Serial.print("Pump cooldown: ");
-            Serial.print(timeLeft);
-            Serial.println(" seconds remaining");
+            LOG_DEBUG("Pump %u cooldown: %lu seconds remaining", zone, pumpCooldownRemaining(zone) / 1000);
         }
-    } else if (soilPercent >= WET_THRESHOLD) {
-        digitalWrite(pumpPin, LOW);
     }
 }
 
-void updateDisplay(float temp, float humidity, int soilPercent) {
-    oled_clear();
-    
-    oled_print(0, 0, "Temp:");
-    oled_print_float(36, 0, temp, 1);
-    oled_print(72, 0, "C");
-    
-    oled_print(0, 12, "Hum:");
-    oled_print_float(30, 12, humidity, 1);
-    oled_print(66, 12, "%");
-    
-    oled_print(0, 24, "Soil:");
-    oled_print_number(36, 24, soilPercent);
-    oled_print(60, 24, "%");
-    
-    oled_draw_rect(0, 36, 100, 8, 1);
-    oled_fill_rect(2, 38, (soilPercent * 96) / 100, 4, 1);
-    
-    if (soilPercent < 30) {
-        oled_print(0, 50, "Status: DRY");
-    } else if (soilPercent < 60) {
-        oled_print(0, 50, "Status: OK");
-    } else {
-        oled_print(0, 50, "Status: WET");
+// A rule's dose runs under the same limits as an automatic one: service
+// enabled, no latched fault, cooldown over, probe in range, runtime caps
+bool rulePump(uint32_t volumeMl) {
+    if (!pumpServiceEnabled || safetyFaultLatched() || pumpRunning(0) || timerActive(pumpCooldownTimers[0])) {
+        return false;
     }
-    
-    oled_display();
+    if (volumeMl > PUMP_MAX_DOSE_ML) {
+        volumeMl = PUMP_MAX_DOSE_ML;
+    }
+    int soilRaw = getSoilRaw(0);
+    if (!safetySoilInRange(soilRaw) || !safetyPumpAllowed(pumpDoseUs(0, volumeMl) / 1000)) {
+        return false;
+    }
+    LOG_INFO("RULE PUMP - Watering plant (%lu mL)...", (unsigned long)volumeMl);
+    displayWake();
+    return startPump(0, volumeMl, PUMP_RUN_AUTO, soilRaw);
 }
 
-void manualPump() {
-    unsigned long currentTime = millis();
+// 0 mL waters the default dose
+void manualPump(uint32_t volumeMl, uint8_t pump) {
+    if (volumeMl == 0) {
+        volumeMl = PUMP_DOSE_ML;
+    }
+    if (volumeMl > PUMP_MAX_DOSE_ML) {
+        LOG_WARN("Manual dose of %lu mL refused, limit %d mL", (unsigned long)volumeMl, PUMP_MAX_DOSE_ML);
+        publishEvent("{\"event\":\"pump_blocked\",\"reason\":\"dose_limit\"}");
+        return;
+    }
     
     // Check cooldown period
-    if (currentTime - lastPumpTime >= PUMP_COOLDOWN) {
-        Serial.println("MANUAL PUMP ACTIVATED - Watering plant...");
-        digitalWrite(pumpPin, HIGH);
-        delay(PUMP_DURATION);
-        digitalWrite(pumpPin, LOW);
-        
-        lastPumpTime = currentTime;
-        
-        Serial.print("Manual watering complete (");
-        Serial.print(PUMP_DURATION / 1000);
-        Serial.println(" seconds)");
-        
-        // Send notification via MQTT
-        mqttClient.publish(MQTT_TOPIC_STATUS, "{\"event\":\"pump_activated\",\"type\":\"manual\"}");
+    if (!pumpRunning(pump) && !timerActive(pumpCooldownTimers[pump])) {
+        // Runtime caps apply to manual runs too; a latched fault does not
+        if (!safetyPumpAllowed(pumpDoseUs(pump, volumeMl) / 1000)) {
+            LOG_WARN("Manual watering refused, pump runtime cap reached");
+            publishEvent("{\"event\":\"pump_blocked\",\"reason\":\"runtime_cap\"}");
+            return;
+        }
+        LOG_INFO("MANUAL PUMP %u ACTIVATED - Watering zone (%lu mL)...", pump, (unsigned long)volumeMl);
+        displayWake();
+        startPump(pump, volumeMl, PUMP_RUN_MANUAL, 0);
     } else {
-        unsigned long timeLeft = (PUMP_COOLDOWN - (currentTime - lastPumpTime)) / 1000;
-        Serial.print("Pump cooldown active: ");
-        Serial.print(timeLeft);
-        Serial.println(" seconds remaining");
+        unsigned long timeLeft = pumpCooldownRemaining(pump) / 1000;
+        LOG_INFO("Pump cooldown active: %lu seconds remaining", timeLeft);
         
         // Send cooldown message
         String cooldownMsg = "{\"event\":\"pump_cooldown\",\"seconds\":" + String(timeLeft) + "}";
-        mqttClient.publish(MQTT_TOPIC_STATUS, cooldownMsg.c_str());
+        publishEvent(cooldownMsg.c_str());
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,377 @@
+#include "mqtt_tls.h"
+#include "logger.h"
+#include <esp_system.h>
+#include <mbedtls/net_sockets.h>
+
+#define MQTT_TLS_RTC_MAGIC 0x544C5353
+
+// Serialized session, kept across resets other than power-on so the first
+// connection after an OTA restart or a crash resumes too
+struct MqttTlsRtcSession {
+    uint32_t magic;
+    uint32_t peer;              // hash of host and port
+    uint16_t length;
+    uint8_t data[MQTT_TLS_RTC_SESSION_MAX];
+};
+
+static RTC_NOINIT_ATTR MqttTlsRtcSession rtcSession;
+
+// FNV-1a; a session is only offered to the broker it came from
+static uint32_t peerHash(const char* host, uint16_t port) {
+    uint32_t hash = 2166136261u;
+    for (const char* c = host; *c != '\0'; c++) {
+        hash = (hash ^ (uint8_t)*c) * 16777619u;
+    }
+    hash = (hash ^ (port & 0xFF)) * 16777619u;
+    return (hash ^ (port >> 8)) * 16777619u;
+}
+
+MqttTlsClient::MqttTlsClient()
+    : caPem(NULL), certPem(NULL), keyPem(NULL), configured(false), open(false), haveSession(false), peeked(-1) {
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&drbg);
+    mbedtls_ssl_config_init(&conf);
+    mbedtls_ssl_init(&ssl);
+    mbedtls_x509_crt_init(&caCert);
+    mbedtls_x509_crt_init(&clientCert);
+    mbedtls_pk_init(&clientKey);
+    mbedtls_ssl_session_init(&session);
+    memset(&stats, 0, sizeof(stats));
+}
+
+MqttTlsClient::~MqttTlsClient() {
+    stop();
+    mbedtls_ssl_session_free(&session);
+    mbedtls_pk_free(&clientKey);
+    mbedtls_x509_crt_free(&clientCert);
+    mbedtls_x509_crt_free(&caCert);
+    mbedtls_ssl_config_free(&conf);
+    mbedtls_ctr_drbg_free(&drbg);
+    mbedtls_entropy_free(&entropy);
+}
+
+void MqttTlsClient::setCACert(const char* ca) {
+    caPem = ca;
+}
+
+void MqttTlsClient::setCertificate(const char* cert, const char* key) {
+    certPem = cert;
+    keyPem = key;
+}
+
+bool MqttTlsClient::setupConfig() {
+    int ret;
+    if (caPem == NULL) {
+        LOG_ERROR("TLS: no CA certificate set");
+        return false;
+    }
+    if ((ret = mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy,
+                                     (const unsigned char*)"growbox", 7)) != 0 ||
+        (ret = mbedtls_x509_crt_parse(&caCert, (const unsigned char*)caPem, strlen(caPem) + 1)) != 0 ||
+        (ret = mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                           MBEDTLS_SSL_PRESET_DEFAULT)) != 0) {
+        LOG_ERROR("TLS: setup failed, -0x%04x", -ret);
+        stats.lastError = ret;
+        return false;
+    }
+    if (certPem != NULL && keyPem != NULL) {
+        if ((ret = mbedtls_x509_crt_parse(&clientCert, (const unsigned char*)certPem, strlen(certPem) + 1)) != 0 ||
+            (ret = mbedtls_pk_parse_key(&clientKey, (const unsigned char*)keyPem, strlen(keyPem) + 1, NULL, 0)) != 0 ||
+            (ret = mbedtls_ssl_conf_own_cert(&conf, &clientCert, &clientKey)) != 0) {
+            LOG_ERROR("TLS: client certificate rejected, -0x%04x", -ret);
+            stats.lastError = ret;
+            return false;
+        }
+    }
+
+    // The broker's chain must end in our CA; no fallback to a CA bundle
+    mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_ca_chain(&conf, &caCert, NULL);
+    mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &drbg);
+    // TLS 1.2: tickets, session ids and max fragment length all apply
+    mbedtls_ssl_conf_min_version(&conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+    mbedtls_ssl_conf_max_frag_len(&conf, MQTT_TLS_MAX_FRAG_LEN);
+#endif
+    configured = true;
+    return true;
+}
+
+// Offer the cached session, from RAM or else from RTC memory
+bool MqttTlsClient::restoreSession(const char* host, uint16_t port) {
+    uint32_t peer = peerHash(host, port);
+    if (rtcSession.magic != MQTT_TLS_RTC_MAGIC || rtcSession.peer != peer) {
+        haveSession = false;
+        return false;
+    }
+    if (!haveSession) {
+        if (rtcSession.length > sizeof(rtcSession.data) ||
+            mbedtls_ssl_session_load(&session, rtcSession.data, rtcSession.length) != 0) {
+            forgetSession();
+            return false;
+        }
+        haveSession = true;
+    }
+    return mbedtls_ssl_set_session(&ssl, &session) == 0;
+}
+
+void MqttTlsClient::saveSession(const char* host, uint16_t port) {
+    mbedtls_ssl_session_free(&session);
+    mbedtls_ssl_session_init(&session);
+    haveSession = mbedtls_ssl_get_session(&ssl, &session) == 0;
+    if (!haveSession) {
+        forgetSession();
+        return;
+    }
+    size_t length = 0;
+    rtcSession.peer = peerHash(host, port);
+    if (mbedtls_ssl_session_save(&session, rtcSession.data, sizeof(rtcSession.data), &length) == 0) {
+        rtcSession.length = length;
+    } else {
+        // Too big for RTC (peer certificate kept): resumes until a reset
+        rtcSession.length = UINT16_MAX;
+    }
+    rtcSession.magic = MQTT_TLS_RTC_MAGIC;
+}
+
+void MqttTlsClient::forgetSession() {
+    rtcSession.magic = 0;
+    mbedtls_ssl_session_free(&session);
+    mbedtls_ssl_session_init(&session);
+    haveSession = false;
+}
+
+int MqttTlsClient::sendCallback(void* ctx, const unsigned char* buf, size_t len) {
+    MqttTlsClient* client = (MqttTlsClient*)ctx;
+    size_t sent = client->tcp.write(buf, len);
+    if (sent == 0) {
+        return client->tcp.connected() ? MBEDTLS_ERR_SSL_WANT_WRITE : MBEDTLS_ERR_NET_SEND_FAILED;
+    }
+    return sent;
+}
+
+// Never blocks: mbedTLS sees WANT_READ until bytes are in
+int MqttTlsClient::recvCallback(void* ctx, unsigned char* buf, size_t len) {
+    MqttTlsClient* client = (MqttTlsClient*)ctx;
+    if (client->tcp.available() <= 0) {
+        return client->tcp.connected() ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_CONN_RESET;
+    }
+    int received = client->tcp.read(buf, len);
+    return received > 0 ? received : MBEDTLS_ERR_SSL_WANT_READ;
+}
+
+int MqttTlsClient::connect(IPAddress ip, uint16_t port) {
+    return connect(ip.toString().c_str(), port);
+}
+
+int MqttTlsClient::connect(const char* host, uint16_t port) {
+    stop();
+    if (!configured && !setupConfig()) {
+        return 0;
+    }
+
+    uint32_t startMs = millis();
+    uint32_t heapBefore = esp_get_free_heap_size();
+    if (!tcp.connect(host, port)) {
+        stats.failures++;
+        return 0;
+    }
+    // Records are small; do not hold them back for coalescing
+    tcp.setNoDelay(true);
+
+    int ret = mbedtls_ssl_setup(&ssl, &conf);
+    if (ret == 0) {
+        ret = mbedtls_ssl_set_hostname(&ssl, host);
+    }
+    mbedtls_ssl_set_bio(&ssl, this, sendCallback, recvCallback, NULL);
+    bool offered = ret == 0 && restoreSession(host, port);
+
+    uint32_t heapMin = heapBefore;
+    while (ret == 0 && (ret = mbedtls_ssl_handshake(&ssl)) != 0) {
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            break;
+        }
+        uint32_t heap = esp_get_free_heap_size();
+        if (heap < heapMin) {
+            heapMin = heap;
+        }
+        if (millis() - startMs > MQTT_TLS_HANDSHAKE_TIMEOUT_MS) {
+            ret = MBEDTLS_ERR_SSL_TIMEOUT;
+            break;
+        }
+        delay(1);
+    }
+    uint32_t elapsedMs = millis() - startMs;
+
+    if (ret != 0) {
+        LOG_ERROR("TLS handshake with %s failed after %lu ms, -0x%04x (verify 0x%lx)", host,
+                  (unsigned long)elapsedMs, -ret, (unsigned long)mbedtls_ssl_get_verify_result(&ssl));
+        stats.failures++;
+        stats.lastError = ret;
+        // A stale session must not fail every later attempt too
+        if (offered) {
+            forgetSession();
+        }
+        mbedtls_ssl_free(&ssl);
+        mbedtls_ssl_init(&ssl);
+        tcp.stop();
+        return 0;
+    }
+
+    // A resumed session keeps the master secret of the cached one
+    bool resumed = offered && memcmp(ssl.session->master, session.master, sizeof(session.master)) == 0;
+    saveSession(host, port);
+    open = true;
+
+    uint32_t heapAfter = esp_get_free_heap_size();
+    stats.handshakes++;
+    stats.lastMs = elapsedMs;
+    stats.heapUsed = heapBefore > heapAfter ? heapBefore - heapAfter : 0;
+    if (heapBefore - heapMin > stats.heapPeak) {
+        stats.heapPeak = heapBefore - heapMin;
+    }
+    if (resumed) {
+        stats.resumed++;
+        if (elapsedMs > stats.resumedMsMax) {
+            stats.resumedMsMax = elapsedMs;
+        }
+    } else if (elapsedMs > stats.fullMsMax) {
+        stats.fullMsMax = elapsedMs;
+    }
+    LOG_INFO("TLS %s handshake in %lu ms (%s), %lu B heap, peak %lu B", resumed ? "resumed" : "full",
+             (unsigned long)elapsedMs, mbedtls_ssl_get_ciphersuite(&ssl), (unsigned long)stats.heapUsed,
+             (unsigned long)(heapBefore - heapMin));
+    return 1;
+}
+
+void MqttTlsClient::freeConnection() {
+    mbedtls_ssl_free(&ssl);
+    mbedtls_ssl_init(&ssl);
+    open = false;
+    peeked = -1;
+}
+
+size_t MqttTlsClient::write(uint8_t b) {
+    return write(&b, 1);
+}
+
+size_t MqttTlsClient::write(const uint8_t* buf, size_t size) {
+    if (!open) {
+        return 0;
+    }
+    size_t done = 0;
+    uint32_t startMs = millis();
+    while (done < size) {
+        int ret = mbedtls_ssl_write(&ssl, buf + done, size - done);
+        if (ret > 0) {
+            done += ret;
+            continue;
+        }
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            stats.lastError = ret;
+            stop();
+            break;
+        }
+        // Socket buffer full: let the WiFi stack drain it, up to the deadline
+        if (millis() - startMs > MQTT_TLS_WRITE_TIMEOUT_MS) {
+            LOG_WARN("TLS write stalled for %lu ms, closing", (unsigned long)(millis() - startMs));
+            stats.lastError = MBEDTLS_ERR_SSL_TIMEOUT;
+            stop();
+            break;
+        }
+        delay(1);
+    }
+    return done;
+}
+
+int MqttTlsClient::available() {
+    if (!open) {
+        return 0;
+    }
+    if (peeked >= 0) {
+        return 1 + mbedtls_ssl_get_bytes_avail(&ssl);
+    }
+    size_t buffered = mbedtls_ssl_get_bytes_avail(&ssl);
+    if (buffered > 0 || tcp.available() <= 0) {
+        return buffered;
+    }
+    // Ciphertext waiting: decrypt the record to see whether it holds data
+    peek();
+    return peeked >= 0 ? 1 + mbedtls_ssl_get_bytes_avail(&ssl) : 0;
+}
+
+int MqttTlsClient::read() {
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+}
+
+int MqttTlsClient::read(uint8_t* buf, size_t size) {
+    if (!open || size == 0) {
+        return -1;
+    }
+    size_t got = 0;
+    if (peeked >= 0) {
+        buf[got++] = (uint8_t)peeked;
+        peeked = -1;
+        if (got == size || mbedtls_ssl_get_bytes_avail(&ssl) == 0) {
+            return got;
+        }
+    }
+    int ret = mbedtls_ssl_read(&ssl, buf + got, size - got);
+    if (ret > 0) {
+        return got + ret;
+    }
+    if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+        // Close notify from the broker, or a broken record
+        if (ret != MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
+            stats.lastError = ret;
+        }
+        stop();
+    }
+    return got > 0 ? (int)got : -1;
+}
+
+int MqttTlsClient::peek() {
+    if (!open) {
+        return -1;
+    }
+    if (peeked < 0) {
+        uint8_t b;
+        int ret = mbedtls_ssl_read(&ssl, &b, 1);
+        if (ret == 1) {
+            peeked = b;
+        } else if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            if (ret != MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
+                stats.lastError = ret;
+            }
+            stop();
+        }
+    }
+    return peeked;
+}
+
+void MqttTlsClient::flush() {
+    tcp.flush();
+}
+
+void MqttTlsClient::stop() {
+    if (open) {
+        mbedtls_ssl_close_notify(&ssl);
+        freeConnection();
+    }
+    tcp.stop();
+}
+
+uint8_t MqttTlsClient::connected() {
+    return open && (peeked >= 0 || mbedtls_ssl_get_bytes_avail(&ssl) > 0 || tcp.connected());
+}
+
+void MqttTlsClient::takeStats(MqttTlsStats* out) {
+    *out = stats;
+    uint32_t heapUsed = stats.heapUsed;
+    memset(&stats, 0, sizeof(stats));
+    stats.heapUsed = heapUsed;
+}
@@ -0,0 +1,103 @@
+#ifndef MQTT_TLS_H
+#define MQTT_TLS_H
+
+#include <WiFi.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/x509_crt.h>
+#include <mbedtls/pk.h>
+
+// TLS transport for PubSubClient (build with -DMQTT_TLS). mbedTLS runs over
+// a plain WiFiClient, so the session can be kept: after the first full
+// handshake the session (ticket or id) is cached in RAM and in RTC memory,
+// and later connections, after a drop, OTA restart or crash, resume it
+// with one round trip and no certificate or key exchange work.
+
+// Largest serialized session kept in RTC memory; bigger ones stay in RAM
+#define MQTT_TLS_RTC_SESSION_MAX 1536
+
+// Give up on a handshake after this long
+#define MQTT_TLS_HANDSHAKE_TIMEOUT_MS 10000
+
+// Give up on a write the broker does not take for this long; the record
+// is half sent by then, so the connection is closed
+#define MQTT_TLS_WRITE_TIMEOUT_MS 5000
+
+// Ask the broker for records of at most 2 KiB (RFC 6066 max fragment
+// length). This does not save heap in the prebuilt core: its receive
+// buffer is a fixed 16 KiB, allocated at setup whatever is negotiated.
+#define MQTT_TLS_MAX_FRAG_LEN MBEDTLS_SSL_MAX_FRAG_LEN_2048
+
+// Handshake cost since the last mqttTlsTakeStats()
+struct MqttTlsStats {
+    uint32_t handshakes;
+    uint32_t resumed;
+    uint32_t failures;
+    uint32_t fullMsMax;
+    uint32_t resumedMsMax;
+    uint32_t lastMs;
+    uint32_t heapUsed;          // held by the open connection
+    uint32_t heapPeak;          // most taken at once during the handshake
+    int lastError;              // mbedTLS error code, 0 if none
+};
+
+class MqttTlsClient : public Client {
+public:
+    MqttTlsClient();
+    ~MqttTlsClient();
+
+    // PEM strings, kept by pointer. The CA is required: the broker's chain
+    // must end in it. Certificate and key are only needed for brokers that
+    // ask for a client certificate.
+    void setCACert(const char* ca);
+    void setCertificate(const char* cert, const char* key);
+
+    int connect(IPAddress ip, uint16_t port);
+    int connect(const char* host, uint16_t port);
+    size_t write(uint8_t b);
+    size_t write(const uint8_t* buf, size_t size);
+    int available();
+    int read();
+    int read(uint8_t* buf, size_t size);
+    int peek();
+    void flush();
+    void stop();
+    uint8_t connected();
+    operator bool() { return connected(); }
+
+    // Drop the cached session, e.g. after the broker's certificate changed
+    void forgetSession();
+
+    void takeStats(MqttTlsStats* stats);
+
+private:
+    bool setupConfig();
+    bool restoreSession(const char* host, uint16_t port);
+    void saveSession(const char* host, uint16_t port);
+    void freeConnection();
+
+    static int sendCallback(void* ctx, const unsigned char* buf, size_t len);
+    static int recvCallback(void* ctx, unsigned char* buf, size_t len);
+
+    WiFiClient tcp;
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context drbg;
+    mbedtls_ssl_config conf;
+    mbedtls_ssl_context ssl;
+    mbedtls_x509_crt caCert;
+    mbedtls_x509_crt clientCert;
+    mbedtls_pk_context clientKey;
+    mbedtls_ssl_session session;
+
+    const char* caPem;
+    const char* certPem;
+    const char* keyPem;
+    bool configured;
+    bool open;
+    bool haveSession;
+    int peeked;
+    MqttTlsStats stats;
+};
+
+#endif
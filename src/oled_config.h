@@ -0,0 +1,101 @@
+#ifndef OLED_CONFIG_H
+#define OLED_CONFIG_H
+
+// Compile-time display selection. Override from build_flags, e.g.
+//   -DOLED_PANEL=OLED_PANEL_SH1106 -DOLED_TRANSPORT=OLED_TRANSPORT_SPI
+// Only the selected panel and transport are compiled in.
+
+#define OLED_PANEL_SSD1306 1
+#define OLED_PANEL_SH1106 2
+
+#define OLED_TRANSPORT_I2C 1
+#define OLED_TRANSPORT_SPI 2
+
+#ifndef OLED_PANEL
+#define OLED_PANEL OLED_PANEL_SSD1306
+#endif
+
+#ifndef OLED_TRANSPORT
+#define OLED_TRANSPORT OLED_TRANSPORT_I2C
+#endif
+
+// Visible geometry
+#ifndef OLED_WIDTH
+#define OLED_WIDTH 128
+#endif
+#ifndef OLED_HEIGHT
+#define OLED_HEIGHT 64
+#endif
+
+// Controller RAM width and the RAM column shown at x = 0
+#if OLED_PANEL == OLED_PANEL_SH1106
+#define OLED_RAM_COLUMNS 132
+#ifndef OLED_COLUMN_OFFSET
+#define OLED_COLUMN_OFFSET 2
+#endif
+#else
+#define OLED_RAM_COLUMNS 128
+#ifndef OLED_COLUMN_OFFSET
+#define OLED_COLUMN_OFFSET 0
+#endif
+#endif
+
+// Only the SSD1306 has hardware scrolling
+#if OLED_PANEL == OLED_PANEL_SSD1306
+#define OLED_HW_SCROLL 1
+#else
+#define OLED_HW_SCROLL 0
+#endif
+
+#define OLED_PAGES (OLED_HEIGHT / 8)
+#define OLED_BUFFER_SIZE (OLED_WIDTH * OLED_PAGES)
+
+#if OLED_HEIGHT % 8 != 0 || OLED_HEIGHT > 64
+#error "OLED_HEIGHT must be a multiple of 8, at most 64"
+#endif
+#if OLED_WIDTH + OLED_COLUMN_OFFSET > OLED_RAM_COLUMNS
+#error "OLED_WIDTH does not fit the controller RAM"
+#endif
+
+// I2C: address and clock on the bus shared with the SHT31 (i2c_bus.h);
+// both controllers are fast-mode parts
+#ifndef OLED_I2C_ADDRESS
+#define OLED_I2C_ADDRESS 0x3C
+#endif
+#ifndef OLED_I2C_CLOCK_HZ
+#define OLED_I2C_CLOCK_HZ 400000
+#endif
+
+// SPI: HSPI pins clear of the LED (23), pump (5) and I2C (19/21) pins
+#ifndef OLED_SPI_HOST
+#define OLED_SPI_HOST HSPI_HOST
+#endif
+#ifndef OLED_SPI_MOSI
+#define OLED_SPI_MOSI 13
+#endif
+#ifndef OLED_SPI_SCLK
+#define OLED_SPI_SCLK 14
+#endif
+#ifndef OLED_SPI_CS
+#define OLED_SPI_CS 15
+#endif
+#ifndef OLED_SPI_DC
+#define OLED_SPI_DC 27
+#endif
+#ifndef OLED_SPI_RST
+#define OLED_SPI_RST 26     // -1 if tied to the ESP32 reset
+#endif
+#ifndef OLED_SPI_CLOCK_HZ
+#define OLED_SPI_CLOCK_HZ 8000000
+#endif
+
+// Largest data write per transaction: I2C chunks are queued on the shared
+// bus, and a short chunk keeps a sensor read from waiting more than about
+// 0.5 ms; SPI streams a whole frame in one DMA transfer
+#if OLED_TRANSPORT == OLED_TRANSPORT_SPI
+#define OLED_TRANSPORT_MAX_DATA OLED_BUFFER_SIZE
+#else
+#define OLED_TRANSPORT_MAX_DATA 16
+#endif
+
+#endif
@@ -0,0 +1,144 @@
+#include "oled_font.h"
+#include "oled_ssd1306.h"
+#include <stddef.h>
+
+typedef struct {
+    const oled_glyph_t *glyph;      // NULL when the slot is free
+    uint32_t last_used;
+    uint16_t columns[OLED_GLYPH_MAX_WIDTH];  // bit 0 = top row of the box
+} glyph_cache_entry_t;
+
+static glyph_cache_entry_t glyph_cache[OLED_GLYPH_CACHE_SIZE];
+static uint32_t glyph_cache_clock = 0;
+static oled_glyph_cache_stats_t glyph_cache_stats;
+
+static const oled_glyph_t *find_glyph(const oled_font_t *font, uint16_t codepoint) {
+    uint16_t lo = 0;
+    uint16_t hi = font->range_count;
+    while (lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        const oled_glyph_range_t *range = &font->ranges[mid];
+        if (codepoint < range->first) {
+            hi = mid;
+        } else if (codepoint - range->first >= range->count) {
+            lo = mid + 1;
+        } else {
+            return &font->glyphs[range->glyph + codepoint - range->first];
+        }
+    }
+    return &font->glyphs[font->fallback];
+}
+
+static void decode_glyph(const oled_font_t *font, const oled_glyph_t *glyph, uint16_t *columns) {
+    uint32_t bit = glyph->bit_offset;
+    uint8_t height = OLED_GLYPH_HEIGHT(glyph);
+    for (uint8_t c = 0; c < OLED_GLYPH_WIDTH(glyph); c++) {
+        uint16_t mask = 0;
+        for (uint8_t r = 0; r < height; r++, bit++) {
+            if (font->bitmap[bit >> 3] & (0x80 >> (bit & 7))) {
+                mask |= 1 << r;
+            }
+        }
+        columns[c] = mask;
+    }
+}
+
+// Least recently used slot is replaced on a miss
+static const uint16_t *cached_columns(const oled_font_t *font, const oled_glyph_t *glyph) {
+    glyph_cache_entry_t *victim = &glyph_cache[0];
+
+    glyph_cache_clock++;
+    for (uint8_t i = 0; i < OLED_GLYPH_CACHE_SIZE; i++) {
+        glyph_cache_entry_t *entry = &glyph_cache[i];
+        if (entry->glyph == glyph) {
+            entry->last_used = glyph_cache_clock;
+            glyph_cache_stats.hits++;
+            return entry->columns;
+        }
+        if (victim->glyph != NULL && (entry->glyph == NULL || entry->last_used < victim->last_used)) {
+            victim = entry;
+        }
+    }
+
+    glyph_cache_stats.misses++;
+    if (victim->glyph != NULL) {
+        glyph_cache_stats.evictions++;
+    }
+    victim->glyph = glyph;
+    victim->last_used = glyph_cache_clock;
+    decode_glyph(font, glyph, victim->columns);
+    return victim->columns;
+}
+
+// Next codepoint from UTF-8; malformed bytes decode as U+FFFD
+static uint16_t utf8_next(const char **text) {
+    const uint8_t *s = (const uint8_t *)*text;
+    uint32_t cp;
+    uint8_t extra;
+
+    if (s[0] < 0x80) {
+        *text += 1;
+        return s[0];
+    } else if ((s[0] & 0xE0) == 0xC0) {
+        cp = s[0] & 0x1F;
+        extra = 1;
+    } else if ((s[0] & 0xF0) == 0xE0) {
+        cp = s[0] & 0x0F;
+        extra = 2;
+    } else if ((s[0] & 0xF8) == 0xF0) {
+        cp = s[0] & 0x07;
+        extra = 3;
+    } else {
+        *text += 1;
+        return 0xFFFD;
+    }
+
+    for (uint8_t i = 1; i <= extra; i++) {
+        if ((s[i] & 0xC0) != 0x80) {
+            *text += i;
+            return 0xFFFD;
+        }
+        cp = (cp << 6) | (s[i] & 0x3F);
+    }
+    *text += extra + 1;
+
+    // Glyph atlases cover the Basic Multilingual Plane only
+    return cp > 0xFFFF ? 0xFFFD : (uint16_t)cp;
+}
+
+uint8_t oled_font_draw_glyph(const oled_font_t *font, uint8_t x, uint8_t y, uint16_t codepoint) {
+    const oled_glyph_t *glyph = find_glyph(font, codepoint);
+
+    if (glyph->size != 0) {
+        const uint16_t *columns = cached_columns(font, glyph);
+        int16_t top = y + font->ascent + glyph->y_offset;
+        for (uint8_t c = 0; c < OLED_GLYPH_WIDTH(glyph); c++) {
+            int16_t cx = x + glyph->x_offset + c;
+            if (cx >= 0 && top >= 0) {
+                oled_draw_column(cx, top, columns[c], OLED_GLYPH_HEIGHT(glyph));
+            }
+        }
+    }
+
+    return glyph->x_advance;
+}
+
+uint8_t oled_font_print(const oled_font_t *font, uint8_t x, uint8_t y, const char *utf8) {
+    uint16_t pos = x;
+    while (*utf8 && pos < SCREEN_WIDTH) {
+        pos += oled_font_draw_glyph(font, pos, y, utf8_next(&utf8));
+    }
+    return pos - x;
+}
+
+uint16_t oled_font_text_width(const oled_font_t *font, const char *utf8) {
+    uint16_t width = 0;
+    while (*utf8) {
+        width += find_glyph(font, utf8_next(&utf8))->x_advance;
+    }
+    return width;
+}
+
+void oled_font_get_cache_stats(oled_glyph_cache_stats_t *stats) {
+    *stats = glyph_cache_stats;
+}
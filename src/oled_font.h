@@ -0,0 +1,67 @@
+#ifndef OLED_FONT_H
+#define OLED_FONT_H
+
+// Proportional fonts with Unicode coverage, stored as bit-packed glyph
+// atlases generated from Adafruit GFX fonts by tools/fontconv.py
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Decoded glyph cache (column masks in RAM for recently drawn glyphs)
+#define OLED_GLYPH_CACHE_SIZE 16
+#define OLED_GLYPH_MAX_WIDTH 12
+#define OLED_GLYPH_MAX_HEIGHT 15
+
+typedef struct {
+    uint16_t bit_offset;    // into oled_font_t.bitmap, column-major, MSB first
+    uint8_t size;           // trimmed bounding box, width << 4 | height
+    uint8_t x_advance;
+    int8_t x_offset;        // from the cursor to the box's top-left corner
+    int8_t y_offset;        // from the baseline
+} oled_glyph_t;
+
+#define OLED_GLYPH_WIDTH(g) ((g)->size >> 4)
+#define OLED_GLYPH_HEIGHT(g) ((g)->size & 0x0F)
+
+// Run of consecutive codepoints backed by consecutive glyphs
+typedef struct {
+    uint16_t first;
+    uint16_t count;
+    uint16_t glyph;         // index of the glyph for `first`
+} oled_glyph_range_t;
+
+typedef struct {
+    const uint8_t *bitmap;
+    const oled_glyph_t *glyphs;
+    const oled_glyph_range_t *ranges;   // sorted by codepoint
+    uint16_t range_count;
+    uint16_t fallback;              // glyph index drawn for missing codepoints
+    uint8_t ascent;                 // baseline distance from the line top
+    uint8_t y_advance;              // line height
+} oled_font_t;
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+} oled_glyph_cache_stats_t;
+
+// Draw one codepoint with the line top at y; returns the x advance
+uint8_t oled_font_draw_glyph(const oled_font_t *font, uint8_t x, uint8_t y, uint16_t codepoint);
+
+// Print UTF-8 text with the line top at y; returns the width drawn
+uint8_t oled_font_print(const oled_font_t *font, uint8_t x, uint8_t y, const char *utf8);
+
+// Width of UTF-8 text in pixels
+uint16_t oled_font_text_width(const oled_font_t *font, const char *utf8);
+
+void oled_font_get_cache_stats(oled_glyph_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
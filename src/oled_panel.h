@@ -0,0 +1,73 @@
+#ifndef OLED_PANEL_H
+#define OLED_PANEL_H
+
+// Driver-internal interfaces between the shared framebuffer code
+// (oled_ssd1306.c), the panel backend (oled_panel_*.c) and the bus
+// transport (oled_transport_*.c, or oled_sim.c on a host build)
+
+#include <stddef.h>
+#include <stdint.h>
+#include "oled_config.h"
+
+#ifdef OLED_SIMULATOR
+#include <stdio.h>
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) ((void)0)
+#define esp_err_to_name(err) "ESP_FAIL"
+#define pdMS_TO_TICKS(ms) (ms)
+#define vTaskDelay(ticks) ((void)0)
+#else
+#include "esp_err.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Commands common to the SSD1306 and SH1106
+#define OLED_CMD_DISPLAYOFF 0xAE
+#define OLED_CMD_DISPLAYON 0xAF
+#define OLED_CMD_SETDISPLAYCLOCKDIV 0xD5
+#define OLED_CMD_SETMULTIPLEX 0xA8
+#define OLED_CMD_SETDISPLAYOFFSET 0xD3
+#define OLED_CMD_SETSTARTLINE 0x40
+#define OLED_CMD_SEGREMAP 0xA0
+#define OLED_CMD_COMSCANDEC 0xC8
+#define OLED_CMD_SETCOMPINS 0xDA
+#define OLED_CMD_SETCONTRAST 0x81
+#define OLED_CMD_SETPRECHARGE 0xD9
+#define OLED_CMD_SETVCOMDETECT 0xDB
+#define OLED_CMD_DISPLAYALLON_RESUME 0xA4
+#define OLED_CMD_NORMALDISPLAY 0xA6
+#define OLED_CMD_INVERTDISPLAY 0xA7
+#define OLED_CMD_SETPAGE 0xB0
+#define OLED_CMD_SETLOWCOLUMN 0x00
+#define OLED_CMD_SETHIGHCOLUMN 0x10
+
+// Transport: bring up the bus and check the panel answers
+esp_err_t oled_transport_init();
+
+// One transaction of command (control 0x00) or data (control 0x40) bytes
+esp_err_t oled_transport_write(uint8_t control, const uint8_t *bytes, size_t len);
+
+// Counted, logged writes through the transport (oled_ssd1306.c)
+esp_err_t oled_write_commands(const uint8_t *cmds, size_t len);
+esp_err_t oled_write_data(const uint8_t *data, size_t len);
+
+// Panel: initialization sequence, ending with the display on
+esp_err_t oled_panel_init();
+
+// Send columns x0..x1 of pages page0..page1 of the framebuffer
+esp_err_t oled_panel_flush(const uint8_t *buffer, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,64 @@
+#include "oled_panel.h"
+
+#if OLED_PANEL == OLED_PANEL_SH1106
+
+// SH1106: 132-column RAM, page addressing only (no column/page windows,
+// no horizontal addressing mode, no hardware scroll)
+#define SH1106_DCDC_CONTROL 0xAD
+#define SH1106_DCDC_ON 0x8B
+#define SH1106_PUMP_VOLTAGE_8V 0x32
+
+esp_err_t oled_panel_init() {
+    const uint8_t init_cmds[] = {
+        OLED_CMD_DISPLAYOFF,
+        OLED_CMD_SETDISPLAYCLOCKDIV, 0x80,
+        OLED_CMD_SETMULTIPLEX, OLED_HEIGHT - 1,
+        OLED_CMD_SETDISPLAYOFFSET, 0x00,
+        OLED_CMD_SETSTARTLINE | 0x00,
+        SH1106_DCDC_CONTROL, SH1106_DCDC_ON,
+        SH1106_PUMP_VOLTAGE_8V,
+        OLED_CMD_SEGREMAP | 0x01,
+        OLED_CMD_COMSCANDEC,
+        OLED_CMD_SETCOMPINS, 0x12,
+        OLED_CMD_SETCONTRAST, 0xCF,
+        OLED_CMD_SETPRECHARGE, 0x22,
+        OLED_CMD_SETVCOMDETECT, 0x35,
+        OLED_CMD_DISPLAYALLON_RESUME,
+        OLED_CMD_NORMALDISPLAY,
+        OLED_CMD_DISPLAYON,
+    };
+    return oled_write_commands(init_cmds, sizeof(init_cmds));
+}
+
+esp_err_t oled_panel_flush(const uint8_t *buffer, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1) {
+    uint8_t column = x0 + OLED_COLUMN_OFFSET;
+
+    for (uint8_t page = page0; page <= page1; page++) {
+        // The column pointer does not advance to the next page by itself
+        const uint8_t address[] = {
+            (uint8_t)(OLED_CMD_SETPAGE | page),
+            (uint8_t)(OLED_CMD_SETLOWCOLUMN | (column & 0x0F)),
+            (uint8_t)(OLED_CMD_SETHIGHCOLUMN | (column >> 4)),
+        };
+        esp_err_t ret = oled_write_commands(address, sizeof(address));
+        if (ret != ESP_OK) {
+            return ret;
+        }
+
+        const uint8_t *row = &buffer[page * OLED_WIDTH];
+        for (uint16_t x = x0; x <= x1; x += OLED_TRANSPORT_MAX_DATA) {
+            uint16_t chunk_size = OLED_TRANSPORT_MAX_DATA;
+            if (x + chunk_size > x1 + 1) {
+                chunk_size = x1 + 1 - x;
+            }
+            ret = oled_write_data(&row[x], chunk_size);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+        }
+    }
+
+    return ESP_OK;
+}
+
+#endif
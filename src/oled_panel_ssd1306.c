@@ -0,0 +1,83 @@
+#include "oled_panel.h"
+
+#if OLED_PANEL == OLED_PANEL_SSD1306
+
+#define SSD1306_CHARGEPUMP 0x8D
+#define SSD1306_MEMORYMODE 0x20
+#define SSD1306_COLUMNADDR 0x21
+#define SSD1306_PAGEADDR 0x22
+
+// 128x64 panels use alternative COM pins, 128x32 sequential
+#if OLED_HEIGHT > 32
+#define SSD1306_COMPINS 0x12
+#else
+#define SSD1306_COMPINS 0x02
+#endif
+
+esp_err_t oled_panel_init() {
+    const uint8_t init_cmds[] = {
+        OLED_CMD_DISPLAYOFF,
+        OLED_CMD_SETDISPLAYCLOCKDIV, 0x80,
+        OLED_CMD_SETMULTIPLEX, OLED_HEIGHT - 1,
+        OLED_CMD_SETDISPLAYOFFSET, 0x00,
+        OLED_CMD_SETSTARTLINE | 0x00,
+        SSD1306_CHARGEPUMP, 0x14,
+        SSD1306_MEMORYMODE, 0x00,       // horizontal addressing
+        OLED_CMD_SEGREMAP | 0x01,
+        OLED_CMD_COMSCANDEC,
+        OLED_CMD_SETCOMPINS, SSD1306_COMPINS,
+        OLED_CMD_SETCONTRAST, 0xCF,
+        OLED_CMD_SETPRECHARGE, 0xF1,
+        OLED_CMD_SETVCOMDETECT, 0x40,
+        OLED_CMD_DISPLAYALLON_RESUME,
+        OLED_CMD_NORMALDISPLAY,
+        OLED_CMD_DISPLAYON,
+    };
+    return oled_write_commands(init_cmds, sizeof(init_cmds));
+}
+
+esp_err_t oled_panel_flush(const uint8_t *buffer, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1) {
+    const uint8_t window[] = {
+        SSD1306_COLUMNADDR, x0 + OLED_COLUMN_OFFSET, x1 + OLED_COLUMN_OFFSET,
+        SSD1306_PAGEADDR, page0, page1,
+    };
+    esp_err_t ret = oled_write_commands(window, sizeof(window));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    // Full-width windows are contiguous in the buffer and in the address
+    // pointer's walk, so they go out in as few writes as the transport allows
+    if (x0 == 0 && x1 == OLED_WIDTH - 1) {
+        const uint8_t *data = &buffer[page0 * OLED_WIDTH];
+        size_t remaining = (size_t)(page1 - page0 + 1) * OLED_WIDTH;
+        while (remaining > 0) {
+            size_t chunk_size = remaining < OLED_TRANSPORT_MAX_DATA ? remaining : OLED_TRANSPORT_MAX_DATA;
+            ret = oled_write_data(data, chunk_size);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+            data += chunk_size;
+            remaining -= chunk_size;
+        }
+        return ESP_OK;
+    }
+
+    for (uint8_t page = page0; page <= page1; page++) {
+        const uint8_t *row = &buffer[page * OLED_WIDTH];
+        for (uint16_t x = x0; x <= x1; x += OLED_TRANSPORT_MAX_DATA) {
+            uint16_t chunk_size = OLED_TRANSPORT_MAX_DATA;
+            if (x + chunk_size > x1 + 1) {
+                chunk_size = x1 + 1 - x;
+            }
+            ret = oled_write_data(&row[x], chunk_size);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+        }
+    }
+
+    return ESP_OK;
+}
+
+#endif
@@ -0,0 +1,262 @@
+#include "oled_sim.h"
+#include "oled_panel.h"
+
+#ifdef OLED_SIMULATOR
+
+#include <string.h>
+
+#define OLED_SIM_PAGES 8
+
+static oled_sim_state_t sim;
+
+// Command being collected, when it takes argument bytes
+static uint8_t pending_cmd = 0;
+static uint8_t pending_args[7];
+static uint8_t pending_needed = 0;
+static uint8_t pending_count = 0;
+
+// Page addressing mode column start (set by 0x00-0x1F)
+static uint8_t page_mode_column = 0;
+
+// Frames per scroll step, indexed by oled_scroll_speed_t
+static const uint16_t scroll_step_frames[8] = {5, 64, 128, 256, 3, 4, 25, 2};
+
+void oled_sim_reset() {
+    memset(&sim, 0, sizeof(sim));
+    sim.contrast = 0x7F;
+    sim.memory_mode = 2;
+    sim.col_end = OLED_RAM_COLUMNS - 1;
+    sim.page_end = OLED_SIM_PAGES - 1;
+    sim.vscroll_rows = OLED_HEIGHT;
+    pending_needed = 0;
+    pending_count = 0;
+    page_mode_column = 0;
+}
+
+const oled_sim_state_t *oled_sim_state() {
+    return &sim;
+}
+
+static uint8_t command_arg_count(uint8_t cmd) {
+    switch (cmd) {
+        case 0x26: case 0x27:
+            return 6;
+        case 0x29: case 0x2A:
+            return 5;
+        case 0x21: case 0x22: case 0xA3:
+            return 2;
+        case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xAD: case 0xD3:
+        case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static void run_command(uint8_t cmd, const uint8_t *args) {
+    if (cmd >= 0x40 && cmd <= 0x7F) {
+        sim.start_line = cmd & 0x3F;
+    } else if (cmd >= 0xB0 && cmd <= 0xB7) {
+        sim.page = cmd & 0x07;
+    } else if (cmd <= 0x0F) {
+        page_mode_column = (page_mode_column & 0xF0) | cmd;
+        sim.column = page_mode_column;
+    } else if (cmd >= 0x10 && cmd <= 0x1F) {
+        page_mode_column = (page_mode_column & 0x0F) | ((cmd & 0x0F) << 4);
+        sim.column = page_mode_column;
+    } else {
+        switch (cmd) {
+            case 0x20:
+                sim.memory_mode = args[0] & 0x03;
+                break;
+            case 0x21:
+                sim.col_start = args[0] % OLED_RAM_COLUMNS;
+                sim.col_end = args[1] % OLED_RAM_COLUMNS;
+                sim.column = sim.col_start;
+                break;
+            case 0x22:
+                sim.page_start = args[0] & 0x07;
+                sim.page_end = args[1] & 0x07;
+                sim.page = sim.page_start;
+                break;
+            case 0x81:
+                sim.contrast = args[0];
+                break;
+            case 0xA4: case 0xA5:
+                sim.all_on = cmd == 0xA5;
+                break;
+            case 0xA6: case 0xA7:
+                sim.inverted = cmd == 0xA7;
+                break;
+            case 0xAE: case 0xAF:
+                sim.display_on = cmd == 0xAF;
+                break;
+            case 0xA3:
+                sim.vscroll_top = args[0] & 0x3F;
+                sim.vscroll_rows = args[1] & 0x7F;
+                break;
+            case 0x26: case 0x27:
+                sim.scroll_cmd = cmd;
+                sim.scroll_page0 = args[1] & 0x07;
+                sim.scroll_speed = args[2] & 0x07;
+                sim.scroll_page1 = args[3] & 0x07;
+                sim.scroll_vertical_step = 0;
+                break;
+            case 0x29: case 0x2A:
+                sim.scroll_cmd = cmd;
+                sim.scroll_page0 = args[1] & 0x07;
+                sim.scroll_speed = args[2] & 0x07;
+                sim.scroll_page1 = args[3] & 0x07;
+                sim.scroll_vertical_step = args[4] & 0x3F;
+                break;
+            case 0x2F:
+                sim.scroll_active = sim.scroll_cmd != 0;
+                sim.scroll_frames = 0;
+                break;
+            case 0x2E:
+                sim.scroll_active = false;
+                sim.vscroll_offset = 0;
+                break;
+            default:
+                // Timing, charge pump, remap and COM settings: no visible effect here
+                break;
+        }
+    }
+}
+
+static void write_data_byte(uint8_t value) {
+    if (sim.scroll_active) {
+        sim.writes_during_scroll++;
+    }
+    sim.gddram[sim.page & 0x07][sim.column % OLED_RAM_COLUMNS] = value;
+
+    switch (sim.memory_mode) {
+        case 0:
+            if (sim.column++ >= sim.col_end) {
+                sim.column = sim.col_start;
+                if (sim.page++ >= sim.page_end) {
+                    sim.page = sim.page_start;
+                }
+            }
+            break;
+        case 1:
+            if (sim.page++ >= sim.page_end) {
+                sim.page = sim.page_start;
+                if (sim.column++ >= sim.col_end) {
+                    sim.column = sim.col_start;
+                }
+            }
+            break;
+        default:
+            if (sim.column++ >= OLED_RAM_COLUMNS - 1) {
+                sim.column = page_mode_column;
+            }
+            break;
+    }
+}
+
+void oled_sim_write(uint8_t control, const uint8_t *bytes, size_t len) {
+    if (control == 0x40) {
+        sim.data_bytes += len;
+        for (size_t i = 0; i < len; i++) {
+            write_data_byte(bytes[i]);
+        }
+        return;
+    }
+
+    sim.command_bytes += len;
+    for (size_t i = 0; i < len; i++) {
+        if (pending_needed) {
+            pending_args[pending_count++] = bytes[i];
+            if (pending_count == pending_needed) {
+                pending_needed = 0;
+                run_command(pending_cmd, pending_args);
+            }
+            continue;
+        }
+
+        uint8_t needed = command_arg_count(bytes[i]);
+        if (needed) {
+            pending_cmd = bytes[i];
+            pending_needed = needed;
+            pending_count = 0;
+        } else {
+            run_command(bytes[i], NULL);
+        }
+    }
+}
+
+// The panel really rotates GDDRAM while scrolling horizontally
+static void scroll_step() {
+    bool right = sim.scroll_cmd == 0x26 || sim.scroll_cmd == 0x29;
+
+    for (uint8_t page = sim.scroll_page0; page <= sim.scroll_page1 && page < OLED_SIM_PAGES; page++) {
+        uint8_t *row = sim.gddram[page];
+        if (right) {
+            uint8_t last = row[OLED_RAM_COLUMNS - 1];
+            memmove(row + 1, row, OLED_RAM_COLUMNS - 1);
+            row[0] = last;
+        } else {
+            uint8_t first = row[0];
+            memmove(row, row + 1, OLED_RAM_COLUMNS - 1);
+            row[OLED_RAM_COLUMNS - 1] = first;
+        }
+    }
+
+    if (sim.scroll_vertical_step && sim.vscroll_rows) {
+        sim.vscroll_offset = (sim.vscroll_offset + sim.scroll_vertical_step) % sim.vscroll_rows;
+    }
+}
+
+void oled_sim_advance_frames(uint32_t frames) {
+    if (!sim.scroll_active) {
+        return;
+    }
+
+    uint16_t step = scroll_step_frames[sim.scroll_speed];
+    sim.scroll_frames += frames;
+    while (sim.scroll_frames >= step) {
+        sim.scroll_frames -= step;
+        scroll_step();
+    }
+}
+
+uint8_t oled_sim_pixel(uint8_t x, uint8_t y) {
+    if (x >= SCREEN_WIDTH || y >= SCREEN_HEIGHT || !sim.display_on) {
+        return 0;
+    }
+    if (sim.all_on) {
+        return 1;
+    }
+
+    uint8_t row = y;
+    if (sim.vscroll_offset && row >= sim.vscroll_top && row < sim.vscroll_top + sim.vscroll_rows) {
+        row = sim.vscroll_top + (row - sim.vscroll_top + sim.vscroll_offset) % sim.vscroll_rows;
+    }
+    row = (row + sim.start_line) % (OLED_SIM_PAGES * 8);
+
+    uint8_t lit = (sim.gddram[row / 8][x + OLED_COLUMN_OFFSET] >> (row & 7)) & 1;
+    return sim.inverted ? !lit : lit;
+}
+
+// Stands in for the I2C/SPI transport
+esp_err_t oled_transport_init() {
+    oled_sim_reset();
+    return ESP_OK;
+}
+
+esp_err_t oled_transport_write(uint8_t control, const uint8_t *bytes, size_t len) {
+    oled_sim_write(control, bytes, len);
+    return ESP_OK;
+}
+
+void oled_sim_dump(FILE *out) {
+    for (uint8_t y = 0; y < SCREEN_HEIGHT; y++) {
+        for (uint8_t x = 0; x < SCREEN_WIDTH; x++) {
+            fputc(oled_sim_pixel(x, y) ? '#' : '.', out);
+        }
+        fputc('\n', out);
+    }
+}
+
+#endif
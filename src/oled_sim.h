@@ -0,0 +1,82 @@
+#ifndef OLED_SIM_H
+#define OLED_SIM_H
+
+// SSD1306 emulator for host builds (-DOLED_SIMULATOR). The driver hands it
+// the bytes it would put on the bus in place of the I2C/SPI transport, for
+// either configured panel; it keeps the panel's GDDRAM, address
+// pointers and display state, and runs hardware scrolling frame by frame.
+// Segment remap and COM scan direction are taken as the driver sets them.
+
+#ifdef OLED_SIMULATOR
+
+#include <stddef.h>
+#include <stdio.h>
+#include "oled_ssd1306.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint8_t gddram[8][OLED_RAM_COLUMNS];
+
+    // Display state
+    bool display_on;
+    bool inverted;
+    bool all_on;
+    uint8_t contrast;
+    uint8_t start_line;
+
+    // Addressing (memory_mode 0 = horizontal, 1 = vertical, 2 = page)
+    uint8_t memory_mode;
+    uint8_t col_start;
+    uint8_t col_end;
+    uint8_t page_start;
+    uint8_t page_end;
+    uint8_t column;
+    uint8_t page;
+
+    // Hardware scroll
+    bool scroll_active;
+    uint8_t scroll_cmd;         // 0x26/0x27 horizontal, 0x29/0x2A diagonal
+    uint8_t scroll_page0;
+    uint8_t scroll_page1;
+    uint8_t scroll_speed;       // oled_scroll_speed_t
+    uint8_t scroll_vertical_step;
+    uint8_t vscroll_top;        // rows fixed at the top
+    uint8_t vscroll_rows;       // rows in the vertical scroll area
+    uint8_t vscroll_offset;     // current vertical scroll position
+    uint32_t scroll_frames;     // frames towards the next step
+
+    // Bus activity
+    uint32_t command_bytes;
+    uint32_t data_bytes;
+    uint32_t writes_during_scroll;  // RAM writes the real panel would corrupt
+} oled_sim_state_t;
+
+// Power-on state
+void oled_sim_reset();
+
+// One bus transaction: control 0x00 for commands, 0x40 for data
+void oled_sim_write(uint8_t control, const uint8_t *bytes, size_t len);
+
+const oled_sim_state_t *oled_sim_state();
+
+// Run the panel for a number of frames (about 100 per second), stepping an
+// active scroll
+void oled_sim_advance_frames(uint32_t frames);
+
+// What the panel shows at (x, y): start line, vertical scroll, invert,
+// entire-display-on and sleep applied
+uint8_t oled_sim_pixel(uint8_t x, uint8_t y);
+
+// Print the visible panel as text, '#' for lit pixels
+void oled_sim_dump(FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+#endif
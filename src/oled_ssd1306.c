@@ -2,41 +2,37 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
-#include "driver/i2c.h"
-#include "esp_system.h"
-#include "esp_log.h"
+#include "oled_panel.h"
+#include "fixed_point.h"
 
 static const char *TAG = "OLED";
 
-// SSD1306 I2C address
-#define SSD1306_I2C_ADDRESS 0x3C
-#define I2C_MASTER_NUM I2C_NUM_0
-#define I2C_MASTER_FREQ_HZ 400000
-#define I2C_MASTER_TIMEOUT_MS 1000
-
-// SSD1306 Commands
-#define SSD1306_DISPLAYOFF 0xAE
-#define SSD1306_DISPLAYON 0xAF
-#define SSD1306_SETDISPLAYCLOCKDIV 0xD5
-#define SSD1306_SETMULTIPLEX 0xA8
-#define SSD1306_SETDISPLAYOFFSET 0xD3
-#define SSD1306_SETSTARTLINE 0x40
-#define SSD1306_CHARGEPUMP 0x8D
-#define SSD1306_MEMORYMODE 0x20
-#define SSD1306_SEGREMAP 0xA0
-#define SSD1306_COMSCANDEC 0xC8
-#define SSD1306_SETCOMPINS 0xDA
-#define SSD1306_SETCONTRAST 0x81
-#define SSD1306_SETPRECHARGE 0xD9
-#define SSD1306_SETVCOMDETECT 0xDB
-#define SSD1306_DISPLAYALLON_RESUME 0xA4
-#define SSD1306_NORMALDISPLAY 0xA6
-#define SSD1306_COLUMNADDR 0x21
-#define SSD1306_PAGEADDR 0x22
+#if OLED_HW_SCROLL
+#define SSD1306_DEACTIVATE_SCROLL 0x2E
+#define SSD1306_ACTIVATE_SCROLL 0x2F
+#define SSD1306_SET_VERTICAL_SCROLL_AREA 0xA3
+#define SSD1306_VERTICAL_AND_RIGHT_SCROLL 0x29
+#define SSD1306_VERTICAL_AND_LEFT_SCROLL 0x2A
+#endif
 
 // Display buffer
-static uint8_t display_buffer[SCREEN_WIDTH * SCREEN_HEIGHT / 8];
+static uint8_t display_buffer[OLED_BUFFER_SIZE];
 static bool oled_initialized = false;
+static uint32_t oled_error_count = 0;
+static oled_stats_t oled_stats;
+
+// Regions changed since the last flush
+static oled_rect_t dirty_rects[OLED_MAX_DIRTY_RECTS];
+static uint8_t dirty_count = 0;
+static bool dirty_full = false;
+
+// Hash of the last frame sent by oled_display(), to skip identical frames
+static uint32_t last_frame_hash = 0;
+
+#if OLED_HW_SCROLL
+// GDDRAM must not be written while a hardware scroll runs
+static bool scroll_active = false;
+#endif
 
 // Simple 5x7 font (ASCII 32-90)
 static const uint8_t font5x7[][5] = {
@@ -101,68 +97,59 @@ static const uint8_t font5x7[][5] = {
     {0x61, 0x51, 0x49, 0x45, 0x43}, // Z (90)
 };
 
-static esp_err_t oled_command(uint8_t cmd) {
-    i2c_cmd_handle_t i2c_cmd = i2c_cmd_link_create();
-    i2c_master_start(i2c_cmd);
-    i2c_master_write_byte(i2c_cmd, (SSD1306_I2C_ADDRESS << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(i2c_cmd, 0x00, true);  // Command mode
-    i2c_master_write_byte(i2c_cmd, cmd, true);
-    i2c_master_stop(i2c_cmd);
-    esp_err_t ret = i2c_master_cmd_begin(I2C_NUM_0, i2c_cmd, pdMS_TO_TICKS(I2C_MASTER_TIMEOUT_MS));
-    i2c_cmd_link_delete(i2c_cmd);
+// All panel traffic goes through here: one transaction of command (0x00)
+// or data (0x40) bytes on the configured transport
+static esp_err_t oled_write(uint8_t control, const uint8_t *bytes, size_t len) {
+    esp_err_t ret = oled_transport_write(control, bytes, len);
     
+    oled_stats.transactions++;
+    oled_stats.bytes_sent += len;
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "I2C command failed: %s", esp_err_to_name(ret));
+        oled_error_count++;
+        ESP_LOGE(TAG, "%s write failed: %s", control == 0x40 ? "Display data" : "Command",
+                 esp_err_to_name(ret));
     }
     
     return ret;
 }
 
+static esp_err_t oled_command(uint8_t cmd) {
+    return oled_write(0x00, &cmd, 1);
+}
+
+// Send several command bytes in one transaction (Co = 0)
+esp_err_t oled_write_commands(const uint8_t *cmds, size_t len) {
+    return oled_write(0x00, cmds, len);
+}
+
+esp_err_t oled_write_data(const uint8_t *data, size_t len) {
+    return oled_write(0x40, data, len);
+}
+
+// Stream a column/page window of the framebuffer
+static esp_err_t oled_flush_window(uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1) {
+#if OLED_HW_SCROLL
+    if (scroll_active) {
+        oled_scroll_stop();
+    }
+#endif
+    
+    return oled_panel_flush(display_buffer, x0, x1, page0, page1);
+}
+
 void oled_init(uint8_t sda_pin, uint8_t scl_pin) {
 
     vTaskDelay(pdMS_TO_TICKS(100));
     
-    // Test I2C communication
-    i2c_cmd_handle_t test_cmd = i2c_cmd_link_create();
-    i2c_master_start(test_cmd);
-    i2c_master_write_byte(test_cmd, (SSD1306_I2C_ADDRESS << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_stop(test_cmd);
-    esp_err_t ret = i2c_master_cmd_begin(I2C_NUM_0, test_cmd, pdMS_TO_TICKS(I2C_MASTER_TIMEOUT_MS));
-    i2c_cmd_link_delete(test_cmd);
-    
+    esp_err_t ret = oled_transport_init();
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "OLED not found at address 0x%02X: %s", SSD1306_I2C_ADDRESS, esp_err_to_name(ret));
+        oled_error_count++;
         return;
     }
     
-    ESP_LOGI(TAG, "OLED found at 0x%02X, sending initialization commands", SSD1306_I2C_ADDRESS);
-    
-    // Initialization sequence
-    oled_command(SSD1306_DISPLAYOFF);
-    oled_command(SSD1306_SETDISPLAYCLOCKDIV);
-    oled_command(0x80);
-    oled_command(SSD1306_SETMULTIPLEX);
-    oled_command(SCREEN_HEIGHT - 1);
-    oled_command(SSD1306_SETDISPLAYOFFSET);
-    oled_command(0x00);
-    oled_command(SSD1306_SETSTARTLINE | 0x00);
-    oled_command(SSD1306_CHARGEPUMP);
-    oled_command(0x14);
-    oled_command(SSD1306_MEMORYMODE);
-    oled_command(0x00);
-    oled_command(SSD1306_SEGREMAP | 0x01);
-    oled_command(SSD1306_COMSCANDEC);
-    oled_command(SSD1306_SETCOMPINS);
-    oled_command(0x12);
-    oled_command(SSD1306_SETCONTRAST);
-    oled_command(0xCF);
-    oled_command(SSD1306_SETPRECHARGE);
-    oled_command(0xF1);
-    oled_command(SSD1306_SETVCOMDETECT);
-    oled_command(0x40);
-    oled_command(SSD1306_DISPLAYALLON_RESUME);
-    oled_command(SSD1306_NORMALDISPLAY);
-    oled_command(SSD1306_DISPLAYON);
+    if (oled_panel_init() != ESP_OK) {
+        return;
+    }
     
     oled_initialized = true;
 }
@@ -177,40 +164,173 @@ void oled_display() {
         return;
     }
     
-    oled_command(SSD1306_COLUMNADDR);
-    oled_command(0);
-    oled_command(SCREEN_WIDTH - 1);
-    oled_command(SSD1306_PAGEADDR);
-    oled_command(0);
-    oled_command(7);
+    dirty_count = 0;
+    dirty_full = false;
     
-    // Send display buffer in chunks
-    for (uint16_t i = 0; i < sizeof(display_buffer); i += 16) {
-        i2c_cmd_handle_t i2c_cmd = i2c_cmd_link_create();
-        i2c_master_start(i2c_cmd);
-        i2c_master_write_byte(i2c_cmd, (SSD1306_I2C_ADDRESS << 1) | I2C_MASTER_WRITE, true);
-        i2c_master_write_byte(i2c_cmd, 0x40, true);  // Data mode
-        
-        uint8_t chunk_size = 16;
-        if (i + 16 > sizeof(display_buffer)) {
-            chunk_size = sizeof(display_buffer) - i;
+    // FNV-1a over the framebuffer costs far less than sending it
+    uint32_t hash = 2166136261u;
+    for (uint16_t i = 0; i < sizeof(display_buffer); i++) {
+        hash = (hash ^ display_buffer[i]) * 16777619u;
+    }
+    if (hash == last_frame_hash) {
+        oled_stats.frames_skipped++;
+        return;
+    }
+    
+    if (oled_flush_window(0, OLED_WIDTH - 1, 0, OLED_PAGES - 1) == ESP_OK) {
+        last_frame_hash = hash;
+    }
+}
+
+void oled_set_contrast(uint8_t contrast) {
+    const uint8_t cmds[] = {OLED_CMD_SETCONTRAST, contrast};
+    oled_write_commands(cmds, sizeof(cmds));
+}
+
+void oled_set_power(bool on) {
+    oled_command(on ? OLED_CMD_DISPLAYON : OLED_CMD_DISPLAYOFF);
+}
+
+void oled_set_invert(bool invert) {
+    oled_command(invert ? OLED_CMD_INVERTDISPLAY : OLED_CMD_NORMALDISPLAY);
+}
+
+void oled_set_start_line(uint8_t line) {
+    oled_command(OLED_CMD_SETSTARTLINE | (line & 0x3F));
+}
+
+#if OLED_HW_SCROLL
+void oled_scroll_horizontal(oled_scroll_dir_t dir, uint8_t page0, uint8_t page1,
+                            oled_scroll_speed_t speed) {
+    const uint8_t cmds[] = {
+        SSD1306_DEACTIVATE_SCROLL,
+        (uint8_t)dir, 0x00, (uint8_t)(page0 & 7), (uint8_t)speed, (uint8_t)(page1 & 7), 0x00, 0xFF,
+        SSD1306_ACTIVATE_SCROLL,
+    };
+    if (oled_write_commands(cmds, sizeof(cmds)) == ESP_OK) {
+        scroll_active = true;
+    }
+}
+
+void oled_scroll_diagonal(oled_scroll_dir_t dir, uint8_t page0, uint8_t page1,
+                          oled_scroll_speed_t speed, uint8_t top_fixed, uint8_t rows,
+                          uint8_t vertical_step) {
+    uint8_t mode = (dir == OLED_SCROLL_LEFT) ? SSD1306_VERTICAL_AND_LEFT_SCROLL
+                                             : SSD1306_VERTICAL_AND_RIGHT_SCROLL;
+    const uint8_t cmds[] = {
+        SSD1306_DEACTIVATE_SCROLL,
+        SSD1306_SET_VERTICAL_SCROLL_AREA, (uint8_t)(top_fixed & 0x3F), (uint8_t)(rows & 0x7F),
+        mode, 0x00, (uint8_t)(page0 & 7), (uint8_t)speed, (uint8_t)(page1 & 7),
+        (uint8_t)(vertical_step & 0x3F),
+        SSD1306_ACTIVATE_SCROLL,
+    };
+    if (oled_write_commands(cmds, sizeof(cmds)) == ESP_OK) {
+        scroll_active = true;
+    }
+}
+
+void oled_scroll_stop() {
+    if (oled_command(SSD1306_DEACTIVATE_SCROLL) != ESP_OK) {
+        return;
+    }
+    scroll_active = false;
+    
+    // The panel does not restore the scrolled-out RAM; resend it all
+    last_frame_hash = 0;
+    dirty_full = true;
+}
+
+bool oled_scroll_active() {
+    return scroll_active;
+}
+#endif
+
+void oled_display_window(uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1) {
+    if (!oled_initialized) {
+        ESP_LOGW(TAG, "OLED not initialized");
+        return;
+    }
+    if (x0 > x1 || page0 > page1 || x1 >= OLED_WIDTH || page1 >= OLED_PAGES) return;
+    
+    last_frame_hash = 0;
+    oled_flush_window(x0, x1, page0, page1);
+}
+
+void oled_mark_dirty(uint8_t x, uint8_t y, uint8_t w, uint8_t h) {
+    if (w == 0 || h == 0 || x >= SCREEN_WIDTH || y >= SCREEN_HEIGHT || dirty_full) return;
+    if (x + w > SCREEN_WIDTH) w = SCREEN_WIDTH - x;
+    if (y + h > SCREEN_HEIGHT) h = SCREEN_HEIGHT - y;
+    
+    // Merge with an overlapping or touching rect to keep the list short
+    for (uint8_t i = 0; i < dirty_count; i++) {
+        oled_rect_t *r = &dirty_rects[i];
+        if (x <= r->x + r->w && r->x <= x + w && y <= r->y + r->h && r->y <= y + h) {
+            uint8_t x1 = (x + w > r->x + r->w) ? x + w : r->x + r->w;
+            uint8_t y1 = (y + h > r->y + r->h) ? y + h : r->y + r->h;
+            r->x = (x < r->x) ? x : r->x;
+            r->y = (y < r->y) ? y : r->y;
+            r->w = x1 - r->x;
+            r->h = y1 - r->y;
+            return;
         }
-        
-        i2c_master_write(i2c_cmd, &display_buffer[i], chunk_size, true);
-        i2c_master_stop(i2c_cmd);
-        esp_err_t ret = i2c_master_cmd_begin(I2C_NUM_0, i2c_cmd, pdMS_TO_TICKS(I2C_MASTER_TIMEOUT_MS));
-        i2c_cmd_link_delete(i2c_cmd);
-        
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "Display update failed at chunk %d: %s", i/16, esp_err_to_name(ret));
+    }
+    
+    if (dirty_count == OLED_MAX_DIRTY_RECTS) {
+        dirty_full = true;
+        return;
+    }
+    dirty_rects[dirty_count++] = (oled_rect_t){x, y, w, h};
+}
+
+uint8_t oled_get_dirty_rects(const oled_rect_t **rects) {
+    *rects = dirty_rects;
+    return dirty_full ? OLED_DIRTY_ALL : dirty_count;
+}
+
+void oled_display_dirty() {
+    if (!oled_initialized) {
+        ESP_LOGW(TAG, "OLED not initialized");
+        return;
+    }
+    
+    if (dirty_full) {
+        oled_display();
+        return;
+    }
+    
+    // The panel no longer shows the last full frame, so the next
+    // oled_display() must not be skipped as unchanged
+    if (dirty_count > 0) {
+        last_frame_hash = 0;
+    }
+    for (uint8_t i = 0; i < dirty_count; i++) {
+        const oled_rect_t *r = &dirty_rects[i];
+        if (oled_flush_window(r->x, r->x + r->w - 1, r->y / 8, (r->y + r->h - 1) / 8) != ESP_OK) {
+            // Which windows arrived is unknown; resend the whole frame next time
+            dirty_count = 0;
+            dirty_full = true;
             return;
         }
     }
+    dirty_count = 0;
+}
+
+void oled_get_stats(oled_stats_t *stats) {
+    *stats = oled_stats;
+}
+
+void oled_reset_stats() {
+    memset(&oled_stats, 0, sizeof(oled_stats));
+}
+
+uint32_t oled_get_error_count() {
+    return oled_error_count;
 }
 
 void oled_set_pixel(uint8_t x, uint8_t y, uint8_t color) {
     if (x >= SCREEN_WIDTH || y >= SCREEN_HEIGHT) return;
     
+    oled_stats.pixels_written++;
     if (color) {
         display_buffer[x + (y / 8) * SCREEN_WIDTH] |= (1 << (y & 7));
     } else {
@@ -218,7 +338,56 @@ void oled_set_pixel(uint8_t x, uint8_t y, uint8_t color) {
     }
 }
 
+void oled_draw_vspan(uint8_t x, uint8_t y0, uint8_t y1, uint8_t color) {
+    if (x >= SCREEN_WIDTH) return;
+    if (y0 > y1) {
+        uint8_t t = y0;
+        y0 = y1;
+        y1 = t;
+    }
+    if (y0 >= SCREEN_HEIGHT) return;
+    if (y1 >= SCREEN_HEIGHT) y1 = SCREEN_HEIGHT - 1;
+    
+    // Whole page bytes at a time instead of one pixel per call
+    for (uint8_t page = y0 / 8; page <= y1 / 8; page++) {
+        uint8_t top = (page == y0 / 8) ? (y0 & 7) : 0;
+        uint8_t bottom = (page == y1 / 8) ? (y1 & 7) : 7;
+        uint8_t mask = (uint8_t)((0xFF << top) & (0xFF >> (7 - bottom)));
+        
+        if (color) {
+            display_buffer[x + page * SCREEN_WIDTH] |= mask;
+        } else {
+            display_buffer[x + page * SCREEN_WIDTH] &= ~mask;
+        }
+        oled_stats.pixels_written += bottom - top + 1;
+    }
+}
+
+void oled_shift_left(uint8_t x, uint8_t w, uint8_t page0, uint8_t page1) {
+    if (w == 0 || x >= SCREEN_WIDTH) return;
+    if (x + w > SCREEN_WIDTH) w = SCREEN_WIDTH - x;
+    
+    for (uint8_t page = page0; page <= page1 && page < SCREEN_HEIGHT / 8; page++) {
+        uint8_t *row = &display_buffer[page * SCREEN_WIDTH + x];
+        memmove(row, row + 1, w - 1);
+        row[w - 1] = 0;
+    }
+}
+
+void oled_draw_column(uint8_t x, uint8_t y, uint16_t bits, uint8_t height) {
+    if (x >= SCREEN_WIDTH || y >= SCREEN_HEIGHT) return;
+    if (height < 16) bits &= (1u << height) - 1;
+    
+    uint32_t shifted = (uint32_t)bits << (y & 7);
+    for (uint8_t page = y / 8; shifted != 0 && page < OLED_PAGES; page++) {
+        display_buffer[x + page * SCREEN_WIDTH] |= shifted & 0xFF;
+        shifted >>= 8;
+    }
+    oled_stats.pixels_written += __builtin_popcount(bits);
+}
+
 void oled_draw_char(uint8_t x, uint8_t y, char c) {
+    if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
     if (c < 32 || c > 90) c = 32;
     
     for (uint8_t i = 0; i < 5; i++) {
@@ -242,16 +411,18 @@ void oled_print(uint8_t x, uint8_t y, const char* str) {
 }
 
 void oled_print_number(uint8_t x, uint8_t y, int num) {
-    char buffer[12];
-    sprintf(buffer, "%d", num);
+    char buffer[FIXED_FORMAT_MAX];
+    fixed_format(buffer, num, 0, 0);
     oled_print(x, y, buffer);
 }
 
 void oled_print_float(uint8_t x, uint8_t y, float num, int decimals) {
-    char buffer[20];
-    char format[10];
-    sprintf(format, "%%.%df", decimals);
-    sprintf(buffer, format, num);
+    oled_print_fixed(x, y, fixed_from_float(num, decimals), decimals, decimals);
+}
+
+void oled_print_fixed(uint8_t x, uint8_t y, int32_t value, uint8_t frac_digits, uint8_t decimals) {
+    char buffer[FIXED_FORMAT_MAX];
+    fixed_format(buffer, value, frac_digits, decimals);
     oled_print(x, y, buffer);
 }
 
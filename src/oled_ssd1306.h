@@ -2,31 +2,53 @@
 #define OLED_SSD1306_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include "oled_config.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// Screen dimensions
-#define SCREEN_WIDTH 128
-#define SCREEN_HEIGHT 64
+// Screen dimensions, from the panel configured in oled_config.h
+#define SCREEN_WIDTH OLED_WIDTH
+#define SCREEN_HEIGHT OLED_HEIGHT
+
+// Dirty-rect list capacity; beyond it the whole screen is flushed
+#define OLED_MAX_DIRTY_RECTS 8
+#define OLED_DIRTY_ALL 0xFF
 
 typedef struct {
-    uint16_t bitmapOffset;  // Pointer into GFXfont->bitmap
-    uint8_t  width;         // Bitmap dimensions in pixels
-    uint8_t  height;
-    uint8_t  xAdvance;      // Distance to advance cursor (x axis)
-    int8_t   xOffset;       // X dist from cursor pos to UL corner
-    int8_t   yOffset;       // Y dist from cursor pos to UL corner
-} GFXglyph;
+    uint8_t x;
+    uint8_t y;
+    uint8_t w;
+    uint8_t h;
+} oled_rect_t;
 
+// Drawing and bus counters, for measuring redraw cost
 typedef struct {
-    uint8_t  *bitmap;       // Glyph bitmaps, concatenated
-    GFXglyph *glyph;        // Glyph array
-    uint8_t   first;        // ASCII extents (first char)
-    uint8_t   last;         // ASCII extents (last char)
-    uint8_t   yAdvance;     // Newline distance (y axis)
-} GFXfont;
+    uint32_t pixels_written;  // oled_set_pixel calls
+    uint32_t bytes_sent;      // command + data bytes on the bus
+    uint32_t transactions;    // bus transactions
+    uint32_t frames_skipped;  // oled_display() calls with an unchanged frame
+} oled_stats_t;
+
+// Hardware scroll direction (SSD1306 command bytes)
+typedef enum {
+    OLED_SCROLL_RIGHT = 0x26,
+    OLED_SCROLL_LEFT = 0x27
+} oled_scroll_dir_t;
+
+// Hardware scroll step interval in panel frames (SSD1306 encoding)
+typedef enum {
+    OLED_SCROLL_FRAMES_5 = 0,
+    OLED_SCROLL_FRAMES_64 = 1,
+    OLED_SCROLL_FRAMES_128 = 2,
+    OLED_SCROLL_FRAMES_256 = 3,
+    OLED_SCROLL_FRAMES_3 = 4,
+    OLED_SCROLL_FRAMES_4 = 5,
+    OLED_SCROLL_FRAMES_25 = 6,
+    OLED_SCROLL_FRAMES_2 = 7
+} oled_scroll_speed_t;
 
 // Initialize the OLED display
 void oled_init(uint8_t sda_pin, uint8_t scl_pin);
@@ -34,13 +56,79 @@ void oled_init(uint8_t sda_pin, uint8_t scl_pin);
 // Clear the display buffer
 void oled_clear();
 
-// Update the physical display with buffer contents
+// Update the physical display with buffer contents; skipped if the frame
+// is identical to the last one sent
 void oled_display();
 
+// Panel contrast (0x00-0xFF, default 0xCF)
+void oled_set_contrast(uint8_t contrast);
+
+// Panel on/off (sleep); display RAM is kept while off
+void oled_set_power(bool on);
+
+// Inverse video, done by the panel
+void oled_set_invert(bool invert);
+
+// Panel row 0 shows RAM row `line` (0-63), wrapping around. Rolls the whole
+// screen vertically without resending it; framebuffer coordinates stay RAM
+// coordinates.
+void oled_set_start_line(uint8_t line);
+
+#if OLED_HW_SCROLL
+// Continuously scroll pages page0..page1 one column per step. The panel
+// moves the pixels itself; no framebuffer data is sent.
+void oled_scroll_horizontal(oled_scroll_dir_t dir, uint8_t page0, uint8_t page1,
+                            oled_scroll_speed_t speed);
+
+// Horizontal scroll of page0..page1 combined with a vertical scroll of
+// `vertical_step` rows per step inside the area of `rows` rows below
+// `top_fixed` fixed rows
+void oled_scroll_diagonal(oled_scroll_dir_t dir, uint8_t page0, uint8_t page1,
+                          oled_scroll_speed_t speed, uint8_t top_fixed, uint8_t rows,
+                          uint8_t vertical_step);
+
+// Stop scrolling. The panel RAM is then out of step with the framebuffer,
+// so the next flush resends the whole frame. Any flush stops a running
+// scroll first, since RAM writes during a scroll are not allowed.
+void oled_scroll_stop();
+bool oled_scroll_active();
+#endif
+
+// Send columns x0..x1 of pages page0..page1 (inclusive) from the framebuffer
+void oled_display_window(uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1);
+
+// Record a changed region for oled_display_dirty()
+void oled_mark_dirty(uint8_t x, uint8_t y, uint8_t w, uint8_t h);
+
+// Current dirty list; returns the count, or OLED_DIRTY_ALL if it overflowed
+uint8_t oled_get_dirty_rects(const oled_rect_t **rects);
+
+// Send only the page/column windows covering the dirty rects
+void oled_display_dirty();
+
+// Drawing and bus counters
+void oled_get_stats(oled_stats_t *stats);
+void oled_reset_stats();
+
+// Transfers the transport refused since boot. Queued I2C writes that fail
+// on the wire are counted per device in the i2c_bus stats instead.
+uint32_t oled_get_error_count();
+
 // Set a single pixel
 void oled_set_pixel(uint8_t x, uint8_t y, uint8_t color);
 
-// Draw a character at position
+// Draw a vertical span from y0 to y1 inclusive (page-byte fast path)
+void oled_draw_vspan(uint8_t x, uint8_t y0, uint8_t y1, uint8_t color);
+
+// Shift columns x..x+w-1 of pages page0..page1 one column left, clearing
+// the rightmost column
+void oled_shift_left(uint8_t x, uint8_t w, uint8_t page0, uint8_t page1);
+
+// Light the pixels of a column of up to 16 rows, bit 0 at y (page-byte
+// fast path used by the glyph atlas, see oled_font.h)
+void oled_draw_column(uint8_t x, uint8_t y, uint16_t bits, uint8_t height);
+
+// Draw a character at position (5x7 font, lowercase drawn as uppercase)
 void oled_draw_char(uint8_t x, uint8_t y, char c);
 
 // Print a string at position
@@ -52,6 +140,10 @@ void oled_print_number(uint8_t x, uint8_t y, int num);
 // Print a float at position with specified decimal places
 void oled_print_float(uint8_t x, uint8_t y, float num, int decimals);
 
+// Print a scaled integer (e.g. centi-degrees: frac_digits 2) with `decimals`
+// decimal places; no float math
+void oled_print_fixed(uint8_t x, uint8_t y, int32_t value, uint8_t frac_digits, uint8_t decimals);
+
 // Draw a line
 void oled_draw_line(int x0, int y0, int x1, int y1, uint8_t color);
 
@@ -61,11 +153,6 @@ void oled_draw_rect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t color);
 // Draw a filled rectangle
 void oled_fill_rect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t color);
 
-// Set Font
-void oled_set_font(const GFXfont *font);
-void oled_print_gfx(uint8_t x, uint8_t y, const char* str);
-void oled_draw_char_gfx(uint8_t x, uint8_t y, char c);
-
 #ifdef __cplusplus
 }
 #endif
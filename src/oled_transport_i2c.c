@@ -0,0 +1,34 @@
+#include "oled_panel.h"
+
+#if OLED_TRANSPORT == OLED_TRANSPORT_I2C && !defined(OLED_SIMULATOR)
+
+#include "i2c_bus.h"
+
+static const char *TAG = "OLED";
+
+static i2c_bus_device_t oled_bus_device;
+
+// The controller belongs to i2c_bus (started before oled_init()); the panel
+// is a low-priority device on it
+esp_err_t oled_transport_init() {
+    const i2c_bus_device_config_t config = {"oled", OLED_I2C_ADDRESS, OLED_I2C_CLOCK_HZ, I2C_BUS_PRIO_LOW};
+    esp_err_t ret = i2c_bus_add_device(&config, &oled_bus_device);
+    if (ret == ESP_OK) {
+        ret = i2c_bus_probe(oled_bus_device);
+    }
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "OLED not found at address 0x%02X: %s", OLED_I2C_ADDRESS, esp_err_to_name(ret));
+    } else {
+        ESP_LOGI(TAG, "OLED found at 0x%02X", OLED_I2C_ADDRESS);
+    }
+    return ret;
+}
+
+// Queued: returns once the chunk is copied, the bus task sends it between
+// sensor transactions and counts failures in the bus stats
+esp_err_t oled_transport_write(uint8_t control, const uint8_t *bytes, size_t len) {
+    return i2c_bus_write_async(oled_bus_device, control, bytes, len);
+}
+
+#endif
@@ -0,0 +1,78 @@
+#include "oled_panel.h"
+
+#if OLED_TRANSPORT == OLED_TRANSPORT_SPI && !defined(OLED_SIMULATOR)
+
+#include "driver/spi_master.h"
+#include "driver/gpio.h"
+
+static const char *TAG = "OLED";
+
+static spi_device_handle_t oled_spi = NULL;
+
+// D/C is driven from the transaction's user field just before it is clocked out
+static void IRAM_ATTR oled_spi_pre_transfer(spi_transaction_t *t) {
+    gpio_set_level(OLED_SPI_DC, (int)(intptr_t)t->user);
+}
+
+esp_err_t oled_transport_init() {
+    gpio_set_direction(OLED_SPI_DC, GPIO_MODE_OUTPUT);
+#if OLED_SPI_RST >= 0
+    gpio_set_direction(OLED_SPI_RST, GPIO_MODE_OUTPUT);
+    gpio_set_level(OLED_SPI_RST, 0);
+    vTaskDelay(pdMS_TO_TICKS(1));
+    gpio_set_level(OLED_SPI_RST, 1);
+    vTaskDelay(pdMS_TO_TICKS(1));
+#endif
+
+    spi_bus_config_t bus = {
+        .mosi_io_num = OLED_SPI_MOSI,
+        .miso_io_num = -1,
+        .sclk_io_num = OLED_SPI_SCLK,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = OLED_BUFFER_SIZE,
+    };
+    esp_err_t ret = spi_bus_initialize(OLED_SPI_HOST, &bus, SPI_DMA_CH_AUTO);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "SPI bus init failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    spi_device_interface_config_t device = {
+        .mode = 0,
+        .clock_speed_hz = OLED_SPI_CLOCK_HZ,
+        .spics_io_num = OLED_SPI_CS,
+        .queue_size = 1,
+        .pre_cb = oled_spi_pre_transfer,
+    };
+    ret = spi_bus_add_device(OLED_SPI_HOST, &device, &oled_spi);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "SPI device add failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    // SPI is write-only: there is no acknowledge to probe for
+    ESP_LOGI(TAG, "OLED on SPI, %d Hz", OLED_SPI_CLOCK_HZ);
+    return ESP_OK;
+}
+
+esp_err_t oled_transport_write(uint8_t control, const uint8_t *bytes, size_t len) {
+    if (oled_spi == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    spi_transaction_t t = {
+        .length = len * 8,
+        .tx_buffer = bytes,
+        .user = (void *)(intptr_t)(control == 0x40 ? 1 : 0),
+    };
+
+    // Short command lists are cheaper polled; frame data goes out by DMA
+    // with the task blocked instead of spinning
+    if (control != 0x40) {
+        return spi_device_polling_transmit(oled_spi, &t);
+    }
+    return spi_device_transmit(oled_spi, &t);
+}
+
+#endif
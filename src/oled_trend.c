@@ -0,0 +1,66 @@
+#include "oled_trend.h"
+#include <string.h>
+
+static uint8_t value_to_row(const oled_sparkline_t *line, int32_t value) {
+    if (value < line->min_value) value = line->min_value;
+    if (value > line->max_value) value = line->max_value;
+
+    int32_t range = line->max_value - line->min_value;
+    if (range <= 0) return line->y + line->h - 1;
+
+    int32_t offset = ((value - line->min_value) * (line->h - 1) + range / 2) / range;
+    return line->y + line->h - 1 - offset;
+}
+
+void oled_sparkline_init(oled_sparkline_t *line) {
+    if (line->w > OLED_SPARKLINE_MAX_WIDTH) line->w = OLED_SPARKLINE_MAX_WIDTH;
+    if (line->samples_per_column == 0) line->samples_per_column = 1;
+
+    line->bucket_count = 0;
+    line->head = 0;
+    line->count = 0;
+}
+
+void oled_sparkline_add(oled_sparkline_t *line, int32_t value, bool draw) {
+    if (line->bucket_count == 0 || value < line->bucket_min) line->bucket_min = value;
+    if (line->bucket_count == 0 || value > line->bucket_max) line->bucket_max = value;
+    if (++line->bucket_count < line->samples_per_column) return;
+    line->bucket_count = 0;
+
+    uint8_t top = value_to_row(line, line->bucket_max);
+    uint8_t bottom = value_to_row(line, line->bucket_min);
+
+    // Stretch towards the previous column so the trace stays connected
+    if (line->count > 0) {
+        uint8_t prev = (line->head + line->w - 1) % line->w;
+        if (top > line->col_bottom[prev]) top = line->col_bottom[prev];
+        if (bottom < line->col_top[prev]) bottom = line->col_top[prev];
+    }
+
+    line->col_top[line->head] = top;
+    line->col_bottom[line->head] = bottom;
+    line->head = (line->head + 1) % line->w;
+    if (line->count < line->w) line->count++;
+
+    if (!draw) return;
+
+    uint8_t page0 = line->y / 8;
+    uint8_t page1 = (line->y + line->h - 1) / 8;
+    oled_shift_left(line->x, line->w, page0, page1);
+    oled_draw_vspan(line->x + line->w - 1, top, bottom, 1);
+    oled_mark_dirty(line->x, line->y, line->w, line->h);
+}
+
+void oled_sparkline_redraw(oled_sparkline_t *line) {
+    oled_fill_rect(line->x, line->y, line->w, line->h, 0);
+
+    // Oldest column first, right aligned so new data enters at the right edge
+    uint8_t tail = (line->head + line->w - line->count) % line->w;
+    uint8_t x = line->x + line->w - line->count;
+    for (uint8_t i = 0; i < line->count; i++) {
+        uint8_t index = (tail + i) % line->w;
+        oled_draw_vspan(x + i, line->col_top[index], line->col_bottom[index], 1);
+    }
+
+    oled_mark_dirty(line->x, line->y, line->w, line->h);
+}
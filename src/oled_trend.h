@@ -0,0 +1,54 @@
+#ifndef OLED_TREND_H
+#define OLED_TREND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "oled_ssd1306.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OLED_SPARKLINE_MAX_WIDTH SCREEN_WIDTH
+
+// Scrolling sparkline. Each column holds the min/max of samples_per_column
+// samples, so the history never has more points than the plot has pixels.
+// The column ring lets the plot be replotted when its screen is shown again.
+typedef struct {
+    // Plot area; y and h must be page aligned (multiples of 8)
+    uint8_t x;
+    uint8_t y;
+    uint8_t w;
+    uint8_t h;
+    // Value range mapped to the plot height (caller's units, e.g. x10)
+    int32_t min_value;
+    int32_t max_value;
+    uint16_t samples_per_column;
+
+    // Decimation bucket for the column being built
+    uint16_t bucket_count;
+    int32_t bucket_min;
+    int32_t bucket_max;
+
+    // Drawn columns as pixel rows, oldest at tail
+    uint8_t col_top[OLED_SPARKLINE_MAX_WIDTH];
+    uint8_t col_bottom[OLED_SPARKLINE_MAX_WIDTH];
+    uint8_t head;
+    uint8_t count;
+} oled_sparkline_t;
+
+// Reset the history (does not draw)
+void oled_sparkline_init(oled_sparkline_t *line);
+
+// Add a sample. When a column completes and draw is set, the plot shifts
+// one column and only the new column is drawn.
+void oled_sparkline_add(oled_sparkline_t *line, int32_t value, bool draw);
+
+// Clear the plot area and replot all columns from the history
+void oled_sparkline_redraw(oled_sparkline_t *line);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,83 @@
+#include "oled_widgets.h"
+#include "fixed_point.h"
+#include <string.h>
+
+void oled_label_draw(const oled_label_t *label) {
+    oled_print(label->x, label->y, label->text);
+    oled_mark_dirty(label->x, label->y, strlen(label->text) * OLED_CELL_WIDTH, OLED_CELL_HEIGHT);
+}
+
+void oled_field_init(oled_field_t *field) {
+    if (field->width > OLED_FIELD_MAX_CHARS) field->width = OLED_FIELD_MAX_CHARS;
+
+    memset(field->cells, ' ', sizeof(field->cells));
+    oled_fill_rect(field->x, field->y, field->width * OLED_CELL_WIDTH, OLED_CELL_HEIGHT, 0);
+    oled_mark_dirty(field->x, field->y, field->width * OLED_CELL_WIDTH, OLED_CELL_HEIGHT);
+}
+
+void oled_field_set_text(oled_field_t *field, const char *text) {
+    uint8_t first = 0xFF;
+    uint8_t last = 0;
+
+    for (uint8_t i = 0; i < field->width; i++) {
+        char c = *text ? *text++ : ' ';
+        if (c == field->cells[i]) continue;
+
+        uint8_t cell_x = field->x + i * OLED_CELL_WIDTH;
+        oled_fill_rect(cell_x, field->y, OLED_CELL_WIDTH, OLED_CELL_HEIGHT, 0);
+        oled_draw_char(cell_x, field->y, c);
+        field->cells[i] = c;
+
+        if (first == 0xFF) first = i;
+        last = i;
+    }
+
+    // One rect spanning the changed cells
+    if (first != 0xFF) {
+        oled_mark_dirty(field->x + first * OLED_CELL_WIDTH, field->y,
+                        (last - first + 1) * OLED_CELL_WIDTH, OLED_CELL_HEIGHT);
+    }
+}
+
+void oled_field_set_int(oled_field_t *field, int value) {
+    oled_field_set_fixed(field, value, 0, 0);
+}
+
+void oled_field_set_float(oled_field_t *field, float value, int decimals) {
+    oled_field_set_fixed(field, fixed_from_float(value, decimals), decimals, decimals);
+}
+
+void oled_field_set_fixed(oled_field_t *field, int32_t value, uint8_t frac_digits, uint8_t decimals) {
+    char buffer[FIXED_FORMAT_MAX];
+    fixed_format(buffer, value, frac_digits, decimals);
+    oled_field_set_text(field, buffer);
+}
+
+void oled_gauge_init(oled_gauge_t *gauge) {
+    oled_fill_rect(gauge->x, gauge->y, gauge->w, gauge->h, 0);
+    oled_draw_rect(gauge->x, gauge->y, gauge->w, gauge->h, 1);
+    oled_mark_dirty(gauge->x, gauge->y, gauge->w, gauge->h);
+    gauge->fill = 0;
+}
+
+void oled_gauge_set(oled_gauge_t *gauge, int percent) {
+    if (percent < 0) percent = 0;
+    if (percent > 100) percent = 100;
+
+    // Bar sits inside the frame with a one pixel gap
+    uint8_t inner_x = gauge->x + 2;
+    uint8_t inner_w = gauge->w - 4;
+    uint8_t inner_h = gauge->h - 4;
+    uint8_t fill = (percent * inner_w) / 100;
+
+    if (fill == gauge->fill) return;
+
+    if (fill > gauge->fill) {
+        oled_fill_rect(inner_x + gauge->fill, gauge->y + 2, fill - gauge->fill, inner_h, 1);
+        oled_mark_dirty(inner_x + gauge->fill, gauge->y + 2, fill - gauge->fill, inner_h);
+    } else {
+        oled_fill_rect(inner_x + fill, gauge->y + 2, gauge->fill - fill, inner_h, 0);
+        oled_mark_dirty(inner_x + fill, gauge->y + 2, gauge->fill - fill, inner_h);
+    }
+    gauge->fill = fill;
+}
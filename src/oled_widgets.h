@@ -0,0 +1,67 @@
+#ifndef OLED_WIDGETS_H
+#define OLED_WIDGETS_H
+
+#include <stdint.h>
+#include "oled_ssd1306.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Character cell of the built-in 5x7 font, including spacing
+#define OLED_CELL_WIDTH 6
+#define OLED_CELL_HEIGHT 8
+
+#define OLED_FIELD_MAX_CHARS 16
+
+// Static text, drawn once
+typedef struct {
+    uint8_t x;
+    uint8_t y;
+    const char *text;
+} oled_label_t;
+
+// Fixed-width text field; only cells whose character changed are repainted.
+// Used for numeric values and status text.
+typedef struct {
+    uint8_t x;
+    uint8_t y;
+    uint8_t width;                          // in character cells
+    char cells[OLED_FIELD_MAX_CHARS];       // what is on screen now
+} oled_field_t;
+
+// Horizontal bar gauge (0-100); only the columns between old and new fill
+// are repainted
+typedef struct {
+    uint8_t x;
+    uint8_t y;
+    uint8_t w;
+    uint8_t h;
+    uint8_t fill;                           // filled columns on screen now
+} oled_gauge_t;
+
+// Draw a label and mark it dirty
+void oled_label_draw(const oled_label_t *label);
+
+// Clear a field's cells and mark it dirty; resets its cache
+void oled_field_init(oled_field_t *field);
+
+// Set field text, left aligned and space padded to the field width
+void oled_field_set_text(oled_field_t *field, const char *text);
+void oled_field_set_int(oled_field_t *field, int value);
+void oled_field_set_float(oled_field_t *field, float value, int decimals);
+
+// Scaled integer with `frac_digits` implied decimals, shown with `decimals`
+void oled_field_set_fixed(oled_field_t *field, int32_t value, uint8_t frac_digits, uint8_t decimals);
+
+// Draw the gauge frame with an empty bar
+void oled_gauge_init(oled_gauge_t *gauge);
+
+// Set the gauge value in percent
+void oled_gauge_set(oled_gauge_t *gauge, int percent);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
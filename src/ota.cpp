@@ -0,0 +1,466 @@
+#include "ota.h"
+#include "ota_patch.h"
+#include "boot.h"
+#include "connectToWifi.h"
+#include "logger.h"
+#include "timer_wheel.h"
+#include "outbox.h"
+#include <Preferences.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <mbedtls/ecdsa.h>
+#include <mbedtls/sha256.h>
+#include <ota_signing_key.h>
+
+#define OTA_NAMESPACE "ota"
+
+enum OtaState {
+    OTA_IDLE = 0,
+    OTA_RECEIVING,
+    OTA_REBOOTING
+};
+
+static OtaState state = OTA_IDLE;
+static uint32_t patchSize = 0;
+static uint32_t received = 0;
+static uint32_t resendOffset = UINT32_MAX;
+
+static const esp_partition_t* basePartition = NULL;
+static const esp_partition_t* targetPartition = NULL;
+static esp_ota_handle_t otaHandle = 0;
+static bool otaOpen = false;
+static mbedtls_sha256_context imageSha;
+static ota_patch_t patch;
+
+static TimerId idleTimer = TIMER_NONE;
+static TimerId rebootTimer = TIMER_NONE;
+static TimerId confirmTimer = TIMER_NONE;
+
+// Running an image that has not passed its health check yet
+static bool trial = false;
+
+// Rollback to report once MQTT is up, empty if none
+static char rollbackReason[24] = "";
+
+// Arduino marks a new image valid in initArduino() unless told that the
+// app does it itself, after its health check
+extern "C" bool verifyRollbackLater() {
+    return true;
+}
+
+static void publishOta(const char* otaState, const char* extra, const char* requestId) {
+    char event[224];
+    int len = snprintf(event, sizeof(event), "{\"event\":\"ota\",\"state\":\"%s\"%s", otaState, extra);
+    if (requestId != NULL) {
+        len += snprintf(event + len, sizeof(event) - len, ",\"req\":\"%s\"", requestId);
+    }
+    snprintf(event + len, sizeof(event) - len, "}");
+    publishEvent(event);
+}
+
+static void publishOtaReason(const char* otaState, const char* reason) {
+    char extra[48];
+    snprintf(extra, sizeof(extra), ",\"reason\":\"%s\"", reason);
+    publishOta(otaState, extra, NULL);
+}
+
+// Next patch offset wanted; resend asks the sender to go back to it
+static void publishAck(bool resend) {
+    char ack[48];
+    snprintf(ack, sizeof(ack), "{\"next\":%lu%s}", (unsigned long)received, resend ? ",\"resend\":true" : "");
+    mqttClient.publish(mqttTopicOtaAck, ack);
+}
+
+static void endTransfer() {
+    if (otaOpen) {
+        esp_ota_abort(otaHandle);
+        otaOpen = false;
+    }
+    mbedtls_sha256_free(&imageSha);
+    timerStop(idleTimer);
+    state = OTA_IDLE;
+}
+
+// otaState is "error" or "aborted"
+static void abortUpdate(const char* otaState, const char* reason) {
+    endTransfer();
+    publishOtaReason(otaState, reason);
+    LOG_WARN("OTA %s: %s (at %lu of %lu bytes)", otaState, reason, (unsigned long)received, (unsigned long)patchSize);
+}
+
+static void idleTimeout() {
+    if (state == OTA_RECEIVING) {
+        abortUpdate("aborted", "timeout");
+    }
+}
+
+static void rebootNow() {
+    ESP.restart();
+}
+
+static bool readBase(void* ctx, uint32_t offset, uint8_t* out, size_t len) {
+    return esp_partition_read(basePartition, offset, out, len) == ESP_OK;
+}
+
+static bool writeImage(void* ctx, const uint8_t* data, size_t len) {
+    if (!otaOpen) {
+        return false;
+    }
+    mbedtls_sha256_update_ret(&imageSha, data, len);
+    return esp_ota_write(otaHandle, data, len) == ESP_OK;
+}
+
+// The header is signed with the release key (tools/ota_patch.py keygen).
+// It carries the hash of the new image, which is checked once the image is
+// written, so the signature covers the image as well.
+static bool signatureValid() {
+    uint8_t digest[32];
+    mbedtls_sha256_ret(patch.header_bytes, OTA_PATCH_SIGNED_SIZE, digest, 0);
+
+    mbedtls_ecp_group group;
+    mbedtls_ecp_point key;
+    mbedtls_mpi r, s;
+    mbedtls_ecp_group_init(&group);
+    mbedtls_ecp_point_init(&key);
+    mbedtls_mpi_init(&r);
+    mbedtls_mpi_init(&s);
+    const uint8_t* signature = patch.header.signature;
+    int ret = mbedtls_ecp_group_load(&group, MBEDTLS_ECP_DP_SECP256R1);
+    if (ret == 0) {
+        ret = mbedtls_ecp_point_read_binary(&group, &key, OTA_SIGNING_PUBLIC_KEY, sizeof(OTA_SIGNING_PUBLIC_KEY));
+    }
+    if (ret == 0) {
+        ret = mbedtls_ecp_check_pubkey(&group, &key);
+    }
+    if (ret == 0) {
+        ret = mbedtls_mpi_read_binary(&r, signature, OTA_PATCH_SIGNATURE_SIZE / 2);
+    }
+    if (ret == 0) {
+        ret = mbedtls_mpi_read_binary(&s, signature + OTA_PATCH_SIGNATURE_SIZE / 2, OTA_PATCH_SIGNATURE_SIZE / 2);
+    }
+    if (ret == 0) {
+        ret = mbedtls_ecdsa_verify(&group, digest, sizeof(digest), &key, &r, &s);
+    }
+    mbedtls_mpi_free(&s);
+    mbedtls_mpi_free(&r);
+    mbedtls_ecp_point_free(&key);
+    mbedtls_ecp_group_free(&group);
+    if (ret != 0) {
+        LOG_WARN("OTA: patch signature rejected, -0x%04x", -ret);
+    }
+    return ret == 0;
+}
+
+// A delta only applies to the exact image it was made from
+static bool baseMatches(const ota_patch_header_t& header) {
+    static uint8_t block[1024];
+    if (header.base_size > basePartition->size) {
+        return false;
+    }
+    mbedtls_sha256_context sha;
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts_ret(&sha, 0);
+    bool ok = true;
+    for (uint32_t offset = 0; offset < header.base_size && ok; offset += sizeof(block)) {
+        uint32_t len = header.base_size - offset < sizeof(block) ? header.base_size - offset : sizeof(block);
+        ok = esp_partition_read(basePartition, offset, block, len) == ESP_OK;
+        mbedtls_sha256_update_ret(&sha, block, len);
+    }
+    uint8_t digest[32];
+    mbedtls_sha256_finish_ret(&sha, digest);
+    mbedtls_sha256_free(&sha);
+    return ok && memcmp(digest, header.base_sha256, sizeof(digest)) == 0;
+}
+
+// Header is in: check it and open the target partition. Reason on failure.
+static const char* startImage(const ota_patch_header_t& header) {
+    // Before anything else: the base check reads the whole partition
+    if (!signatureValid()) {
+        return "bad_signature";
+    }
+    if (header.new_size > targetPartition->size) {
+        return "too_large";
+    }
+    if ((header.flags & OTA_PATCH_FLAG_DELTA) && !baseMatches(header)) {
+        return "base_mismatch";
+    }
+    // Sectors are erased as the writes reach them, not all up front, so
+    // the loop keeps running during the transfer
+    if (esp_ota_begin(targetPartition, OTA_WITH_SEQUENTIAL_WRITES, &otaHandle) != ESP_OK) {
+        return "begin_failed";
+    }
+    otaOpen = true;
+    mbedtls_sha256_starts_ret(&imageSha, 0);
+    LOG_INFO("OTA: %s image, %lu bytes into %s", (header.flags & OTA_PATCH_FLAG_DELTA) ? "delta" : "full",
+             (unsigned long)header.new_size, targetPartition->label);
+    return NULL;
+}
+
+// Whole image written: verify, switch the boot partition and restart
+static void finishImage() {
+    uint8_t digest[32];
+    mbedtls_sha256_finish_ret(&imageSha, digest);
+    if (memcmp(digest, patch.header.new_sha256, sizeof(digest)) != 0) {
+        abortUpdate("error", "hash_mismatch");
+        return;
+    }
+    // Checks the image structure and checksum; frees the handle either way
+    otaOpen = false;
+    if (esp_ota_end(otaHandle) != ESP_OK) {
+        abortUpdate("error", "image_invalid");
+        return;
+    }
+    // One otadata write: either the old or the new image boots, never
+    // something in between
+    if (esp_ota_set_boot_partition(targetPartition) != ESP_OK) {
+        abortUpdate("error", "switch_failed");
+        return;
+    }
+    endTransfer();
+
+    Preferences prefs;
+    prefs.begin(OTA_NAMESPACE, false);
+    prefs.putUChar("trial", 1);
+    prefs.putUChar("tries", 0);
+    prefs.putString("from", basePartition->label);
+    prefs.putString("target", targetPartition->label);
+    prefs.end();
+
+    state = OTA_REBOOTING;
+    char extra[48];
+    snprintf(extra, sizeof(extra), ",\"partition\":\"%s\"", targetPartition->label);
+    publishOta("rebooting", extra, NULL);
+    LOG_INFO("OTA: image verified, rebooting into %s", targetPartition->label);
+    timerStart(rebootTimer, OTA_REBOOT_DELAY_MS);
+}
+
+void otaHandleChunk(const uint8_t* payload, unsigned int length) {
+    if (state != OTA_RECEIVING || length < 4) {
+        return;
+    }
+    uint32_t offset = (uint32_t)payload[0] | ((uint32_t)payload[1] << 8) |
+                      ((uint32_t)payload[2] << 16) | ((uint32_t)payload[3] << 24);
+    const uint8_t* data = payload + 4;
+    uint32_t len = length - 4;
+
+    // Chunks are taken in order only. Ask once per gap for a resend;
+    // repeats of chunks already taken are dropped.
+    if (offset != received) {
+        if (offset > received && resendOffset != received) {
+            resendOffset = received;
+            publishAck(true);
+        }
+        return;
+    }
+    if (len > patchSize - received) {
+        abortUpdate("error", "too_long");
+        return;
+    }
+    timerStart(idleTimer, OTA_IDLE_TIMEOUT_MS);
+
+    ota_patch_result_t result = OTA_PATCH_OK;
+    size_t pos = 0;
+    while (pos < len) {
+        size_t used;
+        result = ota_patch_feed(&patch, data + pos, len - pos, &used);
+        pos += used;
+        if (result == OTA_PATCH_HEADER) {
+            const char* reason = startImage(patch.header);
+            if (reason != NULL) {
+                abortUpdate("error", reason);
+                return;
+            }
+            result = OTA_PATCH_OK;
+        } else if (result != OTA_PATCH_OK) {
+            break;
+        }
+    }
+    if (result != OTA_PATCH_OK && result != OTA_PATCH_DONE) {
+        abortUpdate("error", ota_patch_result_name(result));
+        return;
+    }
+
+    received += len;
+    publishAck(false);
+
+    if (result == OTA_PATCH_DONE) {
+        if (pos != len || received != patchSize) {
+            abortUpdate("error", "bad_patch");
+        } else {
+            finishImage();
+        }
+    } else if (received == patchSize) {
+        abortUpdate("error", "truncated");
+    }
+}
+
+static void beginUpdate(long size, const char* requestId) {
+    if (state == OTA_REBOOTING) {
+        return;
+    }
+    // The other partition holds the image to roll back to
+    if (trial) {
+        publishOtaReason("error", "unconfirmed");
+        return;
+    }
+    if (size <= OTA_PATCH_HEADER_SIZE) {
+        publishOtaReason("error", "bad_size");
+        return;
+    }
+    if (state == OTA_RECEIVING) {
+        abortUpdate("aborted", "restarted");
+    }
+
+    basePartition = esp_ota_get_running_partition();
+    targetPartition = esp_ota_get_next_update_partition(NULL);
+    if (basePartition == NULL || targetPartition == NULL) {
+        publishOtaReason("error", "no_partition");
+        return;
+    }
+
+    ota_patch_init(&patch, readBase, writeImage, NULL);
+    mbedtls_sha256_init(&imageSha);
+    patchSize = size;
+    received = 0;
+    resendOffset = UINT32_MAX;
+    state = OTA_RECEIVING;
+    timerStart(idleTimer, OTA_IDLE_TIMEOUT_MS);
+
+    char extra[64];
+    snprintf(extra, sizeof(extra), ",\"size\":%lu,\"partition\":\"%s\"", (unsigned long)size, targetPartition->label);
+    publishOta("ready", extra, requestId);
+    publishAck(false);
+}
+
+static void publishOtaStatus(const char* requestId) {
+    static const char* const stateNames[] = {"idle", "receiving", "rebooting"};
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    const esp_app_desc_t* app = esp_ota_get_app_description();
+    char extra[160];
+    snprintf(extra, sizeof(extra),
+             ",\"transfer\":\"%s\",\"received\":%lu,\"size\":%lu,\"running\":\"%s\",\"version\":\"%s\",\"built\":\"%s %s\",\"trial\":%s",
+             stateNames[state], (unsigned long)received, (unsigned long)patchSize,
+             running != NULL ? running->label : "?", app->version, app->date, app->time,
+             trial ? "true" : "false");
+    publishOta("status", extra, requestId);
+}
+
+void handleOtaCommand(const String& command, const String& args, const char* requestId) {
+    if (command == "OTA_BEGIN") {
+        beginUpdate(args.toInt(), requestId);
+    } else if (command == "OTA_ABORT") {
+        if (state == OTA_RECEIVING) {
+            abortUpdate("aborted", "requested");
+        }
+    } else if (command == "OTA_STATUS") {
+        publishOtaStatus(requestId);
+    } else {
+        LOG_WARN("Unknown command: '%s'", command.c_str());
+    }
+}
+
+// Go back to the image the update came from
+static void rollBack(const char* reason) {
+    LOG_ERROR("OTA: new image failed (%s), rolling back", reason);
+    Preferences prefs;
+    prefs.begin(OTA_NAMESPACE, false);
+    prefs.putUChar("trial", 0);
+    prefs.putString("rolled", reason);
+    String from = prefs.getString("from", "");
+    prefs.end();
+
+    // Bootloader rollback: marks this image invalid and restarts
+    esp_ota_mark_app_invalid_rollback_and_reboot();
+
+    // Without it, point otadata back at the previous image ourselves
+    const esp_partition_t* previous = esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_ANY,
+                                                               from.c_str());
+    if (previous != NULL) {
+        esp_ota_set_boot_partition(previous);
+    }
+    ESP.restart();
+}
+
+// Health check of a trial image: it must keep the control loop running and
+// reach the broker, or the next update could not be delivered
+static void confirmTick() {
+    bool healthy = millis() >= OTA_CONFIRM_MIN_MS && mqttClient.connected() &&
+                   bootPhaseDone(BOOT_PHASE_FIRST_CONTROL);
+    if (healthy) {
+        esp_ota_mark_app_valid_cancel_rollback();
+        Preferences prefs;
+        prefs.begin(OTA_NAMESPACE, false);
+        prefs.putUChar("trial", 0);
+        prefs.end();
+        trial = false;
+        timerStop(confirmTimer);
+
+        char extra[48];
+        snprintf(extra, sizeof(extra), ",\"partition\":\"%s\"", esp_ota_get_running_partition()->label);
+        publishOta("confirmed", extra, NULL);
+        LOG_INFO("OTA: new image confirmed");
+    } else if (millis() >= OTA_CONFIRM_TIMEOUT_MS) {
+        rollBack("health_check");
+    }
+}
+
+void initOta() {
+    idleTimer = timerCreate("ota_idle", idleTimeout);
+    rebootTimer = timerCreate("ota_reboot", rebootNow);
+    confirmTimer = timerCreate("ota_confirm", confirmTick);
+
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    esp_ota_img_states_t imageState;
+    bool pendingVerify = esp_ota_get_state_partition(running, &imageState) == ESP_OK &&
+                         imageState == ESP_OTA_IMG_PENDING_VERIFY;
+
+    Preferences prefs;
+    prefs.begin(OTA_NAMESPACE, false);
+    String rolled = prefs.getString("rolled", "");
+    bool updated = prefs.getUChar("trial", 0) != 0;
+    uint8_t tries = 0;
+    if (updated && prefs.getString("target", "") != running->label) {
+        // The bootloader went back on its own: the new image crashed or
+        // hung before passing its health check
+        prefs.putUChar("trial", 0);
+        prefs.putString("rolled", "crashed");
+        rolled = "crashed";
+        updated = false;
+    } else if (updated) {
+        tries = prefs.getUChar("tries", 0) + 1;
+        prefs.putUChar("tries", tries);
+    }
+    prefs.end();
+
+    strncpy(rollbackReason, rolled.c_str(), sizeof(rollbackReason) - 1);
+    if (rollbackReason[0] != '\0') {
+        LOG_WARN("OTA: update was rolled back (%s), running %s", rollbackReason, running->label);
+    }
+
+    if (updated && tries > OTA_MAX_TRIAL_BOOTS) {
+        rollBack("boot_loop");
+    }
+    trial = updated || pendingVerify;
+    if (trial) {
+        LOG_WARN("OTA: running new image from %s on trial (boot %u)", running->label, tries);
+        timerStart(confirmTimer, OTA_CONFIRM_CHECK_MS, OTA_CONFIRM_CHECK_MS);
+    }
+}
+
+void otaOnConnected() {
+    if (!mqttClient.subscribe(mqttTopicOta)) {
+        LOG_ERROR("FAILED to subscribe to OTA topic!");
+    }
+    if (rollbackReason[0] != '\0') {
+        char extra[80];
+        snprintf(extra, sizeof(extra), ",\"reason\":\"%s\",\"partition\":\"%s\"", rollbackReason,
+                 esp_ota_get_running_partition()->label);
+        publishOta("rolled_back", extra, NULL);
+
+        Preferences prefs;
+        prefs.begin(OTA_NAMESPACE, false);
+        prefs.remove("rolled");
+        prefs.end();
+        rollbackReason[0] = '\0';
+    }
+}
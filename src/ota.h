@@ -0,0 +1,48 @@
+#ifndef OTA_H
+#define OTA_H
+
+#include <Arduino.h>
+
+// Firmware updates over MQTT. A patch (ota_patch.h, built and sent with
+// tools/ota_patch.py) arrives in chunks on growbox/<id>/ota and is decoded
+// straight into the inactive app partition; nothing is buffered beyond one
+// flash block. The new image is checked against the SHA-256 in the patch
+// and by esp_ota_end() before the boot partition is switched. It then
+// boots on trial: it must pass the health check within
+// OTA_CONFIRM_TIMEOUT_MS, or it is rolled back to the previous image. A
+// crash or watchdog reset before that also rolls back (bootloader
+// rollback, with a boot counter as a fallback).
+
+// Patch bytes per chunk message; the payload is [u32 offset][data]
+#define OTA_CHUNK_MAX 1024
+
+// Abandon a transfer when no chunk has arrived for this long
+#define OTA_IDLE_TIMEOUT_MS 60000
+
+// Health check of a new image: up this long with MQTT connected and the
+// sensor and pump loop running
+#define OTA_CONFIRM_MIN_MS 60000
+#define OTA_CONFIRM_CHECK_MS 5000
+#define OTA_CONFIRM_TIMEOUT_MS 300000
+
+// Boots of an unconfirmed image before it is given up on
+#define OTA_MAX_TRIAL_BOOTS 3
+
+// Time for the last events to leave before the restart
+#define OTA_REBOOT_DELAY_MS 1000
+
+// Check for a trial or rolled back image and start the health check.
+// Call after initTimers().
+void initOta();
+
+// On every MQTT connection: subscribe to the chunk topic, report a
+// rollback that happened before this boot
+void otaOnConnected();
+
+// A message on growbox/<id>/ota
+void otaHandleChunk(const uint8_t* payload, unsigned int length);
+
+// OTA_BEGIN <patch bytes>, OTA_ABORT, OTA_STATUS
+void handleOtaCommand(const String& command, const String& args, const char* requestId);
+
+#endif
@@ -0,0 +1,291 @@
+#include "ota_patch.h"
+#include <string.h>
+
+enum {
+    OP_END = 0x00,
+    OP_COPY = 0x01,
+    OP_INSERT = 0x02
+};
+
+enum {
+    ST_HEADER = 0,
+    ST_OP,
+    ST_VARINT,
+    ST_COPY_LITERALS,
+    ST_INSERT,
+    ST_END
+};
+
+// Where a finished varint goes
+enum {
+    VAR_COPY_LEN = 0,
+    VAR_COPY_OFFSET,
+    VAR_ZEROS,
+    VAR_LITERALS,
+    VAR_INSERT_LEN
+};
+
+static uint32_t read_u32(const uint8_t *bytes) {
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static void start_varint(ota_patch_t *patch, uint8_t target) {
+    patch->varint = 0;
+    patch->varint_shift = 0;
+    patch->varint_target = target;
+    patch->state = ST_VARINT;
+}
+
+static bool flush_out(ota_patch_t *patch) {
+    if (patch->out_len == 0) {
+        return true;
+    }
+    if (!patch->write(patch->ctx, patch->out, patch->out_len)) {
+        return false;
+    }
+    patch->written += patch->out_len;
+    patch->out_len = 0;
+    return true;
+}
+
+// Room for count more output bytes within new_size
+static bool output_fits(const ota_patch_t *patch, uint32_t count) {
+    return count <= patch->header.new_size - patch->written - patch->out_len;
+}
+
+// count base bytes at base_pos, plus diff if given, to the output
+static ota_patch_result_t emit_base(ota_patch_t *patch, uint32_t count, const uint8_t *diff) {
+    if (count > patch->header.base_size || patch->base_pos > patch->header.base_size - count) {
+        return OTA_PATCH_ERR_RANGE;
+    }
+    while (count > 0) {
+        size_t space = OTA_PATCH_OUT_BLOCK - patch->out_len;
+        size_t n = count < space ? count : space;
+        uint8_t *out = &patch->out[patch->out_len];
+        if (!patch->read(patch->ctx, patch->base_pos, out, n)) {
+            return OTA_PATCH_ERR_READ;
+        }
+        if (diff != NULL) {
+            for (size_t i = 0; i < n; i++) {
+                out[i] += diff[i];
+            }
+            diff += n;
+        }
+        patch->base_pos += n;
+        patch->out_len += n;
+        count -= n;
+        if (patch->out_len == OTA_PATCH_OUT_BLOCK && !flush_out(patch)) {
+            return OTA_PATCH_ERR_WRITE;
+        }
+    }
+    return OTA_PATCH_OK;
+}
+
+static ota_patch_result_t emit_bytes(ota_patch_t *patch, const uint8_t *data, uint32_t count) {
+    while (count > 0) {
+        size_t space = OTA_PATCH_OUT_BLOCK - patch->out_len;
+        size_t n = count < space ? count : space;
+        memcpy(&patch->out[patch->out_len], data, n);
+        patch->out_len += n;
+        data += n;
+        count -= n;
+        if (patch->out_len == OTA_PATCH_OUT_BLOCK && !flush_out(patch)) {
+            return OTA_PATCH_ERR_WRITE;
+        }
+    }
+    return OTA_PATCH_OK;
+}
+
+static ota_patch_result_t parse_header(ota_patch_t *patch) {
+    const uint8_t *h = patch->header_bytes;
+    if (memcmp(h, "GBOT", 4) != 0 || h[4] != OTA_PATCH_VERSION) {
+        return OTA_PATCH_ERR_HEADER;
+    }
+    patch->header.flags = h[5];
+    patch->header.new_size = read_u32(&h[6]);
+    patch->header.base_size = read_u32(&h[10]);
+    memcpy(patch->header.new_sha256, &h[14], 32);
+    memcpy(patch->header.base_sha256, &h[46], 32);
+    memcpy(patch->header.signature, &h[OTA_PATCH_SIGNED_SIZE], OTA_PATCH_SIGNATURE_SIZE);
+    if (patch->header.new_size == 0) {
+        return OTA_PATCH_ERR_HEADER;
+    }
+    // A full image has no base to copy from
+    if (!(patch->header.flags & OTA_PATCH_FLAG_DELTA)) {
+        patch->header.base_size = 0;
+    }
+    patch->state = ST_OP;
+    return OTA_PATCH_HEADER;
+}
+
+// A COPY op is done when it has produced all its bytes; otherwise the
+// next half of the (zeros, literals) pair follows
+static void after_copy_run(ota_patch_t *patch, uint8_t next) {
+    if (patch->op_left == 0) {
+        patch->state = ST_OP;
+    } else {
+        start_varint(patch, next);
+    }
+}
+
+static ota_patch_result_t finish_varint(ota_patch_t *patch) {
+    uint32_t value = patch->varint;
+    switch (patch->varint_target) {
+        case VAR_COPY_LEN:
+            if (value == 0 || !output_fits(patch, value)) {
+                return OTA_PATCH_ERR_RANGE;
+            }
+            patch->op_left = value;
+            start_varint(patch, VAR_COPY_OFFSET);
+            break;
+        case VAR_COPY_OFFSET:
+            patch->base_pos = value;
+            start_varint(patch, VAR_ZEROS);
+            break;
+        case VAR_ZEROS: {
+            if (value > patch->op_left) {
+                return OTA_PATCH_ERR_FORMAT;
+            }
+            ota_patch_result_t ret = emit_base(patch, value, NULL);
+            if (ret != OTA_PATCH_OK) {
+                return ret;
+            }
+            patch->op_left -= value;
+            after_copy_run(patch, VAR_LITERALS);
+            break;
+        }
+        case VAR_LITERALS:
+            if (value > patch->op_left) {
+                return OTA_PATCH_ERR_FORMAT;
+            }
+            patch->run_left = value;
+            if (value == 0) {
+                after_copy_run(patch, VAR_ZEROS);
+            } else {
+                patch->state = ST_COPY_LITERALS;
+            }
+            break;
+        case VAR_INSERT_LEN:
+            if (value == 0 || !output_fits(patch, value)) {
+                return OTA_PATCH_ERR_RANGE;
+            }
+            patch->run_left = value;
+            patch->state = ST_INSERT;
+            break;
+        default:
+            return OTA_PATCH_ERR_FORMAT;
+    }
+    return OTA_PATCH_OK;
+}
+
+void ota_patch_init(ota_patch_t *patch, ota_patch_read_fn read, ota_patch_write_fn write, void *ctx) {
+    memset(patch, 0, sizeof(*patch));
+    patch->read = read;
+    patch->write = write;
+    patch->ctx = ctx;
+    patch->state = ST_HEADER;
+}
+
+ota_patch_result_t ota_patch_feed(ota_patch_t *patch, const uint8_t *data, size_t len, size_t *used) {
+    size_t pos = 0;
+    ota_patch_result_t ret = OTA_PATCH_OK;
+
+    while (pos < len && ret == OTA_PATCH_OK) {
+        switch (patch->state) {
+            case ST_HEADER: {
+                size_t n = OTA_PATCH_HEADER_SIZE - patch->header_len;
+                if (n > len - pos) {
+                    n = len - pos;
+                }
+                memcpy(&patch->header_bytes[patch->header_len], &data[pos], n);
+                patch->header_len += n;
+                pos += n;
+                if (patch->header_len == OTA_PATCH_HEADER_SIZE) {
+                    ret = parse_header(patch);
+                }
+                break;
+            }
+            case ST_OP: {
+                uint8_t op = data[pos++];
+                if (op == OP_COPY) {
+                    start_varint(patch, VAR_COPY_LEN);
+                } else if (op == OP_INSERT) {
+                    start_varint(patch, VAR_INSERT_LEN);
+                } else if (op == OP_END) {
+                    if (!flush_out(patch)) {
+                        ret = OTA_PATCH_ERR_WRITE;
+                    } else if (patch->written != patch->header.new_size) {
+                        ret = OTA_PATCH_ERR_FORMAT;
+                    } else {
+                        patch->state = ST_END;
+                        ret = OTA_PATCH_DONE;
+                    }
+                } else {
+                    ret = OTA_PATCH_ERR_FORMAT;
+                }
+                break;
+            }
+            case ST_VARINT: {
+                uint8_t byte = data[pos++];
+                if (patch->varint_shift > 28) {
+                    ret = OTA_PATCH_ERR_FORMAT;
+                    break;
+                }
+                patch->varint |= (uint32_t)(byte & 0x7F) << patch->varint_shift;
+                patch->varint_shift += 7;
+                if (!(byte & 0x80)) {
+                    ret = finish_varint(patch);
+                }
+                break;
+            }
+            case ST_COPY_LITERALS: {
+                uint32_t n = patch->run_left;
+                if (n > len - pos) {
+                    n = len - pos;
+                }
+                ret = emit_base(patch, n, &data[pos]);
+                pos += n;
+                patch->run_left -= n;
+                patch->op_left -= n;
+                if (ret == OTA_PATCH_OK && patch->run_left == 0) {
+                    after_copy_run(patch, VAR_ZEROS);
+                }
+                break;
+            }
+            case ST_INSERT: {
+                uint32_t n = patch->run_left;
+                if (n > len - pos) {
+                    n = len - pos;
+                }
+                ret = emit_bytes(patch, &data[pos], n);
+                pos += n;
+                patch->run_left -= n;
+                if (ret == OTA_PATCH_OK && patch->run_left == 0) {
+                    patch->state = ST_OP;
+                }
+                break;
+            }
+            default:
+                // Nothing may follow the end op
+                ret = OTA_PATCH_ERR_FORMAT;
+                break;
+        }
+    }
+
+    *used = pos;
+    return ret;
+}
+
+const char *ota_patch_result_name(ota_patch_result_t result) {
+    switch (result) {
+        case OTA_PATCH_OK:          return "ok";
+        case OTA_PATCH_HEADER:      return "header";
+        case OTA_PATCH_DONE:        return "done";
+        case OTA_PATCH_ERR_HEADER:  return "bad_header";
+        case OTA_PATCH_ERR_FORMAT:  return "bad_patch";
+        case OTA_PATCH_ERR_RANGE:   return "out_of_range";
+        case OTA_PATCH_ERR_READ:    return "read_failed";
+        case OTA_PATCH_ERR_WRITE:   return "write_failed";
+    }
+    return "unknown";
+}
@@ -0,0 +1,106 @@
+#ifndef OTA_PATCH_H
+#define OTA_PATCH_H
+
+// Streaming decoder for firmware patches made by tools/ota_patch.py. A
+// patch is a header and a stream of ops that build the new image front to
+// back: COPY takes a span of the running (base) image plus a difference
+// that is mostly zero (bsdiff style, so moved code costs little), INSERT
+// carries new bytes. Input may be split anywhere; output leaves in order
+// through a callback, so the new image is never held in RAM. Plain C with
+// no IDF dependency, so it also builds on a host.
+//
+// Header (little-endian):
+//   "GBOT", version, flags, new size (u32), base size (u32),
+//   SHA-256 of the new image, SHA-256 of the base image (zero if full),
+//   ECDSA P-256 signature (r then s, 32 bytes each, big-endian) over the
+//   SHA-256 of the header bytes before it
+// The decoder only takes the signature apart; the caller checks it before
+// anything is written (ota.cpp).
+// Ops (sizes are LEB128 varints):
+//   0x00                      end
+//   0x01 len base_offset      COPY: then (zeros, count, count diff bytes)
+//                             pairs until len bytes are produced; either
+//                             half may end the op
+//   0x02 len bytes            INSERT
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OTA_PATCH_VERSION 2
+#define OTA_PATCH_SIGNED_SIZE 78
+#define OTA_PATCH_SIGNATURE_SIZE 64
+#define OTA_PATCH_HEADER_SIZE (OTA_PATCH_SIGNED_SIZE + OTA_PATCH_SIGNATURE_SIZE)
+#define OTA_PATCH_FLAG_DELTA 0x01
+
+// Output is handed on in blocks of this size
+#define OTA_PATCH_OUT_BLOCK 1024
+
+typedef struct {
+    uint8_t flags;
+    uint32_t new_size;
+    uint32_t base_size;
+    uint8_t new_sha256[32];
+    uint8_t base_sha256[32];
+    uint8_t signature[OTA_PATCH_SIGNATURE_SIZE];
+} ota_patch_header_t;
+
+typedef enum {
+    OTA_PATCH_OK = 0,           // all input used, more wanted
+    OTA_PATCH_HEADER,           // header complete, stopped right after it
+    OTA_PATCH_DONE,             // end op reached and all output written
+    OTA_PATCH_ERR_HEADER,
+    OTA_PATCH_ERR_FORMAT,
+    OTA_PATCH_ERR_RANGE,        // outside the base image or past new_size
+    OTA_PATCH_ERR_READ,
+    OTA_PATCH_ERR_WRITE
+} ota_patch_result_t;
+
+// Read from the base image; false on failure
+typedef bool (*ota_patch_read_fn)(void *ctx, uint32_t offset, uint8_t *out, size_t len);
+
+// Next bytes of the new image; false on failure
+typedef bool (*ota_patch_write_fn)(void *ctx, const uint8_t *data, size_t len);
+
+typedef struct {
+    ota_patch_read_fn read;
+    ota_patch_write_fn write;
+    void *ctx;
+
+    ota_patch_header_t header;
+    uint8_t header_bytes[OTA_PATCH_HEADER_SIZE];    // as received, for the signature
+    uint8_t state;
+
+    // Varint being read and where it goes
+    uint32_t varint;
+    uint8_t varint_shift;
+    uint8_t varint_target;
+
+    uint32_t op_left;           // bytes the current op still produces
+    uint32_t run_left;          // zeros, literals or insert bytes
+    uint32_t base_pos;
+    uint32_t header_len;
+
+    uint8_t out[OTA_PATCH_OUT_BLOCK];
+    size_t out_len;
+    uint32_t written;           // handed to write()
+} ota_patch_t;
+
+void ota_patch_init(ota_patch_t *patch, ota_patch_read_fn read, ota_patch_write_fn write, void *ctx);
+
+// Decode the next piece of the patch. *used is how much of data was taken:
+// all of it, except on OTA_PATCH_HEADER, where the caller checks the
+// header and feeds the rest again.
+ota_patch_result_t ota_patch_feed(ota_patch_t *patch, const uint8_t *data, size_t len, size_t *used);
+
+const char *ota_patch_result_name(ota_patch_result_t result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,225 @@
+#include "outbox.h"
+#include "connectToWifi.h"
+#include "logger.h"
+#include "timer_wheel.h"
+#include "web_server.h"
+#include <esp_system.h>
+
+struct OutboxEvent {
+    bool pending;               // false once acked
+    bool sent;
+    uint32_t seq;
+    uint32_t nextSendMs;
+    uint32_t retryMs;
+    char json[OUTBOX_EVENT_MAX];    // without the closing brace
+};
+
+struct OutboxSample {
+    uint32_t takenMs;
+    char json[OUTBOX_SAMPLE_MAX];
+};
+
+// FIFO in seq order; acked events leave from the head
+static OutboxEvent events[OUTBOX_EVENT_SLOTS];
+static uint8_t eventHead = 0;
+static uint8_t eventCount = 0;
+static uint32_t nextSeq = 0;
+
+static OutboxSample samples[OUTBOX_BATCH_MAX];
+static uint8_t sampleCount = 0;
+
+static OutboxStats stats;
+static TimerId outboxTimer = TIMER_NONE;
+
+// Static: too large for the loop task's stack
+static char batch[MQTT_BUFFER_SIZE - 64];
+
+static_assert(OUTBOX_BATCH_MAX * (OUTBOX_SAMPLE_MAX + 24) + 16 <= sizeof(batch),
+              "a full batch must fit in one MQTT message");
+
+static OutboxEvent& eventAt(uint8_t index) {
+    return events[(eventHead + index) % OUTBOX_EVENT_SLOTS];
+}
+
+static uint8_t pendingEvents() {
+    uint8_t pending = 0;
+    for (uint8_t i = 0; i < eventCount; i++) {
+        if (eventAt(i).pending) {
+            pending++;
+        }
+    }
+    return pending;
+}
+
+static bool isDue(uint32_t deadline, uint32_t now) {
+    return (int32_t)(now - deadline) >= 0;
+}
+
+// Resends are marked "dup" (like the MQTT DUP flag), so a receiver that
+// joined late can tell an old event from a new one
+static void sendEvent(OutboxEvent& event, uint32_t now) {
+    char message[OUTBOX_EVENT_MAX + 16];
+    snprintf(message, sizeof(message), "%s%s}", event.json, event.sent ? ",\"dup\":true" : "");
+    if (!mqttClient.publish(mqttTopicStatus, message)) {
+        return;
+    }
+    if (event.sent) {
+        stats.eventsResent++;
+    } else {
+        stats.eventsSent++;
+    }
+    event.sent = true;
+    event.nextSendMs = now + event.retryMs;
+    event.retryMs = event.retryMs * 2 < OUTBOX_RETRY_MAX_MS ? event.retryMs * 2 : OUTBOX_RETRY_MAX_MS;
+}
+
+static void sendDueEvents(uint32_t now) {
+    if (!mqttClient.connected()) {
+        return;
+    }
+    for (uint8_t i = 0; i < eventCount; i++) {
+        OutboxEvent& event = eventAt(i);
+        if (event.pending && isDue(event.nextSendMs, now)) {
+            sendEvent(event, now);
+        }
+    }
+}
+
+// Samples go oldest first, each with ,"age_ms":<ms before now>
+static void flushBatch(uint32_t now) {
+    if (sampleCount == 0 || !mqttClient.connected()) {
+        return;
+    }
+    int len = snprintf(batch, sizeof(batch), "{\"samples\":[");
+    for (uint8_t i = 0; i < sampleCount; i++) {
+        const char* sample = samples[i].json;
+        size_t sampleLen = strlen(sample);
+        len += snprintf(batch + len, sizeof(batch) - len, "%s%.*s,\"age_ms\":%lu}", i ? "," : "",
+                        (int)(sampleLen - 1), sample, (unsigned long)(now - samples[i].takenMs));
+    }
+    snprintf(batch + len, sizeof(batch) - len, "]}");
+
+    // Retained, so a bot that connects later sees the last known state
+    if (!mqttClient.publish(mqttTopicStatus, batch, true)) {
+        return;
+    }
+    stats.batches++;
+    stats.batchSamples += sampleCount;
+    if (sampleCount > stats.batchMax) {
+        stats.batchMax = sampleCount;
+    }
+    sampleCount = 0;
+}
+
+static void outboxTick() {
+    uint32_t now = millis();
+    sendDueEvents(now);
+    if (sampleCount > 0 && isDue(samples[0].takenMs + OUTBOX_BATCH_WINDOW_MS, now)) {
+        flushBatch(now);
+    }
+}
+
+void initOutbox() {
+    // Receivers dedupe by seq; a random start keeps the seqs of one boot
+    // apart from those of the last
+    nextSeq = esp_random();
+    outboxTimer = timerCreate("outbox", outboxTick);
+    timerStart(outboxTimer, OUTBOX_TICK_MS, OUTBOX_TICK_MS);
+}
+
+void publishEvent(const char* json) {
+    webBroadcast(json);
+
+    size_t len = strlen(json);
+    if (len < 2 || json[len - 1] != '}' || len + 24 > OUTBOX_EVENT_MAX) {
+        LOG_WARN("Event does not fit the outbox, sent once: %.40s", json);
+        mqttClient.publish(mqttTopicStatus, json);
+        return;
+    }
+
+    if (eventCount == OUTBOX_EVENT_SLOTS) {
+        LOG_WARN("Outbox full, dropping event %lu", (unsigned long)events[eventHead].seq);
+        stats.eventsDropped++;
+        eventHead = (eventHead + 1) % OUTBOX_EVENT_SLOTS;
+        eventCount--;
+    }
+    OutboxEvent& event = eventAt(eventCount);
+    eventCount++;
+
+    uint32_t now = millis();
+    event.pending = true;
+    event.sent = false;
+    event.seq = nextSeq++;
+    event.nextSendMs = now;
+    event.retryMs = OUTBOX_RETRY_MIN_MS;
+    snprintf(event.json, sizeof(event.json), "%.*s,\"seq\":%lu", (int)(len - 1), json, (unsigned long)event.seq);
+
+    uint8_t pending = pendingEvents();
+    if (pending > stats.eventsPendingMax) {
+        stats.eventsPendingMax = pending;
+    }
+    if (mqttClient.connected()) {
+        sendEvent(event, now);
+    }
+}
+
+void outboxAddSample(const char* json) {
+    size_t len = strlen(json);
+    if (len < 2 || json[len - 1] != '}' || len >= OUTBOX_SAMPLE_MAX) {
+        return;
+    }
+    // Offline: keep the newest samples
+    if (sampleCount == OUTBOX_BATCH_MAX) {
+        memmove(&samples[0], &samples[1], sizeof(samples[0]) * (OUTBOX_BATCH_MAX - 1));
+        sampleCount--;
+        stats.samplesDropped++;
+    }
+    samples[sampleCount].takenMs = millis();
+    memcpy(samples[sampleCount].json, json, len + 1);
+    sampleCount++;
+
+    if (sampleCount == OUTBOX_BATCH_MAX) {
+        flushBatch(millis());
+    }
+}
+
+void outboxOnConnected() {
+    uint32_t now = millis();
+    for (uint8_t i = 0; i < eventCount; i++) {
+        eventAt(i).nextSendMs = now;
+    }
+    sendDueEvents(now);
+    flushBatch(now);
+}
+
+void outboxHandleAck(const uint8_t* payload, unsigned int length) {
+    if (length == 0) {
+        return;
+    }
+    uint32_t seq = 0;
+    for (unsigned int i = 0; i < length; i++) {
+        if (payload[i] < '0' || payload[i] > '9') {
+            return;
+        }
+        seq = seq * 10 + (payload[i] - '0');
+    }
+    for (uint8_t i = 0; i < eventCount; i++) {
+        OutboxEvent& event = eventAt(i);
+        if (event.pending && event.seq == seq) {
+            event.pending = false;
+            stats.eventsAcked++;
+            break;
+        }
+    }
+    while (eventCount > 0 && !events[eventHead].pending) {
+        eventHead = (eventHead + 1) % OUTBOX_EVENT_SLOTS;
+        eventCount--;
+    }
+}
+
+void outboxTakeStats(OutboxStats* out) {
+    stats.eventsPending = pendingEvents();
+    *out = stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.eventsPendingMax = out->eventsPending;
+}
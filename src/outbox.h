@@ -0,0 +1,62 @@
+#ifndef OUTBOX_H
+#define OUTBOX_H
+
+#include <Arduino.h>
+
+// Outbound traffic on growbox/<id>/status. PubSubClient publishes at QoS 0
+// only, so delivery of events is made reliable here: each event carries a
+// "seq", stays queued until the bot acks it on growbox/<id>/ack and is
+// resent with backoff until then, across reconnects too. Resends carry
+// "dup":true; receivers drop repeats by seq. Samples are coalesced: the
+// ones taken within OUTBOX_BATCH_WINDOW_MS leave as one retained
+// {"samples":[...]} message, each with its age in ms.
+
+// Unacked events kept; the oldest is dropped when a new one does not fit
+#define OUTBOX_EVENT_SLOTS 12
+#define OUTBOX_EVENT_MAX 340
+
+// Resend an unacked event after this long, doubling up to the max
+#define OUTBOX_RETRY_MIN_MS 5000
+#define OUTBOX_RETRY_MAX_MS 60000
+
+// Samples per batch message, and how long the first one may wait
+#define OUTBOX_BATCH_MAX 6
+#define OUTBOX_BATCH_WINDOW_MS 30000
+#define OUTBOX_SAMPLE_MAX 288
+
+#define OUTBOX_TICK_MS 1000
+
+// Counters since the last outboxTakeStats()
+struct OutboxStats {
+    uint8_t eventsPending;
+    uint8_t eventsPendingMax;
+    uint32_t eventsSent;
+    uint32_t eventsResent;
+    uint32_t eventsAcked;
+    uint32_t eventsDropped;     // pushed out of a full queue unacked
+    uint32_t batches;
+    uint32_t batchSamples;
+    uint8_t batchMax;
+    uint32_t samplesDropped;    // oldest of a full batch while offline
+};
+
+// Start the outbox timer. Call after setupMQTT().
+void initOutbox();
+
+// Queue a status event ({"event":...}) for reliable delivery; it also goes
+// to the LAN clients right away
+void publishEvent(const char* json);
+
+// Add a status sample to the current batch
+void outboxAddSample(const char* json);
+
+// MQTT (re)connected: send what is due without waiting for the timer
+void outboxOnConnected();
+
+// A message on growbox/<id>/ack: the seq of a delivered event
+void outboxHandleAck(const uint8_t* payload, unsigned int length);
+
+// Copy the counters and start a new window
+void outboxTakeStats(OutboxStats* stats);
+
+#endif
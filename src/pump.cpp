@@ -0,0 +1,324 @@
+#include "pump.h"
+#include "board.h"
+#include "logger.h"
+#include "safety.h"
+#include "timer_wheel.h"
+#include "outbox.h"
+#include <Preferences.h>
+#include <esp_timer.h>
+
+#define PUMP_NAMESPACE "pump"
+
+// How long after the off edge the loop picks up a finished pulse
+#define PUMP_DONE_MARGIN_MS 20
+
+static_assert(Board::Pumps::count == PUMP_COUNT, "PUMP_COUNT does not match the board");
+
+struct PumpChannel {
+    uint8_t index;
+    uint32_t flowMlMin;
+    bool calibrated;
+    esp_timer_handle_t onTimer;
+    esp_timer_handle_t offTimer;
+    PumpPulse pulse;
+    int64_t startUs;            // scheduled on edge
+    bool running;
+    // Written by the esp_timer task
+    volatile int64_t onUs;
+    volatile int64_t offUs;
+    volatile bool finished;
+    // Measured length of the last calibration run, 0 if none
+    uint32_t calRunUs;
+};
+
+static PumpChannel channels[PUMP_COUNT];
+static uint8_t channelCount = 0;
+static PumpDoneCallback doneCallback = NULL;
+static TimerId doneTimer = TIMER_NONE;
+
+// Orders the edges against pumpStop() on the loop task
+static portMUX_TYPE edgeMux = portMUX_INITIALIZER_UNLOCKED;
+
+static void pumpKey(char* key, uint8_t pump, const char* suffix) {
+    snprintf(key, 16, "p%u%s", pump, suffix);
+}
+
+// esp_timer task: edges only, no logging or MQTT. esp_timer_stop() does
+// not wait for a callback already running, so an edge checks under the
+// lock that the pulse was not stopped meanwhile.
+static void onEdge(void* arg) {
+    PumpChannel* ch = (PumpChannel*)arg;
+    portENTER_CRITICAL(&edgeMux);
+    if (!ch->finished) {
+        Board::Pumps::set(ch->index, true);
+        ch->onUs = esp_timer_get_time();
+    }
+    portEXIT_CRITICAL(&edgeMux);
+}
+
+static void offEdge(void* arg) {
+    PumpChannel* ch = (PumpChannel*)arg;
+    portENTER_CRITICAL(&edgeMux);
+    Board::Pumps::set(ch->index, false);
+    if (!ch->finished) {
+        ch->offUs = esp_timer_get_time();
+        ch->finished = true;
+    }
+    portEXIT_CRITICAL(&edgeMux);
+}
+
+static void publishPumpCalibration(uint8_t pump, const char* state, const char* extra, const char* requestId) {
+    char event[192];
+    int len = snprintf(event, sizeof(event),
+                       "{\"event\":\"pump_calibration\",\"pump\":%u,\"state\":\"%s\",\"flow_ml_min\":%lu,\"calibrated\":%s%s",
+                       pump, state, (unsigned long)channels[pump].flowMlMin,
+                       channels[pump].calibrated ? "true" : "false", extra);
+    if (requestId != NULL) {
+        len += snprintf(event + len, sizeof(event) - len, ",\"req\":\"%s\"", requestId);
+    }
+    snprintf(event + len, sizeof(event) - len, "}");
+    publishEvent(event);
+}
+
+static void publishPumpError(uint8_t pump, const char* reason, const char* requestId) {
+    char extra[48];
+    snprintf(extra, sizeof(extra), ",\"reason\":\"%s\"", reason);
+    publishPumpCalibration(pump, "error", extra, requestId);
+    LOG_WARN("Pump %u calibration: %s", pump, reason);
+}
+
+// Loop side of a finished pulse
+static void collectPulses() {
+    bool pending = false;
+    for (uint8_t pump = 0; pump < channelCount; pump++) {
+        PumpChannel& ch = channels[pump];
+        if (!ch.running) {
+            continue;
+        }
+        if (!ch.finished) {
+            pending = true;
+            continue;
+        }
+        ch.running = false;
+
+        PumpPulse pulse = ch.pulse;
+        // Stopped before the on edge: the pump never ran
+        pulse.actualUs = ch.onUs != 0 && ch.offUs > ch.onUs ? (uint32_t)(ch.offUs - ch.onUs) : 0;
+        int32_t error = (int32_t)(pulse.actualUs - pulse.requestedUs);
+        pulse.widthErrorUs = error;
+        if (abs(error) > PUMP_WIDTH_TOLERANCE_US && pulse.actualUs != 0) {
+            LOG_WARN("Pump %u pulse %lu us, requested %lu us", pump,
+                     (unsigned long)pulse.actualUs, (unsigned long)pulse.requestedUs);
+        }
+
+        if (pulse.kind == PUMP_RUN_CALIBRATION) {
+            // A run cut short cannot be used to work out the flow
+            ch.calRunUs = error > -PUMP_WIDTH_TOLERANCE_US ? pulse.actualUs : 0;
+            char extra[48];
+            snprintf(extra, sizeof(extra), ",\"run_ms\":%lu", (unsigned long)(pulse.actualUs / 1000));
+            publishPumpCalibration(pump, ch.calRunUs ? "measure" : "cancelled", extra, NULL);
+        }
+        if (doneCallback != NULL) {
+            doneCallback(pulse);
+        }
+    }
+
+    // The off edge is late; look again shortly
+    if (pending) {
+        timerStart(doneTimer, PUMP_DONE_MARGIN_MS);
+    }
+}
+
+static void loadFlow(Preferences& prefs, uint8_t pump) {
+    PumpChannel& ch = channels[pump];
+    char key[16];
+    pumpKey(key, pump, "flow");
+    uint32_t flow = prefs.getUInt(key, 0);
+    ch.calibrated = flow >= PUMP_MIN_FLOW_ML_MIN && flow <= PUMP_MAX_FLOW_ML_MIN;
+    ch.flowMlMin = ch.calibrated ? flow : PUMP_DEFAULT_FLOW_ML_MIN;
+}
+
+void initPump(PumpDoneCallback done) {
+    doneCallback = done;
+    doneTimer = timerCreate("pump_done", collectPulses);
+
+    Preferences prefs;
+    prefs.begin(PUMP_NAMESPACE, true);
+
+    Board::Pumps::init();
+    channelCount = PUMP_COUNT;
+    for (uint8_t pump = 0; pump < channelCount; pump++) {
+        PumpChannel& ch = channels[pump];
+        ch.index = pump;
+
+        esp_timer_create_args_t args = {};
+        args.arg = &ch;
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.callback = onEdge;
+        args.name = "pump_on";
+        esp_timer_create(&args, &ch.onTimer);
+        args.callback = offEdge;
+        args.name = "pump_off";
+        esp_timer_create(&args, &ch.offTimer);
+
+        loadFlow(prefs, pump);
+        LOG_INFO("Pump %u: %lu mL/min%s", pump, (unsigned long)ch.flowMlMin,
+                 ch.calibrated ? "" : " (default, not calibrated)");
+    }
+    prefs.end();
+}
+
+uint32_t pumpDoseUs(uint8_t pump, uint32_t volumeMl) {
+    uint64_t us = (uint64_t)volumeMl * 60000000ULL;
+    return (uint32_t)((us + channels[pump].flowMlMin / 2) / channels[pump].flowMlMin);
+}
+
+static bool startPulse(uint8_t pump, uint32_t durationUs, uint32_t volumeMl, PumpRunKind kind) {
+    if (pump >= channelCount || channels[pump].running || durationUs == 0) {
+        return false;
+    }
+    PumpChannel& ch = channels[pump];
+    ch.pulse = {pump, kind, volumeMl, durationUs, 0, 0};
+    ch.onUs = 0;
+    ch.offUs = 0;
+    ch.finished = false;
+    ch.running = true;
+
+    // Both alarms are armed back to back from the same base
+    ch.startUs = esp_timer_get_time() + PUMP_START_LEAD_US;
+    esp_timer_start_once(ch.onTimer, PUMP_START_LEAD_US);
+    esp_timer_start_once(ch.offTimer, PUMP_START_LEAD_US + durationUs);
+    timerStart(doneTimer, (PUMP_START_LEAD_US + durationUs) / 1000 + PUMP_DONE_MARGIN_MS);
+    return true;
+}
+
+bool pumpStart(uint8_t pump, uint32_t volumeMl, PumpRunKind kind) {
+    if (pump >= channelCount || volumeMl == 0 || volumeMl > PUMP_MAX_DOSE_ML) {
+        return false;
+    }
+    return startPulse(pump, pumpDoseUs(pump, volumeMl), volumeMl, kind);
+}
+
+void pumpStop(uint8_t pump) {
+    if (pump >= channelCount) {
+        return;
+    }
+    PumpChannel& ch = channels[pump];
+    esp_timer_stop(ch.onTimer);
+    esp_timer_stop(ch.offTimer);
+
+    // Off again after the timers are stopped, under the edge lock: an on
+    // edge already dispatched either ran before this or sees finished
+    portENTER_CRITICAL(&edgeMux);
+    Board::Pumps::set(pump, false);
+    bool stopped = ch.running && !ch.finished;
+    if (stopped) {
+        ch.offUs = esp_timer_get_time();
+        ch.finished = true;
+    }
+    portEXIT_CRITICAL(&edgeMux);
+    if (stopped) {
+        timerStart(doneTimer, 0);
+    }
+}
+
+bool pumpRunning(uint8_t pump) {
+    return pump < channelCount && channels[pump].running;
+}
+
+uint32_t pumpRemainingMs(uint8_t pump) {
+    if (!pumpRunning(pump)) {
+        return 0;
+    }
+    const PumpChannel& ch = channels[pump];
+    int64_t remaining = ch.startUs + ch.pulse.requestedUs - esp_timer_get_time();
+    return remaining > 0 ? (uint32_t)((remaining + 999) / 1000) : 0;
+}
+
+uint32_t pumpFlowMlPerMin(uint8_t pump) {
+    return pump < channelCount ? channels[pump].flowMlMin : 0;
+}
+
+bool pumpCalibrated(uint8_t pump) {
+    return pump < channelCount && channels[pump].calibrated;
+}
+
+static void startCalibrationRun(uint8_t pump, const char* requestId) {
+    const uint32_t durationUs = PUMP_CAL_RUN_MS * 1000UL;
+    if (pumpRunning(pump)) {
+        publishPumpError(pump, "busy", requestId);
+        return;
+    }
+    // Runtime caps apply; the fault latch does not, as for manual runs
+    if (!safetyPumpAllowed(PUMP_CAL_RUN_MS)) {
+        publishPumpError(pump, "runtime_cap", requestId);
+        return;
+    }
+    channels[pump].calRunUs = 0;
+    startPulse(pump, durationUs, 0, PUMP_RUN_CALIBRATION);
+
+    char extra[48];
+    snprintf(extra, sizeof(extra), ",\"run_ms\":%lu", (unsigned long)PUMP_CAL_RUN_MS);
+    publishPumpCalibration(pump, "running", extra, requestId);
+    LOG_INFO("Pump %u calibration run, %lu ms", pump, (unsigned long)PUMP_CAL_RUN_MS);
+}
+
+// Flow from the volume the last calibration run delivered
+static void saveFlow(uint8_t pump, long volumeMl, const char* requestId) {
+    PumpChannel& ch = channels[pump];
+    if (ch.calRunUs == 0) {
+        publishPumpError(pump, "no_run", requestId);
+        return;
+    }
+    if (volumeMl <= 0) {
+        publishPumpError(pump, "bad_volume", requestId);
+        return;
+    }
+
+    uint64_t scaled = (uint64_t)volumeMl * 60000000ULL;
+    uint32_t flow = (uint32_t)((scaled + ch.calRunUs / 2) / ch.calRunUs);
+    if (flow < PUMP_MIN_FLOW_ML_MIN || flow > PUMP_MAX_FLOW_ML_MIN) {
+        publishPumpError(pump, "flow_out_of_range", requestId);
+        return;
+    }
+
+    Preferences prefs;
+    prefs.begin(PUMP_NAMESPACE, false);
+    char key[16];
+    pumpKey(key, pump, "flow");
+    prefs.putUInt(key, flow);
+    prefs.end();
+
+    ch.flowMlMin = flow;
+    ch.calibrated = true;
+    ch.calRunUs = 0;
+    publishPumpCalibration(pump, "saved", "", requestId);
+    LOG_INFO("Pump %u calibrated: %lu mL/min", pump, (unsigned long)flow);
+}
+
+void handlePumpCommand(const String& command, const String& args, const char* requestId) {
+    // The pump number comes last: "PUMP_CAL 250 1", "PUMP_CAL_RUN 1"
+    String pumpArg = args;
+    long volume = 0;
+    if (command == "PUMP_CAL") {
+        int space = args.indexOf(' ');
+        volume = args.toInt();
+        pumpArg = space >= 0 ? args.substring(space + 1) : "";
+    }
+
+    long pump = pumpArg.toInt();
+    if (pump < 0 || pump >= channelCount) {
+        publishPumpError(0, "bad_pump", requestId);
+        return;
+    }
+
+    if (command == "PUMP_CAL_RUN") {
+        startCalibrationRun(pump, requestId);
+    } else if (command == "PUMP_CAL") {
+        saveFlow(pump, volume, requestId);
+    } else if (command == "PUMP_CAL_STATUS") {
+        publishPumpCalibration(pump, "status", "", requestId);
+    } else {
+        LOG_WARN("Unknown command: '%s'", command.c_str());
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef PUMP_H
+#define PUMP_H
+
+#include <Arduino.h>
+
+// Pumps, one relay each, dosed by volume at their own calibrated flow rate.
+// Both edges of a pulse are esp_timer one-shots, so the run time does not
+// depend on what the loop is doing.
+
+#ifndef PUMP_COUNT
+#define PUMP_COUNT 1
+#endif
+
+// Flow rate used until a pump is calibrated (small 5 V submersible pump)
+#define PUMP_DEFAULT_FLOW_ML_MIN 1500
+
+// Accepted calibrated flow rates
+#define PUMP_MIN_FLOW_ML_MIN 10
+#define PUMP_MAX_FLOW_ML_MIN 10000
+
+// Largest single dose
+#define PUMP_MAX_DOSE_ML 1000
+
+// Calibration run: pump into a measuring jug for this long, then report
+// the volume with PUMP_CAL
+#define PUMP_CAL_RUN_MS 10000
+
+// The on edge is scheduled this far ahead, so both edges go through the
+// esp_timer task with the same dispatch latency
+#define PUMP_START_LEAD_US 1000
+
+// Pulse width error above this is logged
+#define PUMP_WIDTH_TOLERANCE_US 2000
+
+enum PumpRunKind {
+    PUMP_RUN_AUTO = 0,
+    PUMP_RUN_MANUAL,
+    PUMP_RUN_CALIBRATION
+};
+
+struct PumpPulse {
+    uint8_t pump;
+    PumpRunKind kind;
+    uint32_t volumeMl;          // 0 for a calibration run
+    uint32_t requestedUs;
+    uint32_t actualUs;          // measured between the two edges
+    int32_t widthErrorUs;       // actual minus requested
+};
+
+// Called from the loop once a pulse has ended, on time or stopped early
+typedef void (*PumpDoneCallback)(const PumpPulse& pulse);
+
+// Set up the board's relay pins (off) and load each pump's flow rate from NVS
+void initPump(PumpDoneCallback done);
+
+// Run time for a dose at the pump's flow rate
+uint32_t pumpDoseUs(uint8_t pump, uint32_t volumeMl);
+
+// Start a dose; false if the pump is already running
+bool pumpStart(uint8_t pump, uint32_t volumeMl, PumpRunKind kind);
+
+// Switch off at once; the pulse is reported with its actual width
+void pumpStop(uint8_t pump);
+
+bool pumpRunning(uint8_t pump);
+
+// Time left in the pulse, 0 when stopped
+uint32_t pumpRemainingMs(uint8_t pump);
+
+uint32_t pumpFlowMlPerMin(uint8_t pump);
+bool pumpCalibrated(uint8_t pump);
+
+// PUMP_CAL_RUN [pump], PUMP_CAL <ml> [pump], PUMP_CAL_STATUS [pump]
+void handlePumpCommand(const String& command, const String& args, const char* requestId);
+
+#endif
@@ -0,0 +1,193 @@
+#include "rule_vm.h"
+
+enum {
+    OP_CHANNEL = 0x01,
+    OP_PUSH8 = 0x02,
+    OP_PUSH16 = 0x03,
+    OP_PUSH32 = 0x04,
+    OP_LT = 0x10,
+    OP_LE = 0x11,
+    OP_GT = 0x12,
+    OP_GE = 0x13,
+    OP_EQ = 0x14,
+    OP_NE = 0x15,
+    OP_AND = 0x20,
+    OP_OR = 0x21,
+    OP_NOT = 0x22,
+    OP_ADD = 0x30,
+    OP_SUB = 0x31
+};
+
+static uint16_t read_u16(const uint8_t *bytes) {
+    return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+static int32_t read_i32(const uint8_t *bytes) {
+    return (int32_t)((uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) |
+                     ((uint32_t)bytes[3] << 24));
+}
+
+// Operand bytes after the opcode; -1 for an unknown opcode
+static int operand_size(uint8_t op) {
+    switch (op) {
+    case OP_CHANNEL:
+    case OP_PUSH8:
+        return 1;
+    case OP_PUSH16:
+        return 2;
+    case OP_PUSH32:
+        return 4;
+    case OP_LT: case OP_LE: case OP_GT: case OP_GE: case OP_EQ: case OP_NE:
+    case OP_AND: case OP_OR: case OP_NOT:
+    case OP_ADD: case OP_SUB:
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+// Walk the code once, tracking the stack depth; rule_eval relies on this
+static rule_result_t verify(rule_t *rule) {
+    int depth = 0;
+    rule->inputs = 0;
+    for (size_t pc = 0; pc < rule->code_len;) {
+        uint8_t op = rule->code[pc];
+        int operands = operand_size(op);
+        if (operands < 0) {
+            return RULE_ERR_OPCODE;
+        }
+        if (pc + 1 + operands > rule->code_len) {
+            return RULE_ERR_LENGTH;
+        }
+        if (op == OP_CHANNEL) {
+            uint8_t channel = rule->code[pc + 1];
+            if (channel >= RULE_CHANNELS) {
+                return RULE_ERR_CHANNEL;
+            }
+            rule->inputs |= 1u << channel;
+        }
+        if (op <= OP_PUSH32) {
+            depth++;
+        } else if (op != OP_NOT) {
+            depth--;
+        }
+        if (depth < 1 || depth > RULE_STACK_MAX) {
+            return RULE_ERR_STACK;
+        }
+        pc += 1 + operands;
+    }
+    return depth == 1 ? RULE_OK : RULE_ERR_STACK;
+}
+
+rule_result_t rule_set_load(rule_set_t *set, const uint8_t *data, size_t len) {
+    set->count = 0;
+    if (len < RULE_SET_HEADER_SIZE || data[0] != 'G' || data[1] != 'R' || data[2] != RULE_SET_VERSION) {
+        return RULE_ERR_HEADER;
+    }
+    if (data[3] > RULES_MAX) {
+        return RULE_ERR_COUNT;
+    }
+
+    size_t pos = RULE_SET_HEADER_SIZE;
+    for (uint8_t i = 0; i < data[3]; i++) {
+        if (len - pos < RULE_HEADER_SIZE) {
+            return RULE_ERR_LENGTH;
+        }
+        rule_t *rule = &set->rules[i];
+        rule->id = data[pos];
+        rule->action = data[pos + 1];
+        rule->arg = read_u16(&data[pos + 2]);
+        rule->code_len = data[pos + 4];
+        rule->code = &data[pos + RULE_HEADER_SIZE];
+        pos += RULE_HEADER_SIZE;
+        if (rule->action >= RULE_ACTIONS) {
+            return RULE_ERR_ACTION;
+        }
+        if (rule->code_len == 0 || rule->code_len > RULE_CODE_MAX || len - pos < rule->code_len) {
+            return RULE_ERR_LENGTH;
+        }
+        rule_result_t result = verify(rule);
+        if (result != RULE_OK) {
+            return result;
+        }
+        pos += rule->code_len;
+    }
+    if (pos != len) {
+        return RULE_ERR_LENGTH;
+    }
+    set->count = data[3];
+    return RULE_OK;
+}
+
+// Only verified code gets here: operands and stack bounds are not checked
+bool rule_eval(const rule_t *rule, const int32_t *channels) {
+    int32_t stack[RULE_STACK_MAX];
+    int sp = 0;
+    const uint8_t *code = rule->code;
+    for (size_t pc = 0; pc < rule->code_len;) {
+        uint8_t op = code[pc++];
+        if (op == OP_CHANNEL) {
+            stack[sp++] = channels[code[pc++]];
+            continue;
+        }
+        if (op == OP_PUSH8) {
+            stack[sp++] = (int8_t)code[pc++];
+            continue;
+        }
+        if (op == OP_PUSH16) {
+            stack[sp++] = (int16_t)read_u16(&code[pc]);
+            pc += 2;
+            continue;
+        }
+        if (op == OP_PUSH32) {
+            stack[sp++] = read_i32(&code[pc]);
+            pc += 4;
+            continue;
+        }
+        if (op == OP_NOT) {
+            stack[sp - 1] = !stack[sp - 1];
+            continue;
+        }
+        int32_t b = stack[--sp];
+        int32_t a = stack[sp - 1];
+        int32_t r;
+        switch (op) {
+        case OP_LT: r = a < b; break;
+        case OP_LE: r = a <= b; break;
+        case OP_GT: r = a > b; break;
+        case OP_GE: r = a >= b; break;
+        case OP_EQ: r = a == b; break;
+        case OP_NE: r = a != b; break;
+        case OP_AND: r = a && b; break;
+        case OP_OR: r = a || b; break;
+        case OP_ADD: r = (int32_t)((uint32_t)a + (uint32_t)b); break;
+        default: r = (int32_t)((uint32_t)a - (uint32_t)b); break;
+        }
+        stack[sp - 1] = r;
+    }
+    return stack[0] != 0;
+}
+
+const char *rule_result_name(rule_result_t result) {
+    switch (result) {
+    case RULE_OK: return "ok";
+    case RULE_ERR_HEADER: return "header";
+    case RULE_ERR_LENGTH: return "length";
+    case RULE_ERR_COUNT: return "count";
+    case RULE_ERR_ACTION: return "action";
+    case RULE_ERR_OPCODE: return "opcode";
+    case RULE_ERR_CHANNEL: return "channel";
+    case RULE_ERR_STACK: return "stack";
+    default: return "unknown";
+    }
+}
+
+const char *rule_action_name(uint8_t action) {
+    switch (action) {
+    case RULE_ACTION_ALERT: return "alert";
+    case RULE_ACTION_WATER: return "water";
+    case RULE_ACTION_PUMP_DISABLE: return "pump_disable";
+    case RULE_ACTION_PUMP_ENABLE: return "pump_enable";
+    default: return "unknown";
+    }
+}
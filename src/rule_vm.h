@@ -0,0 +1,103 @@
+#ifndef RULE_VM_H
+#define RULE_VM_H
+
+// Loader and evaluator for automation rules compiled by
+// tools/rule_compiler.py. A rule is a condition in stack bytecode plus an
+// action. Programs are checked once at load: every opcode and channel
+// known, the stack within RULE_STACK_MAX, one value left at the end. There
+// are no jumps, so evaluating a rule costs at most its code length in
+// steps. Plain C with no IDF dependency, so it also builds on a host.
+//
+// Rule set (little-endian):
+//   "GR", version, rule count,
+//   per rule: id, action, action argument (u16), code length, code
+// Opcodes:
+//   0x01 ch          push channel ch
+//   0x02 i8          push constant
+//   0x03 i16         push constant
+//   0x04 i32         push constant
+//   0x10..0x15       LT LE GT GE EQ NE: pop b, a; push a op b (0 or 1)
+//   0x20 0x21        AND OR: pop b, a; push logical result
+//   0x22             NOT
+//   0x30 0x31        ADD SUB (wrapping)
+// The condition holds when the value left is non-zero.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RULE_SET_VERSION 1
+#define RULE_SET_HEADER_SIZE 4
+#define RULE_HEADER_SIZE 5
+
+#define RULES_MAX 16
+#define RULE_CODE_MAX 48
+#define RULE_STACK_MAX 8
+
+// Largest valid rule set
+#define RULE_SET_MAX (RULE_SET_HEADER_SIZE + RULES_MAX * (RULE_HEADER_SIZE + RULE_CODE_MAX))
+
+// Inputs, in the units the firmware keeps them in
+typedef enum {
+    RULE_CH_TEMP = 0,           // centi-degrees C
+    RULE_CH_HUMIDITY,           // centi-percent
+    RULE_CH_SOIL,               // percent, compensated
+    RULE_CH_SOIL_RAW,           // ADC counts
+    RULE_CH_TIME,               // minutes since local midnight
+    RULE_CH_PUMP_ENABLED,       // 0 or 1
+    RULE_CH_FAULT,              // 1 while a safety fault is latched
+    RULE_CHANNELS
+} rule_channel_t;
+
+typedef enum {
+    RULE_ACTION_ALERT = 0,      // event only
+    RULE_ACTION_WATER,          // argument: mL
+    RULE_ACTION_PUMP_DISABLE,   // argument: minutes, 0 until PUMP_ENABLE
+    RULE_ACTION_PUMP_ENABLE,
+    RULE_ACTIONS
+} rule_action_t;
+
+typedef enum {
+    RULE_OK = 0,
+    RULE_ERR_HEADER,
+    RULE_ERR_LENGTH,            // truncated, or bytes after the last rule
+    RULE_ERR_COUNT,
+    RULE_ERR_ACTION,
+    RULE_ERR_OPCODE,
+    RULE_ERR_CHANNEL,
+    RULE_ERR_STACK              // overflow, underflow or not one result
+} rule_result_t;
+
+typedef struct {
+    uint8_t id;
+    uint8_t action;
+    uint16_t arg;
+    uint16_t inputs;            // bit per channel the condition reads
+    uint8_t code_len;
+    const uint8_t *code;        // points into the loaded rule set
+} rule_t;
+
+typedef struct {
+    rule_t rules[RULES_MAX];
+    uint8_t count;
+} rule_set_t;
+
+// Check a rule set and index its rules. The rules point into data, which
+// must stay in place while the set is used.
+rule_result_t rule_set_load(rule_set_t *set, const uint8_t *data, size_t len);
+
+// Evaluate a loaded rule's condition against the channel values
+bool rule_eval(const rule_t *rule, const int32_t *channels);
+
+const char *rule_result_name(rule_result_t result);
+const char *rule_action_name(uint8_t action);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,221 @@
+#include "rules.h"
+#include "connectToWifi.h"
+#include "controller.h"
+#include "logger.h"
+#include "outbox.h"
+#include "timer_wheel.h"
+#include <Preferences.h>
+#include <esp_timer.h>
+#include <time.h>
+
+// Rule set as received; the loaded rules point into it
+static uint8_t ruleData[RULE_SET_MAX];
+static size_t ruleDataLen = 0;
+static rule_set_t ruleSet;
+
+// Last condition of each rule; actions fire on false -> true
+static bool ruleState[RULES_MAX];
+
+// Channels of the previous sample
+static int32_t lastChannels[RULE_CHANNELS];
+static uint16_t lastValid = 0;
+static bool runAll = true;
+
+static RulesStats stats;
+static TimerId pumpHoldTimer = TIMER_NONE;
+
+static void publishRules(const char* state, const char* reason) {
+    char event[96];
+    if (reason != NULL) {
+        snprintf(event, sizeof(event), "{\"event\":\"rules\",\"state\":\"%s\",\"reason\":\"%s\"}", state, reason);
+    } else {
+        snprintf(event, sizeof(event), "{\"event\":\"rules\",\"state\":\"%s\",\"count\":%u}", state, ruleSet.count);
+    }
+    publishEvent(event);
+}
+
+// Index the rule set in ruleData and start with every condition false
+static rule_result_t loadRuleData() {
+    rule_result_t result = rule_set_load(&ruleSet, ruleData, ruleDataLen);
+    if (result != RULE_OK) {
+        ruleDataLen = 0;
+    }
+    memset(ruleState, 0, sizeof(ruleState));
+    runAll = true;
+    return result;
+}
+
+static void onPumpHoldEnd() {
+    LOG_INFO("Rule pump hold over, pump service ENABLED");
+    pumpServiceEnabled = true;
+    publishEvent("{\"event\":\"pump_enabled\",\"source\":\"rule\"}");
+}
+
+static bool runAction(const rule_t& rule) {
+    switch (rule.action) {
+    case RULE_ACTION_WATER:
+        return rulePump(rule.arg);
+    case RULE_ACTION_PUMP_DISABLE:
+        pumpServiceEnabled = false;
+        stopPump();
+        timerStop(pumpHoldTimer);
+        if (rule.arg > 0) {
+            uint32_t minutes = rule.arg < RULES_DISABLE_MAX_MIN ? rule.arg : RULES_DISABLE_MAX_MIN;
+            timerStart(pumpHoldTimer, minutes * 60000);
+        }
+        return true;
+    case RULE_ACTION_PUMP_ENABLE:
+        timerStop(pumpHoldTimer);
+        pumpServiceEnabled = true;
+        return true;
+    default:
+        return true;
+    }
+}
+
+static void fireRule(const rule_t& rule) {
+    bool done = runAction(rule);
+    stats.fired++;
+    LOG_INFO("Rule %u fired: %s %u%s", rule.id, rule_action_name(rule.action), rule.arg, done ? "" : " (refused)");
+
+    char event[112];
+    snprintf(event, sizeof(event), "{\"event\":\"rule\",\"id\":%u,\"action\":\"%s\",\"arg\":%u,\"done\":%s}",
+             rule.id, rule_action_name(rule.action), rule.arg, done ? "true" : "false");
+    publishEvent(event);
+}
+
+// Minutes since local midnight; false until SNTP has set the clock
+static bool localMinutes(int32_t* minutes) {
+    time_t now = time(NULL);
+    struct tm local;
+    localtime_r(&now, &local);
+    if (local.tm_year < 2020 - 1900) {
+        return false;
+    }
+    *minutes = local.tm_hour * 60 + local.tm_min;
+    return true;
+}
+
+void initRules() {
+    pumpHoldTimer = timerCreate("rule_pump_hold", onPumpHoldEnd);
+
+    // Starts syncing once WiFi is up
+    configTzTime(RULES_TIME_ZONE, RULES_NTP_SERVER);
+
+    Preferences prefs;
+    prefs.begin(RULES_NAMESPACE, true);
+    ruleDataLen = prefs.getBytes("set", ruleData, sizeof(ruleData));
+    prefs.end();
+    if (ruleDataLen == 0) {
+        LOG_INFO("No automation rules stored");
+        return;
+    }
+    rule_result_t result = loadRuleData();
+    if (result != RULE_OK) {
+        LOG_ERROR("Stored rule set rejected: %s", rule_result_name(result));
+        return;
+    }
+    LOG_INFO("%u automation rules loaded", ruleSet.count);
+}
+
+void rulesOnConnected() {
+    if (!mqttClient.subscribe(mqttTopicRules, 1)) {
+        LOG_ERROR("FAILED to subscribe to rules topic!");
+    }
+}
+
+void rulesHandleMessage(const uint8_t* payload, unsigned int length) {
+    Preferences prefs;
+    if (length == 0) {
+        ruleDataLen = 0;
+        loadRuleData();
+        timerStop(pumpHoldTimer);
+        prefs.begin(RULES_NAMESPACE, false);
+        prefs.remove("set");
+        prefs.end();
+        LOG_INFO("Automation rules cleared");
+        publishRules("cleared", NULL);
+        return;
+    }
+
+    // Checked before it replaces the running set
+    rule_set_t incoming;
+    rule_result_t result = length <= sizeof(ruleData) ? rule_set_load(&incoming, payload, length) : RULE_ERR_LENGTH;
+    if (result != RULE_OK) {
+        LOG_WARN("Rule set rejected: %s", rule_result_name(result));
+        publishRules("rejected", rule_result_name(result));
+        return;
+    }
+
+    memcpy(ruleData, payload, length);
+    ruleDataLen = length;
+    loadRuleData();
+    timerStop(pumpHoldTimer);
+
+    prefs.begin(RULES_NAMESPACE, false);
+    bool stored = prefs.putBytes("set", ruleData, ruleDataLen) == ruleDataLen;
+    prefs.end();
+    if (!stored) {
+        LOG_ERROR("Rule set not stored, active until restart");
+    }
+    LOG_INFO("%u automation rules loaded (%u bytes)", ruleSet.count, length);
+    publishRules(stored ? "loaded" : "not_stored", NULL);
+}
+
+void rulesEvaluate(int32_t* channels, uint16_t valid) {
+    if (localMinutes(&channels[RULE_CH_TIME])) {
+        valid |= 1u << RULE_CH_TIME;
+    }
+
+    // Channels whose value or validity moved since the last sample
+    uint16_t changed = valid ^ lastValid;
+    for (uint8_t ch = 0; ch < RULE_CHANNELS; ch++) {
+        if ((valid & (1u << ch)) && channels[ch] != lastChannels[ch]) {
+            changed |= 1u << ch;
+        }
+    }
+    memcpy(lastChannels, channels, sizeof(lastChannels));
+    lastValid = valid;
+    if (ruleSet.count == 0) {
+        return;
+    }
+    stats.samples++;
+
+    int64_t startUs = esp_timer_get_time();
+    for (uint8_t i = 0; i < ruleSet.count; i++) {
+        const rule_t& rule = ruleSet.rules[i];
+        if (!runAll && (rule.inputs & changed) == 0) {
+            stats.skipped++;
+            continue;
+        }
+        // A rule on a missing reading is false until the reading is back
+        bool holds = false;
+        if ((rule.inputs & valid) == rule.inputs) {
+            holds = rule_eval(&rule, channels);
+            stats.runs++;
+        } else {
+            stats.skipped++;
+        }
+        if (holds && !ruleState[i]) {
+            fireRule(rule);
+        }
+        ruleState[i] = holds;
+    }
+    runAll = false;
+
+    // Actions publish and may start the pump; they are part of the cost
+    uint32_t elapsedUs = (uint32_t)(esp_timer_get_time() - startUs);
+    if (elapsedUs > stats.evalMaxUs) {
+        stats.evalMaxUs = elapsedUs;
+    }
+}
+
+void rulesCancelPumpHold() {
+    timerStop(pumpHoldTimer);
+}
+
+void rulesTakeStats(RulesStats* out) {
+    stats.count = ruleSet.count;
+    *out = stats;
+    memset(&stats, 0, sizeof(stats));
+}
@@ -0,0 +1,55 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <Arduino.h>
+#include "rule_vm.h"
+
+// On-device automation rules ("if humidity > 80 and temp < 18 then disable
+// pump for 2 h", "at 07:00 if soil < 40 then water 50 ml"). Rule sets are
+// compiled on the host by tools/rule_compiler.py (format in rule_vm.h),
+// arrive on growbox/<id>/rules and are kept in NVS. Each sample is checked
+// against them; a rule only runs when one of the channels it reads has
+// changed, and fires its action when its condition becomes true.
+
+#define RULES_NAMESPACE "rules"
+
+// Local time for RULE_CH_TIME, POSIX TZ format; the clock comes from SNTP
+#ifndef RULES_TIME_ZONE
+#define RULES_TIME_ZONE "UTC0"
+#endif
+#define RULES_NTP_SERVER "pool.ntp.org"
+
+// Longest pump hold a rule may ask for (the timer wheel spans 46 h)
+#define RULES_DISABLE_MAX_MIN 1440
+
+// Counters since the last rulesTakeStats()
+struct RulesStats {
+    uint8_t count;
+    uint32_t samples;
+    uint32_t runs;              // conditions evaluated
+    uint32_t skipped;           // inputs unchanged or not valid
+    uint32_t fired;
+    uint32_t evalMaxUs;         // slowest pass over all rules
+};
+
+// Load the stored rule set and start the clock. Call after initTimers().
+void initRules();
+
+// On every MQTT connection: subscribe to the rules topic
+void rulesOnConnected();
+
+// A message on growbox/<id>/rules: a compiled rule set, or empty to clear
+void rulesHandleMessage(const uint8_t* payload, unsigned int length);
+
+// Check a new sample. channels[RULE_CHANNELS] in rule_vm.h units, bit n
+// of valid set when channel n holds a reading; the time channel is filled
+// in here.
+void rulesEvaluate(int32_t* channels, uint16_t valid);
+
+// PUMP_ENABLE / PUMP_DISABLE by hand: drop a rule's pending re-enable
+void rulesCancelPumpHold();
+
+// Copy the counters and start a new window
+void rulesTakeStats(RulesStats* stats);
+
+#endif
@@ -0,0 +1,274 @@
+#include "safety.h"
+#include "connectToWifi.h"
+#include "display_scheduler.h"
+#include "logger.h"
+#include "outbox.h"
+#include "soil_calibration.h"
+#include <Preferences.h>
+
+// Sliding window of samples with running sums: push, mean and variance
+// are O(1)
+struct RollingWindow {
+    int32_t values[SAFETY_WINDOW];
+    uint8_t next;
+    uint8_t count;
+    int64_t sum;
+    int64_t sumSquares;
+};
+
+static void windowPush(RollingWindow& w, int32_t value) {
+    if (w.count == SAFETY_WINDOW) {
+        int32_t old = w.values[w.next];
+        w.sum -= old;
+        w.sumSquares -= (int64_t)old * old;
+    } else {
+        w.count++;
+    }
+    w.values[w.next] = value;
+    w.next = (w.next + 1) % SAFETY_WINDOW;
+    w.sum += value;
+    w.sumSquares += (int64_t)value * value;
+}
+
+static void windowReset(RollingWindow& w) {
+    w.next = 0;
+    w.count = 0;
+    w.sum = 0;
+    w.sumSquares = 0;
+}
+
+static int32_t windowMean(const RollingWindow& w) {
+    return w.count ? (int32_t)(w.sum / w.count) : 0;
+}
+
+// n^2 * variance, exact in integers
+static int64_t windowScaledVariance(const RollingWindow& w) {
+    return w.count * w.sumSquares - w.sum * w.sum;
+}
+
+// Runtime summed over a sliding period, kept in buckets: adding and
+// expiring are O(1) per elapsed bucket
+template <uint8_t BUCKETS>
+struct RuntimeWindow {
+    uint32_t bucketMs;
+    uint32_t buckets[BUCKETS];
+    uint8_t current;
+    uint32_t total;
+    unsigned long bucketStart;
+
+    void advance(unsigned long now) {
+        uint8_t steps = 0;
+        while (now - bucketStart >= bucketMs && steps < BUCKETS) {
+            current = (current + 1) % BUCKETS;
+            total -= buckets[current];
+            buckets[current] = 0;
+            bucketStart += bucketMs;
+            steps++;
+        }
+        if (now - bucketStart >= bucketMs) {
+            // Idle for longer than the whole period
+            bucketStart = now;
+        }
+    }
+
+    void add(uint32_t ms) {
+        buckets[current] += ms;
+        total += ms;
+    }
+};
+
+static RuntimeWindow<12> hourRuntime = {5UL * 60 * 1000};
+static RuntimeWindow<24> dayRuntime = {60UL * 60 * 1000};
+
+// Soil checks per zone: consecutive failing samples per check, and the
+// response check for the zone's last automatic run
+struct SoilChecks {
+    RollingWindow window;
+    uint8_t rangeStrikes;
+    uint8_t slewStrikes;
+    bool responsePending;
+    unsigned long responseDue;
+    int responseBaseline;
+    uint8_t dryRuns;
+};
+
+static SoilChecks soilChecks[SOIL_ZONE_COUNT];
+static int32_t lastTempCenti = 0;
+static bool haveTemp = false;
+static uint8_t tempStrikes = 0;
+
+static SafetyFault latchedFault = SAFETY_OK;
+
+const char* safetyFaultName(SafetyFault fault) {
+    switch (fault) {
+        case SAFETY_OK:               return "none";
+        case SAFETY_SOIL_RANGE:       return "soil_range";
+        case SAFETY_SOIL_SLEW:        return "soil_slew";
+        case SAFETY_SOIL_STUCK:       return "soil_stuck";
+        case SAFETY_PUMP_NO_RESPONSE: return "pump_no_response";
+        case SAFETY_PUMP_RUNTIME_CAP: return "pump_runtime_cap";
+        default:                      return "unknown";
+    }
+}
+
+// zone < 0 for alarms that are not about one soil zone
+static void publishAlarm(const char* name, bool latched, int value, int zone = -1) {
+    char alarm[128];
+    int len = snprintf(alarm, sizeof(alarm), "{\"event\":\"alarm\",\"alarm\":\"%s\",\"latched\":%s,\"value\":%d",
+                       name, latched ? "true" : "false", value);
+    if (zone >= 0) {
+        len += snprintf(alarm + len, sizeof(alarm) - len, ",\"zone\":%d", zone);
+    }
+    snprintf(alarm + len, sizeof(alarm) - len, "}");
+    publishEvent(alarm);
+    displayWake();
+}
+
+static void latchFault(SafetyFault fault, int value, int zone = -1) {
+    if (latchedFault != SAFETY_OK) {
+        return;
+    }
+    latchedFault = fault;
+
+    // Survives a reset, so a watchdog reboot does not re-enable the pump
+    Preferences prefs;
+    prefs.begin("safety", false);
+    prefs.putUChar("fault", fault);
+    prefs.end();
+
+    LOG_ERROR("Safety fault %s (%d, zone %d), automatic watering blocked", safetyFaultName(fault), value, zone);
+    publishAlarm(safetyFaultName(fault), true, value, zone);
+}
+
+void initSafety() {
+    Preferences prefs;
+    prefs.begin("safety", true);
+    latchedFault = (SafetyFault)prefs.getUChar("fault", SAFETY_OK);
+    prefs.end();
+
+    hourRuntime.bucketStart = millis();
+    dayRuntime.bucketStart = millis();
+    if (latchedFault != SAFETY_OK) {
+        LOG_ERROR("Safety fault %s still latched, automatic watering blocked", safetyFaultName(latchedFault));
+    }
+}
+
+bool safetyCheckTemperature(int32_t tempCenti, bool readOk) {
+    if (!readOk) {
+        haveTemp = false;
+        tempStrikes = 0;
+        return false;
+    }
+
+    bool plausible = tempCenti >= SAFETY_TEMP_MIN_CENTI && tempCenti <= SAFETY_TEMP_MAX_CENTI &&
+                     (!haveTemp || abs(tempCenti - lastTempCenti) <= SAFETY_TEMP_MAX_STEP_CENTI);
+    if (plausible) {
+        lastTempCenti = tempCenti;
+        haveTemp = true;
+        tempStrikes = 0;
+        return true;
+    }
+
+    // A real change of that size shows up again in the next samples; keep
+    // comparing against the last good value until it is confirmed
+    if (++tempStrikes == SAFETY_CONFIRM_SAMPLES) {
+        LOG_WARN("SHT31 temperature implausible: %ld", (long)tempCenti);
+        publishAlarm("temp_implausible", false, tempCenti);
+        haveTemp = false;
+    }
+    return false;
+}
+
+bool safetySoilInRange(int raw) {
+    return raw >= SAFETY_SOIL_RAW_MIN && raw <= SAFETY_SOIL_RAW_MAX;
+}
+
+void safetyCheckSoil(uint8_t zone, int raw) {
+    if (zone >= SOIL_ZONE_COUNT) {
+        return;
+    }
+    SoilChecks& c = soilChecks[zone];
+    c.rangeStrikes = safetySoilInRange(raw) ? 0 : c.rangeStrikes + 1;
+    if (c.rangeStrikes >= SAFETY_CONFIRM_SAMPLES) {
+        latchFault(SAFETY_SOIL_RANGE, raw, zone);
+    }
+
+    // Drying is slow; a jump towards "dry" is the probe coming loose
+    bool slew = c.window.count > 0 && raw - windowMean(c.window) > SAFETY_SOIL_MAX_RISE;
+    c.slewStrikes = slew ? c.slewStrikes + 1 : 0;
+    if (c.slewStrikes >= SAFETY_CONFIRM_SAMPLES) {
+        latchFault(SAFETY_SOIL_SLEW, raw, zone);
+    }
+
+    windowPush(c.window, raw);
+    const int64_t n = SAFETY_WINDOW;
+    if (c.window.count == SAFETY_WINDOW &&
+        windowScaledVariance(c.window) < (int64_t)(SAFETY_SOIL_STUCK_VARIANCE * n * n)) {
+        latchFault(SAFETY_SOIL_STUCK, raw, zone);
+    }
+
+    if (c.responsePending && (long)(millis() - c.responseDue) >= 0) {
+        c.responsePending = false;
+        int response = c.responseBaseline - raw;
+        if (response >= SAFETY_PUMP_MIN_RESPONSE) {
+            c.dryRuns = 0;
+        } else if (++c.dryRuns >= SAFETY_PUMP_MAX_DRY_RUNS) {
+            latchFault(SAFETY_PUMP_NO_RESPONSE, response, zone);
+        } else {
+            LOG_WARN("Zone %u: no moisture rise after watering (%d counts), %u in a row", zone, response, c.dryRuns);
+        }
+    }
+}
+
+bool safetyPumpAllowed(uint32_t durationMs) {
+    unsigned long now = millis();
+    hourRuntime.advance(now);
+    dayRuntime.advance(now);
+
+    if (hourRuntime.total + durationMs > SAFETY_PUMP_MAX_MS_PER_HOUR ||
+        dayRuntime.total + durationMs > SAFETY_PUMP_MAX_MS_PER_DAY) {
+        latchFault(SAFETY_PUMP_RUNTIME_CAP, dayRuntime.total / 1000);
+        return false;
+    }
+    return true;
+}
+
+void safetyRecordPump(uint8_t zone, uint32_t durationMs, int rawBefore, bool automatic) {
+    hourRuntime.add(durationMs);
+    dayRuntime.add(durationMs);
+
+    if (automatic && zone < SOIL_ZONE_COUNT) {
+        SoilChecks& c = soilChecks[zone];
+        c.responsePending = true;
+        c.responseDue = millis() + SAFETY_PUMP_SETTLE_MS;
+        c.responseBaseline = rawBefore;
+    }
+}
+
+bool safetyFaultLatched() {
+    return latchedFault != SAFETY_OK;
+}
+
+SafetyFault safetyFault() {
+    return latchedFault;
+}
+
+void safetyClearFault() {
+    latchedFault = SAFETY_OK;
+    for (uint8_t zone = 0; zone < SOIL_ZONE_COUNT; zone++) {
+        SoilChecks& c = soilChecks[zone];
+        c.rangeStrikes = 0;
+        c.slewStrikes = 0;
+        c.dryRuns = 0;
+        c.responsePending = false;
+        windowReset(c.window);
+    }
+
+    Preferences prefs;
+    prefs.begin("safety", false);
+    prefs.remove("fault");
+    prefs.end();
+
+    LOG_INFO("Safety fault cleared");
+    publishEvent("{\"event\":\"alarm_cleared\"}");
+}
@@ -0,0 +1,78 @@
+#ifndef SAFETY_H
+#define SAFETY_H
+
+#include <Arduino.h>
+
+// Samples in the rolling windows (5 s apart: 5 minutes)
+#define SAFETY_WINDOW 60
+
+// Consecutive failing samples before an anomaly is confirmed
+#define SAFETY_CONFIRM_SAMPLES 3
+
+// Soil raw readings outside this range mean an unplugged or shorted probe
+// (a probe in soil, however dry, stays below the open-input reading)
+#define SAFETY_SOIL_RAW_MIN 100
+#define SAFETY_SOIL_RAW_MAX 4090
+
+// Raw rise above the window mean that drying soil cannot produce
+#define SAFETY_SOIL_MAX_RISE 300
+
+// A full window whose variance is below this (counts^2) is a stuck reading
+#define SAFETY_SOIL_STUCK_VARIANCE 0.25
+
+// Air temperature limits and plausible change (centi-degrees)
+#define SAFETY_TEMP_MIN_CENTI -1000
+#define SAFETY_TEMP_MAX_CENTI 6000
+#define SAFETY_TEMP_MAX_STEP_CENTI 500
+
+// Automatic runs in a row that must move the reading before the pump is
+// considered to be watering nothing (empty tank, probe out of the pot)
+#define SAFETY_PUMP_SETTLE_MS 60000
+#define SAFETY_PUMP_MIN_RESPONSE 30
+#define SAFETY_PUMP_MAX_DRY_RUNS 3
+
+// Pump runtime caps over a sliding hour and day
+#define SAFETY_PUMP_MAX_MS_PER_HOUR 30000
+#define SAFETY_PUMP_MAX_MS_PER_DAY 180000
+
+enum SafetyFault {
+    SAFETY_OK = 0,
+    SAFETY_SOIL_RANGE,
+    SAFETY_SOIL_SLEW,
+    SAFETY_SOIL_STUCK,
+    SAFETY_PUMP_NO_RESPONSE,
+    SAFETY_PUMP_RUNTIME_CAP
+};
+
+// Restore a latched fault from NVS
+void initSafety();
+
+// Check an SHT31 sample; false while it is missing or implausible, so the
+// temperature is not used for compensation. Never blocks watering.
+bool safetyCheckTemperature(int32_t tempCenti, bool readOk);
+
+// Quick range check for readings taken outside the sample cycle
+bool safetySoilInRange(int raw);
+
+// Check a zone's soil raw sample and the response to the zone's last
+// automatic run; confirmed anomalies latch a fault and publish an alarm.
+// The latch is shared: a fault in any zone blocks automatic watering in
+// all of them.
+void safetyCheckSoil(uint8_t zone, int raw);
+
+// Whether a run of this length fits under the runtime caps, which count
+// all pumps together. A refused run latches SAFETY_PUMP_RUNTIME_CAP.
+bool safetyPumpAllowed(uint32_t durationMs);
+
+// Count a finished run of the zone's pump against the caps; automatic runs
+// are also checked for a moisture response in the zone
+void safetyRecordPump(uint8_t zone, uint32_t durationMs, int rawBefore, bool automatic);
+
+// A latched fault blocks automatic watering until FAULT_CLEAR
+bool safetyFaultLatched();
+SafetyFault safetyFault();
+const char* safetyFaultName(SafetyFault fault);
+
+void safetyClearFault();
+
+#endif
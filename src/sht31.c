@@ -0,0 +1,83 @@
+#include "sht31.h"
+#include "i2c_bus.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define SHT31_CMD_MEASURE_HIGH 0x2400   // high repeatability, no clock stretching
+#define SHT31_CMD_SOFT_RESET 0x30A2
+#define SHT31_CMD_READ_STATUS 0xF32D
+
+// Conversion time for high repeatability is 15 ms at most
+#define SHT31_MEASURE_MS 16
+
+static i2c_bus_device_t sht31_device;
+static bool sht31_registered = false;
+
+static esp_err_t sht31_command(uint16_t cmd) {
+    const uint8_t bytes[2] = {cmd >> 8, cmd & 0xFF};
+    return i2c_bus_write(sht31_device, bytes, sizeof(bytes));
+}
+
+// CRC-8, polynomial 0x31, init 0xFF, over each 16-bit word
+static uint8_t sht31_crc(const uint8_t *data) {
+    uint8_t crc = 0xFF;
+    for (uint8_t i = 0; i < 2; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = crc & 0x80 ? (crc << 1) ^ 0x31 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+esp_err_t sht31_init() {
+    if (!sht31_registered) {
+        const i2c_bus_device_config_t config = {"sht31", SHT31_ADDRESS, SHT31_CLOCK_HZ, I2C_BUS_PRIO_HIGH};
+        esp_err_t ret = i2c_bus_add_device(&config, &sht31_device);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        sht31_registered = true;
+    }
+
+    esp_err_t ret = sht31_command(SHT31_CMD_SOFT_RESET);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    vTaskDelay(pdMS_TO_TICKS(2));
+
+    uint8_t status[3];
+    ret = sht31_command(SHT31_CMD_READ_STATUS);
+    if (ret == ESP_OK) {
+        ret = i2c_bus_read(sht31_device, status, sizeof(status));
+    }
+    if (ret == ESP_OK && sht31_crc(status) != status[2]) {
+        ret = ESP_ERR_INVALID_CRC;
+    }
+    return ret;
+}
+
+esp_err_t sht31_read(int32_t *temp_centi, int32_t *humidity_centi) {
+    uint8_t reply[6];
+
+    // The bus is free for display traffic while the sensor converts
+    esp_err_t ret = sht31_command(SHT31_CMD_MEASURE_HIGH);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    vTaskDelay(pdMS_TO_TICKS(SHT31_MEASURE_MS));
+    ret = i2c_bus_read(sht31_device, reply, sizeof(reply));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (sht31_crc(&reply[0]) != reply[2] || sht31_crc(&reply[3]) != reply[5]) {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    // T = -45 + 175 * ticks / 65535, RH = 100 * ticks / 65535, rounded
+    int32_t temp_ticks = (reply[0] << 8) | reply[1];
+    int32_t humidity_ticks = (reply[3] << 8) | reply[4];
+    *temp_centi = -4500 + (17500 * temp_ticks + 32767) / 65535;
+    *humidity_centi = (10000 * humidity_ticks + 32767) / 65535;
+    return ESP_OK;
+}
@@ -0,0 +1,29 @@
+#ifndef SHT31_H
+#define SHT31_H
+
+// SHT31 temperature/humidity sensor on the shared I2C bus. Results are
+// converted straight from the sensor ticks to centi-units, without float.
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SHT31_ADDRESS 0x44
+
+// The SHT31 is a fast-mode plus part
+#define SHT31_CLOCK_HZ 1000000
+
+// Register the sensor with the bus (once), soft-reset it and check it answers
+esp_err_t sht31_init();
+
+// One high-repeatability measurement; ESP_ERR_INVALID_CRC on a corrupted reply
+esp_err_t sht31_read(int32_t *temp_centi, int32_t *humidity_centi);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,398 @@
+#include "soil_calibration.h"
+#include "board.h"
+#include "connectToWifi.h"
+#include "logger.h"
+#include "outbox.h"
+#include <Preferences.h>
+
+#define SOIL_CAL_NAMESPACE "soilcal"
+#define SOIL_CAL_VERSION 1
+
+static_assert(Board::SoilSensors::count == SOIL_ZONE_COUNT, "SOIL_ZONE_COUNT does not match the board");
+
+// Stored per zone under "z<zone>"; the table itself under "z<zone>lut"
+struct SoilCalRecord {
+    uint8_t version;
+    uint8_t pin;            // a record for another pin is ignored
+    uint8_t count;
+    SoilCalPoint points[SOIL_CAL_MAX_POINTS];   // sorted by raw
+};
+
+// Temperature compensation, under "z<zone>tc"
+struct SoilTempRecord {
+    uint8_t version;
+    int16_t slopeQ8;
+    int16_t refCenti;
+};
+
+struct SoilZone {
+    int pin;
+    bool calibrated;
+    int16_t tempSlopeQ8;
+    int16_t tempRefCenti;
+    uint8_t pointCount;
+    SoilCalPoint points[SOIL_CAL_MAX_POINTS];
+};
+
+static SoilZone zones[SOIL_ZONE_COUNT];
+static uint8_t zoneCount = 0;
+
+static int32_t currentTempCenti = 0;
+static bool currentTempValid = false;
+
+// Raw reading -> percent, one byte per ADC level
+static uint8_t zoneLut[SOIL_ZONE_COUNT][SOIL_ADC_LEVELS];
+
+// Capture in progress
+static struct {
+    bool active;
+    uint8_t zone;
+    uint8_t count;
+    SoilCalPoint points[SOIL_CAL_MAX_POINTS];
+} session;
+
+static void zoneKey(char* key, uint8_t zone, const char* suffix) {
+    snprintf(key, 16, "z%u%s", zone, suffix);
+}
+
+// Piecewise linear through the points, flat beyond the end points
+static void buildLut(uint8_t* lut, const SoilCalPoint* points, uint8_t count) {
+    uint8_t segment = 0;
+    for (int raw = 0; raw < SOIL_ADC_LEVELS; raw++) {
+        if (raw <= points[0].raw) {
+            lut[raw] = points[0].percent;
+        } else if (raw >= points[count - 1].raw) {
+            lut[raw] = points[count - 1].percent;
+        } else {
+            while (raw > points[segment + 1].raw) {
+                segment++;
+            }
+            const SoilCalPoint& a = points[segment];
+            const SoilCalPoint& b = points[segment + 1];
+            int32_t span = b.raw - a.raw;
+            int32_t delta = (int32_t)(b.percent - a.percent) * (raw - a.raw);
+            lut[raw] = a.percent + (delta + (delta >= 0 ? span / 2 : -span / 2)) / span;
+        }
+    }
+}
+
+static void setDefaultCalibration(uint8_t zone) {
+    SoilZone& z = zones[zone];
+    z.calibrated = false;
+    z.pointCount = 2;
+    z.points[0] = {SOIL_DEFAULT_WATER_RAW, 100};
+    z.points[1] = {SOIL_DEFAULT_AIR_RAW, 0};
+    buildLut(zoneLut[zone], z.points, z.pointCount);
+}
+
+static bool loadCalibration(Preferences& prefs, uint8_t zone) {
+    SoilZone& z = zones[zone];
+    char key[16];
+    SoilCalRecord record;
+
+    zoneKey(key, zone, "");
+    if (prefs.getBytes(key, &record, sizeof(record)) != sizeof(record) ||
+        record.version != SOIL_CAL_VERSION || record.pin != z.pin ||
+        record.count < 2 || record.count > SOIL_CAL_MAX_POINTS) {
+        return false;
+    }
+    z.calibrated = true;
+    z.pointCount = record.count;
+    memcpy(z.points, record.points, sizeof(z.points));
+
+    // The table is normally read back as is; rebuild it if it is missing
+    zoneKey(key, zone, "lut");
+    if (prefs.getBytes(key, zoneLut[zone], SOIL_ADC_LEVELS) != SOIL_ADC_LEVELS) {
+        buildLut(zoneLut[zone], z.points, z.pointCount);
+        prefs.putBytes(key, zoneLut[zone], SOIL_ADC_LEVELS);
+    }
+    return true;
+}
+
+static void loadTempCompensation(Preferences& prefs, uint8_t zone) {
+    SoilZone& z = zones[zone];
+    char key[16];
+    SoilTempRecord record;
+
+    zoneKey(key, zone, "tc");
+    if (prefs.getBytes(key, &record, sizeof(record)) == sizeof(record) && record.version == SOIL_CAL_VERSION) {
+        z.tempSlopeQ8 = record.slopeQ8;
+        z.tempRefCenti = record.refCenti;
+    } else {
+        z.tempSlopeQ8 = 0;
+        z.tempRefCenti = 0;
+    }
+}
+
+void initSoilCalibration() {
+    Preferences prefs;
+    prefs.begin(SOIL_CAL_NAMESPACE, false);
+
+    Board::SoilSensors::init();
+    zoneCount = SOIL_ZONE_COUNT;
+    for (uint8_t zone = 0; zone < zoneCount; zone++) {
+        zones[zone].pin = Board::SoilSensors::pin(zone);
+        loadTempCompensation(prefs, zone);
+        if (loadCalibration(prefs, zone)) {
+            LOG_INFO("Soil zone %u: %u-point calibration", zone, zones[zone].pointCount);
+        } else {
+            setDefaultCalibration(zone);
+            LOG_INFO("Soil zone %u: not calibrated, using air/water defaults", zone);
+        }
+    }
+    prefs.end();
+}
+
+int soilReadRaw(uint8_t zone) {
+    return Board::SoilSensors::read(zone);
+}
+
+void soilUpdateTemperature(int32_t tempCenti, bool valid) {
+    currentTempCenti = tempCenti;
+    currentTempValid = valid;
+}
+
+int soilCompensateRaw(uint8_t zone, int raw) {
+    const SoilZone& z = zones[zone];
+    if (!currentTempValid || z.tempSlopeQ8 == 0) {
+        return raw;
+    }
+    // counts = slope / 2^shift * (t - ref) / 100, rounded
+    const int32_t unit = 100 << SOIL_TEMP_SLOPE_SHIFT;
+    int32_t scaled = (int32_t)z.tempSlopeQ8 * (currentTempCenti - z.tempRefCenti);
+    int32_t correction = (scaled + (scaled >= 0 ? unit / 2 : -unit / 2)) / unit;
+    return constrain(raw - correction, 0, SOIL_ADC_LEVELS - 1);
+}
+
+uint8_t soilPercentFromRaw(uint8_t zone, int raw) {
+    return zoneLut[zone][constrain(raw, 0, SOIL_ADC_LEVELS - 1)];
+}
+
+bool soilZoneCalibrated(uint8_t zone) {
+    return zone < zoneCount && zones[zone].calibrated;
+}
+
+static int averageRaw(uint8_t zone) {
+    uint32_t sum = 0;
+    for (int i = 0; i < SOIL_CAL_SAMPLES; i++) {
+        sum += Board::SoilSensors::read(zone);
+        delay(2);
+    }
+    // Points live in the compensated domain the table is looked up in
+    return soilCompensateRaw(zone, (sum + SOIL_CAL_SAMPLES / 2) / SOIL_CAL_SAMPLES);
+}
+
+static void publishCalibration(uint8_t zone, const char* state, uint8_t points,
+                               const char* extra, const char* requestId) {
+    char event[256];
+    int len = snprintf(event, sizeof(event),
+                       "{\"event\":\"calibration\",\"zone\":%u,\"state\":\"%s\",\"points\":%u%s",
+                       zone, state, points, extra);
+    if (requestId != NULL) {
+        len += snprintf(event + len, sizeof(event) - len, ",\"req\":\"%s\"", requestId);
+    }
+    snprintf(event + len, sizeof(event) - len, "}");
+    publishEvent(event);
+}
+
+static void publishError(uint8_t zone, const char* reason, const char* requestId) {
+    char extra[48];
+    snprintf(extra, sizeof(extra), ",\"reason\":\"%s\"", reason);
+    publishCalibration(zone, "error", session.active ? session.count : 0, extra, requestId);
+    LOG_WARN("Calibration zone %u: %s", zone, reason);
+}
+
+// Percent must move one way only as the raw reading rises
+static bool isMonotonic(const SoilCalPoint* points, uint8_t count) {
+    bool falling = points[count - 1].percent < points[0].percent;
+    if (points[count - 1].percent == points[0].percent) {
+        return false;
+    }
+    for (uint8_t i = 1; i < count; i++) {
+        if (falling ? points[i].percent > points[i - 1].percent
+                    : points[i].percent < points[i - 1].percent) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void capturePoint(int percent, const char* requestId) {
+    uint8_t zone = session.zone;
+    if (percent < 0 || percent > 100) {
+        publishError(zone, "bad_percent", requestId);
+        return;
+    }
+
+    int raw = averageRaw(zone);
+
+    // Re-capturing a percent replaces that point
+    int replace = -1;
+    for (uint8_t i = 0; i < session.count; i++) {
+        if (session.points[i].percent == percent) {
+            replace = i;
+        } else if (abs(session.points[i].raw - raw) < SOIL_CAL_MIN_RAW_GAP) {
+            publishError(zone, "too_close", requestId);
+            return;
+        }
+    }
+    if (replace >= 0) {
+        memmove(&session.points[replace], &session.points[replace + 1],
+                (session.count - replace - 1) * sizeof(SoilCalPoint));
+        session.count--;
+    } else if (session.count >= SOIL_CAL_MAX_POINTS) {
+        publishError(zone, "full", requestId);
+        return;
+    }
+
+    uint8_t at = 0;
+    while (at < session.count && session.points[at].raw < raw) {
+        at++;
+    }
+    memmove(&session.points[at + 1], &session.points[at], (session.count - at) * sizeof(SoilCalPoint));
+    session.points[at] = {(uint16_t)raw, (uint8_t)percent};
+    session.count++;
+
+    char extra[48];
+    snprintf(extra, sizeof(extra), ",\"raw\":%d,\"percent\":%d", raw, percent);
+    publishCalibration(zone, "point", session.count, extra, requestId);
+    LOG_INFO("Calibration zone %u: raw %d = %d%% (%u points)", zone, raw, percent, session.count);
+}
+
+static void saveSession(const char* requestId) {
+    uint8_t zone = session.zone;
+    if (session.count < 2) {
+        publishError(zone, "too_few_points", requestId);
+        return;
+    }
+    if (!isMonotonic(session.points, session.count)) {
+        publishError(zone, "not_monotonic", requestId);
+        return;
+    }
+
+    SoilZone& z = zones[zone];
+    z.calibrated = true;
+    z.pointCount = session.count;
+    memcpy(z.points, session.points, sizeof(z.points));
+    buildLut(zoneLut[zone], z.points, z.pointCount);
+
+    SoilCalRecord record = {SOIL_CAL_VERSION, (uint8_t)z.pin, z.pointCount, {}};
+    memcpy(record.points, z.points, sizeof(record.points));
+
+    char key[16];
+    Preferences prefs;
+    prefs.begin(SOIL_CAL_NAMESPACE, false);
+    zoneKey(key, zone, "");
+    bool stored = prefs.putBytes(key, &record, sizeof(record)) == sizeof(record);
+    zoneKey(key, zone, "lut");
+    stored = stored && prefs.putBytes(key, zoneLut[zone], SOIL_ADC_LEVELS) == SOIL_ADC_LEVELS;
+    prefs.end();
+
+    session.active = false;
+    if (!stored) {
+        // Still in effect until the next reboot
+        publishError(zone, "nvs_write", requestId);
+        return;
+    }
+    publishCalibration(zone, "saved", z.pointCount, "", requestId);
+    LOG_INFO("Calibration zone %u saved (%u points)", zone, z.pointCount);
+}
+
+static void clearCalibration(uint8_t zone, const char* requestId) {
+    char key[16];
+    Preferences prefs;
+    prefs.begin(SOIL_CAL_NAMESPACE, false);
+    zoneKey(key, zone, "");
+    prefs.remove(key);
+    zoneKey(key, zone, "lut");
+    prefs.remove(key);
+    prefs.end();
+
+    setDefaultCalibration(zone);
+    publishCalibration(zone, "cleared", 0, "", requestId);
+    LOG_INFO("Calibration zone %u cleared", zone);
+}
+
+static void setTempCompensation(uint8_t zone, const String& args, const char* requestId) {
+    long parsedZone;
+    long slope;
+    long ref;
+    if (sscanf(args.c_str(), "%ld %ld %ld", &parsedZone, &slope, &ref) != 3 ||
+        slope < INT16_MIN || slope > INT16_MAX || ref < -4000 || ref > 12500) {
+        publishError(zone, "bad_temp", requestId);
+        return;
+    }
+
+    SoilZone& z = zones[zone];
+    z.tempSlopeQ8 = slope;
+    z.tempRefCenti = ref;
+
+    char key[16];
+    Preferences prefs;
+    prefs.begin(SOIL_CAL_NAMESPACE, false);
+    zoneKey(key, zone, "tc");
+    if (slope == 0) {
+        prefs.remove(key);
+    } else {
+        SoilTempRecord record = {SOIL_CAL_VERSION, z.tempSlopeQ8, z.tempRefCenti};
+        prefs.putBytes(key, &record, sizeof(record));
+    }
+    prefs.end();
+
+    char extra[48];
+    snprintf(extra, sizeof(extra), ",\"temp_slope\":%d,\"temp_ref\":%d", z.tempSlopeQ8, z.tempRefCenti);
+    publishCalibration(zone, "temp", z.calibrated ? z.pointCount : 0, extra, requestId);
+    LOG_INFO("Calibration zone %u: temperature slope %d/256 counts/C, ref %d", zone, z.tempSlopeQ8, z.tempRefCenti);
+}
+
+static void publishZoneStatus(uint8_t zone, const char* requestId) {
+    int raw = soilReadRaw(zone);
+    int compensated = soilCompensateRaw(zone, raw);
+    char extra[128];
+    snprintf(extra, sizeof(extra),
+             ",\"calibrated\":%s,\"raw\":%d,\"raw_comp\":%d,\"percent\":%u,\"temp_slope\":%d,\"temp_ref\":%d",
+             zones[zone].calibrated ? "true" : "false", raw, compensated, soilPercentFromRaw(zone, compensated),
+             zones[zone].tempSlopeQ8, zones[zone].tempRefCenti);
+    publishCalibration(zone, "status", zones[zone].calibrated ? zones[zone].pointCount : 0, extra, requestId);
+}
+
+void handleCalibrationCommand(const String& command, const String& args, const char* requestId) {
+    if (command == "CAL_POINT" || command == "CAL_SAVE" || command == "CAL_CANCEL") {
+        if (!session.active) {
+            publishError(0, "no_session", requestId);
+        } else if (command == "CAL_POINT") {
+            capturePoint(args.length() > 0 ? args.toInt() : -1, requestId);
+        } else if (command == "CAL_SAVE") {
+            saveSession(requestId);
+        } else {
+            session.active = false;
+            publishCalibration(session.zone, "cancelled", 0, "", requestId);
+        }
+        return;
+    }
+
+    long zone = args.toInt();
+    if (zone < 0 || zone >= zoneCount) {
+        publishError(0, "bad_zone", requestId);
+        return;
+    }
+
+    if (command == "CAL_START") {
+        session.active = true;
+        session.zone = zone;
+        session.count = 0;
+        publishCalibration(zone, "started", 0, "", requestId);
+        LOG_INFO("Calibration zone %ld started", zone);
+    } else if (command == "CAL_CLEAR") {
+        if (session.active && session.zone == zone) {
+            session.active = false;
+        }
+        clearCalibration(zone, requestId);
+    } else if (command == "CAL_STATUS") {
+        publishZoneStatus(zone, requestId);
+    } else if (command == "CAL_TEMP") {
+        setTempCompensation(zone, args, requestId);
+    } else {
+        LOG_WARN("Unknown command: '%s'", command.c_str());
+    }
+}
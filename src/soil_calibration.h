@@ -0,0 +1,64 @@
+#ifndef SOIL_CALIBRATION_H
+#define SOIL_CALIBRATION_H
+
+#include <Arduino.h>
+
+// Soil zones, one capacitive sensor each, calibrated independently
+#ifndef SOIL_ZONE_COUNT
+#define SOIL_ZONE_COUNT 1
+#endif
+
+// Raw ADC range covered by the lookup table (12-bit)
+#define SOIL_ADC_LEVELS 4096
+
+// Two-point mapping used until a zone is calibrated
+#define SOIL_DEFAULT_AIR_RAW 4095
+#define SOIL_DEFAULT_WATER_RAW 2200
+
+#define SOIL_CAL_MAX_POINTS 8
+
+// ADC readings averaged into one captured point
+#define SOIL_CAL_SAMPLES 64
+
+// Points closer than this are within sensor noise of each other
+#define SOIL_CAL_MIN_RAW_GAP 16
+
+// Temperature compensation slope, ADC counts per degree C in Q8
+#define SOIL_TEMP_SLOPE_SHIFT 8
+
+struct SoilCalPoint {
+    uint16_t raw;
+    uint8_t percent;
+};
+
+// Set up the board's zone sensors and load each zone's table from NVS
+void initSoilCalibration();
+
+int soilReadRaw(uint8_t zone);
+
+// Latest air temperature for compensation; invalid turns it off
+void soilUpdateTemperature(int32_t tempCenti, bool valid);
+
+// Raw reading moved to what the sensor would read at the zone's reference
+// temperature. Coefficients are fitted by tools/soil_tempfit.py.
+int soilCompensateRaw(uint8_t zone, int raw);
+
+// Moisture percent for a raw reading: one table lookup
+uint8_t soilPercentFromRaw(uint8_t zone, int raw);
+
+bool soilZoneCalibrated(uint8_t zone);
+
+// Guided capture, driven by the CAL_* control commands:
+//   CAL_START [zone]      begin a session for a zone
+//   CAL_POINT <percent>   average the sensor and record it as <percent>
+//   CAL_SAVE              build the table and store it in NVS
+//   CAL_CANCEL            drop the session
+//   CAL_CLEAR [zone]      back to the two-point default
+//   CAL_STATUS [zone]     report the zone's calibration and current reading
+//   CAL_TEMP <zone> <slope> <ref>   temperature compensation: slope in
+//                         counts/degree C (Q8), reference temperature in
+//                         centi-degrees; slope 0 turns it off
+// Progress is published as "calibration" events on the status topic.
+void handleCalibrationCommand(const String& command, const String& args, const char* requestId);
+
+#endif
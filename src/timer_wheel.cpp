@@ -0,0 +1,265 @@
+#include "timer_wheel.h"
+#include "logger.h"
+#include <esp_timer.h>
+#include <string.h>
+
+#define TIMER_TICK_US ((int64_t)TIMER_TICK_MS * 1000)
+#define TIMER_SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_MAX_TICKS ((1UL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1)
+
+// Marks a timer that is in no slot
+#define TIMER_IDLE 0xFF
+
+struct Timer {
+    const char* name;
+    TimerCallback callback;
+    int64_t dueUs;              // exact deadline, for lateness
+    uint32_t expires;           // deadline in ticks
+    uint32_t periodMs;
+    uint8_t next;               // slot list links
+    uint8_t prev;
+    uint8_t level;
+    uint8_t slot;
+    TimerStats stats;
+};
+
+static Timer timers[TIMER_MAX];
+static uint8_t count = 0;
+
+static uint8_t slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+static uint64_t occupied[TIMER_WHEEL_LEVELS];   // non-empty slots per level
+static uint32_t currentTick = 0;
+
+static uint32_t tickAt(int64_t us) {
+    return (uint32_t)(us / TIMER_TICK_US);
+}
+
+static void link(TimerId id) {
+    Timer& t = timers[id];
+    uint32_t delta = t.expires - currentTick;
+    if (delta > TIMER_MAX_TICKS) {
+        delta = TIMER_MAX_TICKS;
+        t.expires = currentTick + delta;
+    }
+
+    uint8_t level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >> (TIMER_WHEEL_BITS * (level + 1))) {
+        level++;
+    }
+    uint8_t slot = (t.expires >> (TIMER_WHEEL_BITS * level)) & TIMER_SLOT_MASK;
+
+    t.level = level;
+    t.slot = slot;
+    t.prev = TIMER_NONE;
+    t.next = slots[level][slot];
+    if (t.next != TIMER_NONE) {
+        timers[t.next].prev = id;
+    }
+    slots[level][slot] = id;
+    occupied[level] |= 1ULL << slot;
+}
+
+static void unlink(TimerId id) {
+    Timer& t = timers[id];
+    if (t.level == TIMER_IDLE) {
+        return;
+    }
+
+    if (t.prev != TIMER_NONE) {
+        timers[t.prev].next = t.next;
+    } else {
+        slots[t.level][t.slot] = t.next;
+        if (t.next == TIMER_NONE) {
+            occupied[t.level] &= ~(1ULL << t.slot);
+        }
+    }
+    if (t.next != TIMER_NONE) {
+        timers[t.next].prev = t.prev;
+    }
+    t.level = TIMER_IDLE;
+}
+
+// The current tick's slot has been run already, so the next tick is the
+// earliest a deadline set now can expire; that becomes the deadline
+static void arm(TimerId id) {
+    Timer& t = timers[id];
+    t.expires = tickAt(t.dueUs);
+    int32_t ahead = (int32_t)(t.expires - currentTick);
+    if (ahead <= 0) {
+        t.expires = currentTick + 1;
+        t.dueUs += (int64_t)(1 - ahead) * TIMER_TICK_US;
+    }
+    link(id);
+}
+
+// Move a slot's timers one level closer to expiry
+static void cascade(uint8_t level, uint8_t slot) {
+    uint8_t id = slots[level][slot];
+    slots[level][slot] = TIMER_NONE;
+    occupied[level] &= ~(1ULL << slot);
+
+    while (id != TIMER_NONE) {
+        uint8_t next = timers[id].next;
+        link(id);
+        id = next;
+    }
+}
+
+static void expire(TimerId id) {
+    Timer& t = timers[id];
+    unlink(id);
+
+    int64_t now = esp_timer_get_time();
+    uint32_t late = now > t.dueUs ? (uint32_t)(now - t.dueUs) : 0;
+    t.stats.runs++;
+    t.stats.lateSumUs += late;
+    if (late > t.stats.lateMaxUs) {
+        t.stats.lateMaxUs = late;
+    }
+
+    // Re-arm before the callback, which may stop or restart the timer
+    if (t.periodMs != 0) {
+        int64_t periodUs = (int64_t)t.periodMs * 1000;
+        t.dueUs += periodUs;
+        if (t.dueUs <= now) {
+            uint32_t skipped = (uint32_t)((now - t.dueUs) / periodUs) + 1;
+            t.stats.missed += skipped;
+            t.dueUs += skipped * periodUs;
+        }
+        arm(id);
+    }
+
+    if (t.callback != NULL) {
+        t.callback();
+    }
+}
+
+static void advance() {
+    currentTick++;
+
+    // A level's slot is emptied downwards each time the level below wraps
+    uint8_t level = 1;
+    uint32_t tick = currentTick;
+    while (level < TIMER_WHEEL_LEVELS && (tick & TIMER_SLOT_MASK) == 0) {
+        tick >>= TIMER_WHEEL_BITS;
+        cascade(level, tick & TIMER_SLOT_MASK);
+        level++;
+    }
+
+    // Taken one at a time, callbacks may stop timers of the same slot
+    uint8_t slot = currentTick & TIMER_SLOT_MASK;
+    while (slots[0][slot] != TIMER_NONE) {
+        expire(slots[0][slot]);
+    }
+}
+
+// Slots from `index` to the next non-empty one, 1..64; 0 if none
+static uint32_t slotsToNext(uint64_t bits, uint8_t index) {
+    uint8_t shift = (index + 1) & TIMER_SLOT_MASK;
+    uint64_t rotated = shift ? (bits >> shift) | (bits << (TIMER_WHEEL_SLOTS - shift)) : bits;
+    return rotated ? __builtin_ctzll(rotated) + 1 : 0;
+}
+
+// Ticks to the earliest expiry or cascade
+static uint32_t ticksToNext() {
+    uint32_t best = TIMER_MAX_TICKS;
+    for (uint8_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        uint8_t shift = TIMER_WHEEL_BITS * level;
+        uint32_t base = currentTick >> shift;
+        uint32_t steps = slotsToNext(occupied[level], base & TIMER_SLOT_MASK);
+        if (steps == 0) {
+            continue;
+        }
+        uint32_t ticks = ((base + steps) << shift) - currentTick;
+        if (ticks < best) {
+            best = ticks;
+        }
+    }
+    return best;
+}
+
+void initTimers() {
+    memset(slots, TIMER_NONE, sizeof(slots));
+    memset(occupied, 0, sizeof(occupied));
+    currentTick = tickAt(esp_timer_get_time());
+}
+
+TimerId timerCreate(const char* name, TimerCallback callback) {
+    if (count >= TIMER_MAX) {
+        LOG_ERROR("No timer left for %s", name);
+        return TIMER_NONE;
+    }
+    Timer& t = timers[count];
+    t.name = name;
+    t.callback = callback;
+    t.periodMs = 0;
+    t.level = TIMER_IDLE;
+    memset(&t.stats, 0, sizeof(t.stats));
+    return count++;
+}
+
+void timerStart(TimerId id, uint32_t delayMs, uint32_t periodMs) {
+    if (id >= count) {
+        return;
+    }
+    Timer& t = timers[id];
+    unlink(id);
+    t.periodMs = periodMs;
+    // Deadlines sit on tick boundaries, so lateness is the loop's delay
+    // alone and not the rounding
+    int64_t due = esp_timer_get_time() + (int64_t)delayMs * 1000;
+    t.dueUs = (due + TIMER_TICK_US - 1) / TIMER_TICK_US * TIMER_TICK_US;
+    arm(id);
+}
+
+void timerStop(TimerId id) {
+    if (id < count) {
+        unlink(id);
+    }
+}
+
+bool timerActive(TimerId id) {
+    return id < count && timers[id].level != TIMER_IDLE;
+}
+
+uint32_t timerRemainingMs(TimerId id) {
+    if (!timerActive(id)) {
+        return 0;
+    }
+    int64_t remaining = timers[id].dueUs - esp_timer_get_time();
+    return remaining > 0 ? (uint32_t)((remaining + 999) / 1000) : 0;
+}
+
+uint32_t timerRun() {
+    int64_t now = esp_timer_get_time();
+    uint32_t target = tickAt(now);
+    while ((int32_t)(target - currentTick) > 0) {
+        advance();
+    }
+
+    // Wake at the start of the next due tick
+    now = esp_timer_get_time();
+    int64_t sleepUs = (int64_t)ticksToNext() * TIMER_TICK_US - now % TIMER_TICK_US;
+    if (tickAt(now) != currentTick) {
+        return 0;
+    }
+    uint32_t sleepMs = (uint32_t)((sleepUs + 999) / 1000);
+    return sleepMs < TIMER_MAX_SLEEP_MS ? sleepMs : TIMER_MAX_SLEEP_MS;
+}
+
+uint8_t timerCount() {
+    return count;
+}
+
+const char* timerName(TimerId id) {
+    return id < count ? timers[id].name : "";
+}
+
+void timerTakeStats(TimerId id, TimerStats* stats) {
+    if (id >= count) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    *stats = timers[id].stats;
+    memset(&timers[id].stats, 0, sizeof(timers[id].stats));
+}
@@ -0,0 +1,63 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <Arduino.h>
+
+// Hierarchical timer wheel: 4 levels of 64 slots. Starting, stopping and
+// expiring a timer are O(1); a timer far out moves down at most 3 levels
+// on its way to expiry. All periodic and one-shot work in loop() runs from
+// here, and loop() sleeps until the next deadline. Timers are only touched
+// from the loop task.
+
+// Wheel resolution; deadlines are rounded up to a tick, never early
+#define TIMER_TICK_MS 10
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 4
+
+#define TIMER_MAX 24
+#define TIMER_NONE 0xFF
+
+// Longest loop() sleep, so the watchdog is fed with no timer due
+#define TIMER_MAX_SLEEP_MS 1000
+
+typedef uint8_t TimerId;
+typedef void (*TimerCallback)();
+
+// Lateness since the last timerTakeStats(): time from the deadline to the
+// callback, and periods skipped because the loop was busy
+struct TimerStats {
+    uint32_t runs;
+    uint32_t missed;
+    uint32_t lateSumUs;
+    uint32_t lateMaxUs;
+};
+
+void initTimers();
+
+// Register a timer; it does not run until started. TIMER_NONE when all
+// TIMER_MAX are taken. A NULL callback makes a plain deadline, for
+// timerActive() and timerRemainingMs().
+TimerId timerCreate(const char* name, TimerCallback callback);
+
+// (Re)arm: first run after delayMs, then every periodMs (0 = one-shot).
+// Periodic deadlines follow the schedule, not the previous run, so
+// lateness does not accumulate.
+void timerStart(TimerId id, uint32_t delayMs, uint32_t periodMs = 0);
+
+void timerStop(TimerId id);
+bool timerActive(TimerId id);
+
+// Time to the next run, 0 if stopped
+uint32_t timerRemainingMs(TimerId id);
+
+// Run every callback that is due and return how long loop() may sleep
+uint32_t timerRun();
+
+uint8_t timerCount();
+const char* timerName(TimerId id);
+
+// Copy a timer's counters and start a new window
+void timerTakeStats(TimerId id, TimerStats* stats);
+
+#endif
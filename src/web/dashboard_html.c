@@ -0,0 +1,136 @@
+// Generated by tools/webembed.py from dashboard.html; do not edit
+
+#include "dashboard_html.h"
+
+const uint8_t dashboard_html_gz[] = {
+    0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x8D, 0x57,
+    0x6D, 0x6F, 0xDB, 0x36, 0x10, 0xFE, 0xEE, 0x5F, 0xC1, 0xB1, 0x6D, 0x20,
+    0xA3, 0x91, 0x6C, 0xA7, 0x59, 0x90, 0x59, 0xB6, 0x87, 0xB4, 0xC9, 0xB6,
+    0x0E, 0x5D, 0x12, 0xCC, 0x29, 0x8A, 0x61, 0x1B, 0x02, 0x4A, 0xA2, 0x2C,
+    0x22, 0x14, 0xA9, 0x91, 0x94, 0x1D, 0x77, 0xC8, 0x7F, 0xDF, 0x1D, 0xE5,
+    0x17, 0xD9, 0x4E, 0x86, 0x02, 0x81, 0x25, 0x1D, 0xEF, 0x79, 0xEE, 0x78,
+    0x6F, 0x64, 0x46, 0xDF, 0x5D, 0xDE, 0x7C, 0xB8, 0xFB, 0xE3, 0xF6, 0x8A,
+    0x14, 0xAE, 0x94, 0x93, 0xCE, 0xE8, 0xBB, 0x30, 0x24, 0x53, 0x6E, 0xE6,
+    0x3C, 0x23, 0xB3, 0xAF, 0xA2, 0xAA, 0xE0, 0x99, 0x1B, 0x5D, 0x92, 0x5C,
+    0x32, 0x5B, 0x90, 0x64, 0x49, 0x16, 0x3C, 0xB9, 0xB7, 0xA8, 0x60, 0xA2,
+    0xB4, 0xAA, 0x62, 0xC2, 0x72, 0xC7, 0x0D, 0xE1, 0x99, 0x70, 0x42, 0xCD,
+    0x8E, 0x89, 0xE1, 0x33, 0xAE, 0xB8, 0x61, 0x8E, 0x77, 0x32, 0x40, 0x24,
+    0x9A, 0x99, 0xEC, 0x1E, 0xB9, 0xA3, 0xB4, 0x17, 0x15, 0x64, 0x21, 0x5C,
+    0x31, 0x24, 0xD5, 0xD2, 0x15, 0x5A, 0x11, 0xA7, 0xB5, 0xB4, 0x3D, 0x20,
+    0xE4, 0x65, 0xC2, 0xB3, 0xA8, 0x5A, 0x12, 0x6B, 0x52, 0xFC, 0xEE, 0x6D,
+    0xA0, 0x11, 0x42, 0x49, 0x18, 0x82, 0x67, 0xFE, 0x4D, 0x32, 0x35, 0x1B,
+    0x53, 0xAE, 0x28, 0x0A, 0x38, 0xCB, 0xE0, 0x51, 0x72, 0xC7, 0x48, 0x5A,
+    0x30, 0x63, 0xB9, 0x1B, 0xD3, 0xDA, 0xE5, 0xE1, 0x39, 0x5D, 0x8B, 0x15,
+    0x2B, 0xF9, 0x98, 0xCE, 0x05, 0x5F, 0x54, 0xDA, 0x38, 0x4A, 0x52, 0xAD,
+    0x1C, 0x57, 0xA0, 0xB6, 0x10, 0x99, 0x2B, 0xC6, 0x19, 0x9F, 0x8B, 0x94,
+    0x87, 0xFE, 0xE3, 0x98, 0x08, 0x05, 0x7B, 0x60, 0x32, 0xB4, 0x29, 0x93,
+    0x7C, 0x3C, 0x40, 0x12, 0x27, 0x9C, 0xE4, 0x93, 0x9F, 0x8D, 0x5E, 0x90,
+    0x44, 0x3F, 0x8E, 0x7A, 0xCD, 0x77, 0x67, 0x64, 0xDD, 0x12, 0x9F, 0x89,
+    0xCE, 0x96, 0xE4, 0x5F, 0x92, 0x03, 0x6B, 0x98, 0xB3, 0x52, 0xC8, 0xE5,
+    0x90, 0x58, 0xA6, 0x6C, 0x08, 0x01, 0x12, 0x79, 0x4C, 0x4A, 0x66, 0x66,
+    0x42, 0x0D, 0xC9, 0x80, 0x97, 0x84, 0xD5, 0x4E, 0xA3, 0xE4, 0xB1, 0x31,
+    0x37, 0x24, 0xA7, 0x7D, 0x5E, 0xC6, 0xA4, 0x62, 0x59, 0x06, 0x81, 0x1B,
+    0x92, 0x3E, 0x6A, 0xC5, 0xE0, 0xA1, 0xD4, 0x66, 0x48, 0x5E, 0x9D, 0x9C,
+    0x9C, 0xC4, 0xE4, 0xA9, 0x53, 0x0C, 0xD6, 0xFC, 0x56, 0x7C, 0xE5, 0xC0,
+    0x14, 0xBD, 0x43, 0xAD, 0xA7, 0xCE, 0x2B, 0x29, 0xD4, 0x03, 0xAE, 0x49,
+    0xCD, 0xDC, 0x90, 0x18, 0x31, 0x2B, 0x5C, 0xDC, 0xD6, 0xEC, 0x47, 0xE7,
+    0x6D, 0x3E, 0xD6, 0xEF, 0x6F, 0x60, 0x51, 0x5D, 0x01, 0x72, 0xBD, 0xD2,
+    0x3F, 0xF7, 0x2B, 0x51, 0x0A, 0xE1, 0xB6, 0x20, 0xCF, 0x84, 0xAD, 0x24,
+    0x83, 0x9D, 0xCC, 0x8C, 0xC8, 0x62, 0xFF, 0x1B, 0x3A, 0x5E, 0x82, 0xCC,
+    0xF1, 0x10, 0x40, 0x75, 0xA9, 0x2C, 0x18, 0xE4, 0x15, 0x67, 0x2E, 0x78,
+    0x77, 0x4C, 0x06, 0xB9, 0xE9, 0x82, 0x1A, 0xAB, 0xD0, 0xE6, 0xF7, 0x8D,
+    0x77, 0x9E, 0x0C, 0xB8, 0x12, 0x6D, 0x32, 0x0E, 0x46, 0x06, 0xD5, 0x23,
+    0xB1, 0x5A, 0x8A, 0x8C, 0xBC, 0x4A, 0xD3, 0x34, 0x5E, 0xC9, 0x43, 0xC3,
+    0x32, 0x51, 0x03, 0xD9, 0x59, 0xF5, 0xD8, 0x8E, 0x44, 0x74, 0x86, 0x2C,
+    0x8E, 0x3F, 0xBA, 0x90, 0x49, 0x31, 0x83, 0x00, 0xA6, 0x90, 0x34, 0x6E,
+    0xB6, 0xCC, 0x49, 0xDB, 0xCF, 0x44, 0xEA, 0xF4, 0x21, 0xDE, 0x8D, 0xD2,
+    0x59, 0xDB, 0x0F, 0x5B, 0x32, 0x29, 0x5B, 0x3B, 0x3E, 0x3B, 0x3B, 0xF3,
+    0xB1, 0x10, 0x2A, 0xD7, 0x20, 0x5E, 0x67, 0xC9, 0x47, 0x8C, 0xF4, 0xF7,
+    0xA2, 0xF8, 0x43, 0x3B, 0x8A, 0xA7, 0xA7, 0xA7, 0x88, 0x4C, 0x6A, 0xE7,
+    0xA0, 0x7E, 0xDB, 0xD0, 0x13, 0x84, 0xB6, 0x7F, 0x77, 0x36, 0x74, 0xEA,
+    0xE5, 0xE7, 0x8D, 0x53, 0x42, 0x55, 0xB5, 0x03, 0xF0, 0xBA, 0x0E, 0xD6,
+    0x09, 0xD5, 0xB3, 0xFD, 0x5A, 0x2A, 0xB5, 0xD2, 0xB6, 0x62, 0x29, 0x7F,
+    0x2E, 0xB3, 0x05, 0xC7, 0x9C, 0xC3, 0x66, 0xFD, 0x5E, 0x35, 0x34, 0x24,
+    0xD4, 0xC2, 0x22, 0x04, 0x58, 0x53, 0x6A, 0x2F, 0xC5, 0x7E, 0xD7, 0xAD,
+    0x98, 0x2C, 0x0A, 0x01, 0x89, 0xF5, 0x66, 0xA0, 0x33, 0x0D, 0xB4, 0x83,
+    0x61, 0x15, 0x7A, 0x34, 0xEA, 0xAD, 0xCA, 0x7C, 0xD4, 0x5B, 0xB5, 0x1A,
+    0xD6, 0x3B, 0x36, 0xDE, 0x60, 0xD3, 0x12, 0x64, 0x04, 0x40, 0x45, 0x44,
+    0x36, 0xA6, 0x58, 0x59, 0x74, 0xA2, 0xF3, 0x1C, 0x5E, 0x38, 0x60, 0x41,
+    0x3E, 0x01, 0xE4, 0x00, 0x00, 0x99, 0x98, 0x93, 0x14, 0x06, 0x88, 0x1D,
+    0x53, 0x5F, 0x65, 0xF4, 0x50, 0x46, 0x27, 0x23, 0x9F, 0xA6, 0xC9, 0x1D,
+    0x94, 0x1A, 0xCE, 0x8F, 0xDA, 0x20, 0x89, 0x17, 0x8D, 0x12, 0x6F, 0x00,
+    0x8B, 0x90, 0x4E, 0xC2, 0x51, 0x2F, 0x59, 0xEB, 0x1E, 0x65, 0x7C, 0x16,
+    0x7F, 0xD8, 0xA8, 0xF5, 0x80, 0xF3, 0x7F, 0x98, 0x7F, 0xA9, 0x4B, 0x01,
+    0x63, 0x6A, 0xB9, 0x47, 0x5B, 0xD4, 0xE5, 0x2E, 0xEB, 0x9B, 0x6F, 0x25,
+    0x9C, 0x6A, 0x21, 0xF7, 0xC8, 0x2C, 0x88, 0x76, 0xD8, 0x36, 0xD2, 0xA9,
+    0x83, 0xFE, 0xA1, 0x87, 0xE4, 0x2D, 0x1B, 0xA8, 0x8A, 0x35, 0x49, 0x27,
+    0x17, 0x90, 0x41, 0xB2, 0x00, 0x80, 0xF1, 0x99, 0xDA, 0x06, 0x19, 0x53,
+    0xEB, 0xF9, 0x7D, 0x78, 0xC9, 0x11, 0xEC, 0x28, 0xD3, 0xD0, 0xF8, 0x53,
+    0xAE, 0x2C, 0x56, 0xE8, 0x56, 0xD3, 0x7A, 0xC9, 0x73, 0xBA, 0x3F, 0xB1,
+    0x5A, 0xBA, 0xB6, 0x6A, 0x8E, 0x82, 0xAD, 0x66, 0xCB, 0x25, 0xCC, 0x79,
+    0x53, 0xEB, 0x19, 0x73, 0x2C, 0x4C, 0x4B, 0xD0, 0xBE, 0xFD, 0xFC, 0xDB,
+    0xED, 0xFD, 0xD5, 0xF5, 0xC5, 0xFB, 0x4F, 0x57, 0x74, 0x72, 0xA5, 0x58,
+    0x22, 0xB9, 0xAF, 0x38, 0xD8, 0xB3, 0x57, 0x7D, 0x11, 0x73, 0xF9, 0x71,
+    0xDA, 0x80, 0x2E, 0x85, 0xFD, 0x26, 0xD4, 0xF4, 0xEE, 0xE2, 0xEE, 0xF3,
+    0x94, 0x4E, 0x7E, 0xE7, 0xB9, 0xE1, 0xB6, 0x68, 0xA9, 0xEE, 0x78, 0xD8,
+    0xF4, 0x13, 0x6E, 0xA4, 0x94, 0x94, 0xB8, 0x65, 0x05, 0x23, 0x5F, 0xD5,
+    0x70, 0xA4, 0x18, 0x4A, 0x4A, 0xA1, 0xC6, 0xB4, 0x4F, 0x09, 0x4C, 0x8A,
+    0x94, 0x17, 0x5A, 0x42, 0x47, 0x80, 0xDA, 0x27, 0xBA, 0x35, 0x87, 0x38,
+    0x1F, 0x69, 0x3A, 0xF9, 0x82, 0x0F, 0xA2, 0xF4, 0xE2, 0xD0, 0x52, 0x71,
+    0x32, 0xB9, 0x9A, 0xC3, 0x10, 0xB2, 0x50, 0xD1, 0x27, 0xAD, 0x74, 0x41,
+    0xD3, 0xD2, 0x4D, 0xC0, 0x6C, 0x6A, 0x44, 0xE5, 0x26, 0x9D, 0x39, 0x33,
+    0x64, 0x61, 0xC9, 0x98, 0xA8, 0x5A, 0xCA, 0xD8, 0x7F, 0xBE, 0x86, 0xAF,
+    0xBC, 0x56, 0xA9, 0x13, 0x60, 0x32, 0x10, 0x59, 0x17, 0x5A, 0xDD, 0x70,
+    0x28, 0x72, 0xD8, 0xAF, 0x4E, 0xEB, 0x12, 0xA8, 0xA3, 0x19, 0x77, 0x57,
+    0x92, 0xE3, 0xEB, 0xFB, 0xE5, 0xC7, 0x0C, 0x95, 0xA0, 0x0B, 0xE3, 0xCE,
+    0x06, 0x06, 0xB6, 0x02, 0x1C, 0x8A, 0x80, 0xF5, 0x9C, 0xD8, 0x67, 0x68,
+    0x84, 0x2F, 0xC8, 0x25, 0x78, 0x1E, 0x74, 0x23, 0xA7, 0x3F, 0x69, 0x3C,
+    0xBC, 0xEE, 0x44, 0xC9, 0xA7, 0x0E, 0x6B, 0x27, 0xE8, 0x92, 0xB7, 0x84,
+    0x12, 0xF8, 0x7B, 0xEB, 0x07, 0x2A, 0x7E, 0xFD, 0xA5, 0x68, 0xE3, 0x14,
+    0xF6, 0xEF, 0x98, 0xBC, 0x0E, 0xFC, 0x2E, 0xBA, 0x31, 0x1C, 0x67, 0x8F,
+    0x11, 0x2A, 0x7D, 0x68, 0x4E, 0x49, 0x58, 0x0B, 0xBC, 0x8D, 0xB7, 0x64,
+    0x6F, 0xA5, 0x1B, 0x59, 0x09, 0x07, 0x67, 0xD0, 0x3F, 0x26, 0xE7, 0xFD,
+    0x7E, 0x1F, 0xA0, 0x4F, 0x5B, 0x37, 0x6D, 0xA1, 0x17, 0x81, 0x45, 0x27,
+    0x81, 0xD9, 0xF7, 0x6C, 0x77, 0x8F, 0xD5, 0x46, 0x6E, 0xDB, 0xE4, 0x31,
+    0xAA, 0x61, 0x0F, 0x1E, 0x6A, 0x15, 0xAB, 0x86, 0xF5, 0x2A, 0xBE, 0xB3,
+    0x0E, 0x75, 0x50, 0x7C, 0x5F, 0x6A, 0x61, 0x37, 0x5C, 0xDB, 0x66, 0xDB,
+    0xD7, 0xA6, 0x6F, 0x7C, 0x1C, 0x00, 0x04, 0xCB, 0xB5, 0xF5, 0xDA, 0xBE,
+    0xA1, 0x0E, 0x69, 0xAB, 0xBA, 0xAC, 0xEE, 0xB9, 0x2F, 0xEE, 0x8C, 0xFC,
+    0x48, 0xA8, 0x56, 0x94, 0x0C, 0xE1, 0x91, 0xE7, 0xB4, 0x31, 0xD2, 0x74,
+    0xD7, 0x33, 0xFE, 0xF8, 0x85, 0x7B, 0xFD, 0xE0, 0x51, 0x0F, 0x1E, 0x55,
+    0x0A, 0x6B, 0x21, 0x17, 0x0D, 0xB2, 0x69, 0xB6, 0x43, 0xA0, 0x97, 0xEF,
+    0x06, 0x92, 0xAB, 0x2C, 0x48, 0x75, 0x59, 0x32, 0x85, 0xF5, 0xD2, 0x11,
+    0x39, 0x09, 0xA0, 0xAC, 0x8E, 0x8E, 0xA0, 0xB8, 0x22, 0x03, 0x13, 0x79,
+    0xE9, 0xB7, 0x49, 0xC6, 0xE3, 0x31, 0x19, 0xA0, 0xC2, 0xC2, 0x9B, 0xDF,
+    0x62, 0x80, 0x8D, 0x70, 0x69, 0x39, 0x2C, 0xE5, 0xDC, 0xA5, 0x45, 0x40,
+    0x7B, 0xAC, 0x12, 0xBD, 0xD5, 0x32, 0x3D, 0xC6, 0x03, 0x8C, 0xC3, 0x4D,
+    0x2C, 0x03, 0x1F, 0x6F, 0x6F, 0xA6, 0x77, 0x20, 0xC1, 0x09, 0x0F, 0xC7,
+    0x6D, 0xA3, 0x41, 0x9E, 0x7C, 0x66, 0xB1, 0xEE, 0xE8, 0xC4, 0x87, 0xAE,
+    0xC5, 0xBC, 0xF5, 0x13, 0x2E, 0x55, 0x8A, 0xA7, 0x2E, 0x68, 0x5C, 0x58,
+    0x55, 0xE4, 0x17, 0x9E, 0x4C, 0xE1, 0x58, 0xE6, 0x2E, 0xA0, 0x0B, 0x3B,
+    0xEC, 0xF5, 0x10, 0x0D, 0xE7, 0x34, 0x43, 0x44, 0x54, 0x68, 0xEB, 0x2B,
+    0xB1, 0xB7, 0xB0, 0x58, 0x77, 0xE0, 0x37, 0x1C, 0x74, 0x15, 0x57, 0x3B,
+    0x4D, 0x82, 0x2D, 0x82, 0xB5, 0x89, 0xC7, 0xCA, 0x41, 0x26, 0xA5, 0x98,
+    0x73, 0x1A, 0xB7, 0xD6, 0xFD, 0x7C, 0xBE, 0x86, 0xEB, 0x1E, 0xAE, 0xD6,
+    0x15, 0xF5, 0xAD, 0xE3, 0x89, 0x53, 0xA9, 0x2D, 0xDF, 0x67, 0xEE, 0xBC,
+    0xC8, 0xBC, 0x3A, 0xC0, 0x9A, 0x64, 0x3D, 0x47, 0x0E, 0x2B, 0x70, 0xD3,
+    0xC4, 0x16, 0xD3, 0xB5, 0x0B, 0x56, 0x9B, 0x3F, 0x26, 0x27, 0xAB, 0x46,
+    0x58, 0x59, 0x2D, 0xB9, 0xB5, 0x6C, 0xB6, 0x6B, 0xB7, 0x5C, 0x77, 0x6E,
+    0x69, 0x67, 0xB0, 0xF0, 0xEB, 0xF4, 0xE6, 0x3A, 0xAA, 0xF0, 0xDE, 0x1A,
+    0x94, 0x11, 0x4E, 0x3D, 0x80, 0x63, 0x8E, 0x61, 0x35, 0xE2, 0x38, 0x6C,
+    0x50, 0x1D, 0x83, 0xBF, 0x59, 0xDD, 0xA4, 0xD3, 0xF7, 0x18, 0xE8, 0xF9,
+    0x44, 0x3C, 0xE1, 0xCF, 0x66, 0x8A, 0xFC, 0x53, 0x73, 0xB3, 0x9C, 0x72,
+    0x09, 0x4E, 0x69, 0x73, 0x21, 0x65, 0x40, 0x9B, 0x59, 0xF6, 0xE7, 0x7A,
+    0xAE, 0xFE, 0x0D, 0x1B, 0xCA, 0xB5, 0xB9, 0x62, 0x50, 0x10, 0x5B, 0xDF,
+    0x12, 0x34, 0x96, 0xF8, 0x70, 0x89, 0xF4, 0xE1, 0x20, 0x11, 0xBE, 0xAE,
+    0x12, 0xEF, 0x07, 0x6C, 0x3E, 0x02, 0x9A, 0x66, 0x38, 0x61, 0x85, 0x40,
+    0x9C, 0x9A, 0x01, 0xDA, 0x7D, 0x09, 0xDE, 0x6C, 0x5A, 0x82, 0xD8, 0x6F,
+    0xF7, 0xA3, 0x72, 0x01, 0x80, 0x4A, 0xEC, 0xE7, 0x39, 0x93, 0x35, 0x87,
+    0x4B, 0x24, 0xC6, 0xCE, 0x1B, 0x01, 0xB5, 0x09, 0x5C, 0x86, 0xA1, 0x7B,
+    0xFC, 0xA1, 0x71, 0x73, 0xED, 0x0B, 0x0F, 0xA4, 0xC3, 0x8D, 0x84, 0x36,
+    0x71, 0xDE, 0xD4, 0x5D, 0x8C, 0x57, 0x95, 0xD5, 0xEC, 0x85, 0xD1, 0xDD,
+    0x5C, 0x52, 0x7A, 0xFE, 0x1F, 0x9A, 0xFF, 0x00, 0x52, 0xF3, 0x67, 0x57,
+    0xE0, 0x0C, 0x00, 0x00,
+};
+
+const size_t dashboard_html_gz_len = sizeof(dashboard_html_gz);
@@ -0,0 +1,20 @@
+#ifndef DASHBOARD_HTML_H
+#define DASHBOARD_HTML_H
+
+// Generated by tools/webembed.py from dashboard.html; do not edit
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const uint8_t dashboard_html_gz[];
+extern const size_t dashboard_html_gz_len;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
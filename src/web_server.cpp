@@ -0,0 +1,269 @@
+#include "web_server.h"
+#include "web/dashboard_html.h"
+#include "commands.h"
+#include "command_access.h"
+#include "connectToWifi.h"
+#include "logger.h"
+#include "timer_wheel.h"
+#include <ESPmDNS.h>
+#include <esp_http_server.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+#if !CONFIG_HTTPD_WS_SUPPORT
+#error "web_server needs CONFIG_HTTPD_WS_SUPPORT in the IDF config"
+#endif
+
+static httpd_handle_t server = NULL;
+static QueueHandle_t commandQueue = NULL;
+static TimerId pollTimer = TIMER_NONE;
+
+// Server task only: WebSocket sockets and the status served by /api/status
+static int clients[WEB_MAX_CLIENTS];
+static char latestStatus[WEB_STATUS_MAX] = "";
+
+// Read by the loop task to skip pushes nobody would get
+static volatile int clientCount = 0;
+
+// A push handed from the loop task to the server task; json follows it
+struct WebPush {
+    bool isStatus;
+    size_t len;
+};
+
+static void removeClient(int index) {
+    clients[index] = clients[clientCount - 1];
+    clientCount = clientCount - 1;
+}
+
+// Forget sockets that closed since they were added
+static void pruneClients() {
+    for (int i = clientCount - 1; i >= 0; i--) {
+        if (httpd_ws_get_fd_info(server, clients[i]) != HTTPD_WS_CLIENT_WEBSOCKET) {
+            removeClient(i);
+        }
+    }
+}
+
+static bool addClient(int fd) {
+    pruneClients();
+    if (clientCount >= WEB_MAX_CLIENTS) {
+        return false;
+    }
+    clients[clientCount] = fd;
+    clientCount = clientCount + 1;
+    return true;
+}
+
+static void sendText(int fd, const char* text, size_t len) {
+    httpd_ws_frame_t frame = {};
+    frame.final = true;
+    frame.type = HTTPD_WS_TYPE_TEXT;
+    frame.payload = (uint8_t*)text;
+    frame.len = len;
+    if (httpd_ws_send_frame_async(server, fd, &frame) != ESP_OK) {
+        httpd_sess_trigger_close(server, fd);
+    }
+}
+
+// Server task
+static void pushWork(void* arg) {
+    WebPush* push = (WebPush*)arg;
+    const char* json = (const char*)(push + 1);
+    if (push->isStatus) {
+        strncpy(latestStatus, json, sizeof(latestStatus) - 1);
+    }
+    pruneClients();
+    for (int i = 0; i < clientCount; i++) {
+        sendText(clients[i], json, push->len);
+    }
+    free(push);
+}
+
+static void queuePush(const char* json, bool isStatus) {
+    if (server == NULL || (!isStatus && clientCount == 0)) {
+        return;
+    }
+    size_t len = strlen(json);
+    WebPush* push = (WebPush*)malloc(sizeof(WebPush) + len + 1);
+    if (push == NULL) {
+        return;
+    }
+    push->isStatus = isStatus;
+    push->len = len;
+    memcpy(push + 1, json, len + 1);
+    if (httpd_queue_work(server, pushWork, push) != ESP_OK) {
+        free(push);
+    }
+}
+
+void webBroadcast(const char* json) {
+    queuePush(json, false);
+}
+
+void webUpdateStatus(const char* json) {
+    queuePush(json, true);
+}
+
+int webClientCount() {
+    return clientCount;
+}
+
+enum WebCommandResult {
+    WEB_COMMAND_QUEUED = 0,
+    WEB_COMMAND_REFUSED,
+    WEB_COMMAND_BUSY
+};
+
+// Server task: hand a command to the loop task. Trailing whitespace (curl
+// and shells add a newline) is dropped.
+static WebCommandResult queueCommand(char* command, size_t len) {
+    while (len > 0 && isspace((unsigned char)command[len - 1])) {
+        len--;
+    }
+    command[len] = '\0';
+    if (len == 0) {
+        return WEB_COMMAND_QUEUED;
+    }
+    if (!command_lan_allowed(command)) {
+        LOG_WARN("Web command refused: %s", command);
+        return WEB_COMMAND_REFUSED;
+    }
+    return xQueueSend(commandQueue, command, 0) == pdTRUE ? WEB_COMMAND_QUEUED : WEB_COMMAND_BUSY;
+}
+
+// Loop task: commands run here like the ones from MQTT, replies included
+static void pollCommands() {
+    char command[WEB_COMMAND_MAX];
+    while (xQueueReceive(commandQueue, command, 0) == pdTRUE) {
+        LOG_INFO("Web command: %s", command);
+        runCommand(String(command));
+    }
+}
+
+static esp_err_t sendJson(httpd_req_t* req, const char* status, const char* json) {
+    httpd_resp_set_status(req, status);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    return httpd_resp_sendstr(req, json);
+}
+
+static esp_err_t handleRoot(httpd_req_t* req) {
+    httpd_resp_set_type(req, "text/html");
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    return httpd_resp_send(req, (const char*)dashboard_html_gz, dashboard_html_gz_len);
+}
+
+static esp_err_t handleStatus(httpd_req_t* req) {
+    if (latestStatus[0] == '\0') {
+        return sendJson(req, "503 Service Unavailable", "{\"error\":\"no_sample\"}");
+    }
+    return sendJson(req, "200 OK", latestStatus);
+}
+
+static esp_err_t handleCommand(httpd_req_t* req) {
+    char command[WEB_COMMAND_MAX];
+    if (req->content_len == 0 || req->content_len >= sizeof(command)) {
+        return sendJson(req, "400 Bad Request", "{\"error\":\"bad_command\"}");
+    }
+    size_t received = 0;
+    while (received < req->content_len) {
+        int ret = httpd_req_recv(req, command + received, req->content_len - received);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (ret <= 0) {
+            return ESP_FAIL;
+        }
+        received += ret;
+    }
+    WebCommandResult result = queueCommand(command, received);
+    if (result == WEB_COMMAND_REFUSED) {
+        return sendJson(req, "403 Forbidden", "{\"error\":\"not_allowed\"}");
+    }
+    if (result == WEB_COMMAND_BUSY) {
+        return sendJson(req, "503 Service Unavailable", "{\"error\":\"busy\"}");
+    }
+    return sendJson(req, "202 Accepted", "{\"queued\":true}");
+}
+
+static esp_err_t handleWebSocket(httpd_req_t* req) {
+    // Handshake: register the socket and bring it up to date
+    if (req->method == HTTP_GET) {
+        int fd = httpd_req_to_sockfd(req);
+        if (!addClient(fd)) {
+            LOG_WARN("WebSocket refused, %d clients connected", WEB_MAX_CLIENTS);
+            return ESP_FAIL;
+        }
+        LOG_INFO("WebSocket client connected (%d)", (int)clientCount);
+        if (latestStatus[0] != '\0') {
+            sendText(fd, latestStatus, strlen(latestStatus));
+        }
+        return ESP_OK;
+    }
+
+    char command[WEB_COMMAND_MAX];
+    httpd_ws_frame_t frame = {};
+    if (httpd_ws_recv_frame(req, &frame, 0) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    if (frame.type != HTTPD_WS_TYPE_TEXT || frame.len >= sizeof(command)) {
+        return ESP_FAIL;
+    }
+    frame.payload = (uint8_t*)command;
+    if (httpd_ws_recv_frame(req, &frame, sizeof(command) - 1) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    WebCommandResult result = queueCommand(command, frame.len);
+    if (result != WEB_COMMAND_QUEUED) {
+        const char* rejected = result == WEB_COMMAND_REFUSED
+                                   ? "{\"event\":\"command_rejected\",\"reason\":\"not_allowed\"}"
+                                   : "{\"event\":\"command_rejected\",\"reason\":\"busy\"}";
+        httpd_ws_frame_t reply = {};
+        reply.final = true;
+        reply.type = HTTPD_WS_TYPE_TEXT;
+        reply.payload = (uint8_t*)rejected;
+        reply.len = strlen(rejected);
+        httpd_ws_send_frame(req, &reply);
+    }
+    return ESP_OK;
+}
+
+static void registerUri(const char* uri, httpd_method_t method, esp_err_t (*handler)(httpd_req_t*), bool websocket) {
+    httpd_uri_t route = {};
+    route.uri = uri;
+    route.method = method;
+    route.handler = handler;
+    route.is_websocket = websocket;
+    httpd_register_uri_handler(server, &route);
+}
+
+void initWebServer() {
+    commandQueue = xQueueCreate(WEB_COMMAND_QUEUE, WEB_COMMAND_MAX);
+    pollTimer = timerCreate("web_poll", pollCommands);
+    timerStart(pollTimer, WEB_POLL_MS, WEB_POLL_MS);
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = WEB_PORT;
+    // WebSocket clients plus room for plain requests; the least recently
+    // used socket goes when a new one does not fit
+    config.max_open_sockets = WEB_MAX_CLIENTS + 3;
+    config.lru_purge_enable = true;
+    if (httpd_start(&server, &config) != ESP_OK) {
+        LOG_ERROR("Web server failed to start");
+        server = NULL;
+        return;
+    }
+    registerUri("/", HTTP_GET, handleRoot, false);
+    registerUri("/api/status", HTTP_GET, handleStatus, false);
+    registerUri("/api/command", HTTP_POST, handleCommand, false);
+    registerUri("/ws", HTTP_GET, handleWebSocket, true);
+
+    String hostname = String("growbox-") + deviceId;
+    if (MDNS.begin(hostname.c_str())) {
+        MDNS.addService("http", "tcp", WEB_PORT);
+        LOG_INFO("Web server at http://%s.local/", hostname.c_str());
+    } else {
+        LOG_WARN("mDNS failed to start, web server on port %d", WEB_PORT);
+    }
+}
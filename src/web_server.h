@@ -0,0 +1,42 @@
+#ifndef WEB_SERVER_H
+#define WEB_SERVER_H
+
+#include <Arduino.h>
+
+// Dashboard and API for clients on the LAN, so they do not have to go
+// through the broker. Served by the IDF HTTP server on its own task:
+//   GET  /             dashboard (gzip, from flash)
+//   GET  /api/status   latest status sample as JSON
+//   POST /api/command  body is a control command, as on the MQTT topic
+//   GET  /ws           WebSocket: every sample and status event is pushed
+//                      as it is produced; text frames are commands
+// Only the pump and status commands are taken from the LAN (no
+// authentication here); OTA, FAULT_CLEAR and calibration need the broker.
+// The device answers as growbox-<id>.local (mDNS).
+
+#define WEB_PORT 80
+
+// WebSocket clients pushed to at once; more are refused
+#define WEB_MAX_CLIENTS 4
+
+// Commands from the server task wait here for the loop task
+#define WEB_COMMAND_MAX 96
+#define WEB_COMMAND_QUEUE 4
+#define WEB_POLL_MS 20
+
+// Largest status JSON kept for /api/status
+#define WEB_STATUS_MAX 288
+
+// Start the server, mDNS and the web_poll timer. Call after setupMQTT().
+void initWebServer();
+
+// Push a status event to the WebSocket clients
+void webBroadcast(const char* json);
+
+// New status sample: answer /api/status with it and push it
+void webUpdateStatus(const char* json);
+
+// WebSocket clients connected now
+int webClientCount();
+
+#endif
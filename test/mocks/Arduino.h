@@ -0,0 +1,38 @@
+#ifndef MOCK_ARDUINO_H
+#define MOCK_ARDUINO_H
+
+// Host stand-in for the parts of the Arduino core the native tests reach:
+// String, and critical sections that do nothing on one thread
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+typedef uint8_t byte;
+
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
+class String : public std::string {
+public:
+    String() {}
+    String(const char* s) : std::string(s) {}
+    String(const std::string& s) : std::string(s) {}
+
+    int toInt() const {
+        return atoi(c_str());
+    }
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t pos = find(c, from);
+        return pos == npos ? -1 : (int)pos;
+    }
+    String substring(unsigned int from) const {
+        return from < length() ? String(substr(from)) : String();
+    }
+};
+
+#endif
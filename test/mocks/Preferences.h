@@ -0,0 +1,22 @@
+#ifndef MOCK_PREFERENCES_H
+#define MOCK_PREFERENCES_H
+
+// Host stand-in for NVS: an empty store that accepts writes and forgets them
+
+#include <Arduino.h>
+
+class Preferences {
+public:
+    bool begin(const char*, bool = false) {
+        return true;
+    }
+    void end() {}
+    uint32_t getUInt(const char*, uint32_t defaultValue = 0) {
+        return defaultValue;
+    }
+    size_t putUInt(const char*, uint32_t) {
+        return sizeof(uint32_t);
+    }
+};
+
+#endif
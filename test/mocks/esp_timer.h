@@ -0,0 +1,154 @@
+#ifndef MOCK_ESP_TIMER_H
+#define MOCK_ESP_TIMER_H
+
+// Host stand-in for esp_timer. Nothing fires on its own: a test moves the
+// clock with MockTimer::advance(), which runs the callbacks falling due in
+// dispatch order, or runs one with MockTimer::fire() to model a callback
+// dispatched before the timer was stopped. setLatency() makes each
+// dispatch late by a random, seeded amount, as when the esp_timer task
+// waits behind other work; delay() holds back one armed timer.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef void (*esp_timer_cb_t)(void* arg);
+
+typedef enum {
+    ESP_TIMER_TASK
+} esp_timer_dispatch_t;
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void* arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char* name;
+} esp_timer_create_args_t;
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void* arg;
+    const char* name;
+    bool armed;
+    int64_t dueUs;
+    int64_t runUs;              // due time plus dispatch latency
+};
+
+typedef struct esp_timer* esp_timer_handle_t;
+
+#define MOCK_TIMER_MAX 8
+
+struct MockTimer {
+    static int64_t& nowUs() {
+        static int64_t now = 0;
+        return now;
+    }
+    static esp_timer* timers() {
+        static esp_timer all[MOCK_TIMER_MAX];
+        return all;
+    }
+    static size_t& count() {
+        static size_t created = 0;
+        return created;
+    }
+
+    static uint32_t& maxLatencyUs() {
+        static uint32_t latency = 0;
+        return latency;
+    }
+    static uint32_t& seed() {
+        static uint32_t state = 1;
+        return state;
+    }
+
+    static void reset() {
+        nowUs() = 0;
+        count() = 0;
+        maxLatencyUs() = 0;
+    }
+
+    static void setLatency(uint32_t maxUs, uint32_t seedValue) {
+        maxLatencyUs() = maxUs;
+        seed() = seedValue ? seedValue : 1;
+    }
+
+    // xorshift32, so a failing run can be repeated from its seed
+    static uint32_t latency() {
+        if (maxLatencyUs() == 0) {
+            return 0;
+        }
+        uint32_t& x = seed();
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return x % (maxLatencyUs() + 1);
+    }
+
+    static esp_timer* find(const char* name) {
+        for (size_t i = 0; i < count(); i++) {
+            if (strcmp(timers()[i].name, name) == 0) {
+                return &timers()[i];
+            }
+        }
+        return NULL;
+    }
+
+    static void delay(esp_timer_handle_t timer, int64_t us) {
+        timer->runUs += us;
+    }
+
+    static void fire(esp_timer_handle_t timer) {
+        timer->callback(timer->arg);
+    }
+
+    static void advance(int64_t us) {
+        int64_t end = nowUs() + us;
+        for (;;) {
+            esp_timer* next = NULL;
+            for (size_t i = 0; i < count(); i++) {
+                esp_timer* t = &timers()[i];
+                if (t->armed && t->runUs <= end && (next == NULL || t->runUs < next->runUs)) {
+                    next = t;
+                }
+            }
+            if (next == NULL) {
+                break;
+            }
+            nowUs() = next->runUs;
+            next->armed = false;
+            fire(next);
+        }
+        nowUs() = end;
+    }
+};
+
+inline int64_t esp_timer_get_time() {
+    return MockTimer::nowUs();
+}
+
+inline int esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* timer) {
+    if (MockTimer::count() == MOCK_TIMER_MAX) {
+        return -1;
+    }
+    esp_timer* t = &MockTimer::timers()[MockTimer::count()++];
+    t->callback = args->callback;
+    t->arg = args->arg;
+    t->name = args->name;
+    t->armed = false;
+    *timer = t;
+    return 0;
+}
+
+inline int esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeoutUs) {
+    timer->armed = true;
+    timer->dueUs = MockTimer::nowUs() + (int64_t)timeoutUs;
+    timer->runUs = timer->dueUs + MockTimer::latency();
+    return 0;
+}
+
+inline int esp_timer_stop(esp_timer_handle_t timer) {
+    timer->armed = false;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,69 @@
+// LAN command allowlist (env:native): the dashboard's commands and status
+// queries pass with their arguments, deadline and request id; anything
+// that flashes, clears a fault or calibrates is refused
+#include <unity.h>
+#include "command_access.h"
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static void test_allowed(void) {
+    TEST_ASSERT_TRUE(command_lan_allowed("PUMP_ON"));
+    TEST_ASSERT_TRUE(command_lan_allowed("PUMP_ENABLE"));
+    TEST_ASSERT_TRUE(command_lan_allowed("PUMP_DISABLE"));
+    TEST_ASSERT_TRUE(command_lan_allowed("STATUS"));
+    TEST_ASSERT_TRUE(command_lan_allowed("PUMP_CAL_STATUS"));
+    TEST_ASSERT_TRUE(command_lan_allowed("CAL_STATUS"));
+    TEST_ASSERT_TRUE(command_lan_allowed("OTA_STATUS"));
+}
+
+static void test_allowed_with_arguments(void) {
+    TEST_ASSERT_TRUE(command_lan_allowed("PUMP_ON 50"));
+    TEST_ASSERT_TRUE(command_lan_allowed("STATUS:abc123"));
+    TEST_ASSERT_TRUE(command_lan_allowed("PUMP_ON 50:req-1"));
+    TEST_ASSERT_TRUE(command_lan_allowed("PUMP_ON@1760000000"));
+    TEST_ASSERT_TRUE(command_lan_allowed("PUMP_ON 50@1760000000:req-1"));
+    TEST_ASSERT_TRUE(command_lan_allowed("CAL_STATUS 1:x"));
+    TEST_ASSERT_TRUE(command_lan_allowed("PUMP_CAL_STATUS 0"));
+}
+
+static void test_broker_only(void) {
+    TEST_ASSERT_FALSE(command_lan_allowed("OTA_BEGIN"));
+    TEST_ASSERT_FALSE(command_lan_allowed("OTA_BEGIN 123456:abc"));
+    TEST_ASSERT_FALSE(command_lan_allowed("OTA_ABORT"));
+    TEST_ASSERT_FALSE(command_lan_allowed("FAULT_CLEAR"));
+    TEST_ASSERT_FALSE(command_lan_allowed("FAULT_CLEAR:abc"));
+    TEST_ASSERT_FALSE(command_lan_allowed("CAL_SAVE"));
+    TEST_ASSERT_FALSE(command_lan_allowed("CAL_START 0"));
+    TEST_ASSERT_FALSE(command_lan_allowed("CAL_TEMP 0 1025 2038"));
+    TEST_ASSERT_FALSE(command_lan_allowed("PUMP_CAL 250 0"));
+    TEST_ASSERT_FALSE(command_lan_allowed("PUMP_CAL_RUN 0"));
+}
+
+// The whole command word has to match, not a prefix of it or of an
+// allowed one
+static void test_near_misses(void) {
+    TEST_ASSERT_FALSE(command_lan_allowed("PUMP_ONX"));
+    TEST_ASSERT_FALSE(command_lan_allowed("PUMP_ONX 50"));
+    TEST_ASSERT_FALSE(command_lan_allowed("PUMP_O"));
+    TEST_ASSERT_FALSE(command_lan_allowed("STATUSES"));
+    TEST_ASSERT_FALSE(command_lan_allowed("CAL_STATUS_X"));
+    TEST_ASSERT_FALSE(command_lan_allowed("OTA_STATUSX"));
+    TEST_ASSERT_FALSE(command_lan_allowed("pump_on"));
+    TEST_ASSERT_FALSE(command_lan_allowed(" PUMP_ON"));
+    TEST_ASSERT_FALSE(command_lan_allowed("PUMP_ON\tFAULT_CLEAR"));
+    TEST_ASSERT_FALSE(command_lan_allowed(""));
+    TEST_ASSERT_FALSE(command_lan_allowed(":abc"));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_allowed);
+    RUN_TEST(test_allowed_with_arguments);
+    RUN_TEST(test_broker_only);
+    RUN_TEST(test_near_misses);
+    return UNITY_END();
+}
@@ -0,0 +1,79 @@
+// Board types on mock pins (env:native, BOARD_NATIVE): pin levels, ADC
+// reads and device set indexing for both board revisions
+#include <unity.h>
+#include "board.h"
+
+using hal::Mock;
+
+void setUp(void) {
+    Mock::reset();
+}
+
+void tearDown(void) {
+}
+
+static void test_digital_out_levels(void) {
+    typedef hal::DigitalOut<5> Relay;
+    typedef hal::DigitalOut<18, false> ActiveLow;
+
+    Relay::set(true);
+    TEST_ASSERT_EQUAL_UINT8(1, Mock::levels()[5]);
+    Relay::set(false);
+    TEST_ASSERT_EQUAL_UINT8(0, Mock::levels()[5]);
+
+    // Off is the high level on an active-low output, also after init()
+    ActiveLow::init();
+    TEST_ASSERT_EQUAL_UINT8(1, Mock::levels()[18]);
+    ActiveLow::set(true);
+    TEST_ASSERT_EQUAL_UINT8(0, Mock::levels()[18]);
+}
+
+static void test_adc_channels(void) {
+    TEST_ASSERT_EQUAL_INT(6, hal::adc1Channel(34));
+    TEST_ASSERT_EQUAL_INT(7, hal::adc1Channel(35));
+    TEST_ASSERT_EQUAL_INT(-1, hal::adc1Channel(25));
+
+    Mock::adc()[6] = 2345;
+    TEST_ASSERT_EQUAL_INT(2345, hal::AnalogIn<34>::read());
+    TEST_ASSERT_EQUAL_INT(0, hal::AnalogIn<35>::read());
+}
+
+static void test_rev1_board(void) {
+    TEST_ASSERT_EQUAL_UINT8(1, BoardRev1::Pumps::count);
+    TEST_ASSERT_EQUAL_INT(5, BoardRev1::Pumps::pin(0));
+    TEST_ASSERT_EQUAL_INT(-1, BoardRev1::Pumps::pin(1));
+
+    BoardRev1::Pumps::set(0, true);
+    TEST_ASSERT_EQUAL_UINT8(1, Mock::levels()[5]);
+    // Out of range indexes touch nothing
+    BoardRev1::Pumps::set(1, true);
+    TEST_ASSERT_EQUAL_UINT8(0, Mock::levels()[18]);
+
+    Mock::adc()[6] = 1800;
+    TEST_ASSERT_EQUAL_INT(1800, BoardRev1::SoilSensors::read(0));
+    TEST_ASSERT_EQUAL_INT(0, BoardRev1::SoilSensors::read(1));
+}
+
+static void test_rev2_board(void) {
+    TEST_ASSERT_EQUAL_UINT8(2, BoardRev2::Pumps::count);
+    TEST_ASSERT_EQUAL_INT(18, BoardRev2::Pumps::pin(1));
+
+    BoardRev2::Pumps::init();
+    BoardRev2::Pumps::set(1, true);
+    TEST_ASSERT_EQUAL_UINT8(0, Mock::levels()[5]);
+    TEST_ASSERT_EQUAL_UINT8(1, Mock::levels()[18]);
+
+    Mock::adc()[6] = 1000;
+    Mock::adc()[7] = 3000;
+    TEST_ASSERT_EQUAL_INT(1000, BoardRev2::SoilSensors::read(0));
+    TEST_ASSERT_EQUAL_INT(3000, BoardRev2::SoilSensors::read(1));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_digital_out_levels);
+    RUN_TEST(test_adc_channels);
+    RUN_TEST(test_rev1_board);
+    RUN_TEST(test_rev2_board);
+    return UNITY_END();
+}
@@ -0,0 +1,193 @@
+// Driver against the SSD1306 simulator (env:native): what the panel shows
+// after the driver's flushes, partial updates and hardware scrolls
+#include <unity.h>
+#include "oled_ssd1306.h"
+#include "oled_sim.h"
+
+void setUp(void) {
+    oled_init(0, 0);
+    oled_clear();
+    // Full flush of the blank frame; also forgets the last frame hash
+    oled_display_window(0, OLED_WIDTH - 1, 0, OLED_PAGES - 1);
+}
+
+void tearDown(void) {
+}
+
+static uint32_t lit_pixels(void) {
+    uint32_t lit = 0;
+    for (uint8_t y = 0; y < SCREEN_HEIGHT; y++) {
+        for (uint8_t x = 0; x < SCREEN_WIDTH; x++) {
+            lit += oled_sim_pixel(x, y);
+        }
+    }
+    return lit;
+}
+
+static void test_init_sequence(void) {
+    const oled_sim_state_t *sim = oled_sim_state();
+    TEST_ASSERT_TRUE(sim->display_on);
+    TEST_ASSERT_FALSE(sim->inverted);
+    // Horizontal addressing on the SSD1306; the SH1106 only has page mode
+    TEST_ASSERT_EQUAL_UINT8(OLED_PANEL == OLED_PANEL_SH1106 ? 2 : 0, sim->memory_mode);
+    TEST_ASSERT_EQUAL_UINT8(0, sim->start_line);
+    TEST_ASSERT_EQUAL_UINT32(0, lit_pixels());
+}
+
+static void test_pixel_mapping(void) {
+    const uint8_t points[][2] = {{0, 0}, {SCREEN_WIDTH - 1, 0}, {0, SCREEN_HEIGHT - 1},
+                                 {SCREEN_WIDTH - 1, SCREEN_HEIGHT - 1}, {37, 13}, {64, 8}};
+    for (size_t i = 0; i < sizeof(points) / sizeof(points[0]); i++) {
+        oled_set_pixel(points[i][0], points[i][1], 1);
+    }
+    oled_display();
+
+    for (size_t i = 0; i < sizeof(points) / sizeof(points[0]); i++) {
+        TEST_ASSERT_EQUAL_UINT8(1, oled_sim_pixel(points[i][0], points[i][1]));
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, oled_sim_pixel(37, 12));
+    TEST_ASSERT_EQUAL_UINT8(0, oled_sim_pixel(38, 13));
+    TEST_ASSERT_EQUAL_UINT32(6, lit_pixels());
+}
+
+// Only the addressed column/page window reaches the panel
+static void test_window_addressing(void) {
+    oled_fill_rect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, 1);
+    oled_display_window(10, 19, 2, 3);
+
+    TEST_ASSERT_EQUAL_UINT32(10 * 16, lit_pixels());
+    TEST_ASSERT_EQUAL_UINT8(1, oled_sim_pixel(10, 16));
+    TEST_ASSERT_EQUAL_UINT8(1, oled_sim_pixel(19, 31));
+    TEST_ASSERT_EQUAL_UINT8(0, oled_sim_pixel(9, 16));
+    TEST_ASSERT_EQUAL_UINT8(0, oled_sim_pixel(20, 31));
+    TEST_ASSERT_EQUAL_UINT8(0, oled_sim_pixel(10, 15));
+    TEST_ASSERT_EQUAL_UINT8(0, oled_sim_pixel(10, 32));
+}
+
+static void test_dirty_rect_sends_only_the_rect(void) {
+    uint32_t before = oled_sim_state()->data_bytes;
+    oled_fill_rect(40, 20, 8, 4, 1);
+    oled_mark_dirty(40, 20, 8, 4);
+    oled_display_dirty();
+
+    // One page row of 8 columns
+    TEST_ASSERT_EQUAL_UINT32(8, oled_sim_state()->data_bytes - before);
+    TEST_ASSERT_EQUAL_UINT32(32, lit_pixels());
+    TEST_ASSERT_EQUAL_UINT8(1, oled_sim_pixel(47, 23));
+}
+
+static void test_unchanged_frame_skipped(void) {
+    oled_set_pixel(5, 5, 1);
+    oled_display();
+    uint32_t before = oled_sim_state()->data_bytes;
+    oled_display();
+    TEST_ASSERT_EQUAL_UINT32(before, oled_sim_state()->data_bytes);
+}
+
+// Frame A in full, B as a partial update, then A in full again: the last
+// flush must not be skipped as unchanged
+static void test_full_frame_after_partial_update(void) {
+    oled_set_pixel(5, 5, 1);
+    oled_display();
+
+    oled_set_pixel(5, 5, 0);
+    oled_set_pixel(100, 40, 1);
+    oled_mark_dirty(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    oled_display_dirty();
+    TEST_ASSERT_EQUAL_UINT8(0, oled_sim_pixel(5, 5));
+    TEST_ASSERT_EQUAL_UINT8(1, oled_sim_pixel(100, 40));
+
+    oled_set_pixel(5, 5, 1);
+    oled_set_pixel(100, 40, 0);
+    oled_display();
+    TEST_ASSERT_EQUAL_UINT8(1, oled_sim_pixel(5, 5));
+    TEST_ASSERT_EQUAL_UINT8(0, oled_sim_pixel(100, 40));
+}
+
+static void test_invert_and_start_line(void) {
+    oled_set_pixel(0, 0, 1);
+    oled_display();
+
+    oled_set_invert(true);
+    TEST_ASSERT_EQUAL_UINT8(0, oled_sim_pixel(0, 0));
+    TEST_ASSERT_EQUAL_UINT8(1, oled_sim_pixel(1, 0));
+    oled_set_invert(false);
+
+    // Start line 8: RAM row 8 shows at the top, row 0 at the bottom
+    oled_set_start_line(8);
+    TEST_ASSERT_EQUAL_UINT8(1, oled_sim_pixel(0, SCREEN_HEIGHT - 8));
+    TEST_ASSERT_EQUAL_UINT8(0, oled_sim_pixel(0, 0));
+    oled_set_start_line(0);
+}
+
+#if OLED_HW_SCROLL
+static void test_horizontal_scroll(void) {
+    oled_set_pixel(0, 0, 1);
+    oled_set_pixel(SCREEN_WIDTH - 1, 8, 1);
+    oled_display();
+
+    oled_scroll_horizontal(OLED_SCROLL_RIGHT, 0, 0, OLED_SCROLL_FRAMES_5);
+    TEST_ASSERT_TRUE(oled_scroll_active());
+    oled_sim_advance_frames(4);
+    TEST_ASSERT_EQUAL_UINT8(1, oled_sim_pixel(0, 0));
+    oled_sim_advance_frames(1);
+    TEST_ASSERT_EQUAL_UINT8(0, oled_sim_pixel(0, 0));
+    TEST_ASSERT_EQUAL_UINT8(1, oled_sim_pixel(1, 0));
+
+    // Page 1 is outside the scroll
+    TEST_ASSERT_EQUAL_UINT8(1, oled_sim_pixel(SCREEN_WIDTH - 1, 8));
+
+    // Wraps around at the right edge
+    oled_sim_advance_frames(5 * (SCREEN_WIDTH - 1));
+    TEST_ASSERT_EQUAL_UINT8(1, oled_sim_pixel(0, 0));
+}
+
+// A flush stops the scroll first, so no RAM write lands mid-scroll; the
+// scrolled RAM is stale, so the next flush sends the whole frame
+static void test_flush_stops_scroll(void) {
+    oled_set_pixel(0, 0, 1);
+    oled_display();
+    oled_scroll_horizontal(OLED_SCROLL_LEFT, 0, 7, OLED_SCROLL_FRAMES_2);
+    oled_sim_advance_frames(20);
+
+    oled_set_pixel(64, 32, 1);
+    oled_mark_dirty(64, 32, 1, 1);
+    oled_display_dirty();
+    TEST_ASSERT_FALSE(oled_sim_state()->scroll_active);
+    TEST_ASSERT_EQUAL_UINT32(0, oled_sim_state()->writes_during_scroll);
+
+    const oled_rect_t *rects;
+    TEST_ASSERT_EQUAL_UINT8(OLED_DIRTY_ALL, oled_get_dirty_rects(&rects));
+    oled_display_dirty();
+    TEST_ASSERT_EQUAL_UINT8(1, oled_sim_pixel(0, 0));
+    TEST_ASSERT_EQUAL_UINT8(1, oled_sim_pixel(64, 32));
+    TEST_ASSERT_EQUAL_UINT32(2, lit_pixels());
+}
+
+static void test_diagonal_scroll_moves_rows(void) {
+    oled_set_pixel(10, 20, 1);
+    oled_display();
+
+    oled_scroll_diagonal(OLED_SCROLL_RIGHT, 0, 7, OLED_SCROLL_FRAMES_2, 0, SCREEN_HEIGHT, 1);
+    oled_sim_advance_frames(2);
+    TEST_ASSERT_EQUAL_UINT8(1, oled_sim_pixel(11, 19));
+    oled_scroll_stop();
+}
+#endif
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_init_sequence);
+    RUN_TEST(test_pixel_mapping);
+    RUN_TEST(test_window_addressing);
+    RUN_TEST(test_dirty_rect_sends_only_the_rect);
+    RUN_TEST(test_unchanged_frame_skipped);
+    RUN_TEST(test_full_frame_after_partial_update);
+    RUN_TEST(test_invert_and_start_line);
+#if OLED_HW_SCROLL
+    RUN_TEST(test_horizontal_scroll);
+    RUN_TEST(test_flush_stops_scroll);
+    RUN_TEST(test_diagonal_scroll_moves_rows);
+#endif
+    return UNITY_END();
+}
@@ -0,0 +1,71 @@
+"""Writes patch_fixture.h for the decoder test: a delta patch built by
+tools/ota_patch.py between two images that test_main.c rebuilds on its
+own, so the device decoder is checked against the host encoder byte for
+byte. The images are xorshift noise with the kinds of edits a firmware
+update makes: bytes inserted and dropped, a span with every 64th byte
+changed (moved addresses), new bytes at the end. The header is signed
+with a throwaway key; the decoder only takes the signature apart.
+
+    python test/test_ota_patch/make_fixture.py
+"""
+import os
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "..", "..", "tools"))
+import ota_patch  # noqa: E402
+
+BASE_SIZE = 6144
+
+
+def noise(seed, size):
+    x = seed
+    out = bytearray()
+    for _ in range(size):
+        x ^= (x << 13) & 0xFFFFFFFF
+        x ^= x >> 17
+        x ^= (x << 5) & 0xFFFFFFFF
+        out.append(x & 0xFF)
+    return bytes(out)
+
+
+def images():
+    base = noise(1, BASE_SIZE)
+    moved = bytes((b + 4) & 0xFF if i % 64 == 0 else b for i, b in enumerate(base[1000:3000]))
+    new = base[:1000] + noise(2, 100) + moved + base[3200:] + noise(3, 300)
+    return base, new
+
+
+def main():
+    base, new = images()
+    with tempfile.TemporaryDirectory() as tmp:
+        key = os.path.join(tmp, "fixture.pem")
+        ota_patch.keygen(key, os.path.join(tmp, "fixture.h"))
+        patch = ota_patch.diff(base, new, key)
+    if ota_patch.apply(base, patch) != new:
+        sys.exit("host decoder does not reproduce the new image")
+
+    rows = ",\n".join("    " + ", ".join(f"0x{b:02x}" for b in patch[i:i + 12]) for i in range(0, len(patch), 12))
+    path = os.path.join(os.path.dirname(__file__), "patch_fixture.h")
+    with open(path, "w", encoding="utf-8") as f:
+        f.write(f"""#ifndef PATCH_FIXTURE_H
+#define PATCH_FIXTURE_H
+
+// Generated by test/test_ota_patch/make_fixture.py; do not edit
+
+#include <stdint.h>
+
+#define FIXTURE_BASE_SIZE {len(base)}
+#define FIXTURE_NEW_SIZE {len(new)}
+
+static const uint8_t fixture_patch[{len(patch)}] = {{
+{rows}
+}};
+
+#endif
+""")
+    print(f"{path}: {len(patch)} byte patch for a {len(new)} byte image")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,70 @@
+#ifndef PATCH_FIXTURE_H
+#define PATCH_FIXTURE_H
+
+// Generated by test/test_ota_patch/make_fixture.py; do not edit
+
+#include <stdint.h>
+
+#define FIXTURE_BASE_SIZE 6144
+#define FIXTURE_NEW_SIZE 6344
+
+static const uint8_t fixture_patch[661] = {
+    0x47, 0x42, 0x4f, 0x54, 0x02, 0x01, 0xc8, 0x18, 0x00, 0x00, 0x00, 0x18,
+    0x00, 0x00, 0xfb, 0xf3, 0x3e, 0xc2, 0x4a, 0x8c, 0x50, 0xa7, 0xf4, 0xdb,
+    0x3e, 0x08, 0xd7, 0x40, 0x2d, 0x7a, 0x49, 0xbb, 0x90, 0x5b, 0x1f, 0x54,
+    0xbf, 0x30, 0x00, 0x46, 0xcf, 0x1c, 0xbf, 0xf0, 0xc7, 0xab, 0x25, 0x48,
+    0xba, 0x55, 0x3e, 0x5e, 0x4a, 0xdb, 0xdd, 0x76, 0x2b, 0xec, 0xc5, 0x44,
+    0xe6, 0xf9, 0x7c, 0xf7, 0xf5, 0x49, 0xa7, 0x24, 0x14, 0x7e, 0x7e, 0x20,
+    0x6f, 0x3c, 0xc1, 0xf1, 0xa4, 0x2c, 0x56, 0x9f, 0xd6, 0x46, 0xca, 0x6c,
+    0x43, 0x4c, 0x9e, 0x86, 0xc0, 0x36, 0x4e, 0x3c, 0xad, 0xcd, 0x75, 0x31,
+    0xb6, 0xd9, 0x8a, 0xb3, 0x64, 0xbf, 0x11, 0x51, 0xa8, 0x0f, 0x7e, 0x6c,
+    0xf9, 0x5d, 0x20, 0xea, 0xa5, 0x8f, 0xb1, 0xbc, 0xe4, 0x6c, 0x81, 0x7c,
+    0x89, 0xe1, 0x7d, 0x08, 0x45, 0xe6, 0xa6, 0xb7, 0x77, 0x03, 0xc4, 0xc9,
+    0x19, 0xb3, 0x6b, 0xb3, 0xd0, 0xae, 0x6c, 0x64, 0x08, 0x9c, 0x01, 0xe8,
+    0x07, 0x00, 0xe8, 0x07, 0x02, 0x65, 0x42, 0x02, 0x82, 0x06, 0x1a, 0x23,
+    0x59, 0xb6, 0x2a, 0x3b, 0xca, 0x3d, 0x09, 0x24, 0x3e, 0xfe, 0xbf, 0xff,
+    0x35, 0x9b, 0x88, 0xe8, 0x8a, 0x99, 0xe7, 0x64, 0x04, 0x35, 0x20, 0xd9,
+    0xc3, 0x77, 0xd1, 0x7b, 0x3d, 0x6a, 0x22, 0xa7, 0xe5, 0xdd, 0x54, 0x85,
+    0x15, 0xb6, 0x22, 0x03, 0x5c, 0x34, 0x4c, 0xf3, 0x9a, 0x70, 0x4c, 0xaa,
+    0xf7, 0x83, 0x60, 0x79, 0x91, 0xf9, 0xcd, 0x8f, 0x7c, 0xc2, 0x26, 0x30,
+    0x82, 0x56, 0x19, 0x8d, 0xe7, 0x73, 0xdc, 0x9e, 0x35, 0x3b, 0x5d, 0x9a,
+    0xd1, 0xd6, 0x0c, 0xa2, 0x43, 0xaa, 0xdd, 0x83, 0x53, 0x51, 0xef, 0x8e,
+    0x58, 0xb7, 0xff, 0xb2, 0x40, 0x42, 0x4d, 0x48, 0x3d, 0xc7, 0x32, 0x01,
+    0xcf, 0x0f, 0xe9, 0x07, 0x3f, 0x01, 0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01,
+    0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01,
+    0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01,
+    0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01,
+    0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01,
+    0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01,
+    0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01,
+    0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01, 0x04, 0x3f, 0x01,
+    0x04, 0x0f, 0x01, 0x80, 0x17, 0x80, 0x19, 0x80, 0x17, 0x02, 0xac, 0x02,
+    0x63, 0x03, 0x47, 0x49, 0xcb, 0xf3, 0x43, 0x04, 0x0f, 0x4f, 0x01, 0x0a,
+    0x83, 0x8a, 0xcb, 0x4f, 0xb7, 0xf7, 0xa4, 0x82, 0xbb, 0x51, 0x61, 0xd6,
+    0x15, 0x4d, 0xa1, 0xd1, 0xfb, 0xe7, 0x94, 0x63, 0xd0, 0x53, 0xdd, 0x9e,
+    0xd8, 0x45, 0x9b, 0xda, 0xa5, 0x9f, 0x56, 0x91, 0x95, 0xea, 0x19, 0x60,
+    0xe1, 0x76, 0xa1, 0xc3, 0x80, 0x7f, 0x43, 0x57, 0xb4, 0x2d, 0x42, 0x74,
+    0xa0, 0xa9, 0x7c, 0x05, 0x46, 0x80, 0x56, 0x1c, 0xf4, 0x41, 0x69, 0xe2,
+    0xcc, 0xfe, 0xe9, 0x3e, 0x6b, 0x57, 0x4e, 0x06, 0x89, 0xb6, 0x85, 0x6a,
+    0xd9, 0xcf, 0x54, 0x1e, 0xd6, 0xf5, 0x60, 0xea, 0x40, 0x7b, 0x80, 0x98,
+    0xd6, 0xa9, 0xad, 0x30, 0x03, 0x8b, 0xa5, 0x4e, 0x3a, 0x84, 0xe0, 0x31,
+    0xb7, 0x09, 0xc8, 0x05, 0x8c, 0x36, 0x95, 0x82, 0x81, 0x23, 0x25, 0x45,
+    0xff, 0x13, 0x7a, 0xdb, 0xc9, 0x8a, 0xdb, 0xc4, 0xb9, 0x1e, 0x5c, 0x9d,
+    0x52, 0x87, 0xbd, 0x49, 0x55, 0x97, 0x85, 0x0a, 0x92, 0x58, 0xed, 0xbc,
+    0xaf, 0xdd, 0xaa, 0x6e, 0x01, 0x5f, 0xf9, 0x93, 0x1c, 0x3f, 0x0d, 0xb1,
+    0xe6, 0xbb, 0x00, 0x14, 0x85, 0xa2, 0x2b, 0xc7, 0x5d, 0x4b, 0xc1, 0x61,
+    0xd1, 0xef, 0x9f, 0x28, 0x53, 0x80, 0xfd, 0xd2, 0x25, 0xe9, 0x51, 0x59,
+    0x8e, 0x75, 0xf5, 0xfd, 0x95, 0x29, 0xa5, 0xe7, 0x52, 0x74, 0xf9, 0xb9,
+    0x9e, 0xad, 0xb4, 0xa5, 0x8b, 0x58, 0xb8, 0xe8, 0x80, 0x99, 0xde, 0x3b,
+    0x32, 0x5e, 0x33, 0x16, 0xd6, 0xec, 0x36, 0x38, 0x5f, 0xd2, 0xd9, 0x39,
+    0x81, 0xf6, 0xf5, 0x19, 0x1a, 0x49, 0xd4, 0x67, 0xf5, 0x01, 0x60, 0x38,
+    0x40, 0x55, 0xb3, 0xea, 0xf6, 0x6a, 0xbe, 0x9e, 0x34, 0x9b, 0xcd, 0x34,
+    0x06, 0x4c, 0x2e, 0x0f, 0x2b, 0x1c, 0xe7, 0xeb, 0xe8, 0xaf, 0x6c, 0xdc,
+    0x27, 0xf5, 0x8e, 0xd2, 0x8f, 0x96, 0x76, 0xd7, 0x13, 0x05, 0x98, 0x5c,
+    0xb6, 0x9f, 0xa2, 0x3b, 0x06, 0xbb, 0xb5, 0x10, 0x33, 0xb9, 0x06, 0x03,
+    0xfb, 0xc5, 0xe8, 0xba, 0x8f, 0x70, 0x3e, 0x4f, 0x59, 0xae, 0xe3, 0x1b,
+    0xaf, 0x98, 0x1e, 0x12, 0x67, 0xe0, 0x84, 0x2e, 0x1e, 0xd9, 0x2d, 0x97,
+    0x00
+};
+
+#endif
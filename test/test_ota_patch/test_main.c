@@ -0,0 +1,156 @@
+// Patch decoder against tools/ota_patch.py (env:native): a delta built by
+// the host encoder (patch_fixture.h, from make_fixture.py) must decode to
+// the new image byte for byte, however the patch is split
+#include <unity.h>
+#include <string.h>
+#include "ota_patch.h"
+#include "patch_fixture.h"
+
+static uint8_t base_image[FIXTURE_BASE_SIZE];
+static uint8_t new_image[FIXTURE_NEW_SIZE];
+static uint8_t output[FIXTURE_NEW_SIZE];
+static size_t output_len;
+static ota_patch_t patch;
+
+// Same noise and edits as make_fixture.py
+static void noise(uint32_t seed, uint8_t *out, size_t len) {
+    uint32_t x = seed;
+    for (size_t i = 0; i < len; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        out[i] = (uint8_t)x;
+    }
+}
+
+static void build_images(void) {
+    noise(1, base_image, sizeof(base_image));
+    uint8_t *out = new_image;
+    memcpy(out, base_image, 1000);
+    out += 1000;
+    noise(2, out, 100);
+    out += 100;
+    for (size_t i = 0; i < 2000; i++) {
+        *out++ = base_image[1000 + i] + (i % 64 == 0 ? 4 : 0);
+    }
+    memcpy(out, &base_image[3200], FIXTURE_BASE_SIZE - 3200);
+    out += FIXTURE_BASE_SIZE - 3200;
+    noise(3, out, 300);
+}
+
+static bool read_base(void *ctx, uint32_t offset, uint8_t *out, size_t len) {
+    if (offset > sizeof(base_image) || len > sizeof(base_image) - offset) {
+        return false;
+    }
+    memcpy(out, &base_image[offset], len);
+    return true;
+}
+
+static bool write_output(void *ctx, const uint8_t *data, size_t len) {
+    if (len > sizeof(output) - output_len) {
+        return false;
+    }
+    memcpy(&output[output_len], data, len);
+    output_len += len;
+    return true;
+}
+
+// Feed the patch in chunks as ota.cpp does, going on after the header
+static ota_patch_result_t decode(const uint8_t *data, size_t len, size_t chunk) {
+    ota_patch_result_t result = OTA_PATCH_OK;
+    for (size_t start = 0; start < len && result == OTA_PATCH_OK; start += chunk) {
+        size_t end = len - start < chunk ? len : start + chunk;
+        size_t pos = start;
+        while (pos < end) {
+            size_t used;
+            result = ota_patch_feed(&patch, data + pos, end - pos, &used);
+            pos += used;
+            if (result == OTA_PATCH_HEADER) {
+                result = OTA_PATCH_OK;
+            } else if (result != OTA_PATCH_OK) {
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+void setUp(void) {
+    build_images();
+    memset(output, 0, sizeof(output));
+    output_len = 0;
+    ota_patch_init(&patch, read_base, write_output, NULL);
+}
+
+void tearDown(void) {
+}
+
+static void test_header(void) {
+    size_t used;
+    TEST_ASSERT_EQUAL(OTA_PATCH_HEADER, ota_patch_feed(&patch, fixture_patch, sizeof(fixture_patch), &used));
+    TEST_ASSERT_EQUAL(OTA_PATCH_HEADER_SIZE, used);
+    TEST_ASSERT_EQUAL_UINT8(OTA_PATCH_FLAG_DELTA, patch.header.flags);
+    TEST_ASSERT_EQUAL_UINT32(FIXTURE_NEW_SIZE, patch.header.new_size);
+    TEST_ASSERT_EQUAL_UINT32(FIXTURE_BASE_SIZE, patch.header.base_size);
+    TEST_ASSERT_EQUAL_MEMORY(&fixture_patch[OTA_PATCH_SIGNED_SIZE], patch.header.signature, OTA_PATCH_SIGNATURE_SIZE);
+    // The signed bytes stay available for the caller's check
+    TEST_ASSERT_EQUAL_MEMORY(fixture_patch, patch.header_bytes, OTA_PATCH_SIGNED_SIZE);
+}
+
+static void test_decode_whole(void) {
+    TEST_ASSERT_EQUAL(OTA_PATCH_DONE, decode(fixture_patch, sizeof(fixture_patch), sizeof(fixture_patch)));
+    TEST_ASSERT_EQUAL_UINT32(FIXTURE_NEW_SIZE, output_len);
+    TEST_ASSERT_EQUAL_MEMORY(new_image, output, FIXTURE_NEW_SIZE);
+}
+
+// Splits inside the header, varints and literal runs
+static void test_decode_split(void) {
+    const size_t chunks[] = {1, 7, 64, 1024};
+    for (size_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+        setUp();
+        TEST_ASSERT_EQUAL(OTA_PATCH_DONE, decode(fixture_patch, sizeof(fixture_patch), chunks[i]));
+        TEST_ASSERT_EQUAL_UINT32(FIXTURE_NEW_SIZE, output_len);
+        TEST_ASSERT_EQUAL_MEMORY(new_image, output, FIXTURE_NEW_SIZE);
+    }
+}
+
+static void test_truncated(void) {
+    TEST_ASSERT_EQUAL(OTA_PATCH_OK, decode(fixture_patch, sizeof(fixture_patch) - 1, 1024));
+    TEST_ASSERT_TRUE(output_len < FIXTURE_NEW_SIZE);
+}
+
+// Decoding stops at the end op; anything after it is refused
+static void test_trailing_bytes(void) {
+    const uint8_t extra = 0;
+    size_t used;
+    TEST_ASSERT_EQUAL(OTA_PATCH_DONE, decode(fixture_patch, sizeof(fixture_patch), sizeof(fixture_patch)));
+    TEST_ASSERT_EQUAL(OTA_PATCH_ERR_FORMAT, ota_patch_feed(&patch, &extra, 1, &used));
+}
+
+static void test_bad_header(void) {
+    static uint8_t copy[sizeof(fixture_patch)];
+    memcpy(copy, fixture_patch, sizeof(copy));
+    copy[4] = OTA_PATCH_VERSION - 1;
+    TEST_ASSERT_EQUAL(OTA_PATCH_ERR_HEADER, decode(copy, sizeof(copy), sizeof(copy)));
+}
+
+// A copy reaching past the base the header declares
+static void test_copy_out_of_range(void) {
+    static uint8_t copy[sizeof(fixture_patch)];
+    memcpy(copy, fixture_patch, sizeof(copy));
+    copy[10] = (uint8_t)(FIXTURE_BASE_SIZE / 2);
+    copy[11] = (uint8_t)((FIXTURE_BASE_SIZE / 2) >> 8);
+    TEST_ASSERT_EQUAL(OTA_PATCH_ERR_RANGE, decode(copy, sizeof(copy), sizeof(copy)));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_header);
+    RUN_TEST(test_decode_whole);
+    RUN_TEST(test_decode_split);
+    RUN_TEST(test_truncated);
+    RUN_TEST(test_trailing_bytes);
+    RUN_TEST(test_bad_header);
+    RUN_TEST(test_copy_out_of_range);
+    return UNITY_END();
+}
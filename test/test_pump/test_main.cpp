@@ -0,0 +1,195 @@
+// Pump pulses on mock esp_timer and relay pins (env:native_pump): pulse
+// width between the two edges under dispatch latency, early stops, and a
+// stop racing the on edge
+#include <unity.h>
+#include <esp_timer.h>
+#include "board.h"
+#include "pump.h"
+#include "logger.h"
+#include "outbox.h"
+#include "safety.h"
+#include "timer_wheel.h"
+
+using hal::Mock;
+
+// The rest of the firmware, as far as pump.cpp reaches into it
+void logWrite(uint8_t, const char*, ...) {}
+void publishEvent(const char*) {}
+bool safetyPumpAllowed(uint32_t) {
+    return true;
+}
+
+// The loop side runs when a test calls collect(), not on the wheel
+static TimerCallback doneCallback;
+
+TimerId timerCreate(const char*, TimerCallback callback) {
+    doneCallback = callback;
+    return 0;
+}
+void timerStart(TimerId, uint32_t, uint32_t) {}
+
+static void collect() {
+    doneCallback();
+}
+
+static PumpPulse lastPulse;
+static uint32_t pulsesDone;
+
+static void onPulseDone(const PumpPulse& pulse) {
+    lastPulse = pulse;
+    pulsesDone++;
+}
+
+static uint8_t relay() {
+    return Mock::levels()[Board::Pumps::pin(0)];
+}
+
+void setUp(void) {
+    Mock::reset();
+    MockTimer::reset();
+    memset(&lastPulse, 0, sizeof(lastPulse));
+    pulsesDone = 0;
+    initPump(onPulseDone);
+}
+
+void tearDown(void) {
+    // Leave no pulse running into the next test
+    pumpStop(0);
+    collect();
+}
+
+static void test_dose_time(void) {
+    // 25 mL at the default 1500 mL/min
+    TEST_ASSERT_EQUAL_UINT32(1000000, pumpDoseUs(0, 25));
+    TEST_ASSERT_FALSE(pumpStart(0, 0, PUMP_RUN_MANUAL));
+    TEST_ASSERT_FALSE(pumpStart(0, PUMP_MAX_DOSE_ML + 1, PUMP_RUN_MANUAL));
+    TEST_ASSERT_FALSE(pumpStart(PUMP_COUNT, 25, PUMP_RUN_MANUAL));
+}
+
+static void test_pulse_width(void) {
+    TEST_ASSERT_TRUE(pumpStart(0, 25, PUMP_RUN_AUTO));
+    TEST_ASSERT_FALSE(pumpStart(0, 25, PUMP_RUN_AUTO));
+
+    MockTimer::advance(PUMP_START_LEAD_US - 1);
+    TEST_ASSERT_EQUAL_UINT8(0, relay());
+    MockTimer::advance(1);
+    TEST_ASSERT_EQUAL_UINT8(1, relay());
+
+    MockTimer::advance(500000);
+    TEST_ASSERT_EQUAL_UINT8(1, relay());
+    TEST_ASSERT_EQUAL_UINT32(500, pumpRemainingMs(0));
+
+    MockTimer::advance(500000);
+    TEST_ASSERT_EQUAL_UINT8(0, relay());
+    collect();
+    TEST_ASSERT_EQUAL_UINT32(1, pulsesDone);
+    TEST_ASSERT_EQUAL_UINT32(1000000, lastPulse.requestedUs);
+    TEST_ASSERT_EQUAL_UINT32(1000000, lastPulse.actualUs);
+    TEST_ASSERT_EQUAL_INT32(0, lastPulse.widthErrorUs);
+    TEST_ASSERT_EQUAL_UINT32(25, lastPulse.volumeMl);
+    TEST_ASSERT_FALSE(pumpRunning(0));
+}
+
+// Each edge is dispatched up to 1 ms late on its own, as with a busy
+// esp_timer task; the width stays within the tolerance on every pulse
+static void test_pulse_width_under_load(void) {
+    MockTimer::setLatency(1000, 0x2545f491);
+    int32_t worst = 0;
+    for (uint32_t i = 0; i < 500; i++) {
+        uint32_t volumeMl = 1 + i % 50;
+        TEST_ASSERT_TRUE(pumpStart(0, volumeMl, PUMP_RUN_AUTO));
+        MockTimer::advance(PUMP_START_LEAD_US + pumpDoseUs(0, volumeMl) + 2000);
+        collect();
+        TEST_ASSERT_EQUAL_UINT8(0, relay());
+        TEST_ASSERT_EQUAL_UINT32(i + 1, pulsesDone);
+        TEST_ASSERT_INT32_WITHIN(PUMP_WIDTH_TOLERANCE_US, 0, lastPulse.widthErrorUs);
+        TEST_ASSERT_EQUAL_INT32((int32_t)(lastPulse.actualUs - lastPulse.requestedUs), lastPulse.widthErrorUs);
+        if (abs(lastPulse.widthErrorUs) > worst) {
+            worst = abs(lastPulse.widthErrorUs);
+        }
+    }
+    // The latency did reach the edges
+    TEST_ASSERT_TRUE(worst > 0);
+}
+
+// An off edge held back past the tolerance shows up in the reported error
+static void test_late_off_edge_reported(void) {
+    MockTimer::setLatency(1000, 7);
+    pumpStart(0, 25, PUMP_RUN_AUTO);
+    MockTimer::delay(MockTimer::find("pump_off"), PUMP_WIDTH_TOLERANCE_US * 3);
+    MockTimer::advance(PUMP_START_LEAD_US + 1000000 + 1000);
+    TEST_ASSERT_EQUAL_UINT8(1, relay());
+    MockTimer::advance(PUMP_WIDTH_TOLERANCE_US * 3);
+    TEST_ASSERT_EQUAL_UINT8(0, relay());
+    collect();
+    TEST_ASSERT_TRUE(lastPulse.widthErrorUs > PUMP_WIDTH_TOLERANCE_US);
+    TEST_ASSERT_INT32_WITHIN(1000, PUMP_WIDTH_TOLERANCE_US * 3, lastPulse.widthErrorUs);
+}
+
+static void test_stop_early(void) {
+    pumpStart(0, 25, PUMP_RUN_MANUAL);
+    MockTimer::advance(PUMP_START_LEAD_US + 300000);
+    pumpStop(0);
+    TEST_ASSERT_EQUAL_UINT8(0, relay());
+
+    // The off edge was cancelled with the pulse
+    MockTimer::advance(2000000);
+    collect();
+    TEST_ASSERT_EQUAL_UINT32(1, pulsesDone);
+    TEST_ASSERT_EQUAL_UINT32(300000, lastPulse.actualUs);
+    TEST_ASSERT_EQUAL_INT32(300000 - 1000000, lastPulse.widthErrorUs);
+}
+
+// An on edge dispatched before pumpStop() runs after it: the relay stays
+// off and the pulse is reported as never started
+static void test_stop_races_on_edge(void) {
+    pumpStart(0, 25, PUMP_RUN_AUTO);
+    MockTimer::advance(PUMP_START_LEAD_US / 2);
+    pumpStop(0);
+    MockTimer::fire(MockTimer::find("pump_on"));
+    TEST_ASSERT_EQUAL_UINT8(0, relay());
+
+    MockTimer::advance(2000000);
+    TEST_ASSERT_EQUAL_UINT8(0, relay());
+    collect();
+    TEST_ASSERT_EQUAL_UINT32(1, pulsesDone);
+    TEST_ASSERT_EQUAL_UINT32(0, lastPulse.actualUs);
+}
+
+// The same with the off edge: a late one does not move the recorded stop
+static void test_stop_races_off_edge(void) {
+    pumpStart(0, 25, PUMP_RUN_AUTO);
+    MockTimer::advance(PUMP_START_LEAD_US + 400000);
+    pumpStop(0);
+    MockTimer::advance(100000);
+    MockTimer::fire(MockTimer::find("pump_off"));
+    collect();
+    TEST_ASSERT_EQUAL_UINT32(400000, lastPulse.actualUs);
+}
+
+static void test_next_pulse_after_stop(void) {
+    pumpStart(0, 25, PUMP_RUN_AUTO);
+    MockTimer::advance(PUMP_START_LEAD_US / 2);
+    pumpStop(0);
+    collect();
+
+    TEST_ASSERT_TRUE(pumpStart(0, 50, PUMP_RUN_AUTO));
+    MockTimer::advance(PUMP_START_LEAD_US + 2000000);
+    TEST_ASSERT_EQUAL_UINT8(0, relay());
+    collect();
+    TEST_ASSERT_EQUAL_UINT32(2, pulsesDone);
+    TEST_ASSERT_EQUAL_UINT32(2000000, lastPulse.actualUs);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_dose_time);
+    RUN_TEST(test_pulse_width);
+    RUN_TEST(test_pulse_width_under_load);
+    RUN_TEST(test_late_off_edge_reported);
+    RUN_TEST(test_stop_early);
+    RUN_TEST(test_stop_races_on_edge);
+    RUN_TEST(test_stop_races_off_edge);
+    RUN_TEST(test_next_pulse_after_stop);
+    return UNITY_END();
+}
@@ -0,0 +1,97 @@
+"""Writes rules_fixture.h for the rule VM test: the README's example rules
+compiled by tools/rule_compiler.py, plus one reaching the opcodes they do
+not use, with what the compiler's own loader and evaluator make of them.
+The cases are the README's eval example, edits of it around each
+threshold, and seeded random channel values, so the device evaluator is
+checked against the host one.
+
+    python test/test_rule_vm/make_fixture.py
+"""
+import os
+import random
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "..", "..", "tools"))
+import rule_compiler  # noqa: E402
+
+RULES = """\
+if humidity > 80 and temp < 18 then disable pump for 2 h
+at 07:00 if soil < 40 then water 50 ml
+if soil_raw < 100 or fault then alert
+if not pump_enabled and soil_raw - 40000 < soil + 100 - 50000 then enable pump
+"""
+
+EXAMPLE = "temp=17 humidity=85 soil=35 time=07:00 soil_raw=2000 pump_enabled=1 fault=0".split()
+EDITS = ["temp=18", "temp=17.99", "humidity=80", "humidity=80.01", "soil=40", "soil=39", "time=07:01",
+         "time=06:59", "soil_raw=99", "soil_raw=100", "fault=1", "pump_enabled=0", "soil_raw=0 pump_enabled=0"]
+RANDOM_CASES = 48
+
+
+def cases():
+    result = [rule_compiler.parse_values(EXAMPLE)[0]]
+    for edit in EDITS:
+        values = dict(v.split("=") for v in EXAMPLE)
+        values.update(v.split("=") for v in edit.split())
+        result.append(rule_compiler.parse_values(f"{k}={v}" for k, v in values.items())[0])
+    rng = random.Random(50)
+    for _ in range(RANDOM_CASES):
+        result.append([rng.randint(1000, 3000), rng.randint(6000, 9500), rng.randint(30, 50),
+                       rng.choice([0, 99, 100, 4095, -60000]), rng.choice([419, 420, 421]),
+                       rng.randint(0, 1), rng.randint(0, 1)])
+    return result
+
+
+def c_array(values):
+    return "{" + ", ".join(str(v) for v in values) + "}"
+
+
+def main():
+    blob = rule_compiler.compile_rules(RULES)
+    rules = rule_compiler.load(blob)
+    rows = ",\n".join("    " + ", ".join(f"0x{b:02x}" for b in blob[i:i + 12]) for i in range(0, len(blob), 12))
+    expected = ",\n".join(f"    {{{rule_id}, {action}, {arg}, 0x{inputs:02x}}}"
+                          for rule_id, action, arg, inputs, _ in rules)
+    table = ",\n".join(f"    {{{c_array(channels)}, {c_array(int(rule_compiler.evaluate(r[4], channels)) for r in rules)}}}"
+                       for channels in cases())
+
+    path = os.path.join(os.path.dirname(__file__), "rules_fixture.h")
+    with open(path, "w", encoding="utf-8") as f:
+        f.write(f"""#ifndef RULES_FIXTURE_H
+#define RULES_FIXTURE_H
+
+// Generated by test/test_rule_vm/make_fixture.py; do not edit
+
+#include "rule_vm.h"
+
+#define FIXTURE_RULES {len(rules)}
+
+static const uint8_t fixture_rules[{len(blob)}] = {{
+{rows}
+}};
+
+// As the compiler's loader reads them
+static const struct {{
+    uint8_t id;
+    uint8_t action;
+    uint16_t arg;
+    uint16_t inputs;
+}} fixture_expected[FIXTURE_RULES] = {{
+{expected}
+}};
+
+// Channel values and what the compiler's evaluator gives for each rule;
+// the first is the README's eval example
+static const struct {{
+    int32_t channels[RULE_CHANNELS];
+    uint8_t holds[FIXTURE_RULES];
+}} fixture_cases[] = {{
+{table}
+}};
+
+#endif
+""")
+    print(f"{path}: {len(blob)} byte rule set, {len(rules)} rules, {len(cases())} cases")
+
+
+if __name__ == "__main__":
+    main()
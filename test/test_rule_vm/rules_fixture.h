@@ -0,0 +1,103 @@
+#ifndef RULES_FIXTURE_H
+#define RULES_FIXTURE_H
+
+// Generated by test/test_rule_vm/make_fixture.py; do not edit
+
+#include "rule_vm.h"
+
+#define FIXTURE_RULES 4
+
+static const uint8_t fixture_rules[81] = {
+    0x47, 0x52, 0x01, 0x04, 0x01, 0x02, 0x78, 0x00, 0x0d, 0x01, 0x01, 0x03,
+    0x40, 0x1f, 0x12, 0x01, 0x00, 0x03, 0x08, 0x07, 0x10, 0x20, 0x02, 0x01,
+    0x32, 0x00, 0x0c, 0x01, 0x04, 0x03, 0xa4, 0x01, 0x14, 0x01, 0x02, 0x02,
+    0x28, 0x10, 0x20, 0x03, 0x00, 0x00, 0x00, 0x08, 0x01, 0x03, 0x02, 0x64,
+    0x10, 0x01, 0x06, 0x21, 0x04, 0x03, 0x00, 0x00, 0x18, 0x01, 0x05, 0x22,
+    0x01, 0x03, 0x04, 0x40, 0x9c, 0x00, 0x00, 0x31, 0x01, 0x02, 0x02, 0x64,
+    0x30, 0x04, 0x50, 0xc3, 0x00, 0x00, 0x31, 0x10, 0x20
+};
+
+// As the compiler's loader reads them
+static const struct {
+    uint8_t id;
+    uint8_t action;
+    uint16_t arg;
+    uint16_t inputs;
+} fixture_expected[FIXTURE_RULES] = {
+    {1, 2, 120, 0x03},
+    {2, 1, 50, 0x14},
+    {3, 0, 0, 0x48},
+    {4, 3, 0, 0x2c}
+};
+
+// Channel values and what the compiler's evaluator gives for each rule;
+// the first is the README's eval example
+static const struct {
+    int32_t channels[RULE_CHANNELS];
+    uint8_t holds[FIXTURE_RULES];
+} fixture_cases[] = {
+    {{1700, 8500, 35, 2000, 420, 1, 0}, {1, 1, 0, 0}},
+    {{1800, 8500, 35, 2000, 420, 1, 0}, {0, 1, 0, 0}},
+    {{1799, 8500, 35, 2000, 420, 1, 0}, {1, 1, 0, 0}},
+    {{1700, 8000, 35, 2000, 420, 1, 0}, {0, 1, 0, 0}},
+    {{1700, 8001, 35, 2000, 420, 1, 0}, {1, 1, 0, 0}},
+    {{1700, 8500, 40, 2000, 420, 1, 0}, {1, 0, 0, 0}},
+    {{1700, 8500, 39, 2000, 420, 1, 0}, {1, 1, 0, 0}},
+    {{1700, 8500, 35, 2000, 421, 1, 0}, {1, 0, 0, 0}},
+    {{1700, 8500, 35, 2000, 419, 1, 0}, {1, 0, 0, 0}},
+    {{1700, 8500, 35, 99, 420, 1, 0}, {1, 1, 1, 0}},
+    {{1700, 8500, 35, 100, 420, 1, 0}, {1, 1, 0, 0}},
+    {{1700, 8500, 35, 2000, 420, 1, 1}, {1, 1, 1, 0}},
+    {{1700, 8500, 35, 2000, 420, 0, 0}, {1, 1, 0, 0}},
+    {{1700, 8500, 35, 0, 420, 0, 0}, {1, 1, 1, 0}},
+    {{2018, 7090, 41, 99, 421, 1, 1}, {0, 0, 1, 0}},
+    {{1174, 8205, 40, 99, 421, 0, 0}, {1, 0, 1, 0}},
+    {{1711, 9380, 33, 100, 420, 0, 0}, {1, 1, 0, 0}},
+    {{1140, 7347, 49, -60000, 420, 0, 0}, {0, 0, 1, 1}},
+    {{2419, 8473, 40, 4095, 419, 0, 1}, {0, 0, 1, 0}},
+    {{1545, 9271, 43, 0, 419, 1, 1}, {1, 0, 1, 0}},
+    {{2855, 8836, 48, 4095, 419, 1, 0}, {0, 0, 0, 0}},
+    {{2093, 8371, 33, 4095, 421, 0, 1}, {0, 0, 1, 0}},
+    {{1874, 8119, 47, 99, 420, 1, 0}, {0, 0, 1, 0}},
+    {{2756, 7506, 46, 99, 419, 1, 0}, {0, 0, 1, 0}},
+    {{2852, 8404, 43, 4095, 421, 0, 0}, {0, 0, 0, 0}},
+    {{2486, 8346, 33, 99, 420, 1, 0}, {0, 1, 1, 0}},
+    {{1688, 6137, 50, -60000, 419, 0, 0}, {0, 0, 1, 1}},
+    {{2397, 7073, 46, 4095, 420, 1, 1}, {0, 0, 1, 0}},
+    {{1962, 6364, 42, 0, 420, 0, 0}, {0, 0, 1, 0}},
+    {{1138, 7816, 50, -60000, 419, 1, 1}, {0, 0, 1, 0}},
+    {{2751, 7420, 47, -60000, 420, 0, 1}, {0, 0, 1, 1}},
+    {{1327, 7760, 36, 0, 421, 0, 0}, {0, 0, 1, 0}},
+    {{1326, 6541, 31, 99, 419, 1, 1}, {0, 0, 1, 0}},
+    {{1032, 6732, 46, 0, 419, 1, 0}, {0, 0, 1, 0}},
+    {{1304, 8023, 42, 4095, 420, 0, 0}, {1, 0, 0, 0}},
+    {{2751, 6109, 46, -60000, 420, 1, 1}, {0, 0, 1, 0}},
+    {{1667, 6182, 34, -60000, 420, 1, 0}, {0, 1, 1, 0}},
+    {{2653, 6466, 40, 4095, 421, 1, 0}, {0, 0, 0, 0}},
+    {{1203, 8292, 32, 0, 419, 1, 1}, {1, 0, 1, 0}},
+    {{2779, 7907, 38, 100, 421, 0, 1}, {0, 0, 1, 0}},
+    {{2702, 6919, 48, 99, 419, 1, 0}, {0, 0, 1, 0}},
+    {{1100, 8300, 45, 99, 419, 0, 1}, {1, 0, 1, 0}},
+    {{2483, 7556, 30, 100, 421, 0, 0}, {0, 0, 0, 0}},
+    {{2365, 7786, 37, 4095, 420, 0, 1}, {0, 1, 1, 0}},
+    {{2012, 6481, 35, 99, 420, 0, 0}, {0, 1, 1, 0}},
+    {{1473, 6787, 45, 100, 421, 1, 0}, {0, 0, 0, 0}},
+    {{1442, 6156, 41, 0, 419, 0, 0}, {0, 0, 1, 0}},
+    {{1298, 6439, 44, 0, 420, 1, 0}, {0, 0, 1, 0}},
+    {{1350, 7478, 42, -60000, 419, 0, 0}, {0, 0, 1, 1}},
+    {{2828, 9127, 41, 4095, 421, 0, 0}, {0, 0, 0, 0}},
+    {{1773, 7950, 49, 100, 420, 0, 1}, {0, 0, 1, 0}},
+    {{1944, 7009, 44, -60000, 421, 0, 0}, {0, 0, 1, 1}},
+    {{2931, 6994, 34, -60000, 419, 1, 1}, {0, 0, 1, 0}},
+    {{2655, 7225, 46, -60000, 420, 1, 0}, {0, 0, 1, 0}},
+    {{2212, 6561, 31, -60000, 419, 1, 1}, {0, 0, 1, 0}},
+    {{1560, 7382, 41, 100, 420, 1, 1}, {0, 0, 1, 0}},
+    {{2896, 7942, 34, 0, 419, 1, 1}, {0, 0, 1, 0}},
+    {{1835, 7940, 47, 0, 420, 0, 0}, {0, 0, 1, 0}},
+    {{2290, 8352, 39, 4095, 421, 1, 0}, {0, 0, 0, 0}},
+    {{1683, 7005, 35, 99, 421, 1, 0}, {0, 0, 1, 0}},
+    {{2594, 8749, 41, 99, 419, 1, 1}, {0, 0, 1, 0}},
+    {{1687, 8158, 49, 100, 420, 1, 1}, {1, 0, 1, 0}}
+};
+
+#endif
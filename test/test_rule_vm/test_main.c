@@ -0,0 +1,185 @@
+// Rule loader and evaluator against tools/rule_compiler.py (env:native):
+// the compiler's output loads and evaluates as the compiler says, and
+// malformed rule sets from the network are refused
+#include <unity.h>
+#include <string.h>
+#include "rule_vm.h"
+#include "rules_fixture.h"
+
+static rule_set_t set;
+static uint8_t blob[RULE_SET_MAX + 8];
+
+// A set of one rule with the given code
+static size_t one_rule(uint8_t action, const uint8_t *code, size_t len) {
+    const uint8_t header[] = {'G', 'R', RULE_SET_VERSION, 1, 7, action, 0, 0, (uint8_t)len};
+    memcpy(blob, header, sizeof(header));
+    memcpy(&blob[sizeof(header)], code, len);
+    return sizeof(header) + len;
+}
+
+static rule_result_t load_code(const uint8_t *code, size_t len) {
+    return rule_set_load(&set, blob, one_rule(RULE_ACTION_ALERT, code, len));
+}
+
+void setUp(void) {
+    memset(&set, 0, sizeof(set));
+}
+
+void tearDown(void) {
+}
+
+static void test_load_compiled(void) {
+    TEST_ASSERT_EQUAL(RULE_OK, rule_set_load(&set, fixture_rules, sizeof(fixture_rules)));
+    TEST_ASSERT_EQUAL_UINT8(FIXTURE_RULES, set.count);
+    for (uint8_t i = 0; i < FIXTURE_RULES; i++) {
+        TEST_ASSERT_EQUAL_UINT8(fixture_expected[i].id, set.rules[i].id);
+        TEST_ASSERT_EQUAL_UINT8(fixture_expected[i].action, set.rules[i].action);
+        TEST_ASSERT_EQUAL_UINT16(fixture_expected[i].arg, set.rules[i].arg);
+    }
+    // "disable pump for 2 h", "water 50 ml"
+    TEST_ASSERT_EQUAL_UINT8(RULE_ACTION_PUMP_DISABLE, set.rules[0].action);
+    TEST_ASSERT_EQUAL_UINT16(120, set.rules[0].arg);
+    TEST_ASSERT_EQUAL_UINT8(RULE_ACTION_WATER, set.rules[1].action);
+    TEST_ASSERT_EQUAL_UINT16(50, set.rules[1].arg);
+}
+
+// Only the channels a rule reads are in its mask, the same as the compiler's
+static void test_inputs_mask(void) {
+    rule_set_load(&set, fixture_rules, sizeof(fixture_rules));
+    for (uint8_t i = 0; i < FIXTURE_RULES; i++) {
+        TEST_ASSERT_EQUAL_HEX16(fixture_expected[i].inputs, set.rules[i].inputs);
+    }
+    TEST_ASSERT_EQUAL_HEX16((1u << RULE_CH_HUMIDITY) | (1u << RULE_CH_TEMP), set.rules[0].inputs);
+    TEST_ASSERT_EQUAL_HEX16((1u << RULE_CH_TIME) | (1u << RULE_CH_SOIL), set.rules[1].inputs);
+
+    // A channel read twice is one bit
+    const uint8_t twice[] = {0x01, RULE_CH_SOIL, 0x01, RULE_CH_SOIL, 0x10};
+    TEST_ASSERT_EQUAL(RULE_OK, load_code(twice, sizeof(twice)));
+    TEST_ASSERT_EQUAL_HEX16(1u << RULE_CH_SOIL, set.rules[0].inputs);
+}
+
+static void test_eval_matches_compiler(void) {
+    rule_set_load(&set, fixture_rules, sizeof(fixture_rules));
+    for (size_t c = 0; c < sizeof(fixture_cases) / sizeof(fixture_cases[0]); c++) {
+        for (uint8_t i = 0; i < FIXTURE_RULES; i++) {
+            if (rule_eval(&set.rules[i], fixture_cases[c].channels) != (fixture_cases[c].holds[i] != 0)) {
+                char message[48];
+                snprintf(message, sizeof(message), "case %u, rule %u", (unsigned)c, (unsigned)i + 1);
+                TEST_FAIL_MESSAGE(message);
+            }
+        }
+    }
+}
+
+// The README example: temp=17 humidity=85 soil=35 time=07:00
+static void test_eval_readme_example(void) {
+    rule_set_load(&set, fixture_rules, sizeof(fixture_rules));
+    int32_t channels[RULE_CHANNELS] = {1700, 8500, 35, 2000, 7 * 60, 1, 0};
+    TEST_ASSERT_TRUE(rule_eval(&set.rules[0], channels));
+    TEST_ASSERT_TRUE(rule_eval(&set.rules[1], channels));
+    TEST_ASSERT_FALSE(rule_eval(&set.rules[2], channels));
+    channels[RULE_CH_FAULT] = 1;
+    TEST_ASSERT_TRUE(rule_eval(&set.rules[2], channels));
+}
+
+static void test_truncated(void) {
+    for (size_t len = 0; len < sizeof(fixture_rules); len++) {
+        rule_result_t result = rule_set_load(&set, fixture_rules, len);
+        TEST_ASSERT_TRUE(result == RULE_ERR_HEADER || result == RULE_ERR_LENGTH);
+        TEST_ASSERT_EQUAL_UINT8(0, set.count);
+    }
+    // Cut inside an operand
+    const uint8_t operand[] = {0x03, 0x10};
+    TEST_ASSERT_EQUAL(RULE_ERR_LENGTH, load_code(operand, sizeof(operand)));
+}
+
+static void test_trailing_bytes(void) {
+    memcpy(blob, fixture_rules, sizeof(fixture_rules));
+    blob[sizeof(fixture_rules)] = 0x22;
+    TEST_ASSERT_EQUAL(RULE_ERR_LENGTH, rule_set_load(&set, blob, sizeof(fixture_rules) + 1));
+    TEST_ASSERT_EQUAL_UINT8(0, set.count);
+}
+
+static void test_stack_bounds(void) {
+    const uint8_t underflow[] = {0x02, 1, 0x10};
+    TEST_ASSERT_EQUAL(RULE_ERR_STACK, load_code(underflow, sizeof(underflow)));
+    const uint8_t empty_not[] = {0x22};
+    TEST_ASSERT_EQUAL(RULE_ERR_STACK, load_code(empty_not, sizeof(empty_not)));
+    const uint8_t two_left[] = {0x02, 1, 0x02, 2};
+    TEST_ASSERT_EQUAL(RULE_ERR_STACK, load_code(two_left, sizeof(two_left)));
+
+    // RULE_STACK_MAX pushes fit, one more does not
+    uint8_t code[2 * (RULE_STACK_MAX + 1) + RULE_STACK_MAX];
+    size_t len = 0;
+    for (int i = 0; i < RULE_STACK_MAX; i++) {
+        code[len++] = 0x02;
+        code[len++] = (uint8_t)i;
+    }
+    for (int i = 0; i < RULE_STACK_MAX - 1; i++) {
+        code[len++] = 0x30;
+    }
+    TEST_ASSERT_EQUAL(RULE_OK, load_code(code, len));
+    int32_t channels[RULE_CHANNELS] = {0};
+    TEST_ASSERT_TRUE(rule_eval(&set.rules[0], channels));
+
+    len = 0;
+    for (int i = 0; i <= RULE_STACK_MAX; i++) {
+        code[len++] = 0x02;
+        code[len++] = (uint8_t)i;
+    }
+    for (int i = 0; i < RULE_STACK_MAX; i++) {
+        code[len++] = 0x30;
+    }
+    TEST_ASSERT_EQUAL(RULE_ERR_STACK, load_code(code, len));
+}
+
+static void test_bad_channel_and_opcode(void) {
+    const uint8_t channel[] = {0x01, RULE_CHANNELS};
+    TEST_ASSERT_EQUAL(RULE_ERR_CHANNEL, load_code(channel, sizeof(channel)));
+    const uint8_t opcode[] = {0x02, 1, 0x23};
+    TEST_ASSERT_EQUAL(RULE_ERR_OPCODE, load_code(opcode, sizeof(opcode)));
+    const uint8_t zero[] = {0x00};
+    TEST_ASSERT_EQUAL(RULE_ERR_OPCODE, load_code(zero, sizeof(zero)));
+}
+
+static void test_bad_headers(void) {
+    const uint8_t code[] = {0x02, 1};
+    size_t len = one_rule(RULE_ACTIONS, code, sizeof(code));
+    TEST_ASSERT_EQUAL(RULE_ERR_ACTION, rule_set_load(&set, blob, len));
+
+    len = one_rule(RULE_ACTION_ALERT, code, sizeof(code));
+    blob[2] = RULE_SET_VERSION + 1;
+    TEST_ASSERT_EQUAL(RULE_ERR_HEADER, rule_set_load(&set, blob, len));
+    blob[2] = RULE_SET_VERSION;
+    blob[3] = RULES_MAX + 1;
+    TEST_ASSERT_EQUAL(RULE_ERR_COUNT, rule_set_load(&set, blob, len));
+
+    // Code length 0, and one past RULE_CODE_MAX
+    len = one_rule(RULE_ACTION_ALERT, code, 0);
+    TEST_ASSERT_EQUAL(RULE_ERR_LENGTH, rule_set_load(&set, blob, len));
+    uint8_t longest[RULE_CODE_MAX + 1];
+    memset(longest, 0x22, sizeof(longest));
+    longest[0] = 0x02;
+    longest[1] = 1;
+    TEST_ASSERT_EQUAL(RULE_OK, load_code(longest, RULE_CODE_MAX));
+    TEST_ASSERT_EQUAL(RULE_ERR_LENGTH, load_code(longest, RULE_CODE_MAX + 1));
+
+    // An empty set clears the rules
+    const uint8_t none[] = {'G', 'R', RULE_SET_VERSION, 0};
+    TEST_ASSERT_EQUAL(RULE_OK, rule_set_load(&set, none, sizeof(none)));
+    TEST_ASSERT_EQUAL_UINT8(0, set.count);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_load_compiled);
+    RUN_TEST(test_inputs_mask);
+    RUN_TEST(test_eval_matches_compiler);
+    RUN_TEST(test_eval_readme_example);
+    RUN_TEST(test_truncated);
+    RUN_TEST(test_trailing_bytes);
+    RUN_TEST(test_stack_bounds);
+    RUN_TEST(test_bad_channel_and_opcode);
+    RUN_TEST(test_bad_headers);
+    return UNITY_END();
+}
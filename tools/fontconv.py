@@ -0,0 +1,260 @@
+"""Converts an Adafruit GFX font header into an oled_font.h glyph atlas.
+
+Glyph bitmaps are trimmed to their inked bounding box, stored column-major
+(the order the SSD1306 pages want them) and bit-packed into one stream, with
+identical bitmaps shared. Codepoints are taken from the glyph table comments
+(/* 0xB0 degree */), so the extended Latin-1 and symbol glyphs keep their
+Unicode values even though GFXfont.first/last only cover ASCII.
+
+    python tools/fontconv.py src/fonts/TomThumb.h --extended \\
+        --name TomThumbAtlas --out-dir src/fonts
+
+Prints the flash cost of the atlas next to the GFX original and the
+uncompressed page-column equivalent, plus the RAM taken by the glyph cache.
+"""
+import argparse
+import os
+import re
+import sys
+
+# Keep in sync with oled_font.h
+GLYPH_MAX_WIDTH = 12
+GLYPH_MAX_HEIGHT = 15
+GLYPH_CACHE_SIZE = 16
+
+# ESP32 struct sizes
+SIZEOF_ATLAS_GLYPH = 6      # oled_glyph_t
+SIZEOF_ATLAS_RANGE = 6      # oled_glyph_range_t
+SIZEOF_ATLAS_FONT = 20      # oled_font_t
+SIZEOF_CACHE_ENTRY = 4 + 4 + 2 * GLYPH_MAX_WIDTH
+SIZEOF_GFX_GLYPH = 8        # GFXglyph
+SIZEOF_GFX_FONT = 12        # GFXfont
+
+GLYPH_RE = re.compile(
+    r"\{\s*(-?\w+)\s*,\s*(-?\w+)\s*,\s*(-?\w+)\s*,\s*(-?\w+)\s*,\s*(-?\w+)\s*,\s*(-?\w+)\s*\}\s*,?"
+    r"[ \t]*(?:/\*\s*(0x[0-9A-Fa-f]+)?\s*([^*]*?)\s*\*/)?"
+)
+
+
+def preprocess(text, extended):
+    """Drop the lines inside #if blocks that are switched off."""
+    lines = []
+    stack = []
+    for line in text.splitlines():
+        stripped = line.strip()
+        if stripped.startswith("#if"):
+            stack.append(extended if "USE_EXTENDED" in stripped else True)
+        elif stripped.startswith("#else"):
+            stack[-1] = not stack[-1]
+        elif stripped.startswith("#endif"):
+            stack.pop()
+        elif stripped.startswith("#"):
+            continue
+        elif all(stack):
+            lines.append(line)
+    return "\n".join(lines)
+
+
+def strip_comments(text):
+    return re.sub(r"//[^\n]*", "", re.sub(r"/\*.*?\*/", "", text, flags=re.S))
+
+
+def parse_gfx_font(path, extended):
+    text = preprocess(open(path, encoding="utf-8").read(), extended)
+
+    match = re.search(r"const\s+uint8_t\s+\w+\[\]\s*(?:PROGMEM)?\s*=\s*\{(.*?)\};", text, re.S)
+    if not match:
+        sys.exit(f"{path}: no bitmap array")
+    bitmap = [int(v, 16) for v in re.findall(r"0x[0-9A-Fa-f]+", strip_comments(match.group(1)))]
+
+    match = re.search(r"const\s+GFXglyph\s+\w+\[\]\s*(?:PROGMEM)?\s*=\s*\{(.*?)^\};", text, re.S | re.M)
+    if not match:
+        sys.exit(f"{path}: no glyph array")
+    glyph_rows = GLYPH_RE.findall(match.group(1))
+
+    match = re.search(r"const\s+GFXfont\s+(\w+)\s*(?:PROGMEM)?\s*=\s*\{(.*?)\};", text, re.S)
+    if not match:
+        sys.exit(f"{path}: no GFXfont")
+    fields = [f.strip() for f in strip_comments(match.group(2)).split(",")]
+    first, _last, y_advance = (int(f, 0) for f in fields[-3:])
+
+    glyphs = []
+    for index, row in enumerate(glyph_rows):
+        offset, width, height, x_advance, x_offset, y_offset = (int(v, 0) for v in row[:6])
+        codepoint = int(row[6], 16) if row[6] else first + index
+        glyphs.append({
+            "codepoint": codepoint,
+            "name": row[7],
+            "width": width,
+            "height": height,
+            "x_advance": x_advance,
+            "x_offset": x_offset,
+            "y_offset": y_offset,
+            "pixels": gfx_pixels(bitmap, offset, width, height),
+        })
+    return match.group(1), bitmap, glyphs, y_advance
+
+
+def gfx_pixels(bitmap, offset, width, height):
+    """Inked pixels of a GFX glyph (row-major bits, MSB first)."""
+    pixels = set()
+    for i in range(width * height):
+        bit = offset * 8 + i
+        if bitmap[bit >> 3] & (0x80 >> (bit & 7)):
+            pixels.add((i % width, i // width))
+    return pixels
+
+
+def build_atlas(glyphs):
+    bits = []
+    shared = {}
+    entries = []
+    page_column_bytes = 0
+
+    for glyph in sorted(glyphs, key=lambda g: g["codepoint"]):
+        pixels = glyph["pixels"]
+        if pixels:
+            x0 = min(x for x, _ in pixels)
+            y0 = min(y for _, y in pixels)
+            width = max(x for x, _ in pixels) - x0 + 1
+            height = max(y for _, y in pixels) - y0 + 1
+        else:
+            x0 = y0 = width = height = 0
+
+        if width > GLYPH_MAX_WIDTH or height > GLYPH_MAX_HEIGHT:
+            sys.exit(f"glyph U+{glyph['codepoint']:04X} is {width}x{height}, "
+                     f"larger than {GLYPH_MAX_WIDTH}x{GLYPH_MAX_HEIGHT}")
+
+        column_major = tuple(1 if (x0 + c, y0 + r) in pixels else 0
+                             for c in range(width) for r in range(height))
+        key = (width, height, column_major)
+        if key not in shared:
+            shared[key] = len(bits)
+            bits.extend(column_major)
+
+        entries.append({
+            **glyph,
+            "bit_offset": shared[key],
+            "width": width,
+            "height": height,
+            "x_offset": glyph["x_offset"] + x0,
+            "y_offset": glyph["y_offset"] + y0,
+        })
+        page_column_bytes += width * ((height + 7) // 8)
+
+    codepoints = [e["codepoint"] for e in entries]
+    if len(set(codepoints)) != len(codepoints):
+        sys.exit("duplicate codepoints in glyph table")
+    if len(bits) >= 1 << 16:
+        sys.exit(f"atlas bitmap is {len(bits)} bits; bit offsets are 16-bit")
+
+    packed = bytearray((len(bits) + 7) // 8)
+    for i, bit in enumerate(bits):
+        if bit:
+            packed[i >> 3] |= 0x80 >> (i & 7)
+    return entries, bytes(packed), page_column_bytes
+
+
+def codepoint_ranges(entries):
+    """(first codepoint, count, first glyph index) runs."""
+    ranges = []
+    for index, entry in enumerate(entries):
+        codepoint = entry["codepoint"]
+        if ranges and ranges[-1][0] + ranges[-1][1] == codepoint:
+            ranges[-1][1] += 1
+        else:
+            ranges.append([codepoint, 1, index])
+    return ranges
+
+
+def fallback_index(entries):
+    for codepoint in (0xFFFD, ord("?")):
+        for index, entry in enumerate(entries):
+            if entry["codepoint"] == codepoint:
+                return index
+    return 0
+
+
+def write_atlas(name, source, entries, ranges, packed, y_advance, out_dir):
+    inked = [e for e in entries if e["width"]]
+    ascent = max([-e["y_offset"] for e in inked] + [0])
+    guard = re.sub(r"(?<=[a-z])(?=[A-Z])", "_", name).upper() + "_H"
+
+    with open(os.path.join(out_dir, name + ".h"), "w", encoding="utf-8") as f:
+        f.write(f"""#ifndef {guard}
+#define {guard}
+
+// Generated by tools/fontconv.py from {source}; do not edit
+
+#include "../oled_font.h"
+
+#ifdef __cplusplus
+extern "C" {{
+#endif
+
+extern const oled_font_t {name};
+
+#ifdef __cplusplus
+}}
+#endif
+
+#endif
+""")
+
+    with open(os.path.join(out_dir, name + ".c"), "w", encoding="utf-8") as f:
+        f.write(f"// Generated by tools/fontconv.py from {source}; do not edit\n\n")
+        f.write(f'#include "{name}.h"\n\n')
+        f.write(f"static const uint8_t {name}Bitmap[] = {{\n")
+        for i in range(0, len(packed), 12):
+            f.write("    " + ", ".join(f"0x{b:02X}" for b in packed[i:i + 12]) + ",\n")
+        f.write("};\n\n")
+        f.write("/* {bit offset, width << 4 | height, advance, x offset, y offset} */\n")
+        f.write(f"static const oled_glyph_t {name}Glyphs[] = {{\n")
+        for e in entries:
+            row = (f"{{{e['bit_offset']}, 0x{e['width']:X}{e['height']:X}, "
+                   f"{e['x_advance']}, {e['x_offset']}, {e['y_offset']}}},")
+            f.write(f"    {row:<28} /* 0x{e['codepoint']:04X} {e['name']} */\n")
+        f.write("};\n\n")
+        f.write("/* {first codepoint, count, first glyph} */\n")
+        f.write(f"static const oled_glyph_range_t {name}Ranges[] = {{\n")
+        for first, count, glyph in ranges:
+            f.write(f"    {{0x{first:04X}, {count}, {glyph}}},\n")
+        f.write("};\n\n")
+        f.write(f"const oled_font_t {name} = {{\n"
+                f"    {name}Bitmap, {name}Glyphs, {name}Ranges, {len(ranges)}, "
+                f"{fallback_index(entries)}, {ascent}, {y_advance}\n}};\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("font", help="Adafruit GFX font header")
+    parser.add_argument("--name", required=True, help="C symbol and file name of the atlas")
+    parser.add_argument("--out-dir", help="write <name>.c/.h here (report only if omitted)")
+    parser.add_argument("--extended", action="store_true", help="include *_USE_EXTENDED glyphs")
+    args = parser.parse_args()
+
+    gfx_name, bitmap, glyphs, y_advance = parse_gfx_font(args.font, args.extended)
+    entries, packed, page_column_bytes = build_atlas(glyphs)
+    ranges = codepoint_ranges(entries)
+
+    source = os.path.basename(args.font) + (" (extended)" if args.extended else "")
+    if args.out_dir:
+        write_atlas(args.name, source, entries, ranges, packed, y_advance, args.out_dir)
+
+    count = len(entries)
+    tables = count * SIZEOF_ATLAS_GLYPH + len(ranges) * SIZEOF_ATLAS_RANGE + SIZEOF_ATLAS_FONT
+    atlas_flash = len(packed) + tables
+    gfx_flash = len(bitmap) + count * SIZEOF_GFX_GLYPH + SIZEOF_GFX_FONT
+    page_flash = page_column_bytes + tables
+    print(f"{source} -> {args.name}: {count} glyphs, "
+          f"U+{entries[0]['codepoint']:04X}..U+{entries[-1]['codepoint']:04X}")
+    print(f"  flash  atlas {atlas_flash} B (bitmap {len(packed)} B, glyphs {count} x {SIZEOF_ATLAS_GLYPH} B, "
+          f"ranges {len(ranges)} x {SIZEOF_ATLAS_RANGE} B)")
+    print(f"         {gfx_name} GFX original {gfx_flash} B (bitmap {len(bitmap)} B)")
+    print(f"         page-column uncompressed {page_flash} B (bitmap {page_column_bytes} B)")
+    print(f"  RAM    glyph cache {GLYPH_CACHE_SIZE} x {SIZEOF_CACHE_ENTRY} B = "
+          f"{GLYPH_CACHE_SIZE * SIZEOF_CACHE_ENTRY} B, shared by all fonts")
+
+
+if __name__ == "__main__":
+    main()
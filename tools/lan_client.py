@@ -0,0 +1,164 @@
+"""Talks to the grow box web server over the LAN, without the broker.
+
+Watches the WebSocket push stream, sends commands over the REST endpoint or
+the WebSocket, and measures how long the device takes to answer. Standard
+library only.
+
+    python tools/lan_client.py growbox-<id>.local
+    python tools/lan_client.py 192.168.1.50 --command PUMP_DISABLE
+    python tools/lan_client.py growbox-<id>.local --latency 20
+
+The default prints every pushed message with the time since the previous
+one. --latency sends STATUS:<id> over the WebSocket that many times and
+reports the round trip to the matching reply.
+"""
+import argparse
+import base64
+import json
+import os
+import socket
+import statistics
+import struct
+import sys
+import time
+import urllib.error
+import urllib.request
+
+OP_TEXT = 0x1
+OP_CLOSE = 0x8
+OP_PING = 0x9
+OP_PONG = 0xA
+
+
+class WebSocket:
+    """Minimal client side of RFC 6455: unfragmented text frames."""
+
+    def __init__(self, host, port, path="/ws", timeout=10.0):
+        self.sock = socket.create_connection((host, port), timeout=timeout)
+        key = base64.b64encode(os.urandom(16)).decode()
+        request = (f"GET {path} HTTP/1.1\r\nHost: {host}:{port}\r\nUpgrade: websocket\r\n"
+                   f"Connection: Upgrade\r\nSec-WebSocket-Key: {key}\r\nSec-WebSocket-Version: 13\r\n\r\n")
+        self.sock.sendall(request.encode())
+        response = b""
+        while b"\r\n\r\n" not in response:
+            chunk = self.sock.recv(1024)
+            if not chunk:
+                raise ConnectionError("connection closed during handshake")
+            response += chunk
+        head, self.buffer = response.split(b"\r\n\r\n", 1)
+        status = head.split(b"\r\n", 1)[0]
+        if b" 101 " not in status:
+            raise ConnectionError(f"handshake refused: {status.decode(errors='replace')}")
+
+    def _read(self, count):
+        while len(self.buffer) < count:
+            chunk = self.sock.recv(4096)
+            if not chunk:
+                raise ConnectionError("connection closed")
+            self.buffer += chunk
+        data, self.buffer = self.buffer[:count], self.buffer[count:]
+        return data
+
+    def _send_frame(self, opcode, payload):
+        mask = os.urandom(4)
+        header = bytes([0x80 | opcode])
+        if len(payload) < 126:
+            header += bytes([0x80 | len(payload)])
+        else:
+            header += bytes([0x80 | 126]) + struct.pack(">H", len(payload))
+        masked = bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+        self.sock.sendall(header + mask + masked)
+
+    def send(self, text):
+        self._send_frame(OP_TEXT, text.encode())
+
+    def recv(self):
+        """Next text message; None when the server closes."""
+        while True:
+            first, second = self._read(2)
+            opcode = first & 0x0F
+            length = second & 0x7F
+            if length == 126:
+                length = struct.unpack(">H", self._read(2))[0]
+            elif length == 127:
+                length = struct.unpack(">Q", self._read(8))[0]
+            payload = self._read(length)
+            if opcode == OP_TEXT:
+                return payload.decode()
+            if opcode == OP_PING:
+                self._send_frame(OP_PONG, payload)
+            elif opcode == OP_CLOSE:
+                return None
+
+    def close(self):
+        try:
+            self._send_frame(OP_CLOSE, b"")
+        finally:
+            self.sock.close()
+
+
+def post_command(host, port, command):
+    request = urllib.request.Request(f"http://{host}:{port}/api/command", data=command.encode(), method="POST")
+    try:
+        with urllib.request.urlopen(request, timeout=10) as response:
+            return response.status, response.read().decode()
+    except urllib.error.HTTPError as e:
+        return e.code, e.read().decode()
+
+
+def watch(ws):
+    last = time.monotonic()
+    while True:
+        message = ws.recv()
+        if message is None:
+            print("server closed the connection")
+            return
+        now = time.monotonic()
+        print(f"+{(now - last) * 1000:7.0f} ms  {message}")
+        last = now
+
+
+def measure_latency(ws, count):
+    rtts = []
+    for i in range(count):
+        request_id = f"lat{i}"
+        start = time.monotonic()
+        ws.send(f"STATUS:{request_id}")
+        while True:
+            message = ws.recv()
+            if message is None:
+                raise ConnectionError("connection closed")
+            if json.loads(message).get("req") == request_id:
+                break
+        rtts.append((time.monotonic() - start) * 1000)
+    print(f"{count} STATUS round trips: min {min(rtts):.1f} ms, median {statistics.median(rtts):.1f} ms, "
+          f"max {max(rtts):.1f} ms")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host", help="growbox-<id>.local or the device IP")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--command", help="send one command with POST /api/command and exit")
+    parser.add_argument("--latency", type=int, metavar="N", help="time N STATUS round trips over the WebSocket")
+    args = parser.parse_args()
+
+    if args.command:
+        status, body = post_command(args.host, args.port, args.command)
+        print(f"{status} {body}")
+        sys.exit(0 if status == 202 else 1)
+
+    ws = WebSocket(args.host, args.port)
+    try:
+        if args.latency:
+            measure_latency(ws, args.latency)
+        else:
+            watch(ws)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        ws.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,315 @@
+"""Stand-in for the grow box web server, to try lan_client.py and the
+dashboard on a PC without a box.
+
+Serves the same endpoints as src/web_server.cpp: the dashboard page,
+/api/status, POST /api/command and the /ws WebSocket. The sensor readings
+are made up and pushed every --interval seconds. Commands go through the
+same LAN allowlist as on the box and answer with the events the box would
+send. Standard library only.
+
+    python tools/lan_server.py --port 8080
+    python tools/lan_client.py localhost --port 8080 --latency 20
+    python tools/lan_client.py localhost --port 8080 --command FAULT_CLEAR   # 403
+"""
+import argparse
+import base64
+import hashlib
+import http.server
+import json
+import os
+import random
+import struct
+import threading
+import time
+
+# Keep in sync with web_server.h and command_access.c
+MAX_CLIENTS = 4
+COMMAND_MAX = 96
+LAN_COMMANDS = {"PUMP_ON", "PUMP_ENABLE", "PUMP_DISABLE", "STATUS", "PUMP_CAL_STATUS", "CAL_STATUS", "OTA_STATUS"}
+COMMAND_SEPARATORS = " @:"
+
+# Default dose and flow rate of an uncalibrated pump (main.cpp, pump.h)
+DEFAULT_DOSE_ML = 75
+FLOW_ML_MIN = 1500
+
+WS_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+OP_TEXT = 0x1
+OP_CLOSE = 0x8
+OP_PING = 0x9
+OP_PONG = 0xA
+
+DASHBOARD = os.path.join(os.path.dirname(__file__), "..", "src", "web", "dashboard.html")
+
+
+def lan_allowed(line):
+    """command_lan_allowed(): the command word must match exactly."""
+    end = len(line)
+    for separator in COMMAND_SEPARATORS:
+        index = line.find(separator)
+        if index >= 0:
+            end = min(end, index)
+    return line[:end] in LAN_COMMANDS
+
+
+def split_command(line):
+    """(command, args, deadline, request id) as runCommand() splits them."""
+    line, _, request_id = line.partition(":")
+    line, _, deadline = line.partition("@")
+    command, _, args = line.partition(" ")
+    return command, args, deadline, request_id
+
+
+class Box:
+    """The state a command can change, and the JSON the box would send."""
+
+    def __init__(self, seed):
+        self.rng = random.Random(seed)
+        self.lock = threading.Lock()
+        self.clients = []
+        self.pump_enabled = True
+        self.soil = 45
+        self.latest = None
+
+    def status(self, request_id=None):
+        self.soil = max(0, min(100, self.soil + self.rng.choice((-1, 0, 0, 1))))
+        raw = 4095 - self.soil * 19
+        state = "DRY" if self.soil < 30 else "OK" if self.soil < 60 else "WET"
+        # Same field order as formatStatus()
+        fields = [
+            f"\"temperature\":{self.rng.uniform(20, 24):.1f}",
+            f"\"humidity\":{self.rng.uniform(50, 60):.1f}",
+            f"\"soil_moisture\":{self.soil}",
+            f"\"pump_enabled\":{'true' if self.pump_enabled else 'false'}",
+            "\"sensor_ok\":true",
+            f"\"status\":\"{state}\"",
+            f"\"soil_moisture_uncomp\":{self.soil}",
+            f"\"soil_raw\":{raw}",
+            f"\"soil_raw_comp\":{raw}",
+            "\"fault\":\"none\"",
+        ]
+        if request_id:
+            fields.append(f"\"req\":\"{request_id}\"")
+        return "{" + ",".join(fields) + "}"
+
+    def sample(self):
+        with self.lock:
+            self.latest = self.status()
+        self.broadcast(self.latest)
+
+    def run(self, line):
+        """runCommand() for an allowed command; its replies are pushed."""
+        command, args, deadline, request_id = split_command(line)
+        if deadline and time.time() > (int(deadline) if deadline.isdigit() else 0):
+            self.event({"event": "command_expired", "command": command, "reason": "expired"}, request_id)
+            return
+        if command == "STATUS":
+            with self.lock:
+                reply = self.status(request_id)
+            self.broadcast(reply)
+        elif command == "PUMP_ON":
+            # Dose, then the pump: "PUMP_ON 50 1"
+            dose, _, pump = args.partition(" ")
+            if (pump or "0") != "0":
+                self.event({"event": "pump_blocked", "reason": "bad_pump"})
+                return
+            volume = int(dose) if dose.isdigit() and int(dose) > 0 else DEFAULT_DOSE_ML
+            ms = volume * 60000 // FLOW_ML_MIN
+            self.event({"event": "pump_activated", "pump": 0, "ml": volume, "ms": ms, "width_err_us": 0,
+                        "type": "manual"})
+        elif command in ("PUMP_ENABLE", "PUMP_DISABLE"):
+            self.pump_enabled = command == "PUMP_ENABLE"
+            self.event({"event": "pump_enabled" if self.pump_enabled else "pump_disabled"})
+        elif command == "PUMP_CAL_STATUS":
+            self.event({"event": "pump_calibration", "pump": int(args or 0), "state": "status",
+                        "flow_ml_min": FLOW_ML_MIN, "calibrated": False}, request_id)
+        elif command == "CAL_STATUS":
+            self.event({"event": "calibration", "zone": int(args or 0), "state": "status", "points": 0}, request_id)
+        elif command == "OTA_STATUS":
+            self.event({"event": "ota", "state": "idle"}, request_id)
+
+    def event(self, data, request_id=None):
+        if request_id:
+            data["req"] = request_id
+        self.broadcast(json.dumps(data, separators=(",", ":")))
+
+    def broadcast(self, text):
+        with self.lock:
+            clients = list(self.clients)
+        for client in clients:
+            client.send(text)
+
+
+class ServerSocket:
+    """Server side of RFC 6455: unfragmented text frames."""
+
+    def __init__(self, sock):
+        self.sock = sock
+        self.send_lock = threading.Lock()
+
+    def _read(self, count):
+        data = b""
+        while len(data) < count:
+            chunk = self.sock.recv(count - len(data))
+            if not chunk:
+                raise ConnectionError("connection closed")
+            data += chunk
+        return data
+
+    def _send_frame(self, opcode, payload):
+        header = bytes([0x80 | opcode])
+        if len(payload) < 126:
+            header += bytes([len(payload)])
+        else:
+            header += bytes([126]) + struct.pack(">H", len(payload))
+        with self.send_lock:
+            self.sock.sendall(header + payload)
+
+    def send(self, text):
+        try:
+            self._send_frame(OP_TEXT, text.encode())
+        except OSError:
+            pass
+
+    def recv(self):
+        """Next text message; None when the client closes."""
+        while True:
+            first, second = self._read(2)
+            opcode = first & 0x0F
+            length = second & 0x7F
+            if length == 126:
+                length = struct.unpack(">H", self._read(2))[0]
+            elif length == 127:
+                length = struct.unpack(">Q", self._read(8))[0]
+            mask = self._read(4) if second & 0x80 else b"\0\0\0\0"
+            payload = bytes(b ^ mask[i % 4] for i, b in enumerate(self._read(length)))
+            if opcode == OP_TEXT:
+                return payload.decode(errors="replace")
+            if opcode == OP_PING:
+                self._send_frame(OP_PONG, payload)
+            elif opcode == OP_CLOSE:
+                return None
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    box = None
+
+    def log_message(self, fmt, *args):
+        print(f"{self.address_string()} {fmt % args}")
+
+    def send_json(self, status, text):
+        body = text.encode()
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Cache-Control", "no-store")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_GET(self):
+        if self.path == "/":
+            with open(DASHBOARD, "rb") as f:
+                body = f.read()
+            self.send_response(200)
+            self.send_header("Content-Type", "text/html")
+            self.send_header("Content-Length", str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+        elif self.path == "/api/status":
+            latest = self.box.latest
+            if latest is None:
+                self.send_json(503, "{\"error\":\"no_sample\"}")
+            else:
+                self.send_json(200, latest)
+        elif self.path == "/ws":
+            self.websocket()
+        else:
+            self.send_error(404)
+
+    def do_POST(self):
+        if self.path != "/api/command":
+            self.send_error(404)
+            return
+        length = int(self.headers.get("Content-Length", 0))
+        if length == 0 or length >= COMMAND_MAX:
+            self.send_json(400, "{\"error\":\"bad_command\"}")
+            return
+        line = self.rfile.read(length).decode(errors="replace").rstrip()
+        if line and not lan_allowed(line):
+            print(f"Web command refused: {line}")
+            self.send_json(403, "{\"error\":\"not_allowed\"}")
+            return
+        self.send_json(202, "{\"queued\":true}")
+        if line:
+            self.box.run(line)
+
+    def websocket(self):
+        key = self.headers.get("Sec-WebSocket-Key")
+        with self.box.lock:
+            full = len(self.box.clients) >= MAX_CLIENTS
+        if key is None or full:
+            self.send_error(400 if key is None else 503)
+            return
+        accept = base64.b64encode(hashlib.sha1((key + WS_GUID).encode()).digest()).decode()
+        self.send_response(101)
+        self.send_header("Upgrade", "websocket")
+        self.send_header("Connection", "Upgrade")
+        self.send_header("Sec-WebSocket-Accept", accept)
+        self.end_headers()
+        self.wfile.flush()
+
+        ws = ServerSocket(self.connection)
+        with self.box.lock:
+            self.box.clients.append(ws)
+            latest = self.box.latest
+        if latest is not None:
+            ws.send(latest)
+        try:
+            while True:
+                line = ws.recv()
+                if line is None:
+                    break
+                line = line.rstrip()
+                if len(line) >= COMMAND_MAX:
+                    break
+                if not line:
+                    continue
+                if lan_allowed(line):
+                    self.box.run(line)
+                else:
+                    ws.send("{\"event\":\"command_rejected\",\"reason\":\"not_allowed\"}")
+        except (ConnectionError, OSError):
+            pass
+        finally:
+            with self.box.lock:
+                self.box.clients.remove(ws)
+            self.close_connection = True
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="127.0.0.1", help="address to listen on")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--interval", type=float, default=5.0, help="seconds between pushed samples")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    Handler.box = box = Box(args.seed)
+    box.sample()
+    server = http.server.ThreadingHTTPServer((args.host, args.port), Handler)
+    server.daemon_threads = True
+
+    def sampler():
+        while True:
+            time.sleep(args.interval)
+            box.sample()
+
+    threading.Thread(target=sampler, daemon=True).start()
+    print(f"Stand-in web server at http://{args.host}:{args.port}/")
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
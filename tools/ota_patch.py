@@ -0,0 +1,560 @@
+"""Builds, checks and sends OTA firmware patches for the grow box.
+
+A patch turns the firmware a device runs (the base) into a new one. Delta
+patches are bsdiff style: spans of the new image are matched against the
+base allowing for small differences (moved code changes addresses), and
+the difference, mostly zero bytes, is run-length coded. The format is
+described in src/ota_patch.h; apply() here mirrors the device decoder.
+
+Patch headers are signed (ECDSA P-256) with a release key, and devices
+only take patches that verify against the public key built into them
+(include/ota_signing_key.h). Keys and signatures go through the openssl
+command line tool.
+
+    python tools/ota_patch.py keygen -o ota_signing.pem --header include/ota_signing_key.h
+    python tools/ota_patch.py diff base.bin new.bin --key ota_signing.pem -o update.gbot
+    python tools/ota_patch.py full new.bin --key ota_signing.pem -o update.gbot
+    python tools/ota_patch.py apply base.bin update.gbot --key ota_signing.pem -o check.bin
+    python tools/ota_patch.py send update.gbot --device <id>
+    python tools/ota_patch.py simulate base.bin new.bin
+
+The images are the application .bin files PlatformIO builds
+(.pio/build/<env>/firmware.bin); the base must be exactly what the device
+runs. `simulate` runs the whole transfer against an in-process broker and
+a simulated device, without hardware or network.
+"""
+import argparse
+import hashlib
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+# Keep in sync with ota_patch.h / ota.h / connectToWifi.h
+MAGIC = b"GBOT"
+VERSION = 2
+FLAG_DELTA = 0x01
+# Signed part of the header; the signature (r, s) follows it
+HEADER = struct.Struct("<4sBBII32s32s")
+SIGNATURE_SIZE = 64
+HEADER_SIZE = HEADER.size + SIGNATURE_SIZE
+OP_END, OP_COPY, OP_INSERT = 0, 1, 2
+CHUNK_MAX = 1024
+MQTT_TOPIC_ROOT = "growbox"
+
+# Seeds: BLOCK-byte strings of the base indexed every STRIDE bytes, so any
+# exact match of BLOCK + STRIDE - 1 bytes is found
+BLOCK = 16
+STRIDE = 4
+# A match stops growing after this many bytes without improving
+EXTEND_SLACK = 256
+# Zero runs shorter than this stay inside a literal run
+MIN_ZERO_RUN = 3
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def openssl(*args, data=None):
+    try:
+        return subprocess.run(["openssl", *args], input=data, capture_output=True, check=True).stdout
+    except FileNotFoundError:
+        raise SystemExit("openssl not found; it is needed for keys and signatures")
+
+
+def der_length(data, pos):
+    length = data[pos]
+    if length < 0x80:
+        return length, pos + 1
+    count = length & 0x7F
+    return int.from_bytes(data[pos + 1:pos + 1 + count], "big"), pos + 1 + count
+
+
+def der_integer(value):
+    body = value.to_bytes(33, "big").lstrip(b"\0")
+    if not body or body[0] & 0x80:
+        body = b"\0" + body
+    return bytes([0x02, len(body)]) + body
+
+
+def signature_to_raw(der):
+    """DER ECDSA-Sig-Value (what openssl writes) to r || s."""
+    _, pos = der_length(der, 1)
+    raw = b""
+    for _ in range(2):
+        if der[pos] != 0x02:
+            raise ValueError("not an ECDSA signature")
+        length, pos = der_length(der, pos + 1)
+        raw += int.from_bytes(der[pos:pos + length], "big").to_bytes(32, "big")
+        pos += length
+    return raw
+
+
+def signature_to_der(raw):
+    body = der_integer(int.from_bytes(raw[:32], "big")) + der_integer(int.from_bytes(raw[32:], "big"))
+    return bytes([0x30, len(body)]) + body
+
+
+def sign(key, data):
+    """r || s over SHA-256 of data with the PEM private key at path key;
+    all zero (refused by every device) without one."""
+    if key is None:
+        return bytes(SIGNATURE_SIZE)
+    return signature_to_raw(openssl("dgst", "-sha256", "-sign", key, data=data))
+
+
+def verify(key, data, signature):
+    with tempfile.NamedTemporaryFile(delete=False) as f:
+        f.write(signature_to_der(signature))
+    try:
+        openssl("dgst", "-sha256", "-prverify", key, "-signature", f.name, data=data)
+        return True
+    except subprocess.CalledProcessError:
+        return False
+    finally:
+        os.unlink(f.name)
+
+
+def keygen(key, header_path):
+    """New P-256 release key, and the C header with its public half."""
+    openssl("ecparam", "-name", "prime256v1", "-genkey", "-noout", "-out", key)
+    os.chmod(key, 0o600)
+    # SubjectPublicKeyInfo ends in the uncompressed point
+    point = openssl("ec", "-in", key, "-pubout", "-outform", "DER")[-65:]
+    rows = ",\n".join("    " + ", ".join(f"0x{b:02x}" for b in point[i:i + 13]) for i in range(0, len(point), 13))
+    with open(header_path, "w", encoding="utf-8") as f:
+        f.write(f"""// ota_signing_key.h
+#ifndef OTA_SIGNING_KEY_H
+#define OTA_SIGNING_KEY_H
+
+// Generated by tools/ota_patch.py keygen; patches must be signed with the
+// matching private key ({os.path.basename(key)})
+
+#include <stdint.h>
+
+static const uint8_t OTA_SIGNING_PUBLIC_KEY[65] = {{
+{rows}
+}};
+
+#endif
+""")
+
+
+def header(new, base=None, key=None):
+    if base is None:
+        signed = HEADER.pack(MAGIC, VERSION, 0, len(new), 0, hashlib.sha256(new).digest(), bytes(32))
+    else:
+        signed = HEADER.pack(MAGIC, VERSION, FLAG_DELTA, len(new), len(base),
+                             hashlib.sha256(new).digest(), hashlib.sha256(base).digest())
+    return signed + sign(key, signed)
+
+
+def encode_insert(data):
+    return bytes([OP_INSERT]) + varint(len(data)) + data
+
+
+def encode_copy(new, base, new_pos, base_pos, length):
+    out = bytearray([OP_COPY])
+    out += varint(length) + varint(base_pos)
+    diff = bytes((new[new_pos + i] - base[base_pos + i]) & 0xFF for i in range(length))
+    i = 0
+    while True:
+        zeros = 0
+        while i + zeros < length and diff[i + zeros] == 0:
+            zeros += 1
+        out += varint(zeros)
+        i += zeros
+        if i == length:
+            break
+        # Literals run up to the next zero run worth its own pair
+        start = i
+        while i < length:
+            if diff[i] == 0 and diff[i:i + MIN_ZERO_RUN] == bytes(min(MIN_ZERO_RUN, length - i)):
+                break
+            i += 1
+        out += varint(i - start) + diff[start:i]
+        if i == length:
+            break
+    return bytes(out)
+
+
+def extend(new, base, new_pos, base_pos, step, limit):
+    """Length of the approximate match from the given positions (bsdiff
+    scoring: keep the length where matches minus mismatches peaks)."""
+    score = best_score = best_len = 0
+    i = 0
+    while i < limit:
+        n = new_pos + i * step
+        b = base_pos + i * step
+        if new[n] == base[b]:
+            score += 1
+        i += 1
+        if score * 2 - i > best_score * 2 - best_len:
+            best_score, best_len = score, i
+        if i - best_len > EXTEND_SLACK:
+            break
+    return best_len
+
+
+def diff(base, new, key=None):
+    index = {}
+    for pos in range(0, len(base) - BLOCK + 1, STRIDE):
+        index.setdefault(base[pos:pos + BLOCK], pos)
+
+    ops = []
+    insert_start = 0
+    pos = 0
+    while pos <= len(new) - BLOCK:
+        base_pos = index.get(new[pos:pos + BLOCK])
+        if base_pos is None:
+            pos += 1
+            continue
+        forward = extend(new, base, pos, base_pos, 1, min(len(new) - pos, len(base) - base_pos))
+        if forward < BLOCK:
+            pos += 1
+            continue
+        back = 0
+        if pos > insert_start and base_pos > 0:
+            back = extend(new, base, pos - 1, base_pos - 1, -1, min(pos - insert_start, base_pos))
+        if pos - back > insert_start:
+            ops.append(encode_insert(new[insert_start:pos - back]))
+        ops.append(encode_copy(new, base, pos - back, base_pos - back, back + forward))
+        pos += forward
+        insert_start = pos
+    if insert_start < len(new):
+        ops.append(encode_insert(new[insert_start:]))
+    return header(new, base, key) + b"".join(ops) + bytes([OP_END])
+
+
+def full(new, key=None):
+    return header(new, key=key) + encode_insert(new) + bytes([OP_END])
+
+
+class PatchError(Exception):
+    pass
+
+
+def read_varint(patch, pos):
+    value = shift = 0
+    while True:
+        if pos >= len(patch) or shift > 28:
+            raise PatchError("bad_patch")
+        byte = patch[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def apply(base, patch, key=None):
+    """Reference decoder; raises PatchError with the device's error name.
+    With key (the PEM private key), the signature is checked first, as the
+    device checks it against the public half."""
+    if len(patch) < HEADER_SIZE:
+        raise PatchError("bad_header")
+    magic, version, flags, new_size, base_size, new_sha, base_sha = HEADER.unpack_from(patch)
+    if magic != MAGIC or version != VERSION or new_size == 0:
+        raise PatchError("bad_header")
+    if key is not None and not verify(key, patch[:HEADER.size], patch[HEADER.size:HEADER_SIZE]):
+        raise PatchError("bad_signature")
+    if flags & FLAG_DELTA:
+        if base is None or len(base) < base_size or hashlib.sha256(base[:base_size]).digest() != base_sha:
+            raise PatchError("base_mismatch")
+        base = base[:base_size]
+    else:
+        base = b""
+
+    out = bytearray()
+    pos = HEADER_SIZE
+    while True:
+        if pos >= len(patch):
+            raise PatchError("bad_patch")
+        op = patch[pos]
+        pos += 1
+        if op == OP_END:
+            break
+        if op == OP_INSERT:
+            length, pos = read_varint(patch, pos)
+            out += patch[pos:pos + length]
+            pos += length
+        elif op == OP_COPY:
+            length, pos = read_varint(patch, pos)
+            base_pos, pos = read_varint(patch, pos)
+            if base_pos + length > len(base):
+                raise PatchError("out_of_range")
+            left = length
+            while left:
+                zeros, pos = read_varint(patch, pos)
+                if zeros > left:
+                    raise PatchError("bad_patch")
+                out += base[base_pos:base_pos + zeros]
+                base_pos += zeros
+                left -= zeros
+                if not left:
+                    break
+                count, pos = read_varint(patch, pos)
+                if count > left:
+                    raise PatchError("bad_patch")
+                out += bytes((base[base_pos + i] + patch[pos + i]) & 0xFF for i in range(count))
+                base_pos += count
+                pos += count
+                left -= count
+        else:
+            raise PatchError("bad_patch")
+        if len(out) > new_size:
+            raise PatchError("out_of_range")
+    if pos != len(patch) or len(out) != new_size:
+        raise PatchError("bad_patch")
+    if hashlib.sha256(out).digest() != new_sha:
+        raise PatchError("hash_mismatch")
+    return bytes(out)
+
+
+def ota_topic(device_id):
+    return f"{MQTT_TOPIC_ROOT}/{device_id}/ota"
+
+
+def send(client, device_id, patch, window=4, timeout=30.0, progress=None):
+    """Stream a patch to a connected device. Chunks are [u32 offset][data];
+    the device acks each one with the next offset it wants, and with
+    "resend" when a chunk was missing. The sender keeps up to `window`
+    chunks in flight and rewinds on resend. Returns the device's final ota
+    event."""
+    import json
+
+    lock = threading.Condition()
+    state = {"next": 0, "rewind": None, "event": None}
+
+    def on_message(_client, _userdata, msg):
+        try:
+            data = json.loads(msg.payload)
+        except ValueError:
+            return
+        with lock:
+            if msg.topic.endswith("/ota_ack"):
+                state["next"] = data.get("next", state["next"])
+                if data.get("resend"):
+                    state["rewind"] = state["next"]
+            # A resend ("dup") may be left over from an earlier transfer
+            elif (data.get("event") == "ota" and data.get("state") in ("error", "aborted", "rebooting")
+                  and not data.get("dup")):
+                state["event"] = data
+            lock.notify_all()
+
+    client.on_message = on_message
+    client.subscribe(ota_topic(device_id) + "_ack")
+    client.subscribe(f"{MQTT_TOPIC_ROOT}/{device_id}/status")
+    client.publish(f"{MQTT_TOPIC_ROOT}/{device_id}/control", f"OTA_BEGIN {len(patch)}")
+
+    sent = 0
+    started = time.monotonic()
+    deadline = started + timeout
+    with lock:
+        while state["event"] is None:
+            if state["rewind"] is not None:
+                sent = state["rewind"]
+                state["rewind"] = None
+            acked = state["next"]
+            if sent < len(patch) and sent < acked + window * CHUNK_MAX:
+                chunk = patch[sent:sent + CHUNK_MAX]
+                lock.release()
+                try:
+                    client.publish(ota_topic(device_id), struct.pack("<I", sent) + chunk)
+                finally:
+                    lock.acquire()
+                sent += len(chunk)
+                continue
+            lock.wait(max(0.0, deadline - time.monotonic()))
+            if state["next"] != acked or state["event"] is not None:
+                deadline = time.monotonic() + timeout
+                if progress:
+                    progress(state["next"], len(patch), time.monotonic() - started)
+            elif time.monotonic() >= deadline:
+                # Lost ack or lost tail: start again from the last ack
+                if sent > acked and state["rewind"] is None:
+                    state["rewind"] = acked
+                    deadline = time.monotonic() + timeout
+                else:
+                    raise TimeoutError(f"no progress from {device_id} at offset {acked}")
+    return state["event"]
+
+
+class SimulatedDevice:
+    """Device side of the transfer on top of apply(): takes the chunks in
+    order, asks for a resend once per gap, and applies the patch at the
+    end, checking the signature when given the key. Every `drop`th chunk is
+    lost on the way in, to exercise resends."""
+
+    def __init__(self, client, device_id, base, drop=0, key=None):
+        self.client = client
+        self.device_id = device_id
+        self.base = base
+        self.drop = drop
+        self.key = key
+        self.received = 0
+        self.resends = 0
+        self.resend_offset = None
+        self.patch = None
+        self.image = None
+        client.on_message = self.on_message
+        client.subscribe(f"{MQTT_TOPIC_ROOT}/{device_id}/control")
+        client.subscribe(ota_topic(device_id))
+
+    def publish(self, topic, **fields):
+        import json
+        self.client.publish(f"{MQTT_TOPIC_ROOT}/{self.device_id}/{topic}", json.dumps(fields))
+
+    def on_message(self, _client, _userdata, msg):
+        if msg.topic.endswith("/control"):
+            command = msg.payload.decode()
+            if command.startswith("OTA_BEGIN "):
+                self.size = int(command.split()[1])
+                self.patch = bytearray()
+                self.publish("status", event="ota", state="ready", size=self.size)
+                self.publish("ota_ack", next=0)
+            return
+        if self.patch is None:
+            return
+        self.received += 1
+        if self.drop and self.received % self.drop == 0:
+            return
+        offset, = struct.unpack_from("<I", msg.payload)
+        if offset != len(self.patch):
+            if offset > len(self.patch) and self.resend_offset != len(self.patch):
+                self.resend_offset = len(self.patch)
+                self.resends += 1
+                self.publish("ota_ack", next=len(self.patch), resend=True)
+            return
+        self.patch += msg.payload[4:]
+        self.publish("ota_ack", next=len(self.patch))
+        if len(self.patch) >= self.size:
+            try:
+                self.image = apply(self.base, bytes(self.patch), self.key)
+                self.publish("status", event="ota", state="rebooting")
+            except PatchError as error:
+                self.publish("status", event="ota", state="error", reason=str(error))
+            self.patch = None
+
+
+def simulate(base, new, delta=True, window=4, drop=0, key=None):
+    sys.path.insert(0, os.path.join(os.path.dirname(__file__), "..", "src", "discordBot"))
+    from mock_broker import MockBroker, MockClient
+
+    started = time.monotonic()
+    patch = diff(base, new, key) if delta else full(new, key)
+    built = time.monotonic() - started
+    broker = MockBroker()
+    device_client = MockClient(broker)
+    device_client.connect()
+    device = SimulatedDevice(device_client, "simulated", base, drop=drop, key=key)
+    sender = MockClient(broker)
+    sender.connect()
+
+    event = send(sender, "simulated", patch, window=window, timeout=0.5)
+    ok = event.get("state") == "rebooting" and device.image == new
+    print(f"patch {len(patch)} bytes for a {len(new)} byte image ({len(patch) / len(new):.1%}, "
+          f"built in {built:.1f} s), {device.received} chunks received, {device.resends} resends, "
+          f"device: {event.get('state')} {event.get('reason', '')}".rstrip())
+    return ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    p = commands.add_parser("keygen", help="new release key and the public key header for the firmware")
+    p.add_argument("-o", "--output", required=True, help="private key (PEM); keep it out of the repository")
+    p.add_argument("--header", required=True, help="C header to build into the firmware")
+
+    p = commands.add_parser("diff", help="delta patch from base to new")
+    p.add_argument("base")
+    p.add_argument("new")
+    p.add_argument("--key", required=True, help="release key (PEM)")
+    p.add_argument("-o", "--output", required=True)
+
+    p = commands.add_parser("full", help="patch carrying the whole image")
+    p.add_argument("new")
+    p.add_argument("--key", required=True, help="release key (PEM)")
+    p.add_argument("-o", "--output", required=True)
+
+    p = commands.add_parser("apply", help="apply a patch on the host and check it")
+    p.add_argument("base")
+    p.add_argument("patch")
+    p.add_argument("--key", help="release key (PEM) to check the signature with")
+    p.add_argument("-o", "--output")
+
+    p = commands.add_parser("send", help="send a patch to a device over MQTT")
+    p.add_argument("patch")
+    p.add_argument("--device", required=True)
+    p.add_argument("--broker", default="broker.hivemq.com")
+    p.add_argument("--port", type=int, help="default 1883, or 8883 with --ca")
+    p.add_argument("--ca", help="CA certificate (PEM) to connect over TLS")
+    p.add_argument("--window", type=int, default=4, help="chunks in flight")
+
+    p = commands.add_parser("simulate", help="full transfer against a simulated device")
+    p.add_argument("base")
+    p.add_argument("new")
+    p.add_argument("--full", action="store_true", help="send the whole image, not a delta")
+    p.add_argument("--drop", type=int, default=0, help="lose every Nth chunk")
+    p.add_argument("--key", help="release key (PEM): sign, and check on the simulated device")
+
+    args = parser.parse_args()
+
+    if args.command == "keygen":
+        keygen(args.output, args.header)
+        print(f"{args.output}: private key; {args.header}: public key for the firmware")
+    elif args.command in ("diff", "full"):
+        new = open(args.new, "rb").read()
+        started = time.monotonic()
+        patch = diff(open(args.base, "rb").read(), new, args.key) if args.command == "diff" else full(new, args.key)
+        open(args.output, "wb").write(patch)
+        print(f"{args.output}: {len(patch)} bytes for a {len(new)} byte image "
+              f"({len(patch) / len(new):.1%}) in {time.monotonic() - started:.1f} s")
+    elif args.command == "apply":
+        try:
+            image = apply(open(args.base, "rb").read(), open(args.patch, "rb").read(), args.key)
+        except PatchError as error:
+            sys.exit(f"patch rejected: {error}")
+        if args.output:
+            open(args.output, "wb").write(image)
+        print(f"ok: {len(image)} bytes, sha256 {hashlib.sha256(image).hexdigest()}")
+    elif args.command == "send":
+        import paho.mqtt.client as mqtt
+
+        client = mqtt.Client()
+        if args.ca:
+            client.tls_set(ca_certs=args.ca)
+        client.connect(args.broker, args.port or (8883 if args.ca else 1883))
+        client.loop_start()
+        patch = open(args.patch, "rb").read()
+
+        def progress(done, total, seconds):
+            print(f"\r{done}/{total} bytes, {done / max(seconds, 0.001) / 1024:.1f} KiB/s", end="", flush=True)
+
+        event = send(client, args.device, patch, window=args.window, progress=progress)
+        print()
+        client.loop_stop()
+        if event.get("state") != "rebooting":
+            sys.exit(f"update failed: {event.get('state')} {event.get('reason', '')}")
+        print(f"{args.device} verified the image and is rebooting into it")
+    elif args.command == "simulate":
+        ok = simulate(open(args.base, "rb").read(), open(args.new, "rb").read(), delta=not args.full,
+                      drop=args.drop, key=args.key)
+        sys.exit(0 if ok else 1)
+
+
+if __name__ == "__main__":
+    main()
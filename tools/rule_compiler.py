@@ -0,0 +1,521 @@
+"""Compiles, checks and sends automation rules for the grow box.
+
+Rules are written one per line and compiled into the stack bytecode the
+device evaluates (format in src/rule_vm.h); load() and evaluate() here
+mirror the device's loader and evaluator.
+
+    # rules.txt
+    if humidity > 80 and temp < 18 then disable pump for 2 h
+    at 07:00 if soil < 40 then water 50 ml
+    if soil_raw < 100 or fault then alert
+
+    python tools/rule_compiler.py compile rules.txt -o rules.bin
+    python tools/rule_compiler.py eval rules.txt temp=17.5 humidity=85 soil=35 time=07:00
+    python tools/rule_compiler.py send rules.txt --device <id>
+    python tools/rule_compiler.py clear --device <id>
+
+A rule is `[at HH:MM] [if <condition>] then <action>`. Conditions compare
+channels (temp in degrees C, humidity in %, soil in %, soil_raw, time,
+pump_enabled, fault) with numbers, + and -, combined with and, or, not and
+parentheses. Numbers are in the units of the channel they are compared
+with. Actions: `water <n> ml`, `disable pump [for <n> h|min]`,
+`enable pump`, `alert`. A rule fires when its condition becomes true; it
+is false while a channel it reads has no valid reading (time before the
+clock is set, temp and humidity without the SHT31, soil with the probe
+out of range).
+"""
+import argparse
+import json
+import re
+import struct
+import sys
+import threading
+import time
+
+# Keep in sync with rule_vm.h / connectToWifi.h
+VERSION = 1
+RULES_MAX = 16
+CODE_MAX = 48
+STACK_MAX = 8
+MQTT_TOPIC_ROOT = "growbox"
+
+# name: (channel, scale from the written unit to the device unit)
+CHANNELS = {
+    "temp": (0, 100),
+    "humidity": (1, 100),
+    "soil": (2, 1),
+    "soil_raw": (3, 1),
+    "time": (4, 1),
+    "pump_enabled": (5, 1),
+    "fault": (6, 1),
+}
+CHANNEL_NAMES = {index: name for name, (index, _) in CHANNELS.items()}
+ALIASES = {"temperature": "temp", "hum": "humidity", "moisture": "soil"}
+
+ACTION_ALERT, ACTION_WATER, ACTION_PUMP_DISABLE, ACTION_PUMP_ENABLE = range(4)
+ACTION_NAMES = ["alert", "water", "pump_disable", "pump_enable"]
+ARG_MAX = 0xFFFF
+
+OP_CHANNEL, OP_PUSH8, OP_PUSH16, OP_PUSH32 = 0x01, 0x02, 0x03, 0x04
+COMPARE_OPS = {"<": 0x10, "<=": 0x11, ">": 0x12, ">=": 0x13, "==": 0x14, "=": 0x14, "!=": 0x15}
+OP_AND, OP_OR, OP_NOT = 0x20, 0x21, 0x22
+OP_ADD, OP_SUB = 0x30, 0x31
+OPERANDS = {OP_CHANNEL: 1, OP_PUSH8: 1, OP_PUSH16: 2, OP_PUSH32: 4}
+MNEMONICS = {OP_CHANNEL: "CH", OP_PUSH8: "PUSH", OP_PUSH16: "PUSH", OP_PUSH32: "PUSH", 0x10: "LT", 0x11: "LE",
+             0x12: "GT", 0x13: "GE", 0x14: "EQ", 0x15: "NE", OP_AND: "AND", OP_OR: "OR", OP_NOT: "NOT",
+             OP_ADD: "ADD", OP_SUB: "SUB"}
+
+
+class RuleError(Exception):
+    pass
+
+
+TOKEN = re.compile(r"\s*(?:(\d{1,2}:\d{2})|(\d+(?:\.\d+)?)|([A-Za-z_]\w*)|(<=|>=|==|!=|[<>=+\-()]))")
+
+
+def tokenize(text):
+    tokens = []
+    pos = 0
+    text = text.rstrip()
+    while pos < len(text):
+        match = TOKEN.match(text, pos)
+        if not match:
+            raise RuleError(f"unexpected {text[pos:].strip()[:10]!r}")
+        clock, number, word, symbol = match.groups()
+        if clock:
+            hours, minutes = map(int, clock.split(":"))
+            if hours > 23 or minutes > 59:
+                raise RuleError(f"no such time {clock}")
+            tokens.append(("time", hours * 60 + minutes))
+        elif number:
+            tokens.append(("num", float(number)))
+        elif word:
+            tokens.append(("word", word.lower()))
+        else:
+            tokens.append(("sym", symbol))
+        pos = match.end()
+    return tokens
+
+
+class Parser:
+    """Recursive descent over one rule. Expressions become tuples:
+    ("num", value), ("time", minutes), ("ch", index, scale),
+    ("bin", op, a, b), ("not", a)."""
+
+    def __init__(self, tokens):
+        self.tokens = tokens
+        self.pos = 0
+
+    def peek(self):
+        return self.tokens[self.pos] if self.pos < len(self.tokens) else (None, None)
+
+    def take(self):
+        token = self.peek()
+        if token[0] is None:
+            raise RuleError("rule ends too early")
+        self.pos += 1
+        return token
+
+    def accept(self, kind, value=None):
+        token = self.peek()
+        if token[0] == kind and (value is None or token[1] == value):
+            self.pos += 1
+            return token
+        return None
+
+    def expect_word(self, word):
+        if not self.accept("word", word):
+            raise RuleError(f"expected {word!r}")
+
+    def rule(self):
+        condition = None
+        if self.accept("word", "at"):
+            token = self.take()
+            if token[0] != "time":
+                raise RuleError("expected HH:MM after 'at'")
+            condition = ("bin", "==", ("ch",) + CHANNELS["time"], token)
+        if self.accept("word", "if"):
+            test = self.expression()
+            condition = test if condition is None else ("bin", "and", condition, test)
+        if condition is None:
+            raise RuleError("a rule starts with 'at' or 'if'")
+        self.expect_word("then")
+        action, arg = self.action()
+        if self.peek()[0] is not None:
+            raise RuleError(f"unexpected {self.peek()[1]!r} after the action")
+        return condition, action, arg
+
+    def number(self, what):
+        token = self.take()
+        if token[0] != "num" or token[1] != int(token[1]):
+            raise RuleError(f"expected a whole number for {what}")
+        return int(token[1])
+
+    def action(self):
+        word = self.take()[1]
+        if word == "water":
+            ml = self.number("water")
+            self.accept("word", "ml")
+            if not 0 < ml <= ARG_MAX:
+                raise RuleError("water needs a dose in mL")
+            return ACTION_WATER, ml
+        if word in ("disable", "disable_pump"):
+            if word == "disable":
+                self.expect_word("pump")
+            if not self.accept("word", "for"):
+                return ACTION_PUMP_DISABLE, 0
+            amount = self.number("the hold")
+            unit = self.take()[1]
+            if unit in ("h", "hour", "hours"):
+                minutes = amount * 60
+            elif unit in ("m", "min", "minutes"):
+                minutes = amount
+            else:
+                raise RuleError("hold is in h or min")
+            if not 0 < minutes <= 1440:
+                raise RuleError("hold must be 1 min to 24 h")
+            return ACTION_PUMP_DISABLE, minutes
+        if word in ("enable", "enable_pump"):
+            if word == "enable":
+                self.expect_word("pump")
+            return ACTION_PUMP_ENABLE, 0
+        if word == "alert":
+            return ACTION_ALERT, 0
+        raise RuleError(f"unknown action {word!r}")
+
+    def expression(self):
+        node = self.conjunction()
+        while self.accept("word", "or"):
+            node = ("bin", "or", node, self.conjunction())
+        return node
+
+    def conjunction(self):
+        node = self.negation()
+        while self.accept("word", "and"):
+            node = ("bin", "and", node, self.negation())
+        return node
+
+    def negation(self):
+        if self.accept("word", "not"):
+            return ("not", self.negation())
+        return self.comparison()
+
+    def comparison(self):
+        node = self.sum()
+        token = self.peek()
+        if token[0] == "sym" and token[1] in COMPARE_OPS:
+            self.pos += 1
+            node = ("bin", token[1], node, self.sum())
+        return node
+
+    def sum(self):
+        node = self.atom()
+        while True:
+            token = self.peek()
+            if token[0] != "sym" or token[1] not in "+-":
+                return node
+            self.pos += 1
+            node = ("bin", token[1], node, self.atom())
+
+    def atom(self):
+        kind, value = self.take()
+        if kind in ("num", "time"):
+            return (kind, value)
+        if kind == "sym" and value == "-":
+            kind, value = self.take()
+            if kind != "num":
+                raise RuleError("expected a number after '-'")
+            return ("num", -value)
+        if kind == "sym" and value == "(":
+            node = self.expression()
+            if not self.accept("sym", ")"):
+                raise RuleError("missing ')'")
+            return node
+        if kind == "word":
+            name = ALIASES.get(value, value)
+            if name in CHANNELS:
+                return ("ch",) + CHANNELS[name]
+        raise RuleError(f"unexpected {value!r}")
+
+
+def push(value):
+    value = int(value)
+    if -128 <= value <= 127:
+        return struct.pack("<Bb", OP_PUSH8, value)
+    if -32768 <= value <= 32767:
+        return struct.pack("<Bh", OP_PUSH16, value)
+    if -2**31 <= value < 2**31:
+        return struct.pack("<Bi", OP_PUSH32, value)
+    raise RuleError(f"{value} is out of range")
+
+
+def scale_of(node):
+    """Scale of a channel expression, None for a bare number."""
+    if node[0] == "ch":
+        return node[2]
+    if node[0] == "bin" and node[1] in "+-":
+        return scale_of(node[2]) or scale_of(node[3])
+    return None if node[0] == "num" else 1
+
+
+def emit(node, scale=1):
+    """Bytecode for node; bare numbers are taken in the given scale."""
+    kind = node[0]
+    if kind == "num":
+        return push(round(node[1] * scale))
+    if kind == "time":
+        return push(node[1])
+    if kind == "ch":
+        return bytes([OP_CHANNEL, node[1]])
+    if kind == "not":
+        return emit(node[1]) + bytes([OP_NOT])
+    _, op, a, b = node
+    if op in ("and", "or"):
+        return emit(a) + emit(b) + bytes([OP_AND if op == "and" else OP_OR])
+    # Numbers take the unit of the channel on the other side
+    side = scale_of(a) or scale_of(b) or scale
+    return emit(a, side) + emit(b, side) + bytes([COMPARE_OPS[op] if op in COMPARE_OPS else
+                                                  OP_ADD if op == "+" else OP_SUB])
+
+
+def compile_rule(text):
+    condition, action, arg = Parser(tokenize(text)).rule()
+    code = emit(condition)
+    if len(code) > CODE_MAX:
+        raise RuleError(f"condition compiles to {len(code)} bytes, limit {CODE_MAX}")
+    verify(code)
+    return action, arg, code
+
+
+def compile_rules(source):
+    """Rule set for the rule lines of source; ids are 1, 2, ... in order."""
+    rules = []
+    for number, line in enumerate(source.splitlines(), 1):
+        line = line.split("#", 1)[0].strip()
+        if not line:
+            continue
+        try:
+            rules.append(compile_rule(line))
+        except RuleError as error:
+            raise RuleError(f"line {number}: {error}")
+    if len(rules) > RULES_MAX:
+        raise RuleError(f"{len(rules)} rules, limit {RULES_MAX}")
+    out = bytearray(b"GR" + bytes([VERSION, len(rules)]))
+    for rule_id, (action, arg, code) in enumerate(rules, 1):
+        out += struct.pack("<BBHB", rule_id, action, arg, len(code)) + code
+    return bytes(out)
+
+
+def instructions(code):
+    pc = 0
+    while pc < len(code):
+        op = code[pc]
+        if op not in MNEMONICS:
+            raise RuleError(f"unknown opcode 0x{op:02x}")
+        size = OPERANDS.get(op, 0)
+        if pc + 1 + size > len(code):
+            raise RuleError("truncated code")
+        operand = None
+        if op == OP_CHANNEL:
+            operand = code[pc + 1]
+        elif op in (OP_PUSH8, OP_PUSH16, OP_PUSH32):
+            operand = struct.unpack_from({1: "<b", 2: "<h", 4: "<i"}[size], code, pc + 1)[0]
+        yield op, operand
+        pc += 1 + size
+
+
+def verify(code):
+    """Channels the code reads, as a mask; raises like the device loader."""
+    depth = 0
+    inputs = 0
+    for op, operand in instructions(code):
+        if op == OP_CHANNEL:
+            if operand not in CHANNEL_NAMES:
+                raise RuleError(f"unknown channel {operand}")
+            inputs |= 1 << operand
+        depth += 1 if op in OPERANDS else 0 if op == OP_NOT else -1
+        if not 1 <= depth <= STACK_MAX:
+            raise RuleError("stack out of bounds")
+    if depth != 1:
+        raise RuleError("code does not leave one value")
+    return inputs
+
+
+def load(blob):
+    """[(id, action, arg, inputs, code)] of a rule set, checked as the
+    device does."""
+    if len(blob) < 4 or blob[:2] != b"GR" or blob[2] != VERSION:
+        raise RuleError("bad header")
+    if blob[3] > RULES_MAX:
+        raise RuleError("too many rules")
+    rules = []
+    pos = 4
+    for _ in range(blob[3]):
+        if len(blob) - pos < 5:
+            raise RuleError("truncated")
+        rule_id, action, arg, length = struct.unpack_from("<BBHB", blob, pos)
+        pos += 5
+        if action >= len(ACTION_NAMES):
+            raise RuleError(f"unknown action {action}")
+        if not 0 < length <= CODE_MAX or len(blob) - pos < length:
+            raise RuleError("bad code length")
+        code = blob[pos:pos + length]
+        rules.append((rule_id, action, arg, verify(code), code))
+        pos += length
+    if pos != len(blob):
+        raise RuleError("bytes after the last rule")
+    return rules
+
+
+def wrap(value):
+    return (value + 2**31) % 2**32 - 2**31
+
+
+def evaluate(code, channels):
+    stack = []
+    for op, operand in instructions(code):
+        if op == OP_CHANNEL:
+            stack.append(channels[operand])
+        elif op in OPERANDS:
+            stack.append(operand)
+        elif op == OP_NOT:
+            stack.append(int(not stack.pop()))
+        else:
+            b, a = stack.pop(), stack.pop()
+            stack.append({0x10: lambda: a < b, 0x11: lambda: a <= b, 0x12: lambda: a > b, 0x13: lambda: a >= b,
+                          0x14: lambda: a == b, 0x15: lambda: a != b, OP_AND: lambda: bool(a and b),
+                          OP_OR: lambda: bool(a or b), OP_ADD: lambda: wrap(a + b),
+                          OP_SUB: lambda: wrap(a - b)}[op]())
+            stack[-1] = int(stack[-1])
+    return stack[0] != 0
+
+
+def disassemble(code):
+    parts = []
+    for op, operand in instructions(code):
+        if op == OP_CHANNEL:
+            parts.append(f"CH {CHANNEL_NAMES[operand]}")
+        elif operand is not None:
+            parts.append(f"PUSH {operand}")
+        else:
+            parts.append(MNEMONICS[op])
+    return "; ".join(parts)
+
+
+def describe_action(action, arg):
+    if action == ACTION_WATER:
+        return f"water {arg} mL"
+    if action == ACTION_PUMP_DISABLE:
+        return f"disable pump for {arg} min" if arg else "disable pump"
+    return ACTION_NAMES[action]
+
+
+def parse_values(assignments):
+    """name=value pairs in written units to (channels, valid mask)."""
+    channels = [0] * len(CHANNELS)
+    valid = 0
+    for assignment in assignments:
+        name, _, text = assignment.partition("=")
+        name = ALIASES.get(name, name)
+        if name not in CHANNELS:
+            raise RuleError(f"unknown channel {name!r}")
+        index, scale = CHANNELS[name]
+        tokens = tokenize(text)
+        if len(tokens) != 1 or tokens[0][0] not in ("num", "time"):
+            raise RuleError(f"bad value for {name}: {text!r}")
+        channels[index] = tokens[0][1] if tokens[0][0] == "time" else round(tokens[0][1] * scale)
+        valid |= 1 << index
+    return channels, valid
+
+
+def connect(args):
+    import paho.mqtt.client as mqtt
+
+    client = mqtt.Client()
+    if args.ca:
+        client.tls_set(ca_certs=args.ca)
+    client.connect(args.broker, args.port or (8883 if args.ca else 1883))
+    return client
+
+
+def send(client, device_id, blob, timeout=10.0):
+    """Publish a rule set (empty clears) and wait for the device's answer."""
+    answer = {}
+    done = threading.Event()
+
+    def on_message(_client, _userdata, msg):
+        try:
+            event = json.loads(msg.payload)
+        except ValueError:
+            return
+        if isinstance(event, dict) and event.get("event") == "rules":
+            answer.update(event)
+            done.set()
+
+    client.on_message = on_message
+    client.subscribe(f"{MQTT_TOPIC_ROOT}/{device_id}/status")
+    client.loop_start()
+    client.publish(f"{MQTT_TOPIC_ROOT}/{device_id}/rules", blob, qos=1)
+    # QoS 1 reaches a box that is offline now once it reconnects
+    if not done.wait(timeout):
+        return None
+    return answer
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    p = commands.add_parser("compile", help="compile rules and show the bytecode")
+    p.add_argument("rules")
+    p.add_argument("-o", "--output")
+
+    p = commands.add_parser("eval", help="evaluate rules against channel values")
+    p.add_argument("rules")
+    p.add_argument("values", nargs="*", metavar="name=value")
+
+    for name, help_text in (("send", "compile rules and send them to a device"),
+                            ("clear", "remove all rules from a device")):
+        p = commands.add_parser(name, help=help_text)
+        if name == "send":
+            p.add_argument("rules")
+        p.add_argument("--device", required=True)
+        p.add_argument("--broker", default="broker.hivemq.com")
+        p.add_argument("--port", type=int, help="default 1883, or 8883 with --ca")
+        p.add_argument("--ca", help="CA certificate (PEM) to connect over TLS")
+
+    args = parser.parse_args()
+    try:
+        blob = compile_rules(open(args.rules).read()) if hasattr(args, "rules") else b""
+        if args.command == "compile":
+            for rule_id, action, arg, inputs, code in load(blob):
+                print(f"rule {rule_id}: {describe_action(action, arg)} when {disassemble(code)}")
+            print(f"{len(load(blob))} rules, {len(blob)} bytes")
+            if args.output:
+                open(args.output, "wb").write(blob)
+        elif args.command == "eval":
+            channels, valid = parse_values(args.values)
+            for rule_id, action, arg, inputs, code in load(blob):
+                if inputs & valid != inputs:
+                    missing = [CHANNEL_NAMES[i] for i in CHANNEL_NAMES if inputs & ~valid & (1 << i)]
+                    state = f"false (no {', '.join(missing)})"
+                else:
+                    state = "true" if evaluate(code, channels) else "false"
+                print(f"rule {rule_id}: {state:24} {describe_action(action, arg)}")
+        else:
+            client = connect(args)
+            started = time.monotonic()
+            answer = send(client, args.device, blob)
+            client.loop_stop()
+            if answer is None:
+                sys.exit("no answer from the device; it gets the rules when it next connects")
+            print(f"{answer.get('state')} in {time.monotonic() - started:.1f} s: "
+                  f"{answer.get('count', answer.get('reason'))}")
+            if answer.get("state") == "rejected":
+                sys.exit(1)
+    except RuleError as error:
+        sys.exit(f"error: {error}")
+
+
+if __name__ == "__main__":
+    main()
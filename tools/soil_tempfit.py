@@ -0,0 +1,169 @@
+"""Fits the soil sensor temperature coefficient from logged status messages.
+
+The log is what a subscriber to the status topic records, one message per
+line, optionally prefixed by a Unix timestamp and the topic:
+
+    mosquitto_sub -R -F '%U %t %p' -t 'growbox/<id>/status' >> soil.log
+    python tools/soil_tempfit.py soil.log --device <id>
+
+The box sends its samples in {"samples":[...]} batches, each sample with
+its age in ms when the batch left; a sample's time is the message time
+minus that age. The last batch is retained, so -R keeps the broker's
+replay of it on every (re)subscribe out of the log; otherwise its samples
+would be counted twice. Older logs with one sample per message still work.
+
+The raw reading is modelled as
+
+    soil_raw = a + b * t + slope * (temperature - ref)
+
+with its own a and b for every stretch between waterings, so drying and
+watering are absorbed there and only the temperature effect is left for the
+shared slope. A stretch ends at a pump_activated event or at a raw drop of
+more than --jump counts between two samples.
+
+Prints the slope and reference, the spread of the data with and without the
+correction, and the CAL_TEMP control command for the device (published with
+--publish). If the log was taken with compensation already on, the slope
+still left in soil_raw_comp is reported too; it should be close to zero.
+"""
+import argparse
+import json
+import sys
+
+# Keep in sync with soil_calibration.h
+SLOPE_SHIFT = 8
+
+# Status samples are 10 s apart when the log has no timestamps
+SAMPLE_INTERVAL = 10.0
+
+
+def message_samples(data):
+    """(age in s, sample) for each sample in a batch or a single status message."""
+    if isinstance(data.get("samples"), list):
+        return [(s.get("age_ms", 0) / 1000.0, s) for s in data["samples"] if isinstance(s, dict)]
+    if "soil_raw" in data:
+        return [(0.0, data)]
+    return []
+
+
+def parse_log(path, device_id):
+    """Stretches of (time, temperature, raw, raw_comp) between waterings."""
+    stretches = [[]]
+    count = 0
+    for line in open(path, encoding="utf-8"):
+        start = line.find("{")
+        if start < 0:
+            continue
+        prefix = line[:start].split()
+        try:
+            data = json.loads(line[start:])
+        except json.JSONDecodeError:
+            continue
+
+        topic = next((p for p in prefix if "/" in p), None)
+        if device_id and topic and topic.split("/")[1] != device_id:
+            continue
+        try:
+            when = float(prefix[0])
+        except (IndexError, ValueError):
+            when = None
+
+        if data.get("event") == "pump_activated":
+            stretches.append([])
+            continue
+        for age, sample in message_samples(data):
+            count += 1
+            if "soil_raw" not in sample or not sample.get("sensor_ok"):
+                continue
+            taken = when - age if when is not None else count * SAMPLE_INTERVAL
+            stretches[-1].append((taken, sample["temperature"], sample["soil_raw"], sample.get("soil_raw_comp")))
+    return stretches
+
+
+def split_jumps(stretches, jump):
+    result = []
+    for stretch in stretches:
+        current = []
+        for sample in stretch:
+            if current and current[-1][2] - sample[2] > jump:
+                result.append(current)
+                current = []
+            current.append(sample)
+        result.append(current)
+    return result
+
+
+def detrend(values, times):
+    """Residuals of a straight-line fit against time."""
+    n = len(values)
+    mean_t = sum(times) / n
+    mean_v = sum(values) / n
+    var_t = sum((t - mean_t) ** 2 for t in times)
+    b = sum((t - mean_t) * (v - mean_v) for t, v in zip(times, values)) / var_t if var_t else 0.0
+    return [v - mean_v - b * (t - mean_t) for t, v in zip(times, values)]
+
+
+def fit_slope(stretches, column):
+    """Shared temperature slope with a line per stretch (Frisch-Waugh)."""
+    temp_residuals = []
+    raw_residuals = []
+    for stretch in stretches:
+        times = [s[0] for s in stretch]
+        temp_residuals += detrend([s[1] for s in stretch], times)
+        raw_residuals += detrend([s[column] for s in stretch], times)
+    var_temp = sum(r * r for r in temp_residuals)
+    if var_temp == 0:
+        sys.exit("temperature does not vary within the stretches; log over warmer and cooler hours")
+    slope = sum(tr * rr for tr, rr in zip(temp_residuals, raw_residuals)) / var_temp
+    before = (sum(r * r for r in raw_residuals) / len(raw_residuals)) ** 0.5
+    after = (sum((rr - slope * tr) ** 2 for tr, rr in zip(temp_residuals, raw_residuals))
+             / len(raw_residuals)) ** 0.5
+    return slope, before, after
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log", help="status messages, one per line")
+    parser.add_argument("--device", help="only use messages from this device id")
+    parser.add_argument("--zone", type=int, default=0, help="soil zone the log's readings come from")
+    parser.add_argument("--jump", type=int, default=150, help="raw drop (counts) treated as a watering")
+    parser.add_argument("--min-samples", type=int, default=30, help="shortest stretch used")
+    parser.add_argument("--publish", action="store_true", help="send CAL_TEMP to the device")
+    parser.add_argument("--broker", default="broker.hivemq.com")
+    parser.add_argument("--port", type=int, default=1883)
+    args = parser.parse_args()
+
+    stretches = [s for s in split_jumps(parse_log(args.log, args.device), args.jump)
+                 if len(s) >= args.min_samples]
+    samples = sum(len(s) for s in stretches)
+    if not stretches:
+        sys.exit(f"no stretch of {args.min_samples} samples with soil_raw between waterings")
+
+    slope, before, after = fit_slope(stretches, 2)
+    temps = sorted(s[1] for stretch in stretches for s in stretch)
+    ref = temps[len(temps) // 2]
+    slope_q8 = round(slope * (1 << SLOPE_SHIFT))
+    ref_centi = round(ref * 100)
+
+    print(f"{samples} samples in {len(stretches)} stretches, {temps[0]:.1f}..{temps[-1]:.1f} C")
+    print(f"  slope  {slope:+.2f} counts/C around {ref:.1f} C")
+    print(f"  spread {before:.1f} counts uncompensated, {after:.1f} compensated (after per-stretch trend)")
+
+    compensated = [s for s in stretches if all(x[3] is not None for x in s)]
+    if compensated:
+        residual, _, _ = fit_slope(compensated, 3)
+        print(f"  soil_raw_comp in the log still has {residual:+.2f} counts/C")
+
+    if not args.device:
+        return
+    command = f"CAL_TEMP {args.zone} {slope_q8} {ref_centi}"
+    topic = f"growbox/{args.device}/control"
+    print(f"  {topic} <- {command}")
+    if args.publish:
+        import paho.mqtt.publish as publish
+        publish.single(topic, command, hostname=args.broker, port=args.port)
+        print("  published")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,40 @@
+#!/bin/sh
+# Certificates for a local TLS test broker: a CA, a server certificate for
+# the given host name or IP, and a client certificate for brokers run with
+# require_certificate. Writes to tools/tls_broker/certs.
+#
+#   tools/tls_broker/gen_certs.sh 192.168.1.10
+#
+# Then paste certs/ca.crt into MQTT_CA_CERT in include/secrets.h (and
+# certs/client.crt / client.key into MQTT_CLIENT_CERT / KEY if needed).
+set -e
+
+HOST=${1:-localhost}
+DIR=$(dirname "$0")/certs
+DAYS=825
+mkdir -p "$DIR"
+cd "$DIR"
+
+case "$HOST" in
+    *[!0-9.]*) SAN="DNS:$HOST" ;;
+    *) SAN="IP:$HOST" ;;
+esac
+
+# EC P-256 keeps the handshake light for the ESP32
+openssl ecparam -name prime256v1 -genkey -noout -out ca.key
+openssl req -x509 -new -key ca.key -sha256 -days $DAYS -subj "/CN=growbox test CA" -out ca.crt
+
+openssl ecparam -name prime256v1 -genkey -noout -out server.key
+openssl req -new -key server.key -subj "/CN=$HOST" -out server.csr
+printf "subjectAltName=%s\nextendedKeyUsage=serverAuth\n" "$SAN" > server.ext
+openssl x509 -req -in server.csr -CA ca.crt -CAkey ca.key -CAcreateserial -sha256 -days $DAYS \
+    -extfile server.ext -out server.crt
+
+openssl ecparam -name prime256v1 -genkey -noout -out client.key
+openssl req -new -key client.key -subj "/CN=growbox" -out client.csr
+printf "extendedKeyUsage=clientAuth\n" > client.ext
+openssl x509 -req -in client.csr -CA ca.crt -CAkey ca.key -CAcreateserial -sha256 -days $DAYS \
+    -extfile client.ext -out client.crt
+
+rm -f server.csr server.ext client.csr client.ext
+echo "certificates for $HOST in $DIR"
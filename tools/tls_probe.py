@@ -0,0 +1,110 @@
+"""Measures full and resumed TLS handshakes against an MQTT broker.
+
+Connects the way firmware built with -DMQTT_TLS does: TLS 1.2, the broker's
+chain checked against a pinned CA, optionally a client certificate, then
+an MQTT CONNECT. The first connection does a full handshake; the following
+ones offer the session it left and report whether the broker resumed it.
+Standard library only.
+
+    python tools/tls_probe.py 192.168.1.10 --ca tools/tls_broker/certs/ca.crt
+    python tools/tls_probe.py broker.local --ca ca.crt --cert client.crt --key client.key -n 20
+
+Times are on the host, so they show the network and broker side of the
+cost; the device's own numbers (full_ms_max, resumed_ms_max, heap) are in
+the "tls" object of growbox/<id>/metrics.
+"""
+import argparse
+import socket
+import ssl
+import statistics
+import struct
+import sys
+import time
+
+
+def mqtt_connect_packet(client_id, keepalive):
+    client_id = client_id.encode()
+    variable = b"\x00\x04MQTT\x04\x02" + struct.pack(">H", keepalive)
+    payload = struct.pack(">H", len(client_id)) + client_id
+    return bytes([0x10, len(variable) + len(payload)]) + variable + payload
+
+
+def read_exact(sock, count):
+    data = b""
+    while len(data) < count:
+        chunk = sock.recv(count - len(data))
+        if not chunk:
+            raise ConnectionError("connection closed")
+        data += chunk
+    return data
+
+
+def probe(context, host, port, session, timeout):
+    """One connection: (handshake ms, MQTT CONNACK ms, resumed, session)."""
+    raw = socket.create_connection((host, port), timeout=timeout)
+    raw.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    try:
+        start = time.perf_counter()
+        tls = context.wrap_socket(raw, server_hostname=host, session=session, do_handshake_on_connect=False)
+        tls.do_handshake()
+        handshake_ms = (time.perf_counter() - start) * 1000
+
+        tls.sendall(mqtt_connect_packet("tls-probe", 30))
+        connack = read_exact(tls, 4)
+        connack_ms = (time.perf_counter() - start) * 1000
+        if connack[0] != 0x20 or connack[3] != 0:
+            raise ConnectionError(f"broker refused the connection: {connack.hex()}")
+
+        resumed = tls.session_reused
+        session = tls.session
+        tls.sendall(b"\xe0\x00")
+        tls.close()
+        return handshake_ms, connack_ms, resumed, session
+    finally:
+        raw.close()
+
+
+def summary(name, values):
+    if not values:
+        return f"{name}: none"
+    return (f"{name}: {len(values)}, min {min(values):.1f} ms, median {statistics.median(values):.1f} ms, "
+            f"max {max(values):.1f} ms")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host")
+    parser.add_argument("--port", type=int, default=8883)
+    parser.add_argument("--ca", required=True, help="CA certificate (PEM) the broker's chain must end in")
+    parser.add_argument("--cert", help="client certificate (PEM)")
+    parser.add_argument("--key", help="client key (PEM)")
+    parser.add_argument("-n", "--count", type=int, default=10, help="connections, the first one full")
+    parser.add_argument("--timeout", type=float, default=10.0)
+    args = parser.parse_args()
+
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_CLIENT)
+    context.minimum_version = ssl.TLSVersion.TLSv1_2
+    context.maximum_version = ssl.TLSVersion.TLSv1_2
+    context.load_verify_locations(args.ca)
+    if args.cert:
+        context.load_cert_chain(args.cert, args.key)
+
+    full, resumed = [], []
+    session = None
+    for i in range(args.count):
+        try:
+            handshake_ms, connack_ms, reused, session = probe(context, args.host, args.port, session, args.timeout)
+        except (OSError, ssl.SSLError) as error:
+            sys.exit(f"connection {i + 1}: {error}")
+        (resumed if reused else full).append(handshake_ms)
+        print(f"{i + 1:3}: {'resumed' if reused else 'full   '} handshake {handshake_ms:6.1f} ms, "
+              f"CONNACK {connack_ms:6.1f} ms")
+
+    print(summary("full", full))
+    print(summary("resumed", resumed))
+    if args.count > 1 and not resumed:
+        print("the broker resumed no session; check that it keeps a session cache or issues tickets")
+
+
+if __name__ == "__main__":
+    main()
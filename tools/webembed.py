@@ -0,0 +1,80 @@
+"""Embeds a web page in the firmware as a gzipped C byte array.
+
+The page is minified lightly (indentation and blank lines go), gzipped at
+the highest level and written next to it as <name>_html.c/.h, so the web
+server can send it as is with Content-Encoding: gzip. The gzip header has
+no timestamp, so the output only changes when the page does.
+
+    python tools/webembed.py src/web/dashboard.html
+
+Prints the flash cost against the plain page.
+"""
+import argparse
+import gzip
+import os
+import re
+
+
+def minify(text):
+    lines = (line.strip() for line in text.splitlines())
+    return "\n".join(line for line in lines if line)
+
+
+def write_c(name, source, data, out_dir):
+    symbol = f"{name}_html_gz"
+    guard = f"{name.upper()}_HTML_H"
+
+    with open(os.path.join(out_dir, f"{name}_html.h"), "w", encoding="utf-8") as f:
+        f.write(f"""#ifndef {guard}
+#define {guard}
+
+// Generated by tools/webembed.py from {source}; do not edit
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {{
+#endif
+
+extern const uint8_t {symbol}[];
+extern const size_t {symbol}_len;
+
+#ifdef __cplusplus
+}}
+#endif
+
+#endif
+""")
+
+    with open(os.path.join(out_dir, f"{name}_html.c"), "w", encoding="utf-8") as f:
+        f.write(f"// Generated by tools/webembed.py from {source}; do not edit\n\n")
+        f.write(f'#include "{name}_html.h"\n\n')
+        f.write(f"const uint8_t {symbol}[] = {{\n")
+        for i in range(0, len(data), 12):
+            f.write("    " + ", ".join(f"0x{b:02X}" for b in data[i:i + 12]) + ",\n")
+        f.write("};\n\n")
+        f.write(f"const size_t {symbol}_len = sizeof({symbol});\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("page", help="HTML file")
+    parser.add_argument("--out-dir", help="write <name>_html.c/.h here (default: next to the page)")
+    args = parser.parse_args()
+
+    with open(args.page, encoding="utf-8") as f:
+        text = f.read()
+    plain = minify(text).encode("utf-8")
+    data = gzip.compress(plain, compresslevel=9, mtime=0)
+
+    source = os.path.basename(args.page)
+    name = re.sub(r"\W", "_", os.path.splitext(source)[0])
+    write_c(name, source, data, args.out_dir or os.path.dirname(args.page))
+
+    print(f"{source} -> {name}_html.c: {len(text.encode('utf-8'))} B, "
+          f"{len(plain)} B minified, {len(data)} B gzipped in flash")
+
+
+if __name__ == "__main__":
+    main()